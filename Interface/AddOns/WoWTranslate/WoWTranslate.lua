@@ -112,6 +112,7 @@ local defaults = {
     incomingToLang = "en",
     outgoingFromLang = "en",
     outgoingToLang = "zh",
+    outgoingPreview = false,  -- Translate the edit box speculatively while typing
 }
 
 -- ============================================================================
@@ -173,10 +174,16 @@ end
 -- Detects if text contains characters from the configured source language
 -- Supports: zh (Chinese), ja (Japanese), ko (Korean), ru (Russian)
 -- For Latin-based languages (en, de, fr, es, pt): detects non-ASCII characters
+-- For "auto": any letters at all; the DLL identifies the language and hands
+-- back text that is already in the target language untranslated
 
 local function ContainsLanguageChars(text, lang)
     if not text then return false end
 
+    if lang == "auto" then
+        return string.find(text, "[%a\128-\255]") ~= nil
+    end
+
     for i = 1, string.len(text) do
         local byte = string.byte(text, i)
 
@@ -251,6 +258,47 @@ local itemCacheCounter = 0
 local itemCacheTooltip = CreateFrame("GameTooltip", "WoWTranslateItemCacheTooltip", nil, "GameTooltipTemplate")
 itemCacheTooltip:SetOwner(WorldFrame, "ANCHOR_NONE")
 
+-- Link names resolved by the DLL's name index ("item:ID" / "quest:ID" -> name)
+-- for the incoming target language; these links skip the item cache wait
+local indexedLinkNames = {}
+local indexedLinkCount = 0
+local indexedLinkLang = nil
+local MAX_INDEXED_LINK_NAMES = 500
+
+-- Resolve every item and quest link in a message with one DLL call
+local function PrefetchLinkNames(text)
+    local lang = WoWTranslateDB and WoWTranslateDB.incomingToLang or "en"
+    if lang ~= "en" and lang ~= "zh" then
+        return
+    end
+    if lang ~= indexedLinkLang or indexedLinkCount > MAX_INDEXED_LINK_NAMES then
+        indexedLinkNames = {}
+        indexedLinkCount = 0
+        indexedLinkLang = lang
+    end
+
+    local keys = {}
+    local seen = {}
+    for linkType, id in string.gfind(text, "|H(%a+):(%d+)") do
+        local key = linkType .. ":" .. id
+        if (linkType == "item" or linkType == "quest") and not indexedLinkNames[key] and not seen[key] then
+            seen[key] = true
+            table.insert(keys, key)
+        end
+    end
+    if table.getn(keys) == 0 then
+        return
+    end
+
+    local names = WoWTranslate_API.LookupLinkNames(keys, lang)
+    if names then
+        for key, name in pairs(names) do
+            indexedLinkNames[key] = name
+            indexedLinkCount = indexedLinkCount + 1
+        end
+    end
+end
+
 -- Force item data to be requested from server using SetHyperlink
 -- This is more reliable than just calling GetItemInfo()
 local function TriggerItemCache(itemId)
@@ -296,7 +344,7 @@ local function CheckItemCache(itemIds, triggerCache)
     local uncachedIds = {}
 
     for _, itemId in ipairs(itemIds) do
-        local name, link = GetItemInfo(itemId)
+        local name = indexedLinkNames["item:" .. itemId] or GetItemInfo(itemId)
         if not name then
             table.insert(uncachedIds, itemId)
             -- Use SetHyperlink to force server to send item data
@@ -403,7 +451,7 @@ local function GetEnglishQuestName(questId)
 end
 
 -- Localize a hyperlink by replacing the display text with the English name
--- Currently supports: items (via GetItemInfo)
+-- Names come from the DLL name index, then GetItemInfo (items) or pfQuest (quests)
 -- Falls back to original if localization not available
 local function LocalizeHyperlink(link)
     DebugLog("LocalizeHyperlink called:", string.sub(link, 1, 40))
@@ -421,9 +469,12 @@ local function LocalizeHyperlink(link)
         local itemId = GetItemIdFromLinkData(linkData)
         DebugLog("  Item ID:", itemId)
         if itemId then
-            -- GetItemInfo returns: name, link, quality, iLevel, ...
-            local itemName, itemLink = GetItemInfo(itemId)
-            DebugLog("  GetItemInfo returned:", itemName or "nil")
+            -- Name index first, then GetItemInfo (name, link, quality, iLevel, ...)
+            local itemName = indexedLinkNames["item:" .. itemId]
+            if not itemName then
+                itemName = GetItemInfo(itemId)
+                DebugLog("  GetItemInfo returned:", itemName or "nil")
+            end
 
             if itemName then
                 -- Always rebuild the link manually to ensure correct structure
@@ -442,8 +493,11 @@ local function LocalizeHyperlink(link)
         local questId = GetQuestIdFromLinkData(linkData)
         DebugLog("  Quest ID:", questId)
         if questId then
-            local questName = GetEnglishQuestName(questId)
-            DebugLog("  GetEnglishQuestName returned:", questName or "nil")
+            local questName = indexedLinkNames["quest:" .. questId]
+            if not questName then
+                questName = GetEnglishQuestName(questId)
+                DebugLog("  GetEnglishQuestName returned:", questName or "nil")
+            end
 
             if questName then
                 local result
@@ -613,7 +667,9 @@ local function BuildTranslatableText(segments)
 end
 
 -- Reconstruct message from translated text and original segments
-local function ReconstructMessage(segments, translatedText)
+-- partial: text is only the start of a streamed translation, so placeholders
+-- not in it yet are left for the final text instead of appended
+local function ReconstructMessage(segments, translatedText, partial)
     local result = {}
     local workText = translatedText
 
@@ -679,7 +735,7 @@ local function ReconstructMessage(segments, translatedText)
             end
         end
 
-        if not found then
+        if not found and not partial then
             DebugLog("Placeholder not found:", placeholder)
             -- Append the link at the end as fallback
             workText = workText .. " " .. linkContents[i]
@@ -689,6 +745,51 @@ local function ReconstructMessage(segments, translatedText)
     return workText
 end
 
+-- Offline glosses (DLL flag "approx") are word-by-word: mark them in chat
+-- and keep them out of the cache so a real translation can replace them
+local APPROX_MARKER = "|cFF999999~|r "
+
+local function IsApproximate(flags)
+    return flags and string.find(flags, "approx", 1, true) ~= nil
+end
+
+-- Long messages the DLL streams arrive sentence by sentence: each piece
+-- shows only what the previous ones did not, marked as a continuation
+local STREAM_CONTINUATION = "|cFF999999...|r "
+
+-- Show the part of text not yet shown for a pending message. False when
+-- text does not continue what was shown (the DLL retried the message whole)
+local function ShowStreamedPart(pending, text)
+    local shown = pending.shown
+    if not shown then
+        pending.shown = text
+        pending.originalAddMessage(pending.frame, text, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
+        return true
+    end
+
+    local shownLength = string.len(shown)
+    if string.sub(text, 1, shownLength) ~= shown then
+        return false
+    end
+    local rest = string.sub(text, shownLength + 1)
+    pending.shown = text
+    if string.find(rest, "%S") then
+        pending.originalAddMessage(pending.frame, STREAM_CONTINUATION .. rest, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
+    end
+    return true
+end
+
+-- onPartial handler for WoWTranslate_API.Translate on a chat message
+local function OnStreamedPart(msgId)
+    return function(translation)
+        local pending = pendingMessages[msgId]
+        if pending then
+            pending.timestamp = GetTime()
+            ShowStreamedPart(pending, ReconstructMessage(pending.segments, translation, true))
+        end
+    end
+end
+
 -- ============================================================================
 -- CHAT FRAME HOOKING
 -- ============================================================================
@@ -741,7 +842,9 @@ local function HookChatFrames()
                 -- Log original message for debugging
                 DebugLog("ORIGINAL MSG:", string.sub(text, 1, 150))
 
-                -- Check for item links and ensure items are cached before processing
+                -- Resolve link names from the DLL's index, then make sure any
+                -- other items are cached before processing
+                PrefetchLinkNames(text)
                 local itemIds = ExtractItemIds(text)
                 if table.getn(itemIds) > 0 then
                     -- Pass true to trigger cache via SetHyperlink for uncached items
@@ -788,7 +891,7 @@ local function HookChatFrames()
 
                 -- Check if credits are exhausted FIRST - if so, pass through original text
                 -- This skips both cache and API to show untranslated text
-                if WoWTranslate_API and WoWTranslate_API.IsCreditsExhausted() then
+                if WoWTranslate_API and WoWTranslate_API.IsCreditsExhausted() and not WoWTranslate_API.IsOfflineEnabled() then
                     DebugLog("Credits exhausted, passing through original (no cache, no API)")
                     WoWTranslate_API.ShowCreditWarningIfNeeded()
                     frameOriginalAddMessage(self, text, r, g, b, id, holdTime)
@@ -829,7 +932,7 @@ local function HookChatFrames()
 
                     DebugLog("Queued for API:", msgId)
 
-                    WoWTranslate_API.Translate(textToTranslate, function(translation, err)
+                    WoWTranslate_API.Translate(textToTranslate, function(translation, err, flags)
                         local pending = pendingMessages[msgId]
                         if pending then
                             pendingMessages[msgId] = nil
@@ -849,8 +952,14 @@ local function HookChatFrames()
                                     DebugLog("WARNING: Final missing link markers!")
                                 end
 
-                                WoWTranslate_CacheSave(pending.originalText, finalText)
-                                pending.originalAddMessage(pending.frame, finalText, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
+                                if IsApproximate(flags) then
+                                    finalText = APPROX_MARKER .. finalText
+                                else
+                                    WoWTranslate_CacheSave(pending.originalText, finalText)
+                                end
+                                if not (pending.shown and ShowStreamedPart(pending, finalText)) then
+                                    pending.originalAddMessage(pending.frame, finalText, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
+                                end
                             else
                                 DebugLog("API error:", err)
                                 -- Check for credit-related errors and show warning
@@ -866,7 +975,7 @@ local function HookChatFrames()
                                 pending.originalAddMessage(pending.frame, pending.originalText, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
                             end
                         end
-                    end)
+                    end, OnStreamedPart(msgId))
 
                     return
                 else
@@ -911,6 +1020,89 @@ local function CleanupOutgoingQueue()
     end
 end
 
+-- ============================================================================
+-- OUTGOING DRAFT PREFETCH
+-- ============================================================================
+-- While the player types, the edit box text is translated speculatively under
+-- one supersede key, so each new draft replaces the previous one in the DLL.
+-- When the message is sent unchanged, the DLL reuses the finished result
+-- from its cache or joins the draft still in flight.
+
+local DRAFT_SUPERSEDE_KEY = "outgoing_draft"
+local DRAFT_DELAY = 0.6       -- Seconds the text must stay unchanged before prefetching
+local DRAFT_MIN_LENGTH = 4
+local draftText = nil
+local draftElapsed = 0
+local draftRequestId = nil
+local draftHookInstalled = false
+
+local function CancelOutgoingDraft()
+    if draftRequestId then
+        WoWTranslate_API.CancelRequest(draftRequestId)
+        draftRequestId = nil
+    end
+    draftText = nil
+end
+
+local function ShouldPrefetchDraft(text, chatType)
+    if not WoWTranslateDB or not WoWTranslateDB.outgoingPreview or not WoWTranslateDB.outgoingEnabled then
+        return false
+    end
+    if not text or string.len(text) < DRAFT_MIN_LENGTH or string.sub(text, 1, 1) == "/" then
+        return false
+    end
+    if not chatType or not WoWTranslateDB.outgoingChannels or not WoWTranslateDB.outgoingChannels[chatType] then
+        return false
+    end
+    if WoWTranslateDB.disableWhileAfk and playerIsAFK then
+        return false
+    end
+    if ContainsOutgoingTargetLanguage(text) then
+        return false
+    end
+    return WoWTranslate_API and WoWTranslate_API.IsAvailable() and not WoWTranslate_API.IsCreditsExhausted()
+end
+
+local draftFrame = CreateFrame("Frame")
+draftFrame:SetScript("OnUpdate", function()
+    if not draftText then return end
+    draftElapsed = draftElapsed + arg1
+    if draftElapsed < DRAFT_DELAY then return end
+
+    local text = draftText
+    draftText = nil
+
+    -- Same text the send path will request, so the DLL can match them up
+    local textToTranslate = BuildTranslatableText(SplitIntoSegments(text))
+    local queued, requestId = WoWTranslate_API.TranslateOutgoing(textToTranslate, nil, DRAFT_SUPERSEDE_KEY)
+    if queued then
+        draftRequestId = requestId
+        DebugLog("Outgoing draft prefetch:", requestId, textToTranslate)
+    end
+end)
+
+local function OnDraftTextChanged()
+    local text = ChatFrameEditBox:GetText()
+    if ShouldPrefetchDraft(text, ChatFrameEditBox.chatType) then
+        draftText = text
+        draftElapsed = 0
+    else
+        draftText = nil
+    end
+end
+
+local function InstallDraftHook()
+    if draftHookInstalled or not ChatFrameEditBox then return end
+    local originalOnTextChanged = ChatFrameEditBox:GetScript("OnTextChanged")
+    ChatFrameEditBox:SetScript("OnTextChanged", function()
+        if originalOnTextChanged then
+            originalOnTextChanged()
+        end
+        OnDraftTextChanged()
+    end)
+    draftHookInstalled = true
+end
+
 -- Hooked SendChatMessage for outgoing translation
 local function HookedSendChatMessage(msg, chatType, language, channel)
     -- Handle nil chatType (WoW 1.12 compatibility)
@@ -1033,6 +1225,9 @@ local function HookedSendChatMessage(msg, chatType, language, channel)
             originalSendChatMessage(queued.originalMsg, queued.chatType, queued.language, queued.channel)
         end
     end)
+
+    -- The send has joined an identical draft if there was one; drop the draft itself
+    CancelOutgoingDraft()
 end
 
 -- Track if hook is installed (for diagnostics)
@@ -1222,6 +1417,162 @@ SlashCmdList["WOWTRANSLATE"] = function(msg)
             DEFAULT_CHAT_FRAME:AddMessage("  " .. logs[i])
         end
 
+    elseif cmd == "template" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetTemplating(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Cache templating: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+        end
+
+    elseif cmd == "segments" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetSegmentMemory(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Segment memory: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+        end
+
+    elseif cmd == "budget" then
+        local micros = tonumber(arg)
+        if micros then
+            if WoWTranslate_API.SetFrameBudget(micros) then
+                DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Frame budget: " .. (micros == 0 and "|cFFFF0000OFF|r" or micros .. " us"))
+            else
+                DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available or invalid budget|r")
+            end
+        else
+            local stats = WoWTranslate_API.GetFrameBudgetStats()
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Frame budget: " .. (stats or "DLL not available"))
+        end
+
+    elseif cmd == "preflight" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetPreflight(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Skip untranslatable lines: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+        end
+
+    elseif cmd == "stream" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetStreaming(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Streaming long messages: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+        end
+
+    elseif cmd == "multiplex" then
+        if arg == "on" or arg == "off" then
+            local enable = (arg == "on")
+            if WoWTranslate_API.SetMultiplexing(enable) then
+                DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Request multiplexing: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+            else
+                DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+            end
+        else
+            local stats = WoWTranslate_API.GetMultiplexStats()
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Multiplexing: " .. (stats or "DLL not available"))
+        end
+
+    elseif cmd == "chunks" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetChunking(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Long-message chunking: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+        end
+
+    elseif cmd == "hedge" then
+        local _, _, mode, percent = string.find(arg or "", "^(%S*)%s*(%d*)")
+        local enable = (mode == "on")
+        if WoWTranslate_API.SetHedging(enable, tonumber(percent)) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Request hedging: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available or invalid budget|r")
+        end
+
+    elseif cmd == "push" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetPushDelivery(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Push delivery: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available or push unsupported (polling instead)|r")
+        end
+
+    elseif cmd == "endpoints" then
+        local endpoints = WoWTranslate_API.GetEndpoints()
+        if not endpoints then
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Server endpoints:")
+            for i = 1, table.getn(endpoints) do
+                local e = endpoints[i]
+                local color = (e.state == "up") and "|cFF00FF00" or "|cFFFF0000"
+                DEFAULT_CHAT_FRAME:AddMessage("  " .. e.name .. " " .. color .. e.state .. "|r " .. e.rtt .. " ms, " ..
+                    e.errors .. "% errors, " .. e.failures .. "/" .. e.requests .. " failed")
+            end
+        end
+
+    elseif cmd == "wire" then
+        if arg == "msgpack" or arg == "json" then
+            if WoWTranslate_API.SetWireFormat(arg) then
+                DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Request format: " .. arg)
+            else
+                DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available|r")
+            end
+        else
+            local format = WoWTranslate_API.GetWireFormat()
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Request format (preferred|negotiated): " .. (format or "DLL not available"))
+        end
+
+    elseif cmd == "shared" then
+        local enable = (arg == "on")
+        if WoWTranslate_API.SetSharedCache(enable) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Shared cache: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available or shared memory unavailable|r")
+        end
+
+    elseif cmd == "preview" then
+        local enable = (arg == "on")
+        WoWTranslateDB.outgoingPreview = enable
+        if enable then
+            InstallDraftHook()
+        else
+            CancelOutgoingDraft()
+        end
+        DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Outgoing draft preview: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+
+    elseif cmd == "neardup" then
+        local _, _, mode, bits = string.find(arg or "", "^(%S*)%s*(%d*)")
+        local enable = (mode == "on")
+        if WoWTranslate_API.SetNearDuplicate(enable, tonumber(bits)) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Near-duplicate reuse: " .. (enable and "|cFF00FF00ON|r" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available or invalid threshold|r")
+        end
+
+    elseif cmd == "offline" then
+        local _, _, mode, chars = string.find(arg or "", "^(%S*)%s*(%d*)")
+        if mode ~= "fallback" and mode ~= "first" then
+            mode = "off"
+        end
+        if WoWTranslate_API.SetOfflineMode(mode, tonumber(chars)) then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Offline dictionary: " .. (mode == "off" and "|cFFFF0000OFF|r" or "|cFF00FF00" .. string.upper(mode) .. "|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] DLL not available or invalid length|r")
+        end
+
+    elseif cmd == "trace" then
+        local enable = (arg == "on")
+        local success, err = WoWTranslate_API.SetTracing(enable)
+        if success then
+            DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] DLL tracing: " .. (enable and "|cFF00FF00ON|r (WoWTranslate_trace.json)" or "|cFFFF0000OFF|r"))
+        else
+            DEFAULT_CHAT_FRAME:AddMessage("|cFFFF0000[WoWTranslate] Tracing failed: " .. (err or "unknown") .. "|r")
+        end
+
     elseif cmd == "clearlog" then
         WoWTranslateDebugLog = {}
         DEFAULT_CHAT_FRAME:AddMessage("[WoWTranslate] Debug log cleared")
@@ -1375,8 +1726,24 @@ SlashCmdList["WOWTRANSLATE"] = function(msg)
         DEFAULT_CHAT_FRAME:AddMessage("  /wt status - Show status")
         DEFAULT_CHAT_FRAME:AddMessage("  /wt clearcache - Clear cache")
         DEFAULT_CHAT_FRAME:AddMessage("  /wt debug - Toggle debug mode")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt template on|off - Share cache entries across numbers/names")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt segments on|off - Reuse translations of recurring phrases")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt neardup on|off [bits] - Reuse translations of near-identical spam")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt shared on|off - Share translations with other clients on this PC")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt preflight on|off - Answer numbers, markers, links and \"LFM MC\" without the server")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt chunks on|off - Translate long messages sentence by sentence in parallel")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt stream on|off - Show long messages sentence by sentence as they arrive")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt multiplex [on|off] - Send queued messages without waiting for earlier ones")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt hedge on|off [percent] - Resend slow requests (extra load capped at percent)")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt wire [msgpack|json] - Show or set the DLL's request format")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt push on|off - Deliver results as soon as they arrive instead of polling")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt endpoints - Show server endpoints with latency and error rate")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt budget [us] - Show or set the DLL's per-frame time budget (0 = off)")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt offline off|fallback|first [chars] - Approximate CN->EN gloss without the server")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt trace on|off - Record DLL request timings")
         DEFAULT_CHAT_FRAME:AddMessage("  -- Outgoing --")
         DEFAULT_CHAT_FRAME:AddMessage("  /wt outgoing on|off - Toggle outgoing translation")
+        DEFAULT_CHAT_FRAME:AddMessage("  /wt preview on|off - Translate outgoing drafts while typing")
         DEFAULT_CHAT_FRAME:AddMessage("  /wt outchannel [type] - Show/toggle channel settings")
         DEFAULT_CHAT_FRAME:AddMessage("  /wt prefix <text> - Set message prefix")
     end
@@ -1475,6 +1842,9 @@ local function OnPlayerLogin()
     if WoWTranslateDB and WoWTranslateDB.outgoingEnabled then
         InstallOutgoingHook()
     end
+    if WoWTranslateDB and WoWTranslateDB.outgoingPreview then
+        InstallDraftHook()
+    end
 end
 
 -- ============================================================================
@@ -1540,7 +1910,7 @@ local function ProcessItemCacheMessage(queued)
     end
 
     -- Check if credits are exhausted FIRST - if so, pass through original (no cache, no API)
-    if WoWTranslate_API and WoWTranslate_API.IsCreditsExhausted() then
+    if WoWTranslate_API and WoWTranslate_API.IsCreditsExhausted() and not WoWTranslate_API.IsOfflineEnabled() then
         DebugLog("Credits exhausted, passing through item message (no cache, no API)")
         WoWTranslate_API.ShowCreditWarningIfNeeded()
         queued.originalAddMessage(queued.frame, text, queued.r, queued.g, queued.b, queued.id, queued.holdTime)
@@ -1579,7 +1949,7 @@ local function ProcessItemCacheMessage(queued)
 
         DebugLog("Queued item message for API:", msgId)
 
-        WoWTranslate_API.Translate(textToTranslate, function(translation, err)
+        WoWTranslate_API.Translate(textToTranslate, function(translation, err, flags)
             local pending = pendingMessages[msgId]
             if pending then
                 pendingMessages[msgId] = nil
@@ -1587,14 +1957,20 @@ local function ProcessItemCacheMessage(queued)
                 if translation then
                     DebugLog("API returned for item msg:", string.sub(translation, 1, 50))
                     local finalText = ReconstructMessage(pending.segments, translation)
-                    WoWTranslate_CacheSave(pending.originalText, finalText)
-                    pending.originalAddMessage(pending.frame, finalText, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
+                    if IsApproximate(flags) then
+                        finalText = APPROX_MARKER .. finalText
+                    else
+                        WoWTranslate_CacheSave(pending.originalText, finalText)
+                    end
+                    if not (pending.shown and ShowStreamedPart(pending, finalText)) then
+                        pending.originalAddMessage(pending.frame, finalText, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
+                    end
                 else
                     DebugLog("API error for item msg:", err)
                     pending.originalAddMessage(pending.frame, pending.originalText, pending.r, pending.g, pending.b, pending.id, pending.holdTime)
                 end
             end
-        end)
+        end, OnStreamedPart(msgId))
     else
         -- No API, just show with localized links
         local result = ""
@@ -15,6 +15,7 @@ local activePendingCount = 0
 -- Credit tracking (updated from DLL responses)
 local creditsRemaining = -1  -- -1 = unknown
 local creditsExhausted = false  -- True when we know credits are zero
+local offlineMode = "off"       -- DLL offline dictionary mode: off, fallback or first
 local lastError = nil
 local lastCreditWarningTime = 0  -- For throttling credit warnings
 
@@ -25,7 +26,15 @@ local COST_PER_CHAR = 0.003  -- $30 per million = 0.003 cents per char
 
 -- Constants
 local POLL_INTERVAL = 0.1  -- Poll every 100ms
+local PUSH_FALLBACK_POLL_INTERVAL = 1.0  -- While the DLL's per-frame tick drives draining, polling only backs it up
 local REQUEST_TIMEOUT = 30 -- Timeout requests after 30 seconds
+local POLL_BATCH_SIZE = 8  -- Results per poll_batch call (the DLL may return fewer)
+local POLL_RECORD_SEPARATOR = "\030"
+local pollBatchSupported = true
+local nameIndexSupported = true  -- Cleared when the DLL has no name index
+local pushEnabled = true     -- Ask the DLL once a frame whether results are ready
+local pushSupported = true   -- Cleared when the DLL has no push
+local pushActive = false     -- Push enabled in the DLL
 
 -- ============================================================================
 -- LUA 5.0 COMPATIBILITY
@@ -209,6 +218,16 @@ function WoWTranslate_API.FetchCredits()
     return true
 end
 
+-- Turn an "error|..." reply from translate_async into a pcall-style failure,
+-- so a request the DLL refused (e.g. still starting up) fails immediately
+-- instead of waiting for REQUEST_TIMEOUT
+local function CheckQueued(success, result)
+    if success and type(result) == "string" and string.sub(result, 1, 6) == "error|" then
+        return false, string.sub(result, 7)
+    end
+    return success, result
+end
+
 -- ============================================================================
 -- API KEY MANAGEMENT
 -- ============================================================================
@@ -249,8 +268,11 @@ end
 -- ============================================================================
 
 -- Request an async translation
--- callback(translation, error) will be called when complete
-function WoWTranslate_API.Translate(text, callback)
+-- callback(translation, error, flags) will be called when complete;
+-- flags is "near" when the DLL reused a near-duplicate's translation.
+-- onPartial(translationSoFar, sequence) (optional) is called before that
+-- when the DLL streams a long message sentence by sentence
+function WoWTranslate_API.Translate(text, callback, onPartial)
     if not dllAvailable then
         if callback then
             callback(nil, "DLL not available")
@@ -272,6 +294,7 @@ function WoWTranslate_API.Translate(text, callback)
     -- Store pending request
     pendingRequests[requestId] = {
         callback = callback,
+        onPartial = onPartial,
         text = text,
         timestamp = GetTime()
     }
@@ -280,8 +303,9 @@ function WoWTranslate_API.Translate(text, callback)
     local fromLang = WoWTranslateDB and WoWTranslateDB.incomingFromLang or "zh"
     local toLang = WoWTranslateDB and WoWTranslateDB.incomingToLang or "en"
     local success, err = pcall(function()
-        UnitXP("WoWTranslate", "translate_async", requestId, text, fromLang, toLang)
+        return UnitXP("WoWTranslate", "translate_async", requestId, text, fromLang, toLang)
     end)
+    success, err = CheckQueued(success, err)
 
     if not success then
         pendingRequests[requestId] = nil
@@ -299,86 +323,142 @@ end
 -- POLLING SYSTEM
 -- ============================================================================
 
--- Poll DLL for completed translations
-local function PollTranslations()
-    if not dllAvailable then return end
+-- Deliver one poll record to its pending request
+-- Success: "requestId|translation||credits|flags"
+-- Error: "requestId||error_message|credits|flags"
+-- Where credits and flags are optional (may be empty)
+local function HandlePollRecord(result)
+    local firstPipe = string.find(result, "|", 1, true)
+    if firstPipe then
+        local requestId = string.sub(result, 1, firstPipe - 1)
+        local remainder = string.sub(result, firstPipe + 1)
+
+        -- Find all pipes in remainder
+        local pipes = {}
+        local searchPos = 1
+        while true do
+            local pos = string.find(remainder, "|", searchPos, true)
+            if pos then
+                table.insert(pipes, pos)
+                searchPos = pos + 1
+            else
+                break
+            end
+        end
 
-    local success, result = pcall(function()
-        return UnitXP("WoWTranslate", "poll")
-    end)
+        local translation, err, credits, flags
+        local pipeCount = table.getn(pipes)
+
+        if pipeCount >= 3 then
+            -- Format: translation|error|credits|flags
+            -- Parsed from the right so a "|" inside the translation survives
+            local p1, p2, p3 = pipes[pipeCount - 2], pipes[pipeCount - 1], pipes[pipeCount]
+            translation = string.sub(remainder, 1, p1 - 1)
+            err = string.sub(remainder, p1 + 1, p2 - 1)
+            credits = tonumber(string.sub(remainder, p2 + 1, p3 - 1))
+            flags = string.sub(remainder, p3 + 1)
+        elseif pipeCount >= 2 then
+            -- Format: translation|error|credits
+            translation = string.sub(remainder, 1, pipes[1] - 1)
+            err = string.sub(remainder, pipes[1] + 1, pipes[2] - 1)
+            local creditsStr = string.sub(remainder, pipes[2] + 1)
+            credits = tonumber(creditsStr)
+        elseif table.getn(pipes) == 1 then
+            -- Old format: translation|error
+            translation = string.sub(remainder, 1, pipes[1] - 1)
+            err = string.sub(remainder, pipes[1] + 1)
+        else
+            translation = remainder
+            err = ""
+        end
 
-    if success and result and result ~= "" then
-        -- Parse result format from proxy-enabled DLL:
-        -- Success: "requestId|translation|credits|"
-        -- Error: "requestId||error_message|credits"
-        -- Where credits is optional (may be empty)
-
-        local firstPipe = string.find(result, "|", 1, true)
-        if firstPipe then
-            local requestId = string.sub(result, 1, firstPipe - 1)
-            local remainder = string.sub(result, firstPipe + 1)
-
-            -- Find all pipes in remainder
-            local pipes = {}
-            local searchPos = 1
-            while true do
-                local pos = string.find(remainder, "|", searchPos, true)
-                if pos then
-                    table.insert(pipes, pos)
-                    searchPos = pos + 1
-                else
-                    break
-                end
-            end
+        -- Update credits if we got a value
+        if credits and credits >= 0 then
+            creditsRemaining = credits
+            creditsExhausted = (credits == 0)
+        end
 
-            local translation, err, credits
-
-            if table.getn(pipes) >= 2 then
-                -- Format: translation|error|credits
-                translation = string.sub(remainder, 1, pipes[1] - 1)
-                err = string.sub(remainder, pipes[1] + 1, pipes[2] - 1)
-                local creditsStr = string.sub(remainder, pipes[2] + 1)
-                credits = tonumber(creditsStr)
-            elseif table.getn(pipes) == 1 then
-                -- Old format: translation|error
-                translation = string.sub(remainder, 1, pipes[1] - 1)
-                err = string.sub(remainder, pipes[1] + 1)
-            else
-                translation = remainder
-                err = ""
+        -- Multi-target results arrive as "requestId@lang", one per target
+        local target
+        if requestId and not pendingRequests[requestId] then
+            local _, _, baseId, lang = string.find(requestId, "^(.-)@(.+)$")
+            if baseId and pendingRequests[baseId] then
+                requestId, target = baseId, lang
             end
+        end
 
-            -- Update credits if we got a value
-            if credits and credits >= 0 then
-                creditsRemaining = credits
-                creditsExhausted = (credits == 0)
+        -- Streamed sentences so far ("partial=N"); the request stays pending
+        local _, _, sequence = string.find(flags or "", "partial=(%d+)")
+        if sequence then
+            local req = requestId and pendingRequests[requestId]
+            if req then
+                req.timestamp = GetTime()
+                if req.onPartial then
+                    req.onPartial(translation, tonumber(sequence))
+                end
             end
+            return
+        end
 
-            if requestId and pendingRequests[requestId] then
-                local req = pendingRequests[requestId]
+        if requestId and pendingRequests[requestId] then
+            local req = pendingRequests[requestId]
+            if target and req.remaining and req.remaining > 1 then
+                req.remaining = req.remaining - 1
+            else
                 pendingRequests[requestId] = nil
                 OnRequestCompleted()
+            end
 
-                if req.callback then
-                    if err and err ~= "" then
-                        -- Store error for UI
-                        lastError = err
-
-                        -- Check for credit exhaustion
-                        if string.find(err, "INSUFFICIENT_CREDITS") or string.find(err, "Insufficient credits") then
-                            creditsExhausted = true
-                            creditsRemaining = 0
-                        end
-
-                        req.callback(nil, err)
-                    else
-                        lastError = nil
-                        req.callback(translation, nil)
+            if req.callback then
+                if err and err ~= "" then
+                    -- Store error for UI
+                    lastError = err
+
+                    -- Check for credit exhaustion
+                    if string.find(err, "INSUFFICIENT_CREDITS") or string.find(err, "Insufficient credits") then
+                        creditsExhausted = true
+                        creditsRemaining = 0
                     end
+
+                    req.callback(nil, err, nil, target)
+                else
+                    lastError = nil
+                    req.callback(translation, nil, flags, target)
                 end
             end
         end
     end
+end
+
+-- Poll DLL for completed translations
+local function PollTranslations()
+    if not dllAvailable then return end
+
+    -- poll_batch drains several results per call within the DLL's frame
+    -- budget (GetTime() marks the frame); older DLLs only know poll
+    local success, result = pcall(function()
+        if pollBatchSupported then
+            return UnitXP("WoWTranslate", "poll_batch", tostring(POLL_BATCH_SIZE), GetTime())
+        end
+        return UnitXP("WoWTranslate", "poll")
+    end)
+
+    if success and result and result ~= "" then
+        if pollBatchSupported and string.sub(result, 1, 6) == "error|" then
+            pollBatchSupported = false
+        else
+            local start = 1
+            while true do
+                local separator = string.find(result, POLL_RECORD_SEPARATOR, start, true)
+                if not separator then
+                    HandlePollRecord(string.sub(result, start))
+                    break
+                end
+                HandlePollRecord(string.sub(result, start, separator - 1))
+                start = separator + 1
+            end
+        end
+    end
 
     -- Cleanup timed-out requests
     local now = GetTime()
@@ -393,16 +473,38 @@ local function PollTranslations()
     end
 end
 
+-- Let the poll frame ask the DLL once a frame whether results are ready
+local function RegisterPush()
+    if pushActive or not pushEnabled or not pushSupported or not dllAvailable then return end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "push", "on")
+    end)
+    if success and result == "ok" then
+        pushActive = true
+    else
+        -- Older DLL: keep polling at the full rate
+        pushSupported = false
+    end
+end
+
 -- Start the polling frame
 function WoWTranslate_API.StartPolling()
     if pollFrame then return end
 
+    RegisterPush()
     pollFrame = CreateFrame("Frame")
     local elapsed = 0
 
     pollFrame:SetScript("OnUpdate", function()
         elapsed = elapsed + arg1
-        if elapsed >= POLL_INTERVAL then
+        -- OnUpdate is the top of the UI's frame: the DLL's tick says whether
+        -- anything is waiting, so results land the frame they are ready
+        local ready = false
+        if pushActive then
+            local success, result = pcall(UnitXP, "WoWTranslate", "push", "tick")
+            ready = success and result == "1"
+        end
+        if ready or elapsed >= (pushActive and PUSH_FALLBACK_POLL_INTERVAL or POLL_INTERVAL) then
             elapsed = 0
             PollTranslations()
         end
@@ -423,7 +525,8 @@ end
 
 -- Request an async outgoing translation (en -> zh)
 -- callback(translation, error) will be called when complete
-function WoWTranslate_API.TranslateOutgoing(text, callback)
+-- supersedeKey (optional): a newer request with the same key replaces this one
+function WoWTranslate_API.TranslateOutgoing(text, callback, supersedeKey)
     if not dllAvailable then
         if callback then
             callback(nil, "DLL not available")
@@ -453,8 +556,72 @@ function WoWTranslate_API.TranslateOutgoing(text, callback)
     local fromLang = WoWTranslateDB and WoWTranslateDB.outgoingFromLang or "en"
     local toLang = WoWTranslateDB and WoWTranslateDB.outgoingToLang or "zh"
     local success, err = pcall(function()
-        UnitXP("WoWTranslate", "translate_async", requestId, text, fromLang, toLang)
+        if supersedeKey then
+            return UnitXP("WoWTranslate", "translate_async", requestId, text, fromLang, toLang, supersedeKey)
+        end
+        return UnitXP("WoWTranslate", "translate_async", requestId, text, fromLang, toLang)
+    end)
+    success, err = CheckQueued(success, err)
+
+    if not success then
+        pendingRequests[requestId] = nil
+        if callback then
+            callback(nil, "DLL call failed: " .. tostring(err))
+        end
+        return false
+    end
+
+    OnRequestQueued()
+    return true, requestId
+end
+
+-- Translate one line into several languages with a single DLL/proxy call
+-- targets: array of language codes, e.g. { "ru", "en" }
+-- callback(translation, error, flags, target) is called once per target;
+-- an error that ends the whole request (cancel, timeout) has no target
+function WoWTranslate_API.TranslateMulti(text, targets, callback, fromLang)
+    if not dllAvailable then
+        if callback then
+            callback(nil, "DLL not available")
+        end
+        return false
+    end
+
+    if not text or text == "" or not targets or table.getn(targets) == 0 then
+        if callback then
+            callback(nil, "Empty text")
+        end
+        return false
+    end
+
+    -- The DLL answers each distinct target once
+    local seen, list = {}, {}
+    for _, lang in ipairs(targets) do
+        if not seen[lang] then
+            seen[lang] = true
+            table.insert(list, lang)
+        end
+    end
+
+    requestCounter = requestCounter + 1
+    local requestId = "multi_" .. tostring(requestCounter)
+
+    pendingRequests[requestId] = {
+        callback = callback,
+        text = text,
+        remaining = table.getn(list),
+        timestamp = GetTime()
+    }
+
+    local toLangs = table.concat(list, ",")
+    if table.getn(list) == 1 then
+        -- A single target is an ordinary request; keep the "@lang" answer shape
+        toLangs = toLangs .. ","
+    end
+    local success, err = pcall(function()
+        return UnitXP("WoWTranslate", "translate_async", requestId, text, fromLang or "auto", toLangs)
     end)
+    success, err = CheckQueued(success, err)
 
     if not success then
         pendingRequests[requestId] = nil
@@ -468,10 +635,294 @@ function WoWTranslate_API.TranslateOutgoing(text, callback)
     return true, requestId
 end
 
+-- Cancel a pending request; its callback will not be called.
+-- The DLL drops it from the queue, or abandons it if nothing else shares it.
+function WoWTranslate_API.CancelRequest(requestId)
+    if not requestId or not pendingRequests[requestId] then
+        return false
+    end
+
+    pendingRequests[requestId] = nil
+    OnRequestCompleted()
+
+    if dllAvailable then
+        pcall(function()
+            UnitXP("WoWTranslate", "cancel", requestId)
+        end)
+    end
+    return true
+end
+
+-- ============================================================================
+-- DLL CACHE OPTIONS
+-- ============================================================================
+
+-- Send an on/off toggle subcommand to the DLL
+local function SetDllOption(subcommand, enabled)
+    if not dllAvailable then return false end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", subcommand, enabled and "on" or "off")
+    end)
+    return success and result == "ok"
+end
+
+-- Toggle DLL cache templating (numbers and player names share one cached translation)
+function WoWTranslate_API.SetTemplating(enabled)
+    return SetDllOption("template", enabled)
+end
+
+-- Toggle DLL segment translation memory (recurring phrases are translated once)
+function WoWTranslate_API.SetSegmentMemory(enabled)
+    return SetDllOption("segments", enabled)
+end
+
+-- Toggle the DLL cache shared with other clients on this machine (multiboxing):
+-- a line one client translated is reused by the others without a request
+function WoWTranslate_API.SetSharedCache(enabled)
+    return SetDllOption("shared", enabled)
+end
+
+-- Set the DLL's game-thread time budget in microseconds per frame (0 = unlimited)
+function WoWTranslate_API.SetFrameBudget(micros)
+    if not dllAvailable then return false end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "budget", tostring(micros))
+    end)
+    return success and result == "ok"
+end
+
+-- Frame budget counters and recent overruns as a "key=value ..." string
+function WoWTranslate_API.GetFrameBudgetStats()
+    if not dllAvailable then return nil end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "budget")
+    end)
+    if success and result and string.sub(result, 1, 6) ~= "error|" then
+        return result
+    end
+    return nil
+end
+
+-- Toggle DLL pre-flight skipping: lines with nothing to translate (numbers,
+-- coordinates, raid markers, lone links, emoticons, shared abbreviations
+-- such as "LFM MC") come back unchanged without a server request
+function WoWTranslate_API.SetPreflight(enabled)
+    return SetDllOption("preflight", enabled)
+end
+
+-- Toggle DLL streaming of long messages: sentences are shown as they are
+-- translated instead of all at once (needs a proxy with /api/translate/stream)
+function WoWTranslate_API.SetStreaming(enabled)
+    return SetDllOption("stream", enabled)
+end
+
+-- Toggle DLL request multiplexing: queued messages are sent while earlier
+-- ones are still being answered, over one connection where HTTP/2 is available
+function WoWTranslate_API.SetMultiplexing(enabled)
+    return SetDllOption("multiplex", enabled)
+end
+
+-- "on|http2|http2Responses|inFlight|peak|prefetched|used|wasted|fallbacks"
+function WoWTranslate_API.GetMultiplexStats()
+    if not dllAvailable then return nil end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "multiplex")
+    end)
+    if success and result and string.sub(result, 1, 6) ~= "error|" then
+        return result
+    end
+    return nil
+end
+
+-- Toggle DLL chunking of long messages (sentences translated in parallel)
+function WoWTranslate_API.SetChunking(enabled)
+    return SetDllOption("chunks", enabled)
+end
+
+-- Toggle DLL request hedging: a request slower than the recent p95 is sent
+-- again on a second connection and the first answer wins
+-- budgetPercent: optional cap on the extra requests (1-50, default 5)
+function WoWTranslate_API.SetHedging(enabled, budgetPercent)
+    if not dllAvailable then return false end
+    local success, result = pcall(function()
+        if budgetPercent then
+            return UnitXP("WoWTranslate", "hedge", enabled and "on" or "off", tostring(budgetPercent))
+        end
+        return UnitXP("WoWTranslate", "hedge", enabled and "on" or "off")
+    end)
+    return success and result == "ok"
+end
+
+-- Toggle push delivery: the poll frame asks the DLL once a frame whether
+-- results are ready, and timed polling drops to a once-a-second fallback
+function WoWTranslate_API.SetPushDelivery(enabled)
+    if not dllAvailable then return false end
+    pushEnabled = enabled
+    if not enabled then
+        pushActive = false
+        local success, result = pcall(function()
+            return UnitXP("WoWTranslate", "push", "off")
+        end)
+        return success and result == "ok"
+    end
+    pushSupported = true
+    RegisterPush()
+    return pushActive
+end
+
+-- Choose the DLL's request format: "msgpack" (compact binary bodies with a
+-- session token, falling back to JSON if the server lacks it) or "json"
+function WoWTranslate_API.SetWireFormat(format)
+    if not dllAvailable then return false end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "wire", format)
+    end)
+    return success and result == "ok"
+end
+
+-- Preferred and negotiated request formats as "preferred|negotiated"
+function WoWTranslate_API.GetWireFormat()
+    if not dllAvailable then return nil end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "wire")
+    end)
+    if success and result and string.sub(result, 1, 6) ~= "error|" then
+        return result
+    end
+    return nil
+end
+
+-- Proxy endpoints the DLL routes between, healthy and fastest first
+-- Returns an array of { name, state ("up"/"down"/"probing"), rtt (ms),
+-- errors (percent), requests, failures }, or nil
+function WoWTranslate_API.GetEndpoints()
+    if not dllAvailable then return nil end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "endpoints")
+    end)
+    if not success or not result or string.sub(result, 1, 6) == "error|" then
+        return nil
+    end
+
+    local endpoints = {}
+    for record in string.gfind(result, "[^" .. POLL_RECORD_SEPARATOR .. "]+") do
+        local _, _, name, state, rtt, errors, requests, failures =
+            string.find(record, "^([^|]*)|([^|]*)|(%d+)|(%d+)|(%d+)|(%d+)$")
+        if name then
+            table.insert(endpoints, {
+                name = name,
+                state = state,
+                rtt = tonumber(rtt),
+                errors = tonumber(errors),
+                requests = tonumber(requests),
+                failures = tonumber(failures),
+            })
+        end
+    end
+    return endpoints
+end
+
+-- Toggle DLL near-duplicate reuse (spam variants share one translation)
+-- threshold: optional SimHash distance in bits (0-16)
+function WoWTranslate_API.SetNearDuplicate(enabled, threshold)
+    if not dllAvailable then return false end
+    local success, result = pcall(function()
+        if threshold then
+            return UnitXP("WoWTranslate", "neardup", enabled and "on" or "off", tostring(threshold))
+        end
+        return UnitXP("WoWTranslate", "neardup", enabled and "on" or "off")
+    end)
+    return success and result == "ok"
+end
+
+-- Choose when the DLL answers with its offline dictionary gloss
+-- mode: "off", "fallback" (server unreachable or out of credits) or "first"
+-- (also short messages the dictionary fully covers); maxChars bounds "first"
+function WoWTranslate_API.SetOfflineMode(mode, maxChars)
+    if not dllAvailable then return false end
+    local success, result = pcall(function()
+        if maxChars then
+            return UnitXP("WoWTranslate", "offline", mode, tostring(maxChars))
+        end
+        return UnitXP("WoWTranslate", "offline", mode)
+    end)
+    if success and result == "ok" then
+        offlineMode = mode
+        return true
+    end
+    return false
+end
+
+-- True when exhausted credits still get an (approximate) offline translation
+function WoWTranslate_API.IsOfflineEnabled()
+    return offlineMode ~= "off"
+end
+
+-- Item and quest names from the DLL's prebuilt name index, all in one call
+-- keys: array of "item:ID" / "quest:ID"; lang: "en" or "zh"
+-- Returns a table of key -> name for the keys the index knows, or nil
+function WoWTranslate_API.LookupLinkNames(keys, lang)
+    if not dllAvailable or not nameIndexSupported or table.getn(keys) == 0 then return nil end
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "names", lang, table.concat(keys, ","))
+    end)
+    if not success or not result then return nil end
+    if string.sub(result, 1, 6) == "error|" then
+        -- No index file, or a DLL without the subcommand: stop asking
+        if result == "error|no name index" or string.find(result, "^error|unknown command") then
+            nameIndexSupported = false
+        end
+        return nil
+    end
+
+    local names = {}
+    local start = 1
+    for i = 1, table.getn(keys) do
+        local separator = string.find(result, POLL_RECORD_SEPARATOR, start, true)
+        local name = string.sub(result, start, (separator or 0) - 1)
+        if name ~= "" then
+            names[keys[i]] = name
+        end
+        if not separator then break end
+        start = separator + 1
+    end
+    return names
+end
+
+-- Tell the DLL which player names to lift into template slots
+-- names: array of player names (e.g. raid or guild roster)
+function WoWTranslate_API.SetTemplateNames(names)
+    if not dllAvailable or not names then return false end
+    local list = table.concat(names, ",")
+    local success = pcall(function()
+        return UnitXP("WoWTranslate", "template_names", list)
+    end)
+    return success
+end
+
 -- ============================================================================
 -- DEBUG FUNCTIONS
 -- ============================================================================
 
+-- Toggle DLL request-lifecycle tracing (writes WoWTranslate_trace.json next to WoW.exe)
+-- Returns: success, error message
+function WoWTranslate_API.SetTracing(enabled)
+    if not dllAvailable then
+        return false, "DLL not available"
+    end
+
+    local success, result = pcall(function()
+        return UnitXP("WoWTranslate", "trace", enabled and "on" or "off")
+    end)
+
+    if success and result == "ok" then
+        return true
+    elseif success and result and string.find(result, "error|") then
+        return false, string.sub(result, 7)
+    end
+    return false, result
+end
+
 -- Get pending request count
 function WoWTranslate_API.GetPendingCount()
     local count = 0
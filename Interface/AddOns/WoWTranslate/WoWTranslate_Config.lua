@@ -17,9 +17,16 @@ local LANGUAGES = {
     { code = "pt", name = "Portuguese" },
 }
 
-local function GetLanguageIndex(code)
-    for i = 1, table.getn(LANGUAGES) do
-        if LANGUAGES[i].code == code then
+-- Incoming source may also be detected by the DLL per message
+local SOURCE_LANGUAGES = { { code = "auto", name = "Auto-detect" } }
+for i = 1, table.getn(LANGUAGES) do
+    table.insert(SOURCE_LANGUAGES, LANGUAGES[i])
+end
+
+local function GetLanguageIndex(code, languages)
+    languages = languages or LANGUAGES
+    for i = 1, table.getn(languages) do
+        if languages[i].code == code then
             return i
         end
     end
@@ -27,9 +34,9 @@ local function GetLanguageIndex(code)
 end
 
 local function GetLanguageName(code)
-    for i = 1, table.getn(LANGUAGES) do
-        if LANGUAGES[i].code == code then
-            return LANGUAGES[i].name
+    for i = 1, table.getn(SOURCE_LANGUAGES) do
+        if SOURCE_LANGUAGES[i].code == code then
+            return SOURCE_LANGUAGES[i].name
         end
     end
     return code
@@ -224,7 +231,8 @@ end
 -- ============================================================================
 -- HELPER: Create Language Selector
 -- ============================================================================
-local function CreateLangSelector(label, xPos, yPos, configKey)
+local function CreateLangSelector(label, xPos, yPos, configKey, languages)
+    languages = languages or LANGUAGES
     local frame = CreateFrame("Frame", nil, configFrame)
     frame:SetPoint("TOPLEFT", configFrame, "TOPLEFT", xPos, yPos)
     frame:SetWidth(170)
@@ -258,23 +266,24 @@ local function CreateLangSelector(label, xPos, yPos, configKey)
 
     frame.display = display
     frame.configKey = configKey
+    frame.languages = languages
 
     leftBtn:SetScript("OnClick", function()
         local parent = this:GetParent()
         local code = WoWTranslate_TempConfig[parent.configKey] or "zh"
-        local idx = GetLanguageIndex(code) - 1
-        if idx < 1 then idx = table.getn(LANGUAGES) end
-        WoWTranslate_TempConfig[parent.configKey] = LANGUAGES[idx].code
-        parent.display:SetText(LANGUAGES[idx].name)
+        local idx = GetLanguageIndex(code, parent.languages) - 1
+        if idx < 1 then idx = table.getn(parent.languages) end
+        WoWTranslate_TempConfig[parent.configKey] = parent.languages[idx].code
+        parent.display:SetText(parent.languages[idx].name)
     end)
 
     rightBtn:SetScript("OnClick", function()
         local parent = this:GetParent()
         local code = WoWTranslate_TempConfig[parent.configKey] or "zh"
-        local idx = GetLanguageIndex(code) + 1
-        if idx > table.getn(LANGUAGES) then idx = 1 end
-        WoWTranslate_TempConfig[parent.configKey] = LANGUAGES[idx].code
-        parent.display:SetText(LANGUAGES[idx].name)
+        local idx = GetLanguageIndex(code, parent.languages) + 1
+        if idx > table.getn(parent.languages) then idx = 1 end
+        WoWTranslate_TempConfig[parent.configKey] = parent.languages[idx].code
+        parent.display:SetText(parent.languages[idx].name)
     end)
 
     return frame
@@ -406,7 +415,7 @@ CreateHeader("Incoming Translation (Chat -> You)", Y_IN_HEADER)
 configFrame.elements.inEnabled = CreateCheckbox("Enable Incoming Translation", 25, Y_IN_ENABLE, "enabled", nil)
 configFrame.elements.afkDisable = CreateCheckbox("Disable while AFK", 250, Y_IN_ENABLE, "disableWhileAfk", nil)
 configFrame.elements.translateSystem = CreateCheckbox("Translate system/emotes", 25, Y_IN_NAMES, "translateSystemMessages", nil)
-configFrame.elements.inFrom = CreateLangSelector("From:", 25, Y_IN_LANG, "incomingFromLang")
+configFrame.elements.inFrom = CreateLangSelector("From:", 25, Y_IN_LANG, "incomingFromLang", SOURCE_LANGUAGES)
 configFrame.elements.inTo = CreateLangSelector("To:", 210, Y_IN_LANG, "incomingToLang")
 
 -- Incoming Channels Section
@@ -0,0 +1,137 @@
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#else
+#include <sys/socket.h>
+#include <deque>
+#include <thread>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "payload_pool.h"
+#include "request_table.h"
+
+// Counters for the async engine; inFlight and peak are requests, not threads
+struct AsyncHttpStats {
+    bool running;
+    bool http2Enabled;         // The session asked for HTTP/2 (Windows 10 1607+)
+    size_t inFlight;
+    size_t peakInFlight;
+    size_t capacity;
+    size_t tableBytes;         // Slots and read buffers
+    uint64_t submitted;
+    uint64_t completed;        // Answered with a body
+    uint64_t failed;           // Network errors, gateway errors, cancels
+    uint64_t cancelled;
+    uint64_t rejected;         // Every slot was in use
+    uint64_t http2Responses;   // Answers that came over an HTTP/2 stream
+};
+
+// Event-driven POSTs over a WinHTTP session in async mode: requests are
+// driven by WinHTTP's completion callbacks on its own small thread pool, so
+// dozens can be in flight without a thread each. HTTP/2 is requested, which
+// carries them as streams on one connection per endpoint; where the system
+// cannot negotiate it they spread over at most MAX_CONNECTIONS_PER_SERVER
+// HTTP/1.1 keep-alive connections (WinHTTP does not pipeline).
+// The POSIX build (host tools) drives plain-HTTP sockets from one epoll
+// thread instead and pipelines HTTP/1.1 requests over the same number of
+// connections per endpoint.
+// Endpoints are indexed like TranslationClient's synchronous connections.
+class AsyncHttpEngine {
+public:
+    // response is empty on network errors, gateway errors (502-504) and
+    // cancels, as with TranslationClient::HttpsRequest. Runs on a WinHTTP
+    // thread, or on the caller of Cancel/Stop; it must not block.
+    using Completion = std::function<void(PooledString response, uint32_t statusCode)>;
+    // Body bytes as they arrive, before done runs; same threads as done.
+    // The epoll transport hands the body over in one piece.
+    using DataHandler = std::function<void(std::string_view bytes)>;
+
+    static constexpr size_t MAX_IN_FLIGHT = 64;
+    static constexpr uint32_t MAX_CONNECTIONS_PER_SERVER = 4;
+    static constexpr uint32_t STOP_WAIT_MS = 2000;
+
+    AsyncHttpEngine();
+    ~AsyncHttpEngine();
+
+    // Opens the async session; false when WinHTTP refuses async mode
+    bool Start(const wchar_t* userAgent);
+    // Call once per endpoint, in the synchronous connections' order
+    void AddEndpoint(const std::string& host, int port);
+    // Cancels everything in flight and closes the session
+    void Stop();
+    bool IsRunning() const { return running; }
+    size_t InFlight() const;
+
+    // Returns the request id, or 0 when it could not be started (done is
+    // then never called). postData is copied.
+    uint64_t Submit(size_t endpoint, const std::string& path, std::string_view postData, bool binary,
+                    uint32_t timeoutMs, Completion done, DataHandler onData = nullptr);
+    // done runs with an empty response; false if the request already finished
+    bool Cancel(uint64_t id);
+
+    AsyncHttpStats GetStats() const;
+
+private:
+    struct Context;
+
+#ifdef _WIN32
+    static void CALLBACK StatusCallback(HINTERNET handle, DWORD_PTR context, DWORD status, LPVOID info,
+                                        DWORD infoLength);
+    void OnStatus(Context* ctx, DWORD status, LPVOID info, DWORD infoLength);
+    void ReadNext(Context* ctx);
+    void Finish(Context* ctx, bool answered);
+    void Closed(Context* ctx);
+
+    HINTERNET session;
+    std::vector<HINTERNET> connections;   // nullptr where the connect failed
+    std::condition_variable drained;
+#else
+    struct Endpoint {
+        sockaddr_storage address;
+        socklen_t addressLength;           // 0 where the host did not resolve
+        std::string hostHeader;
+    };
+    struct Connection;
+
+    void Run();
+    void Wake();
+    void Assign(uint64_t id);
+    bool Open(Connection* connection);
+    void Flush(Connection* connection);
+    void Receive(Connection* connection);
+    void Drop(Connection* connection);
+    void Expire(uint64_t nowMs);
+    // Takes the id's context out of the table; nullptr once cancelled or done
+    Context* Take(uint64_t id);
+    void Complete(Context* ctx, PooledString response, uint32_t statusCode);
+
+    std::string userAgent;
+    std::vector<Endpoint> endpoints;
+    std::vector<Connection*> connections; // Loop thread only
+    std::deque<uint64_t> pending;         // Submitted, not yet on a connection
+    int epollFd;
+    int wakeFd;
+    std::thread loop;
+#endif
+    mutable std::mutex engineMutex;       // table, plus each context's finished/closed (WinHTTP) or pending (epoll)
+    RequestTable table;
+    std::atomic<bool> running;
+    bool http2Enabled;
+
+    std::atomic<uint64_t> submitted;
+    std::atomic<uint64_t> completed;
+    std::atomic<uint64_t> failed;
+    std::atomic<uint64_t> cancelled;
+    std::atomic<uint64_t> rejected;
+    std::atomic<uint64_t> http2Responses;
+};
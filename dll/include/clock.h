@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Millisecond time source for cache expiry, session lifetimes, request ages,
+// endpoint routing and hedge thresholds, and the one the worker's timed
+// waits run on. NowMs ticks wrap like GetTickCount, so compare them by
+// difference; Now does not wrap. TranslationClient runs on the system
+// clock; tools/policy_sim drives a VirtualClock so hours of traffic replay
+// deterministically in CPU time.
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual uint64_t Now() const = 0;
+    uint32_t NowMs() const { return static_cast<uint32_t>(Now()); }
+
+    // condition.wait_for on this clock's time: lock is released while
+    // waiting; returns ready() once it holds or timeoutMs has passed
+    virtual bool WaitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& condition,
+                         uint32_t timeoutMs, const std::function<bool()>& ready) = 0;
+    virtual void SleepFor(uint32_t ms) = 0;
+};
+
+// Monotonic wall time (steady_clock)
+class SystemClock : public Clock {
+public:
+    uint64_t Now() const override;
+    bool WaitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, uint32_t timeoutMs,
+                 const std::function<bool()>& ready) override;
+    void SleepFor(uint32_t ms) override;
+};
+
+// Time moves only when its owner advances it. Single-threaded: a wait
+// hands the time until its deadline to the wait handler (an
+// EventScheduler runs the events due meanwhile) and returns as soon as
+// ready() holds; without a handler the clock jumps to the deadline.
+class VirtualClock : public Clock {
+public:
+    typedef std::function<void(uint64_t deadlineMs, const std::function<bool()>& ready)> WaitHandler;
+
+    VirtualClock() : now(0) {}
+
+    uint64_t Now() const override { return now; }
+    // Never moves backwards
+    void AdvanceTo(uint64_t timeMs) {
+        if (timeMs > now) {
+            now = timeMs;
+        }
+    }
+
+    void SetWaitHandler(WaitHandler handler) { waitHandler = std::move(handler); }
+
+    bool WaitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, uint32_t timeoutMs,
+                 const std::function<bool()>& ready) override;
+    void SleepFor(uint32_t ms) override;
+
+private:
+    void Pass(uint64_t deadlineMs, const std::function<bool()>& ready);
+
+    uint64_t now;
+    WaitHandler waitHandler;
+};
+
+// Process-wide system clock, the default for TranslationClient
+Clock& GetSystemClock();
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Picks which proxy endpoint a request goes to. Each endpoint keeps an EWMA
+// of its round-trip time and of its error rate; requests go to the lowest
+// rtt * (1 + ERROR_PENALTY * errorRate). Consecutive failures eject an
+// endpoint for a cooldown that doubles while it keeps failing; once the
+// cooldown passes, one request probes it. Healthy endpoints that have not
+// answered for a while are re-measured with a single request, so one that
+// recovers wins its traffic back.
+//
+// Times are passed in (milliseconds) so a simulator can drive the same
+// router without a network. Thread-safe: chunk helpers and hedge lanes
+// route concurrently.
+enum class EndpointState {
+    UP = 0,
+    DOWN = 1,      // Ejected until its cooldown passes
+    PROBING = 2    // Cooldown passed; one request is testing it
+};
+
+struct EndpointStats {
+    std::string name;
+    EndpointState state;
+    uint32_t rttMs;          // EWMA of successful requests; 0 until measured
+    uint32_t errorPercent;   // EWMA of failures
+    uint64_t requests;
+    uint64_t failures;
+    uint64_t ejections;
+};
+
+// One routing decision; probe requests should use a short timeout
+struct EndpointChoice {
+    size_t endpoint;
+    bool probe;
+};
+
+class EndpointRouter {
+public:
+    static const size_t MAX_ENDPOINTS = 8;
+    static const size_t NO_ENDPOINT = static_cast<size_t>(-1);
+    static constexpr double RTT_WEIGHT = 0.2;       // EWMA weight of a new sample
+    static constexpr double ERROR_WEIGHT = 0.1;
+    static constexpr double ERROR_PENALTY = 4.0;    // 25% errors cost as much as double the RTT
+    static const uint32_t EJECT_AFTER_FAILURES = 3; // Consecutive
+    static const uint32_t BASE_COOLDOWN_MS = 5000;
+    static const uint32_t MAX_COOLDOWN_MS = 60000;
+    static const uint32_t REMEASURE_MS = 30000;     // Refresh an idle endpoint's RTT this often
+    static const uint32_t PROBE_TIMEOUT_MS = 3000;  // A probe must not stall the request for long
+    static const uint32_t MAX_ATTEMPTS = 3;         // Endpoints tried per request before giving up
+
+    EndpointRouter();
+
+    // Endpoints are added before the first Select and never removed
+    size_t Add(const std::string& name);
+    size_t Count() const;
+    std::string Name(size_t endpoint) const;
+
+    // Endpoint for a request starting at nowMs; endpoints whose bit is set in
+    // excluded (already tried for this request) are skipped. NO_ENDPOINT once
+    // every endpoint is excluded. When all are ejected the one due back
+    // first is used rather than failing the request outright.
+    EndpointChoice Select(uint64_t nowMs, uint32_t excluded = 0);
+    // rttMs is only used for successful requests
+    void Record(size_t endpoint, uint64_t nowMs, uint32_t rttMs, bool ok);
+    // Request on a probe choice that was cancelled before it could answer
+    void ReleaseProbe(size_t endpoint);
+
+    uint64_t GetFailovers() const;
+    void RecordFailover();
+    std::vector<EndpointStats> GetStats(uint64_t nowMs) const;
+
+private:
+    struct Endpoint {
+        std::string name;
+        double rttMs;          // < 0 until the first success
+        double errorRate;
+        uint32_t consecutiveFailures;
+        uint32_t cooldownMs;
+        uint64_t downUntilMs;
+        uint64_t lastUsedMs;
+        bool ejected;
+        bool probing;
+        uint64_t requests;
+        uint64_t failures;
+        uint64_t ejections;
+    };
+
+    double ScoreLocked(const Endpoint& endpoint) const;
+    void EjectLocked(Endpoint& endpoint, uint64_t nowMs);
+
+    mutable std::mutex routerMutex;
+    std::vector<Endpoint> endpoints;
+    uint64_t failovers;
+};
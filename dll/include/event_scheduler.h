@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "clock.h"
+
+// Deterministic discrete-event loop over a VirtualClock: events run in time
+// order, ties in the order they were scheduled, and the clock jumps
+// straight to each event. An event may schedule further events. Lets
+// tools/policy_sim replay traffic against the client's scheduling and cache
+// policies without threads, sleeps or a network. Waits on the clock run
+// the events due before their deadline, so code written against Clock
+// (the worker's idle wait) is driven by the schedule.
+class EventScheduler {
+public:
+    typedef std::function<void()> Event;
+
+    explicit EventScheduler(VirtualClock& clock);
+    ~EventScheduler();
+
+    EventScheduler(const EventScheduler&) = delete;
+    EventScheduler& operator=(const EventScheduler&) = delete;
+
+    // Times earlier than now run at now
+    void At(uint64_t timeMs, Event event);
+    void After(uint64_t delayMs, Event event);
+
+    // Runs every event due at or before endMs, then advances the clock to
+    // endMs; returns the number of events run
+    size_t RunUntil(uint64_t endMs);
+    // Same, but stops early after an event that makes done() true; the
+    // clock then stays at that event's time
+    size_t RunUntil(uint64_t endMs, const std::function<bool()>& done);
+
+    uint64_t Now() const { return clock.Now(); }
+    bool Empty() const { return events.empty(); }
+    uint64_t EventsRun() const { return eventsRun; }
+
+private:
+    struct Scheduled {
+        uint64_t timeMs;
+        uint64_t sequence;
+        Event event;
+    };
+
+    struct Later {
+        bool operator()(const Scheduled& a, const Scheduled& b) const {
+            return a.timeMs != b.timeMs ? a.timeMs > b.timeMs : a.sequence > b.sequence;
+        }
+    };
+
+    VirtualClock& clock;
+    std::priority_queue<Scheduled, std::vector<Scheduled>, Later> events;
+    uint64_t nextSequence;
+    uint64_t eventsRun;
+};
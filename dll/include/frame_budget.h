@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Game-thread time budget for the UnitXP bridge. Every WoWTranslate call runs
+// on WoW's render thread, so the bridge brackets each call and accumulates
+// the time spent per frame. Handlers ask Exhausted() before optional work and
+// degrade instead of hitching: poll batches end early, queue insertion is
+// deferred to a later frame and synchronous network translation is refused.
+//
+// Time is passed in (microseconds) so a harness can drive synthetic frames.
+// Frames are delimited by a per-frame hint from Lua (GetTime() is constant
+// within a frame); calls without a hint start a new frame after a quiet gap.
+// Game thread only; no locking.
+struct FrameBudgetStats {
+    uint32_t budgetMicros;       // 0 = unlimited
+    uint64_t frames;             // Frames with at least one bridge call
+    uint64_t overBudgetFrames;
+    uint64_t calls;
+    uint64_t maxFrameMicros;
+    uint64_t maxCallMicros;
+    uint64_t partialPolls;       // Poll batches cut short with results left
+    uint64_t deferredRequests;   // translate_async calls queued on a later frame
+    uint64_t refusedRequests;    // Synchronous translations refused a network fallback
+};
+
+struct BudgetOverrun {
+    uint64_t frame;
+    uint32_t frameMicros;
+    uint32_t callMicros;         // The most expensive call in the frame...
+    const char* cause;           // ...and its subcommand
+};
+
+class FrameBudget {
+public:
+    static const uint32_t DEFAULT_BUDGET_MICROS = 500;
+    static const uint32_t FRAME_GAP_MICROS = 4000;   // Hint-less calls further apart are new frames
+    static const size_t OVERRUN_HISTORY = 16;
+
+    explicit FrameBudget(uint32_t budgetMicros = DEFAULT_BUDGET_MICROS);
+
+    void SetBudgetMicros(uint32_t micros) { budgetMicros = micros; }
+    uint32_t GetBudgetMicros() const { return budgetMicros; }
+
+    // frameHint: a value constant within one frame, or 0 if unknown
+    void BeginCall(uint64_t nowMicros, double frameHint);
+    void EndCall(uint64_t nowMicros, const char* cause);
+
+    // True once this frame, including the running call, has used its budget
+    bool Exhausted(uint64_t nowMicros) const;
+
+    void RecordPartialPoll() { ++partialPolls; }
+    void RecordDeferred() { ++deferredRequests; }
+    void RecordRefused() { ++refusedRequests; }
+
+    FrameBudgetStats GetStats() const;
+    // Most recent overruns first; returns the number written
+    size_t GetOverruns(BudgetOverrun* out, size_t maxCount) const;
+
+private:
+    void CloseFrame();
+
+    uint32_t budgetMicros;
+    bool inFrame;
+    double frameHint;
+    uint64_t frameIndex;
+    uint64_t frameMicros;
+    uint64_t frameWorstCall;
+    const char* frameWorstCause;
+    uint64_t callStart;
+    uint64_t lastCallEnd;
+
+    uint64_t frames;
+    uint64_t overBudgetFrames;
+    uint64_t calls;
+    uint64_t maxFrameMicros;
+    uint64_t maxCallMicros;
+    uint64_t partialPolls;
+    uint64_t deferredRequests;
+    uint64_t refusedRequests;
+
+    BudgetOverrun overruns[OVERRUN_HISTORY];
+    size_t overrunCount;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Fast 64-bit non-cryptographic hash (wyhash construction).
+// Used for cache keys and on-disk tables, so the output must stay stable
+// across builds: do not change constants without bumping file format versions.
+
+namespace wthash {
+
+static const uint64_t P0 = 0xa0761d6478bd642fULL;
+static const uint64_t P1 = 0xe7037ed1a0b428dbULL;
+static const uint64_t P2 = 0x8ebc6af09c88c6e3ULL;
+static const uint64_t P3 = 0x589965cc75374cc3ULL;
+
+// 64x64 -> 128 multiply, portable to 32-bit MSVC (no _umul128 on x86)
+inline void Mum(uint64_t& a, uint64_t& b) {
+    uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t carry = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+    a = lo;
+    b = hi;
+}
+
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+    Mum(a, b);
+    return a ^ b;
+}
+
+inline uint64_t Read8(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint64_t Read4(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+inline uint64_t Read3(const uint8_t* p, size_t k) {
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[k >> 1]) << 8) | p[k - 1];
+}
+
+} // namespace wthash
+
+inline uint64_t HashBytes(const void* key, size_t len, uint64_t seed = 0) {
+    using namespace wthash;
+    const uint8_t* p = static_cast<const uint8_t*>(key);
+    seed ^= Mix(seed ^ P0, P1);
+    uint64_t a, b;
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (Read4(p) << 32) | Read4(p + ((len >> 3) << 2));
+            b = (Read4(p + len - 4) << 32) | Read4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = Read3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = Mix(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+                see1 = Mix(Read8(p + 16) ^ P2, Read8(p + 24) ^ see1);
+                see2 = Mix(Read8(p + 32) ^ P3, Read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = Mix(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = Read8(p + i - 16);
+        b = Read8(p + i - 8);
+    }
+
+    a ^= P1;
+    b ^= seed;
+    Mum(a, b);
+    return Mix(a ^ P0 ^ len, b ^ P1);
+}
+
+inline uint64_t HashText(std::string_view text, uint64_t seed = 0) {
+    return HashBytes(text.data(), text.size(), seed);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// When to send a duplicate of a slow proxy request. The threshold adapts to
+// the observed latency (a percentile of recent requests), and a token bucket
+// keeps duplicates under a share of all requests: each request earns
+// budgetPercent / 100 of a token, each hedge spends one.
+//
+// Latencies are passed in (milliseconds) so a simulator can drive the same
+// policy without a network. Thread-safe: chunk helpers hedge concurrently.
+struct HedgeStats {
+    bool enabled;
+    uint32_t budgetPercent;
+    uint32_t thresholdMs;        // 0 until enough samples have been seen
+    uint64_t requests;
+    uint64_t hedges;             // Duplicates sent
+    uint64_t hedgeWins;          // Duplicates that answered first
+    uint64_t budgetDenied;       // Past the threshold but out of tokens
+};
+
+class HedgePolicy {
+public:
+    static const uint32_t DEFAULT_BUDGET_PERCENT = 5;
+    static const uint32_t DEFAULT_PERCENTILE = 95;
+    static const size_t SAMPLE_WINDOW = 256;       // Recent latencies kept
+    static const size_t MIN_SAMPLES = 20;          // No hedging before this many
+    static const uint32_t MIN_THRESHOLD_MS = 50;   // Never hedge sooner
+    static const uint32_t MAX_BURST_TOKENS = 10;
+
+    HedgePolicy();
+
+    void Configure(bool enabled, uint32_t budgetPercent);
+    bool IsEnabled() const;
+
+    // A request is about to be sent; returns the hedge delay in ms, or 0
+    // when this request must not be hedged (disabled or still warming up)
+    uint32_t BeginRequest();
+    // The delay passed and the request is still running; spends a token
+    bool TryHedge();
+    // latencyMs of the first answer (for a cancelled primary, a lower bound)
+    void RecordLatency(uint32_t latencyMs);
+    void RecordHedgeWin();
+
+    HedgeStats GetStats() const;
+
+private:
+    uint32_t ThresholdLocked() const;
+
+    mutable std::mutex policyMutex;
+    bool enabled;
+    uint32_t budgetPercent;
+    uint32_t samples[SAMPLE_WINDOW];
+    size_t sampleCount;
+    size_t nextSample;
+    mutable uint32_t cachedThreshold;
+    mutable bool thresholdStale;
+    double tokens;
+    uint64_t requests;
+    uint64_t hedges;
+    uint64_t hedgeWins;
+    uint64_t budgetDenied;
+};
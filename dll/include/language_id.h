@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string_view>
+
+// Compact statistical language identification for chat lines. Script
+// counts settle Korean, Japanese (kana or Japanese-only kanji), Chinese and
+// Russian; Latin-script text, including pinyin and romanized Russian, is
+// scored against character-trigram profiles embedded as constexpr tables.
+
+// Source language value that asks the DLL to identify the language itself
+static constexpr std::string_view AUTO_LANGUAGE = "auto";
+
+struct LanguageGuess {
+    std::string_view language;   // Static language code, empty when undetermined
+    float confidence;            // 0..1
+};
+
+LanguageGuess IdentifyLanguage(std::string_view text);
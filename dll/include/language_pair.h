@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Language pairs ("zh" -> "en") are interned to a small integer at the
+// UnitXP boundary so requests and cache keys carry an ID instead of two strings.
+typedef uint16_t LanguagePairId;
+
+struct LanguagePair {
+    std::string source;
+    std::string target;
+};
+
+static const LanguagePairId DEFAULT_LANGUAGE_PAIR = 0;   // zh -> en
+static const LanguagePairId INVALID_LANGUAGE_PAIR = 0xFFFF;
+static const size_t MAX_LANGUAGE_PAIRS = 64;
+
+// Letters, digits, '-' and '_', 1-16 characters
+bool IsValidLanguageCode(std::string_view code);
+// Returns INVALID_LANGUAGE_PAIR for malformed codes or when the table is full
+LanguagePairId InternLanguagePair(std::string_view source, std::string_view target);
+const LanguagePair& GetLanguagePair(LanguagePairId id);
+
+// True for Chinese, Japanese and Korean codes ("zh", "zh-TW", "ja", "ko")
+bool IsCjkLanguage(std::string_view code);
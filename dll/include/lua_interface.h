@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 // Lua C API function pointers (following UnitXP_SP3 pattern)
@@ -23,13 +24,17 @@ int __fastcall detoured_UnitXP(void* L);
 // Lua interface functions
 bool InitializeLuaInterface();
 void CleanupLuaInterface();
+// Logs the hook install result; InitializeLuaInterface runs before logging starts
+void LogHookInstall();
 
 // Helper functions for Lua interaction
 void lua_pushstring(void* L, const std::string& str);
+void lua_pushstring(void* L, const char* str);
 void lua_pushboolean(void* L, bool value);
 void lua_pushnumber(void* L, double value);
 void lua_pushnil(void* L);
 std::string lua_tostring(void* L, int index);
+std::string_view lua_tostringview(void* L, int index);
 double lua_tonumber(void* L, int index);
 bool lua_toboolean(void* L, int index);
 int lua_gettop(void* L);
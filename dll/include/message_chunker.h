@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Long-message splitting for parallel translation: guild MOTD pastes and
+// DKP rules are cut at sentence ends (or clause breaks, as a last resort at a
+// codepoint) into chunks of at most maxChunkBytes, so each chunk is its own
+// request and cache entry. Chunks are trimmed views into text, in order.
+std::vector<std::string_view> SplitLongMessage(std::string_view text, size_t maxChunkBytes);
+
+// Reassembles chunk translations in order; CJK targets are joined without spaces
+void JoinChunkTranslations(std::string& out, std::string_view translation, bool cjkTarget);
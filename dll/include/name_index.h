@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+
+#include "mapped_file.h"
+#include "name_index_format.h"
+
+// Read-only index of item and quest names by ID, memory-mapped from a file
+// built by tools/name_index_builder. Lets hyperlinks be shown in the
+// reader's language without the game's item cache or an addon database.
+// Lookups return views into the mapping: no allocation and no locking.
+struct NameIndexStats {
+    size_t items;
+    size_t quests;
+    size_t mappedBytes;
+    uint64_t openMicros;       // Time taken to map and validate the file
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t lookupNanos;      // Includes whole batches, so divide by hits + misses
+};
+
+class NameIndex {
+public:
+    NameIndex();
+
+    // Maps and validates the file; false (and stays closed) on any format error
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return header != nullptr; }
+
+    // False if the ID is unknown or has no name in that language
+    bool Lookup(NameKind kind, uint32_t id, NameLanguage language, std::string_view& name) const;
+
+    // Stats are recorded by the caller so a batch is timed once
+    void RecordLookups(uint64_t hitCount, uint64_t missCount, uint64_t nanos);
+    NameIndexStats GetStats() const;
+
+private:
+    MappedFile file;
+    const NameIndexHeader* header;
+    const NameIndexEntry* tables[NAME_KIND_COUNT];
+    const uint32_t* pages[NAME_KIND_COUNT];
+    uint32_t pageCounts[NAME_KIND_COUNT];
+    uint32_t counts[NAME_KIND_COUNT];
+    uint32_t pageShift;
+    const char* strings;
+    uint64_t openMicros;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> lookupNanos;
+};
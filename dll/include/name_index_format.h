@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of the prebuilt item/quest name index
+// (WoWTranslate_names.wtni), shared by the DLL reader and
+// tools/name_index_builder.
+//
+//   NameIndexHeader
+//   uint32_t itemPages[itemPageCount + 1]
+//   uint32_t questPages[questPageCount + 1]
+//   NameIndexEntry items[itemCount]     (sorted by id)
+//   NameIndexEntry quests[questCount]   (sorted by id)
+//   char strings[stringBytes]           (UTF-8 names, identical names stored once)
+//
+// IDs are dense, so each table is split into pages of 2^pageShift IDs:
+// pages[id >> pageShift] is the first entry of that page and the next
+// element ends it, leaving a short binary search within one cache line or
+// two. Each entry holds one name per NameLanguage; a zero length means the
+// name is unknown in that language.
+
+static const char NAME_INDEX_MAGIC[4] = { 'W', 'T', 'N', 'I' };
+static const uint32_t NAME_INDEX_VERSION = 1;
+static const uint32_t NAME_INDEX_PAGE_SHIFT = 5;     // 32 IDs per page
+
+enum NameKind : uint32_t {
+    NAME_KIND_ITEM = 0,
+    NAME_KIND_QUEST = 1,
+    NAME_KIND_COUNT = 2
+};
+
+enum NameLanguage : uint32_t {
+    NAME_LANGUAGE_EN = 0,
+    NAME_LANGUAGE_ZH = 1,
+    NAME_LANGUAGE_COUNT = 2
+};
+
+#pragma pack(push, 1)
+struct NameIndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t itemCount;
+    uint32_t questCount;
+    uint32_t pageShift;
+    uint32_t itemPageCount;
+    uint32_t questPageCount;
+    uint32_t pageOffset;         // Byte offsets from the start of the file
+    uint32_t entryOffset;
+    uint32_t stringOffset;
+    uint32_t stringBytes;
+};
+
+struct NameIndexEntry {
+    uint32_t id;
+    uint32_t nameOffset[NAME_LANGUAGE_COUNT];  // Relative to stringOffset
+    uint16_t nameLength[NAME_LANGUAGE_COUNT];
+};
+#pragma pack(pop)
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "language_pair.h"
+#include "payload_pool.h"
+
+// Near-duplicate index over recent translations. Messages are fingerprinted
+// with a 64-bit SimHash of character trigrams; a new message whose
+// fingerprint is within maxDistance bits of a cached one (and of similar
+// length) reuses that translation instead of going to the proxy.
+struct NearDuplicateStats {
+    size_t entries;
+    uint64_t queries;
+    uint64_t matches;
+    uint64_t scanNanos;        // Total time spent in FindNearest()
+};
+
+class NearDuplicateIndex {
+public:
+    explicit NearDuplicateIndex(size_t capacity);
+
+    static uint64_t Fingerprint(std::string_view normalizedText);
+
+    // Messages shorter than this many characters are never matched
+    static const size_t MIN_CHARS = 12;
+
+    bool FindNearest(std::string_view normalizedText, LanguagePairId pair, int maxDistance,
+                     PooledString& translation, int& distance);
+    void Insert(std::string_view normalizedText, LanguagePairId pair, std::string_view translation);
+    void Clear();
+
+    NearDuplicateStats GetStats();
+
+private:
+    struct Entry {
+        uint32_t chars;
+        LanguagePairId pair;
+        std::string translation;
+    };
+
+    // Fingerprints are kept in their own array so a lookup is one linear scan
+    std::vector<uint64_t> fingerprints;
+    std::vector<Entry> entries;
+    size_t capacity;
+    size_t nextSlot;
+    std::mutex indexMutex;
+    uint64_t queries;
+    uint64_t matches;
+    uint64_t scanNanos;
+};
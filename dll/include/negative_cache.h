@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "language_pair.h"
+#include "payload_pool.h"
+
+// Short-lived memory of lines the proxy could not usefully translate: it
+// handed the text back unchanged, or rejected it with an error that does not
+// depend on credits, the key or the network. A repeat of the line within the
+// TTL is answered the same way without a request. The TTLs are short so a
+// one-off proxy hiccup, or a fixed server, is not remembered for long.
+enum class NegativeResult : uint8_t {
+    UNCHANGED = 0,   // The proxy returned the input as-is
+    REJECTED = 1     // The proxy answered with a per-text error
+};
+
+struct NegativeCacheStats {
+    size_t entries;
+    uint64_t unchangedHits;
+    uint64_t rejectedHits;
+    uint64_t inserts;
+};
+
+class NegativeCache {
+public:
+    static const size_t MAX_ENTRIES = 256;
+    static const uint32_t UNCHANGED_TTL_MS = 600000;   // 10 minutes
+    static const uint32_t REJECTED_TTL_MS = 60000;     // 1 minute
+
+    NegativeCache();
+
+    // Keys are normalized cache-key text, as for TranslationCache.
+    // error receives the proxy's error text for REJECTED entries.
+    bool Lookup(std::string_view text, LanguagePairId pair, uint32_t now, NegativeResult& kind, PooledString& error);
+    void Insert(std::string_view text, LanguagePairId pair, NegativeResult kind, std::string_view error, uint32_t now);
+    // Lookup without counting a hit
+    bool Contains(std::string_view text, LanguagePairId pair, uint32_t now);
+    // Lock-free check so callers can skip normalizing the text while nothing is remembered
+    bool Empty() const { return count.load(std::memory_order_relaxed) == 0; }
+    void Clear();
+
+    NegativeCacheStats GetStats();
+
+private:
+    struct Entry {
+        std::string source;
+        std::string error;
+        uint32_t timestamp;
+        uint32_t ttlMs;
+        LanguagePairId pair;
+        NegativeResult kind;
+    };
+
+    struct IdentityHash {
+        size_t operator()(uint64_t key) const { return static_cast<size_t>(key ^ (key >> 32)); }
+    };
+
+    void EvictLocked(uint32_t now);
+
+    std::unordered_map<uint64_t, Entry, IdentityHash> entries;
+    std::mutex cacheMutex;
+    std::atomic<size_t> count;
+    uint64_t unchangedHits;
+    uint64_t rejectedHits;
+    uint64_t inserts;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+
+// Local word-by-word fallback translator for when the proxy cannot be used
+// (offline, out of credits) or a short message is fully covered locally.
+// CJK text is segmented by forward maximum matching against a dictionary
+// of words and phrases; each match is replaced by its gloss in source order
+// (no reordering), unknown characters pass through. Results are approximate.
+struct OfflineEngineStats {
+    size_t entries;
+    size_t approximateBytes;
+    uint64_t translations;
+    uint64_t fullCoverage;     // Translations where every CJK character matched
+    uint64_t glossNanos;       // Total time spent in Gloss()
+};
+
+class OfflineEngine {
+public:
+    // Seeded with a built-in glossary of common zh -> en chat terms
+    OfflineEngine();
+
+    // Adds word<TAB>gloss lines ('#' comments); returns entries added, -1 if unreadable
+    int LoadDictionary(const std::string& path);
+
+    // Returns false when the text has nothing the dictionary could match.
+    // fullCoverage is true when every CJK character was covered by an entry.
+    bool Gloss(std::string_view text, std::string& out, bool& fullCoverage);
+
+    OfflineEngineStats GetStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::string gloss;
+    };
+
+    bool Add(std::string_view key, std::string_view gloss);
+    const Entry* Find(std::string_view key) const;
+
+    std::vector<Entry> entries;
+    std::unordered_map<uint64_t, uint32_t> index;
+    size_t maxKeyChars;
+    size_t entryBytes;
+    std::atomic<uint64_t> translations;
+    std::atomic<uint64_t> fullCoverage;
+    std::atomic<uint64_t> glossNanos;
+};
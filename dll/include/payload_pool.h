@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Size-class slab pool for per-message payloads (request text, request body,
+// response buffer, translation and error strings).
+// Blocks are carved from 64 KB slabs taken straight from the OS, outside the
+// CRT heap, so in the 32-bit client they never fragment it. Each thread
+// keeps a small free list per class and only takes the pool mutex to move a
+// batch; a slab whose blocks have all come back is released, keeping one
+// spare per class, so the footprint follows the working set down again
+// after a burst. Counters lag by at most one batch per thread.
+struct PayloadPoolStats {
+    uint64_t allocations;      // Total Allocate() calls
+    uint64_t recycled;         // Allocations not served from fresh slab space
+    uint64_t oversize;         // Allocations too large for any size class
+    size_t bytesInUse;         // Bytes out of slabs, thread caches included (size-class rounded)
+    size_t peakBytesInUse;     // High-water mark of bytesInUse
+    size_t slabBytes;          // Bytes currently held in slabs
+    uint64_t slabsReleased;    // Drained slabs given back to the OS
+};
+
+class PayloadPool {
+public:
+    static void* Allocate(size_t bytes);
+    static void Deallocate(void* ptr, size_t bytes);
+    static PayloadPoolStats GetStats();
+    // Returns the calling thread's cached blocks to the pool (e.g. once
+    // the game thread has handed every finished result to the addon)
+    static void ReleaseThreadCache();
+
+    static constexpr size_t MAX_POOLED_SIZE = 16384;
+};
+
+// Minimal std allocator backed by PayloadPool
+template <typename T>
+struct PoolAllocator {
+    typedef T value_type;
+
+    PoolAllocator() noexcept {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(PayloadPool::Allocate(n * sizeof(T)));
+    }
+    void deallocate(T* ptr, size_t n) noexcept {
+        PayloadPool::Deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return true; }
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return false; }
+
+typedef std::basic_string<char, std::char_traits<char>, PoolAllocator<char>> PooledString;
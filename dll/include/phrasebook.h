@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+
+#include "mapped_file.h"
+#include "phrasebook_format.h"
+
+// Read-only phrasebook of common chat phrases, memory-mapped from a file
+// built by tools/phrasebook_builder. Lookups return views into the mapping:
+// no allocation and no locking.
+struct PhrasebookStats {
+    size_t entries;
+    size_t mappedBytes;
+    uint64_t openMicros;       // Time taken to map and validate the file
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t lookupNanos;
+};
+
+class Phrasebook {
+public:
+    Phrasebook();
+
+    // Maps and validates the file; false (and stays closed) on any format error
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return header != nullptr; }
+    std::string_view SourceLanguage() const;
+    std::string_view TargetLanguage() const;
+
+    // normalizedKey must already be normalized with NormalizeForCache
+    bool Lookup(std::string_view normalizedKey, std::string_view& translation);
+    // Lookup without counting a hit or miss
+    bool Contains(std::string_view normalizedKey) const;
+
+    PhrasebookStats GetStats() const;
+
+private:
+    MappedFile file;
+    const PhrasebookHeader* header;
+    const uint32_t* displacements;
+    const PhrasebookEntry* entries;
+    const char* strings;
+    uint64_t openMicros;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> lookupNanos;
+};
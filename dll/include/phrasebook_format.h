@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "hash.h"
+
+// On-disk layout of the prebuilt phrasebook (WoWTranslate_phrasebook.wtpb),
+// shared by the DLL reader and tools/phrasebook_builder.
+//
+//   PhrasebookHeader
+//   uint32_t displacements[bucketCount]
+//   PhrasebookEntry entries[entryCount]     (indexed by perfect-hash slot)
+//   char strings[stringBytes]               (keys sorted, then values)
+//
+// Keys are stored normalized with NormalizeForCache. Lookups use a
+// hash-and-displace minimal perfect hash: the key's bucket selects a
+// displacement seed, which places it in a unique slot; the stored key is
+// compared to reject strings that are not in the book.
+
+static const char PHRASEBOOK_MAGIC[4] = { 'W', 'T', 'P', 'B' };
+static const uint32_t PHRASEBOOK_VERSION = 1;
+static const uint64_t PHRASEBOOK_BUCKET_SEED = 0x5048524153454231ULL;
+
+#pragma pack(push, 1)
+struct PhrasebookHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t bucketCount;
+    char sourceLang[8];          // NUL-padded language codes
+    char targetLang[8];
+    uint32_t displacementOffset; // Byte offsets from the start of the file
+    uint32_t entryOffset;
+    uint32_t stringOffset;
+    uint32_t stringBytes;
+};
+
+struct PhrasebookEntry {
+    uint32_t keyOffset;          // Relative to stringOffset
+    uint32_t keyLength;
+    uint32_t valueOffset;
+    uint32_t valueLength;
+};
+#pragma pack(pop)
+
+inline uint32_t PhrasebookBucket(std::string_view key, uint32_t bucketCount) {
+    return static_cast<uint32_t>(HashText(key, PHRASEBOOK_BUCKET_SEED) % bucketCount);
+}
+
+inline uint32_t PhrasebookSlot(std::string_view key, uint32_t displacement, uint32_t entryCount) {
+    return static_cast<uint32_t>(HashText(key, displacement) % entryCount);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string_view>
+
+// Pre-flight check run before a message is queued: chat lines with nothing
+// a translator could change are answered locally with the text as-is.
+// A line is skipped only when every part of it is one of the kinds below;
+// a single ordinary word sends it to the proxy as before.
+enum class PreflightClass {
+    TRANSLATE = 0,    // Has words; goes to the proxy
+    NUMBERS,          // Digits, prices ("50g", "x5") and punctuation only
+    COORDINATES,      // Two numbers such as "45.2, 67.8"
+    RAID_MARKERS,     // {skull}, {rt1}, ...
+    LINKS,            // Item/quest hyperlinks or the addon's link placeholders
+    EMOTICONS,        // xD, T_T, \o/ ...
+    ABBREVIATIONS     // Raid and chat shorthand both communities write in Latin letters (MC, LFM, DPS ...)
+};
+
+static const int PREFLIGHT_CLASS_COUNT = 7;
+
+// Allocation-free single pass; the class names the most specific kind seen
+PreflightClass ClassifyMessage(std::string_view text);
+const char* PreflightClassName(PreflightClass kind);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// Push delivery of finished translations. Results are handed over at a
+// known top-of-frame point: while requests are pending, the addon's OnUpdate
+// makes one "push tick" UnitXP call per frame, and the tick answers whether
+// to drain with poll_batch now. Lua never runs from inside the message pump,
+// which modal and nested loops (window drags, dialogs) also spin. An idle
+// tick is two branches; drains are spaced MIN_INTERVAL_US apart so one cut
+// short by the frame budget resumes on the next frame. Polling at the full
+// rate stays available as the fallback.
+//
+// Game thread only: enabled and ticked through UnitXP.
+struct PushDeliveryStats {
+    bool enabled;
+    uint64_t checks;           // Ticks while enabled
+    uint64_t deliveries;       // Ticks that told the addon to drain
+    uint64_t throttled;        // Results waiting but the previous drain was too recent
+};
+
+class PushDelivery {
+public:
+    static const uint64_t MIN_INTERVAL_US = 8000;   // About half a frame at 60 fps
+
+    PushDelivery();
+
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return enabled; }
+
+    // Per tick: true when the addon should drain its results now
+    bool ShouldDeliver(uint64_t nowUs, bool resultsWaiting);
+
+    PushDeliveryStats GetStats() const;
+
+private:
+    bool enabled;
+    bool delivered;
+    uint64_t lastDeliveryUs;
+    uint64_t checks;
+    uint64_t deliveries;
+    uint64_t throttled;
+};
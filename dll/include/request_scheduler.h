@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "clock.h"
+#include "language_pair.h"
+#include "payload_pool.h"
+#include "scheduling_policy.h"
+
+// Result flags reported to the addon alongside a translation
+enum TranslationFlags : uint32_t {
+    TRANSLATION_FLAG_NONE = 0,
+    TRANSLATION_FLAG_NEAR_DUPLICATE = 1 << 0,  // Reused from a similar earlier message
+    TRANSLATION_FLAG_SAME_LANGUAGE = 1 << 1,   // Detected language already is the target; text returned as-is
+    TRANSLATION_FLAG_UNDETERMINED = 1 << 2,    // "auto" source could not be identified; text returned as-is
+    TRANSLATION_FLAG_APPROXIMATE = 1 << 3,     // Word-by-word gloss from the offline engine
+    TRANSLATION_FLAG_UNCHANGED = 1 << 4,       // Nothing to translate, or the proxy just returned it as-is; text returned as-is
+    TRANSLATION_FLAG_PARTIAL = 1 << 5          // Streamed sentences so far; the final result follows under the same id
+};
+
+// Details of how a result was produced, passed back with it
+struct TranslationInfo {
+    uint32_t flags;                    // TranslationFlags
+    std::string_view detectedLanguage; // Static code from IdentifyLanguage when the source was "auto"
+    float confidence;
+    uint32_t partialSequence;          // 1, 2, ... on TRANSLATION_FLAG_PARTIAL results
+
+    TranslationInfo() : flags(TRANSLATION_FLAG_NONE), confidence(0.0f), partialSequence(0) {}
+};
+
+// One translation POST on the async HTTP engine (translator_core.h)
+struct AsyncCall;
+
+// Async translation request
+struct AsyncRequest {
+    std::string requestId;
+    PooledString text;
+    LanguagePairId languagePair;
+    uint32_t timestamp;       // Clock tick at enqueue
+    uint64_t traceEnqueueUs;  // 0 unless tracing was enabled at enqueue
+    TranslationInfo info;     // Language detection done at enqueue
+    std::string supersedeKey; // A newer request with the same key replaces this one
+    std::vector<std::string> followers;  // Identical requests answered with this one's result
+    std::vector<LanguagePairId> fanOut;  // All targets of a multi-target request (languagePair is the first)
+    std::shared_ptr<AsyncCall> prefetch; // Sent while still queued; answered when its turn comes
+    bool prefetchChecked;                // Considered for prefetching already
+
+    AsyncRequest() : languagePair(DEFAULT_LANGUAGE_PAIR), timestamp(0), traceEnqueueUs(0), prefetchChecked(false) {}
+    AsyncRequest(const std::string& id, std::string_view t, LanguagePairId pair = DEFAULT_LANGUAGE_PAIR,
+                 const TranslationInfo& detected = TranslationInfo(), std::string_view key = std::string_view())
+        : requestId(id), text(t.data(), t.size()), languagePair(pair), timestamp(0), traceEnqueueUs(0),
+          info(detected), supersedeKey(key), prefetchChecked(false) {}
+};
+
+// The request the worker is translating right now. Cancelling it cancels
+// its calls on the async engine (a prefetch, one per chunk of a long
+// message, the request itself) so the waits return early. Without the
+// engine a request runs to its end on its own thread and the answer is
+// dropped there.
+struct InFlightRequest {
+    bool active;
+    bool leaderCancelled;  // requestId already answered as cancelled/superseded
+    bool abandoned;        // No one wants the result; HTTP is being aborted
+    std::vector<LanguagePairId> fanOut;  // Multi-target request; never shared with single requests
+    std::string requestId;
+    std::string supersedeKey;
+    std::string_view text;
+    LanguagePairId languagePair;
+    std::vector<std::string> followers;
+    std::shared_ptr<AsyncCall> prefetch;                 // Sent while the request was queued
+    std::vector<std::shared_ptr<AsyncCall>> asyncCalls;  // Requests and chunks on the async engine
+
+    InFlightRequest() : active(false), leaderCancelled(false), abandoned(false),
+                        languagePair(DEFAULT_LANGUAGE_PAIR) {}
+};
+
+// The async path's queue and the worker's turn through it, under the
+// rules of a SchedulingPolicy: an identical single-target request joins
+// one already queued or in flight, requests start oldest first, and the
+// idle worker waits for an enqueue or polls, on the injected Clock.
+// TranslationClient runs its requests through this; tools/policy_sim
+// replays traffic through the same code on a VirtualClock.
+//
+// Not locked: the owner holds its request mutex around every call and
+// hands it to WaitForWork.
+class RequestScheduler {
+public:
+    RequestScheduler(const SchedulingPolicy& policy, Clock& clock);
+
+    const SchedulingPolicy& Policy() const { return policy; }
+
+    // Adds requestId to the followers of an identical single-target request
+    // queued or in flight; returns that request's id, or nullptr when there
+    // is none (or sharing is off) and the request has to be queued
+    const std::string* Join(const std::string& requestId, std::string_view text, LanguagePairId languagePair);
+    // Queues request behind the others and wakes the worker
+    void Enqueue(AsyncRequest request);
+
+    // Moves the oldest queued request into request and makes it the one in
+    // flight (inFlight.text views request.text); false when none is queued
+    bool StartNext(AsyncRequest& request);
+    // Ends the in-flight request; returns everyone waiting on its result,
+    // leaderId first unless it was cancelled
+    std::vector<std::string> Finish(const std::string& leaderId);
+
+    // Idle worker, lock held: returns once a request is queued or stop()
+    // holds (wakeOnEnqueue), or after one idleWaitMs poll
+    void WaitForWork(std::unique_lock<std::mutex>& lock, const std::function<bool()>& stop);
+    // Wakes a waiting worker to check stop()
+    void WakeWorker();
+
+    std::deque<AsyncRequest> queued;   // Oldest first
+    InFlightRequest inFlight;
+
+private:
+    const SchedulingPolicy policy;
+    Clock& clock;
+    std::condition_variable workAvailable;  // Signalled on enqueue when policy.wakeOnEnqueue
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Slots for requests in flight on the async HTTP engine. Each slot carries
+// the request's context and a read buffer kept for the next request, so a
+// request in flight costs a slot rather than a thread and its stack. Ids
+// hold a 48-bit generation next to the slot index, so a late completion or
+// cancel for a request that already finished finds nothing: the generation
+// does not repeat within the life of the process. Not locked: the owner
+// serialises access.
+class RequestTable {
+public:
+    static constexpr size_t READ_BUFFER_BYTES = 4096;
+    static constexpr size_t MAX_CAPACITY = 0xFFFF;
+
+    explicit RequestTable(size_t capacity);
+
+    // Returns 0 when every slot is in use
+    uint64_t Acquire(void* context);
+    // nullptr once the id was released
+    void* Find(uint64_t id) const;
+    char* Buffer(uint64_t id);
+    // Returns the context the id held, or nullptr
+    void* Release(uint64_t id);
+    // Ids of every request in flight
+    void CollectIds(std::vector<uint64_t>& ids) const;
+
+    size_t InFlight() const { return inFlight; }
+    size_t Peak() const { return peak; }
+    size_t Capacity() const { return slots.size(); }
+    // Table memory for slots whose buffers have been allocated
+    size_t BytesAllocated() const;
+
+private:
+    struct Slot {
+        uint64_t id;        // 0 when free
+        void* context;
+        std::unique_ptr<char[]> buffer;   // Allocated on first use
+    };
+
+    const Slot* Lookup(uint64_t id) const;
+
+    std::vector<Slot> slots;
+    std::vector<uint16_t> freeSlots;
+    uint64_t generation;
+    size_t inFlight;
+    size_t peak;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Queueing and caching choices of the async translation path, gathered so
+// tools/policy_sim can replay traffic against alternatives with the same
+// fields TranslationClient is built with. The defaults are what the DLL uses.
+struct SchedulingPolicy {
+    static const size_t DEFAULT_CACHE_ENTRIES = 500;
+    static const uint32_t DEFAULT_CACHE_EXPIRY_MS = 3600000;  // 1 hour
+    static const uint32_t DEFAULT_IDLE_WAIT_MS = 50;
+
+    bool wakeOnEnqueue;       // A new request wakes the idle worker; otherwise it polls every idleWaitMs
+    uint32_t idleWaitMs;      // Longest idle wait before the worker checks the queue again
+    bool coalesceIdentical;   // Identical text queued or in flight shares one proxy request
+    size_t cacheEntries;      // DLL cache capacity (trimmed to half when exceeded)
+    uint32_t cacheExpiryMs;
+
+    SchedulingPolicy()
+        : wakeOnEnqueue(true), idleWaitMs(DEFAULT_IDLE_WAIT_MS), coalesceIdentical(true),
+          cacheEntries(DEFAULT_CACHE_ENTRIES), cacheExpiryMs(DEFAULT_CACHE_EXPIRY_MS) {}
+};
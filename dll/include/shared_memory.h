@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Named read-write shared memory visible to every process on the host that
+// opens the same name ("Local\" session namespace on Windows, shm_open on
+// POSIX). New regions start zero-filled; callers coordinate initialization
+// through their own header.
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion();
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    // Creates the region or attaches to an existing one of the same size
+    bool Open(const std::string& name, size_t size);
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+    // Drops the name so the next Open starts from a fresh, zeroed region.
+    // Windows frees the region with its last handle, so this is POSIX-only work.
+    static void Remove(const std::string& name);
+
+private:
+    unsigned char* data;
+    size_t size;
+#ifdef _WIN32
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+};
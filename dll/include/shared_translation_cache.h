@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+
+#include "payload_pool.h"
+#include "shared_memory.h"
+
+// Host-wide translation cache tier for multiboxing: every DLL instance maps
+// the same fixed-size open-addressing table. Slots are seqlock-protected, so
+// readers never block and writers only try-lock the slot they replace. A
+// small claim table gives best-effort cross-process single-flight: the first
+// client to miss a line fetches it, the others wait for its publish.
+//
+// Keys hash the language codes, not LanguagePairId, since pair IDs are
+// interned per process. Times come from steady_clock, which is system-wide
+// (QueryPerformanceCounter / CLOCK_MONOTONIC), so expiry agrees across clients.
+struct SharedCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t publishes;
+    uint64_t waits;        // Another client held the claim
+    uint64_t waitHits;     // ...and published before the wait timed out
+    uint64_t lookupNanos;  // Total time spent in Lookup()
+};
+
+class SharedTranslationCache {
+public:
+    static const uint32_t SLOT_COUNT = 4096;          // Power of two
+    static const uint32_t CLAIM_COUNT = 256;          // Power of two
+    static const uint32_t MAX_PROBE = 8;
+    static const uint32_t SLOT_DATA_BYTES = 1000;     // Source + translation per slot
+
+    explicit SharedTranslationCache(uint32_t expiryMs);
+
+    // Attach to (or create) the named table; false if shared memory is unavailable
+    bool Open(const std::string& name);
+    void Close();
+    bool IsOpen() const { return header != nullptr; }
+
+    bool Lookup(std::string_view text, std::string_view source, std::string_view target,
+                PooledString& translation);
+    // Publishing also releases the claim TryClaim handed out, if any
+    void Publish(std::string_view text, std::string_view source, std::string_view target,
+                 std::string_view translation, uint64_t claim);
+
+    // True if this process should fetch the line; false if another client
+    // holds a live claim and WaitFor should be used instead. claim is set
+    // nonzero only when this call took the line's claim; fetching without
+    // one (the probe window was full) leaves it 0.
+    bool TryClaim(std::string_view text, std::string_view source, std::string_view target,
+                  uint64_t& claim);
+    // Releases only the claim TryClaim returned, never a later owner's
+    void ReleaseClaim(std::string_view text, std::string_view source, std::string_view target,
+                      uint64_t claim);
+    // Polls until the claimant publishes or its claim lapses (at most timeoutMs)
+    bool WaitFor(std::string_view text, std::string_view source, std::string_view target,
+                 uint32_t timeoutMs, PooledString& translation);
+
+    SharedCacheStats GetStats() const;
+
+    static uint64_t MakeKey(std::string_view text, std::string_view source, std::string_view target);
+
+private:
+    struct Header;
+    struct Slot;
+    struct Claim;
+
+    bool ReadSlot(Slot& slot, uint64_t key, std::string_view text, uint32_t now, PooledString& translation);
+
+    SharedMemoryRegion region;
+    Header* header;
+    Slot* slots;
+    Claim* claims;
+    uint32_t expiryMs;
+    std::atomic<uint32_t> nextClaimId;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> publishes;
+    std::atomic<uint64_t> waits;
+    std::atomic<uint64_t> waitHits;
+    std::atomic<uint64_t> lookupNanos;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Deferred startup pipeline. DllMain only installs the UnitXP hook (under
+// the loader lock) and calls BeginStartup; logging, the translation client,
+// phrasebook/dictionary mapping and the WinHTTP session are set up on a
+// background thread. Until it finishes, g_translator must not be touched.
+
+enum class StartupState {
+    NOT_STARTED = 0,
+    RUNNING = 1,
+    READY = 2,
+    FAILED = 3     // g_translator exists but WinHTTP could not be opened
+};
+
+struct StartupTimings {
+    uint64_t attachMicros;      // DLL_PROCESS_ATTACH, i.e. time spent under the loader lock
+    uint64_t logMicros;         // Log file setup on the startup thread
+    uint64_t clientMicros;      // TranslationClient::Start
+    uint64_t totalMicros;       // DllMain entry to READY/FAILED
+    uint64_t lastSetKeyMicros;  // Game-thread cost of the most recent setkey
+};
+
+// Starts the background init thread; attachStartUs is the TraceNowUs() at DllMain entry
+bool BeginStartup(uint64_t attachStartUs, bool hookInstalled);
+
+// Tears the translator down if it was published; a startup thread still
+// running is told not to publish and cleans up its own client
+void ShutdownStartup();
+
+StartupState GetStartupState();
+
+// True once g_translator may be used (READY or FAILED)
+bool IsStartupComplete();
+
+// Applies the key now, or hands it to the init thread if it is still running.
+// Returns false only if startup failed.
+bool SubmitApiKey(const std::string& key);
+
+StartupTimings GetStartupTimings();
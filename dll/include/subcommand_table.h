@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// First UnitXP argument of every WoWTranslate call; anything else belongs to
+// another addon and is forwarded untouched
+static constexpr std::string_view UNITXP_NAMESPACE = "WoWTranslate";
+
+// WoWTranslate subcommands (second UnitXP argument)
+enum class Subcommand : int8_t {
+    Unknown = -1,
+    Ping,
+    Version,
+    Status,
+    SetKey,
+    Credits,
+    Trace,
+    TranslateAsync,
+    Poll,
+    Translate,
+    MemStats,
+    CacheStats,
+    Template,
+    TemplateNames,
+    Segments,
+    NearDup,
+    Detect,
+    Cancel,
+    Offline,
+    Startup,
+    Shared,
+    Chunks,
+    PollBatch,
+    Budget,
+    Wire,
+    Names,
+    Hedge,
+    Endpoints,
+    Push,
+    Preflight,
+    Stream,
+    Multiplex,
+};
+
+// Resolves a subcommand name through a perfect hash table built at compile
+// time from a fixed seed: one FNV-1a hash of the argument, one table probe
+// and one string compare
+Subcommand LookupSubcommand(std::string_view name);
+
+// True when seed gives every subcommand its own table slot; the seed search
+// lives in tools/subcommand_seed rather than in the compiler
+bool IsPerfectSubcommandSeed(uint32_t seed);
+
+// Subcommand name for budget overrun causes (table literals, so never dangling)
+const char* SubcommandName(Subcommand id);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Cache-key normalization: folds full-width ASCII and the ideographic space
+// to half-width, collapses whitespace runs, lowercases Latin letters and
+// caps repeated characters at three. The original text is still what gets
+// sent for translation; only the cache key is normalized.
+std::string NormalizeForCache(std::string_view text);
+
+// Templating: numbers and known player names are lifted into {0}..{8} slots
+// so "收 10g" and "收 20g" share one cached translation of "收 {0}g".
+struct TextTemplate {
+    std::string text;
+    std::vector<std::string> slots;
+};
+
+// Returns false when the text has no slot candidates or cannot be templated safely.
+// Slots keep their original spelling; normalize out.text to build the cache key.
+bool ExtractTemplate(std::string_view text, const std::vector<std::string>& names, TextTemplate& out);
+
+// Substitutes slots back into a translated template; false if any marker was lost
+bool FillTemplate(std::string_view translatedTemplate, const std::vector<std::string>& slots, std::string& out);
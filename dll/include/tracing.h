@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Request-lifecycle tracing in Chrome trace-event format.
+// Output (WoWTranslate_trace.json next to the DLL) opens in chrome://tracing or Perfetto.
+// Tracing is off by default; a disabled span costs one relaxed atomic load.
+
+extern std::atomic<bool> g_tracingEnabled;
+
+inline bool IsTracingEnabled() {
+    return g_tracingEnabled.load(std::memory_order_relaxed);
+}
+
+// Tracing control
+bool StartTracing();
+void StopTracing();
+
+// Microsecond timestamp on the trace clock
+uint64_t TraceNowUs();
+
+// Record a complete span ("ph":"X") tagged with a requestId. Only buffers;
+// the file is written by FlushTracing and StopTracing.
+void TraceComplete(const char* name, uint64_t startUs, uint64_t endUs, const std::string& requestId);
+
+// Append buffered spans to the file once enough have collected. Called by
+// the worker between requests, so no game-thread span ever waits on disk.
+void FlushTracing();
+
+// Tags spans recorded on this thread with requestId while in scope
+class TraceRequestScope {
+public:
+    explicit TraceRequestScope(const std::string& requestId);
+    ~TraceRequestScope();
+
+    TraceRequestScope(const TraceRequestScope&) = delete;
+    TraceRequestScope& operator=(const TraceRequestScope&) = delete;
+
+    static const std::string& Current();
+
+private:
+    const std::string* previous;
+};
+
+// RAII span: records [construction, destruction) under the current request scope
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* spanName)
+        : name(spanName), startUs(IsTracingEnabled() ? TraceNowUs() : 0) {}
+    ~TraceSpan() {
+        if (startUs) {
+            TraceComplete(name, startUs, TraceNowUs(), TraceRequestScope::Current());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    uint64_t startUs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+#include "language_pair.h"
+#include "payload_pool.h"
+
+// DLL-side translation cache keyed by a 64-bit text hash seeded with the
+// language pair ID. The source text is stored once per entry and compared
+// only when the hash matches, so lookups never build a key string.
+struct TranslationCacheStats {
+    size_t entries;
+    size_t approximateBytes;   // Strings plus per-node overhead
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t collisions;       // Hash matched but source text differed
+    uint64_t lookupNanos;      // Time spent in Lookup(), scaled up from every LOOKUP_TIMING_SAMPLE-th call
+};
+
+class TranslationCache {
+public:
+    TranslationCache(size_t maxEntries, uint32_t expiryMs);
+
+    // now is a millisecond tick (GetTickCount on Windows)
+    bool Lookup(std::string_view text, LanguagePairId pair, uint32_t now, PooledString& translation);
+    void Insert(std::string_view text, LanguagePairId pair, std::string_view translation, uint32_t now);
+    // Lookup without copying the translation or counting a hit or miss
+    bool Contains(std::string_view text, LanguagePairId pair, uint32_t now);
+    void CleanExpired(uint32_t now);
+    void Clear();
+
+    size_t Size();
+    TranslationCacheStats GetStats();
+
+    static uint64_t MakeKey(std::string_view text, LanguagePairId pair);
+
+    static const uint32_t LOOKUP_TIMING_SAMPLE = 16;
+
+private:
+    struct Entry {
+        std::string source;
+        std::string translation;
+        uint32_t timestamp;
+        LanguagePairId pair;
+    };
+
+    struct IdentityHash {
+        size_t operator()(uint64_t key) const { return static_cast<size_t>(key ^ (key >> 32)); }
+    };
+
+    std::unordered_map<uint64_t, Entry, IdentityHash> entries;
+    std::mutex cacheMutex;
+    size_t maxEntries;
+    uint32_t expiryMs;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t collisions;
+    uint64_t lookupNanos;
+    std::atomic<uint32_t> lookupTicker;
+};
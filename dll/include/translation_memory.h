@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "translation_cache.h"
+
+// Segment-level translation memory: messages are split at sentence and
+// clause punctuation (and at spaces inside CJK text), and each segment's
+// translation is cached on its own so recombined stock phrases
+// ("组 MC 缺坦克 来的M我" / "组 BWL 缺治疗 来的M我") only pay for new segments.
+struct TextSegment {
+    std::string_view text;       // Segment content without delimiters (may be empty)
+    std::string_view delimiter;  // Punctuation/whitespace that followed it
+    bool literal;                // Passed through untranslated (e.g. "MC" in Chinese chat)
+};
+
+struct TranslationMemoryStats {
+    size_t segments;
+    uint64_t segmentHits;
+    uint64_t segmentMisses;
+    uint64_t localChars;         // Characters served from memory or passed through
+    uint64_t totalChars;         // Characters of all messages routed through segmentation
+};
+
+class TranslationMemory {
+public:
+    TranslationMemory(size_t maxSegments, uint32_t expiryMs);
+
+    // passThroughAscii: keep all-ASCII segments verbatim (CJK source languages)
+    static std::vector<TextSegment> Split(std::string_view text, bool passThroughAscii);
+
+    // Appends a source delimiter to a reassembled translation, converting
+    // full-width punctuation to ASCII for non-CJK targets
+    static void AppendDelimiter(std::string& out, std::string_view delimiter, bool cjkTarget, bool last);
+
+    static size_t CountChars(std::string_view text);
+
+    bool Lookup(std::string_view segment, LanguagePairId pair, uint32_t now, PooledString& translation);
+    void Insert(std::string_view segment, LanguagePairId pair, std::string_view translation, uint32_t now);
+    void CleanExpired(uint32_t now);
+    void RecordMessage(size_t localChars, size_t totalChars);
+    void Clear();
+
+    TranslationMemoryStats GetStats();
+
+private:
+    TranslationCache segments;
+    std::atomic<uint64_t> localChars;
+    std::atomic<uint64_t> totalChars;
+};
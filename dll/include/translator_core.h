@@ -3,12 +3,37 @@
 #include <windows.h>
 #include <winhttp.h>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <memory>
+#include <vector>
 #include <queue>
+#include <deque>
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <functional>
+
+#include "tracing.h"
+#include "payload_pool.h"
+#include "language_pair.h"
+#include "translation_cache.h"
+#include "translation_memory.h"
+#include "near_duplicate.h"
+#include "phrasebook.h"
+#include "name_index.h"
+#include "language_id.h"
+#include "offline_engine.h"
+#include "shared_translation_cache.h"
+#include "message_chunker.h"
+#include "hedge_policy.h"
+#include "endpoint_router.h"
+#include "preflight.h"
+#include "negative_cache.h"
+#include "clock.h"
+#include "scheduling_policy.h"
+#include "request_scheduler.h"
+#include "async_http.h"
 
 // Translation result codes
 enum class TranslationResult {
@@ -21,107 +46,453 @@ enum class TranslationResult {
     PENDING = 6
 };
 
-// Async translation request
-struct AsyncRequest {
-    std::string requestId;
-    std::string text;
-    std::string sourceLang;
-    std::string targetLang;
-    DWORD timestamp;
-
-    AsyncRequest() : sourceLang("zh"), targetLang("en"), timestamp(0) {}
-    AsyncRequest(const std::string& id, const std::string& t,
-                 const std::string& src = "zh", const std::string& tgt = "en")
-        : requestId(id), text(t), sourceLang(src), targetLang(tgt), timestamp(GetTickCount()) {}
+// When the offline engine answers instead of the proxy
+enum class OfflineMode {
+    OFF = 0,
+    FALLBACK = 1,    // Only when the proxy is unreachable or credits are exhausted
+    FIRST_PASS = 2   // Also for short messages the dictionary fully covers
+};
+
+// Body format negotiated with the proxy for /api/translate
+enum class WireProtocol {
+    UNKNOWN = 0,   // Not negotiated yet (or the handshake failed; retried later)
+    JSON = 1,      // Proxy has no binary protocol, or it was disabled
+    MSGPACK = 2    // MessagePack bodies authenticated by a session token
+};
+
+// Request counts and body sizes/costs over both wire formats
+struct WireProtocolStats {
+    WireProtocol protocol;
+    uint64_t requests;
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    uint64_t encodeNanos;
+    uint64_t decodeNanos;
+};
+
+// One translation POST on the async HTTP engine (fields guarded by the
+// client's dispatchMutex). The worker sends queued requests ahead of time
+// this way, and long messages' chunks without a thread each.
+struct AsyncCall {
+    PooledString text;
+    LanguagePairId languagePair;
+    uint64_t httpId;        // Engine request id while in flight
+    uint32_t statusCode;    // HTTP status once done; 0 on network errors and cancels
+    std::string token;      // Session token of a MessagePack call; empty for JSON
+    uint64_t sentMs;        // When it was submitted, for the hedge threshold
+    size_t bytesSent;
+    bool done;              // response is final (empty on failure or cancel)
+    bool cancelled;
+    bool taken;             // The worker has started consuming the answer
+    PooledString response;
+
+    AsyncCall(std::string_view t, LanguagePairId pair)
+        : text(t.data(), t.size()), languagePair(pair), httpId(0), statusCode(0), sentMs(0), bytesSent(0),
+          done(false), cancelled(false), taken(false) {}
 };
 
 // Async translation result
 struct AsyncResult {
     std::string requestId;
-    std::string translation;
-    std::string error;
+    PooledString translation;
+    PooledString error;
+    TranslationInfo info;
     bool ready;
+    uint64_t traceReadyUs;  // 0 unless tracing was enabled when the result was queued
 
-    AsyncResult() : ready(false) {}
-    AsyncResult(const std::string& id, const std::string& trans, const std::string& err)
-        : requestId(id), translation(trans), error(err), ready(true) {}
-};
-
-// Cache entry structure
-struct CacheEntry {
-    std::string translation;
-    DWORD timestamp;
-
-    CacheEntry() : translation(""), timestamp(0) {}
-    CacheEntry(const std::string& trans)
-        : translation(trans), timestamp(GetTickCount()) {}
+    AsyncResult() : ready(false), traceReadyUs(0) {}
+    AsyncResult(std::string id, PooledString trans, PooledString err, const TranslationInfo& resultInfo = TranslationInfo())
+        : requestId(std::move(id)), translation(std::move(trans)), error(std::move(err)), info(resultInfo),
+          ready(true), traceReadyUs(IsTracingEnabled() ? TraceNowUs() : 0) {}
 };
 
 // Translation client class with async support
 class TranslationClient {
 private:
+    Clock& clock;                        // Cache expiry, session lifetimes, routing, hedging, worker waits
     HINTERNET hSession;
-    HINTERNET hConnect;
+    std::vector<HINTERNET> connections;  // One per router endpoint, in the same order; fixed after Start
     std::string apiKey;
-    std::unordered_map<std::string, CacheEntry> cache;
-    bool initialized;
+    std::mutex keyMutex;           // apiKey is replaced on the game thread while the worker reads it
+    TranslationCache cache;
+    std::atomic<bool> initialized; // Started and given a key
 
-    // Server configuration (production only)
-    static constexpr const char* SERVER_HOST = "34.92.64.54.sslip.io";
-    static constexpr int SERVER_PORT = 443;
+    // Production proxy, used unless WoWTranslate_endpoints.txt next to the
+    // DLL lists endpoints of its own ("host[:port]" per line)
+    static constexpr const char* DEFAULT_SERVER_HOST = "34.92.64.54.sslip.io";
+    static constexpr int DEFAULT_SERVER_PORT = 443;
+
+    // Requests go to the endpoint with the best recent latency and error
+    // rate and fail over to the next one when it errors out
+    EndpointRouter router;
 
     // Async translation support
-    std::queue<AsyncRequest> requestQueue;
+    // Queued requests and the one in flight, shared and woken per the
+    // SchedulingPolicy (guarded by requestMutex)
+    RequestScheduler requests;
     std::queue<AsyncResult> resultQueue;
     std::mutex requestMutex;
     std::mutex resultMutex;
     std::thread workerThread;
     std::atomic<bool> running;
+    std::atomic<size_t> resultCount;  // Mirrors resultQueue.size() for lock-free idle polls
+
+    // One hedged exchange (guarded by requestMutex): lane 0 is the original
+    // request on the caller, lane 1 the duplicate the hedge thread sends once
+    // it runs past the threshold. The first answer wins and the other lane's
+    // engine call is cancelled; a lane on the blocking path runs to its end
+    // and drops its own answer. Shared, as a losing lane 1 can outlive the
+    // caller.
+    struct HedgeRace {
+        std::shared_ptr<AsyncCall> calls[2];
+        bool finished[2];
+        int winner;
+        PooledString responses[2];
+        std::condition_variable changed;
+
+        HedgeRace() : calls(), finished(), winner(-1) {}
+    };
+    HedgePolicy hedgePolicy;
+    // Lane 1 of every hedged request runs on this one long-lived thread, a
+    // race at a time (guarded by requestMutex); a request that finds it busy
+    // is not hedged
+    std::thread hedgeThread;
+    std::function<void()> hedgeJob;
+    bool hedgeBusy;
+    std::condition_variable hedgeWork;
+
+    // Credits tracking (from server response; chunk requests update it concurrently)
+    std::atomic<double> creditsRemaining;
+
+    // Cache templating (numbers and player names lifted into slots)
+    std::atomic<bool> templatingEnabled;
+    std::atomic<uint64_t> templateHits;
+    std::shared_ptr<const std::vector<std::string>> templateNames;
+    std::mutex templateMutex;
+
+    // Lines with nothing to translate are answered before they are queued;
+    // lines the proxy returned unchanged or rejected are remembered briefly
+    std::atomic<bool> preflightEnabled;
+    std::atomic<uint64_t> preflightSkipped[PREFLIGHT_CLASS_COUNT];
+    NegativeCache negativeCache;
+
+    // Segment-level translation memory
+    TranslationMemory segmentMemory;
+    std::atomic<bool> segmentMemoryEnabled;
+
+    // Prebuilt phrasebook (WoWTranslate_phrasebook.wtpb next to the DLL)
+    Phrasebook phrasebook;
+    LanguagePairId phrasebookPair;
+
+    // Prebuilt item/quest name index (WoWTranslate_names.wtni next to the DLL)
+    NameIndex nameIndex;
+
+    // SimHash near-duplicate reuse for spam variants
+    NearDuplicateIndex nearDuplicates;
+    std::atomic<bool> nearDuplicateEnabled;
+    std::atomic<int> nearDuplicateThreshold;
+
+    // Dictionary gloss used without the proxy (built-in glossary plus
+    // WoWTranslate_dictionary.tsv next to the DLL); zh -> en only
+    OfflineEngine offlineEngine;
+    std::atomic<OfflineMode> offlineMode;
+    std::atomic<int> offlineFirstPassChars;
 
-    // Credits tracking (from server response)
-    double creditsRemaining;
+    // Multi-target requests (POST /api/translate/multi); cleared when the
+    // proxy turns out not to support it, after which targets go out separately
+    std::atomic<bool> fanOutSupported;
+    std::atomic<uint64_t> fanOutRequests;
+    std::atomic<uint64_t> fanOutTargets;
 
-    static const DWORD CACHE_EXPIRY_MS = 3600000; // 1 hour (DLL cache)
-    static const size_t MAX_CACHE_SIZE = 500;
+    // Cache tier shared with other clients on this machine (multiboxing).
+    // Mapped on first enable and kept until Cleanup, so disabling never
+    // unmaps memory the worker might be reading.
+    SharedTranslationCache sharedCache;
+    std::atomic<bool> sharedCacheEnabled;
+    std::mutex sharedCacheMutex;
+
+    // Long messages are split at sentence ends and the chunks requested in
+    // parallel; each chunk is cached on its own
+    std::atomic<bool> chunkingEnabled;
+    std::atomic<uint64_t> chunkedMessages;
+    std::atomic<uint64_t> chunkRequests;
+    std::atomic<uint64_t> chunkCacheHits;
+
+    // Long async messages streamed sentence by sentence (POST
+    // /api/translate/stream); each batch of sentences goes to the addon as a
+    // partial result. Off by default; cleared like fanOutSupported when the
+    // proxy has no streaming endpoint.
+    std::atomic<bool> streamingEnabled;
+    std::atomic<bool> streamSupported;
+    std::atomic<uint64_t> streamedMessages;
+    std::atomic<uint64_t> streamPartials;
+    std::atomic<uint64_t> streamFirstSentenceMicros;
+    std::atomic<uint64_t> streamFullMicros;
+
+    // Single requests go out as MessagePack with a session token in place of
+    // the API key once the proxy accepts it (POST /api/session); JSON remains
+    // the fallback. keyGeneration moves on every SetApiKey so the session
+    // is renegotiated without SetApiKey waiting on a handshake.
+    std::atomic<WireProtocol> wireProtocol;
+    std::atomic<bool> binaryProtocolEnabled;
+    std::atomic<uint32_t> keyGeneration;
+    uint32_t sessionGeneration;
+    std::string sessionToken;
+    DWORD sessionExpiry;
+    bool sessionHandshaking;   // A handshake is out; guarded by sessionMutex
+    std::mutex sessionMutex;
+    std::atomic<uint64_t> wireRequests;
+    std::atomic<uint64_t> wireBytesSent;
+    std::atomic<uint64_t> wireBytesReceived;
+    std::atomic<uint64_t> wireEncodeNanos;
+    std::atomic<uint64_t> wireDecodeNanos;
+
+    // Requests multiplexed on the async engine: while the worker answers the
+    // queue in order, the requests behind it are already in flight, so one
+    // thread keeps dozens going. Lock order is requestMutex, then
+    // dispatchMutex; engine completions take only dispatchMutex.
+    AsyncHttpEngine asyncHttp;
+    std::atomic<bool> multiplexEnabled;
+    std::mutex dispatchMutex;
+    std::condition_variable dispatchChanged;  // An AsyncCall finished or a request was queued
+    uint64_t dispatchEnqueues;                // Bumped per queued request (guarded by dispatchMutex)
+    std::atomic<uint64_t> prefetchSubmitted;
+    std::atomic<uint64_t> prefetchUsed;
+    std::atomic<uint64_t> prefetchWasted;     // Cancelled, superseded or answered locally after all
+    std::atomic<uint64_t> prefetchFallbacks;  // Failed; the request went out again the usual way
+
+    static const DWORD SEGMENT_MEMORY_EXPIRY_MS = 86400000; // 24 hours
+    static const size_t MAX_SEGMENT_MEMORY_SIZE = 4000;
+    static const size_t MAX_NEAR_DUPLICATE_SIZE = 512;
+    static const int DEFAULT_NEAR_DUPLICATE_THRESHOLD = 8;  // Hamming distance in bits
+    static constexpr float MIN_AUTO_CONFIDENCE = 0.3f;      // Below this an "auto" source is undetermined
+    static const LanguagePairId OFFLINE_LANGUAGE_PAIR = DEFAULT_LANGUAGE_PAIR;
+    static const int DEFAULT_OFFLINE_FIRST_PASS_CHARS = 8;  // Codepoints
+    static constexpr const char* SHARED_CACHE_NAME = "WoWTranslate_cache_v2";
+    static const DWORD SHARED_CACHE_WAIT_MS = 4000;         // Longest wait on another client's request
+    static constexpr size_t CHUNK_MIN_BYTES = 240;          // Shorter messages go out whole
+    static constexpr size_t CHUNK_MAX_BYTES = 160;          // ~50 CJK characters per chunk
+    static constexpr size_t MAX_PARALLEL_CHUNKS = 4;        // Concurrent requests per message
+    static const size_t STREAM_MIN_BYTES = 240;             // Shorter messages are not streamed
+    static constexpr size_t MAX_PREFETCH = 32;              // Engine requests in flight before prefetching stops
+    static const DWORD MAX_SESSION_SECONDS = 86400;
+    static const DWORD SESSION_RENEW_MARGIN_MS = 60000;
 
     // Helper methods
     std::string UrlEncode(const std::string& text);
-    std::string HttpsRequest(const std::string& host, const std::string& path, const std::string& postData);
-    std::string ParseTranslationResponse(const std::string& jsonResponse);
-    std::string GenerateCacheKey(const std::string& text, const std::string& sourceLang, const std::string& targetLang);
-    void CleanExpiredCache();
+    // onData (optional) sees each piece of the body as it is read
+    PooledString HttpsRequest(size_t endpoint, const std::string& path, std::string_view postData,
+                              bool binary = false, HedgeRace* race = nullptr, int lane = 0, DWORD timeoutMs = 0,
+                              const std::function<void(std::string_view)>* onData = nullptr);
+    bool EngineExchange(const std::shared_ptr<AsyncCall>& call, size_t endpoint, const std::string& path,
+                        std::string_view postData, bool binary, DWORD timeoutMs,
+                        const std::function<void(std::string_view)>* onData);
+    PooledString BlockingRequest(size_t endpoint, const std::string& path, std::string_view postData, bool binary,
+                                 DWORD timeoutMs, const std::function<void(std::string_view)>* onData);
+    PooledString RoutedRequest(const std::string& path, std::string_view postData, bool binary = false,
+                               HedgeRace* race = nullptr, int lane = 0,
+                               const std::function<void(std::string_view)>* onData = nullptr);
+    bool RequestAbandoned(HedgeRace* race);
+    PooledString HedgedRequest(const std::string& path, std::string_view postData, bool binary);
+    void FinishHedgeLane(HedgeRace& race, int lane, PooledString response);
+    void RunHedgeLane(const std::shared_ptr<HedgeRace>& race, const std::string& path, const PooledString& postData,
+                      bool binary, uint32_t thresholdMs);
+    void HedgeThreadFunc();
+    std::string ParseTranslationResponse(std::string_view jsonResponse);
+    void LoadPhrasebook();
+    void LoadNameIndex();
+    void LoadEndpoints();
+    void WarmUpConnection(size_t endpoint);
+    void LoadOfflineDictionary();
+    bool TranslateOffline(std::string_view text, LanguagePairId languagePair, bool requireFullCoverage,
+                          PooledString& result, TranslationInfo& info);
+    TranslationResult FallBackOffline(std::string_view text, LanguagePairId languagePair, TranslationResult failure,
+                                      PooledString& result, TranslationInfo& info);
+    TranslationResult RequestTranslation(std::string_view text, LanguagePairId languagePair, PooledString& result);
+    TranslationResult InterpretProxyError(std::string_view error, PooledString& result);
+    bool AcquireSessionToken(std::string& token);
+    bool CurrentSessionToken(std::string& token);
+    void InvalidateSessionToken(const std::string& token);
+    static bool IsSessionError(std::string_view error);
+    bool ParseBinaryTranslation(const PooledString& response, const std::string& token, PooledString& result,
+                                TranslationResult& status);
+    bool RequestTranslationBinary(std::string_view text, LanguagePairId languagePair, const std::string& token,
+                                  PooledString& result, TranslationResult& status);
+    TranslationResult RequestFanOut(std::string_view text, const std::vector<LanguagePairId>& pairs,
+                                    std::vector<PooledString>& results, bool& unsupported);
+    void TranslateFanOut(std::string_view text, const std::vector<LanguagePairId>& pairs,
+                         std::vector<PooledString>& translations, std::vector<PooledString>& errors,
+                         std::vector<TranslationInfo>& infos);
+    static void DescribeFailure(TranslationResult tr, PooledString& translation, PooledString& error);
+    void PushResult(AsyncResult result);
+    void AbandonInFlight();
+    bool CancelLocked(const std::string& requestId, const char* reason);
+    bool ResolveAutoSource(std::string_view text, LanguagePairId& languagePair, TranslationInfo& info);
+    bool AnswerPreflight(std::string_view text, TranslationInfo& info);
+    bool RecallNegative(std::string_view cacheKeyText, std::string_view text, LanguagePairId languagePair,
+                        PooledString& translation, PooledString& error, TranslationInfo& info);
+    void RememberRejection(std::string_view cacheKeyText, LanguagePairId languagePair, TranslationResult tr,
+                           std::string_view error);
+    bool TranslateBySegments(std::string_view text, LanguagePairId languagePair,
+                             PooledString& result, TranslationResult& status);
+    bool TranslateInChunks(std::string_view text, LanguagePairId languagePair,
+                           PooledString& result, TranslationResult& status);
+    bool TranslateStreaming(std::string_view text, LanguagePairId languagePair,
+                            PooledString& result, TranslationResult& status);
+    void PushPartial(std::string_view translation, uint32_t sequence);
+    TranslationResult ParseJsonTranslation(std::string_view response, PooledString& result);
+    void StartAsyncCall(const std::shared_ptr<AsyncCall>& call);
+    void CancelAsyncCall(const std::shared_ptr<AsyncCall>& call);
+    std::shared_ptr<AsyncCall> WaitAsyncCall(const std::shared_ptr<AsyncCall>& call, PooledString& response);
+    bool ParseAsyncCall(const AsyncCall& call, const PooledString& response, PooledString& result,
+                        TranslationResult& status);
+    bool PrefetchEligible(const AsyncRequest& request);
+    void PrefetchQueued();
+    std::shared_ptr<AsyncCall> TakePrefetch(std::string_view text, LanguagePairId languagePair);
+    bool RequestChunksAsync(const std::vector<std::string_view>& chunks, const std::vector<size_t>& missing,
+                            LanguagePairId languagePair, std::vector<PooledString>& translations,
+                            std::vector<TranslationResult>& results);
 
     // Worker thread function
     void WorkerThreadFunc();
 
 public:
-    TranslationClient();
+    explicit TranslationClient(Clock& clock = GetSystemClock(),
+                               const SchedulingPolicy& schedulingPolicy = SchedulingPolicy());
     ~TranslationClient();
 
-    bool Initialize(const std::string& key);
+    // Startup-thread setup (local data, WinHTTP session, endpoint connections
+    // and warm-up, worker thread); returns false if WinHTTP is unavailable
+    bool Start();
+    // Non-blocking; translation requests are accepted once a key is set
+    void SetApiKey(const std::string& key);
     void Cleanup();
     bool IsInitialized() const { return initialized; }
 
     // Server info
     std::string GetServerInfo() const;
 
+    // Per-endpoint latency, error rate and state, and requests moved to another endpoint
+    std::vector<EndpointStats> GetEndpointStats() const;
+    uint64_t GetFailovers() const { return router.GetFailovers(); }
+
     // Credits tracking
     double GetCreditsRemaining() const { return creditsRemaining; }
 
-    // Synchronous translation with configurable language direction
-    TranslationResult TranslateText(const std::string& text, std::string& result,
-                                    const std::string& sourceLang = "zh", const std::string& targetLang = "en");
+    // Cache statistics (entries, memory, hit/miss, lookup time)
+    TranslationCacheStats GetCacheStats() { return cache.GetStats(); }
+
+    // Cache templating controls
+    void SetTemplatingEnabled(bool enabled);
+    bool IsTemplatingEnabled() const { return templatingEnabled; }
+    void SetTemplateNames(std::vector<std::string> names);
+    uint64_t GetTemplateHits() const { return templateHits; }
+
+    // Pre-flight skipping of untranslatable lines, and the negative cache
+    void SetPreflightEnabled(bool enabled);
+    bool IsPreflightEnabled() const { return preflightEnabled; }
+    uint64_t GetPreflightSkipped(PreflightClass kind) const { return preflightSkipped[static_cast<int>(kind)]; }
+    NegativeCacheStats GetNegativeCacheStats() { return negativeCache.GetStats(); }
+
+    // Segment translation memory controls
+    void SetSegmentMemoryEnabled(bool enabled);
+    bool IsSegmentMemoryEnabled() const { return segmentMemoryEnabled; }
+    TranslationMemoryStats GetSegmentMemoryStats() { return segmentMemory.GetStats(); }
+
+    // Phrasebook statistics (entries, mapping cost, hit/miss, lookup time)
+    PhrasebookStats GetPhrasebookStats() const { return phrasebook.GetStats(); }
+
+    // Item/quest names for hyperlinks; read-only once Start has returned
+    NameIndex& GetNameIndex() { return nameIndex; }
+    NameIndexStats GetNameIndexStats() const { return nameIndex.GetStats(); }
 
-    // Async translation methods with configurable language direction
-    bool TranslateAsync(const std::string& requestId, const std::string& text,
-                        const std::string& sourceLang = "zh", const std::string& targetLang = "en");
-    bool PollResult(std::string& requestId, std::string& translation, std::string& error);
+    // Near-duplicate reuse controls
+    void SetNearDuplicateEnabled(bool enabled, int threshold);
+    bool IsNearDuplicateEnabled() const { return nearDuplicateEnabled; }
+    int GetNearDuplicateThreshold() const { return nearDuplicateThreshold; }
+    NearDuplicateStats GetNearDuplicateStats() { return nearDuplicates.GetStats(); }
+
+    // Offline fallback controls; maxChars bounds first-pass messages
+    void SetOfflineMode(OfflineMode mode, int maxChars);
+    OfflineMode GetOfflineMode() const { return offlineMode; }
+    int GetOfflineFirstPassChars() const { return offlineFirstPassChars; }
+    OfflineEngineStats GetOfflineStats() const { return offlineEngine.GetStats(); }
+
+    // Fan-out round trips and the targets they answered
+    uint64_t GetFanOutRequests() const { return fanOutRequests; }
+    uint64_t GetFanOutTargets() const { return fanOutTargets; }
+
+    // Cross-process cache controls; false if the shared region cannot be mapped
+    bool SetSharedCacheEnabled(bool enabled);
+    bool IsSharedCacheEnabled() const { return sharedCacheEnabled; }
+    SharedCacheStats GetSharedCacheStats() const { return sharedCache.GetStats(); }
+
+    // Parallel chunking of long messages
+    void SetChunkingEnabled(bool enabled);
+    bool IsChunkingEnabled() const { return chunkingEnabled; }
+    uint64_t GetChunkedMessages() const { return chunkedMessages; }
+    uint64_t GetChunkRequests() const { return chunkRequests; }
+    uint64_t GetChunkCacheHits() const { return chunkCacheHits; }
+
+    // Sentence-by-sentence streaming of long async messages
+    void SetStreamingEnabled(bool enabled);
+    bool IsStreamingEnabled() const { return streamingEnabled; }
+    bool IsStreamingSupported() const { return streamSupported; }
+    uint64_t GetStreamedMessages() const { return streamedMessages; }
+    uint64_t GetStreamPartials() const { return streamPartials; }
+    uint64_t GetStreamFirstSentenceMicros() const { return streamFirstSentenceMicros; }
+    uint64_t GetStreamFullMicros() const { return streamFullMicros; }
+
+    // Queued requests and chunks multiplexed on the async HTTP engine
+    void SetMultiplexEnabled(bool enabled) { multiplexEnabled = enabled; }
+    bool IsMultiplexEnabled() const { return multiplexEnabled; }
+    AsyncHttpStats GetAsyncHttpStats() const { return asyncHttp.GetStats(); }
+    uint64_t GetPrefetchSubmitted() const { return prefetchSubmitted; }
+    uint64_t GetPrefetchUsed() const { return prefetchUsed; }
+    uint64_t GetPrefetchWasted() const { return prefetchWasted; }
+    uint64_t GetPrefetchFallbacks() const { return prefetchFallbacks; }
+
+    // Binary wire protocol; disabling sends everything as JSON
+    void SetBinaryProtocolEnabled(bool enabled);
+    bool IsBinaryProtocolEnabled() const { return binaryProtocolEnabled; }
+    WireProtocolStats GetWireStats() const;
+
+    // Duplicate slow requests (past the recent p95) within budgetPercent extra load
+    void SetHedging(bool enabled, uint32_t budgetPercent);
+    HedgeStats GetHedgeStats() const { return hedgePolicy.GetStats(); }
+
+    // Synchronous translation; languagePair comes from InternLanguagePair and
+    // may have an "auto" source. info (optional) receives flags and the
+    // detected language describing how the result was produced.
+    TranslationResult TranslateText(std::string_view text, PooledString& result,
+                                    LanguagePairId languagePair = DEFAULT_LANGUAGE_PAIR,
+                                    TranslationInfo* info = nullptr);
+    // Phrasebook and DLL cache only; never blocks on the network
+    bool TranslateLocal(std::string_view text, PooledString& result,
+                        LanguagePairId languagePair = DEFAULT_LANGUAGE_PAIR);
+
+    // Async translation methods with configurable language direction.
+    // An "auto" source is identified here; text already in the target
+    // language is answered immediately without reaching the worker.
+    // A non-empty supersedeKey replaces any pending request with the same
+    // key; identical text already queued or in flight is shared, not resent.
+    bool TranslateAsync(const std::string& requestId, std::string_view text,
+                        LanguagePairId languagePair = DEFAULT_LANGUAGE_PAIR,
+                        std::string_view supersedeKey = std::string_view());
+    // One text into several target languages with a single proxy call;
+    // results arrive as "requestId@target", one per target
+    bool TranslateAsync(const std::string& requestId, std::string_view text,
+                        const std::vector<LanguagePairId>& languagePairs);
+    // Drops a queued request or abandons it in flight; its result is "cancelled"
+    bool CancelRequest(const std::string& requestId);
+    // Answers a request that never reached the queue with an error result,
+    // once per target for a fan-out request
+    void PushError(const std::string& requestId, const std::vector<LanguagePairId>& fanOut, const char* error);
+    // A request may yield TRANSLATION_FLAG_PARTIAL results before its final one
+    bool PollResult(std::string& requestId, PooledString& translation, PooledString& error, TranslationInfo& info);
+    bool HasResults() const { return resultCount.load(std::memory_order_acquire) != 0; }
     size_t GetPendingCount();
 };
 
 // Global translation instance
 extern std::unique_ptr<TranslationClient> g_translator;
-
-// Static buffers for Lua interface
-extern char g_translation_buffer[4096];
-extern char g_error_buffer[256];
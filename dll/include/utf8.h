@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Minimal UTF-8 helpers shared by the text-processing stages
+
+static const uint32_t UTF8_REPLACEMENT = 0xFFFD;
+
+// Decode the codepoint at pos and advance pos; invalid bytes yield U+FFFD
+inline uint32_t NextCodepoint(std::string_view s, size_t& pos) {
+    unsigned char c = static_cast<unsigned char>(s[pos]);
+    if (c < 0x80) {
+        ++pos;
+        return c;
+    }
+
+    size_t extra;
+    uint32_t cp;
+    if ((c & 0xE0) == 0xC0) { extra = 1; cp = c & 0x1F; }
+    else if ((c & 0xF0) == 0xE0) { extra = 2; cp = c & 0x0F; }
+    else if ((c & 0xF8) == 0xF0) { extra = 3; cp = c & 0x07; }
+    else { ++pos; return UTF8_REPLACEMENT; }
+
+    if (pos + extra >= s.size()) {
+        pos = s.size();
+        return UTF8_REPLACEMENT;
+    }
+    for (size_t i = 1; i <= extra; ++i) {
+        unsigned char cc = static_cast<unsigned char>(s[pos + i]);
+        if ((cc & 0xC0) != 0x80) {
+            pos += i;
+            return UTF8_REPLACEMENT;
+        }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    pos += extra + 1;
+    return cp;
+}
+
+template <typename String>
+inline void AppendCodepoint(String& out, uint32_t cp) {
+    if (cp <= 0x7F) {
+        out += static_cast<char>(cp);
+    } else if (cp <= 0x7FF) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp <= 0xFFFF) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp <= 0x10FFFF) {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Codepoints in well-formed UTF-8 (continuation bytes are not counted)
+inline size_t CountCodepoints(std::string_view s) {
+    size_t count = 0;
+    for (char c : s) {
+        if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+inline bool IsCjkCodepoint(uint32_t cp) {
+    return (cp >= 0x4E00 && cp <= 0x9FFF) ||   // CJK Unified Ideographs
+           (cp >= 0x3400 && cp <= 0x4DBF) ||   // Extension A
+           (cp >= 0xF900 && cp <= 0xFAFF);     // Compatibility Ideographs
+}
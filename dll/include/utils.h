@@ -7,6 +7,7 @@
 // Utility functions
 std::string GetCurrentTimestamp();
 std::string GetDllPath();
+std::string GetDllFolder();
 std::vector<std::string> SplitString(const std::string& str, char delimiter);
 std::string TrimString(const std::string& str);
 
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+#include "payload_pool.h"
+
+// Proxy wire formats. JSON is the original protocol: requests carry the API
+// key and are built by hand, responses are scanned for known fields.
+// MessagePack is the negotiated binary protocol: a session token replaces the
+// key, fields are one-byte integer keys, strings go out raw (no escaping) and
+// the decoder returns views into the response buffer without copying.
+
+// Simple JSON parser for proxy server responses
+class SimpleJsonParser {
+public:
+    static std::string extractField(std::string_view json, std::string_view fieldName);
+    // Reads "fieldName": ["a", "b", ...]; returns false if absent or malformed
+    static bool extractStringArray(std::string_view json, std::string_view fieldName,
+                                   std::vector<std::string>& values);
+    static double extractNumber(std::string_view json, std::string_view fieldName);
+
+private:
+    static std::string unescapeJson(std::string_view input);
+    static std::string ConvertCodepointToUTF8(unsigned int codepoint);
+};
+
+void AppendJsonEscaped(PooledString& out, std::string_view input);
+
+// Format: { "apiKey": "WT-xxx", "text": "...", "from": "zh", "to": "en" }
+void EncodeJsonRequest(PooledString& out, std::string_view apiKey, std::string_view text,
+                       std::string_view from, std::string_view to);
+
+// MessagePack subset used by the binary protocol: maps, arrays, strings,
+// unsigned integers, floats, booleans and nil
+class MsgPackWriter {
+public:
+    explicit MsgPackWriter(PooledString& out) : out(out) {}
+
+    void Map(uint32_t count);
+    void Array(uint32_t count);
+    void Str(std::string_view value);
+    void Uint(uint64_t value);
+
+private:
+    void Header(uint8_t fixBase, uint32_t fixLimit, uint8_t code16, uint8_t code32, uint32_t count);
+    void BigEndian(uint64_t value, int bytes);
+
+    PooledString& out;
+};
+
+class MsgPackReader {
+public:
+    explicit MsgPackReader(std::string_view data) : data(data), pos(0) {}
+
+    bool ReadMap(uint32_t& count);
+    bool ReadArray(uint32_t& count);
+    bool ReadStr(std::string_view& value);     // View into data
+    bool ReadUint(uint64_t& value);
+    bool ReadNumber(double& value);            // Any integer or float
+    bool Skip();                               // One complete value of any supported type
+    bool AtEnd() const { return pos == data.size(); }
+
+private:
+    bool Take(size_t bytes, const unsigned char*& ptr);
+    bool ReadLength(uint8_t code, uint8_t fixBase, uint8_t fixMask, uint8_t code8,
+                    uint8_t code16, uint8_t code32, uint32_t& length);
+
+    std::string_view data;
+    size_t pos;
+};
+
+// Binary protocol field keys (positive fixints, one byte on the wire)
+enum WireRequestKey : uint8_t {
+    WIRE_REQUEST_TOKEN = 0,
+    WIRE_REQUEST_TEXT = 1,
+    WIRE_REQUEST_FROM = 2,
+    WIRE_REQUEST_TO = 3
+};
+
+enum WireResponseKey : uint8_t {
+    WIRE_RESPONSE_TRANSLATION = 0,
+    WIRE_RESPONSE_CREDITS = 1,
+    WIRE_RESPONSE_ERROR = 2
+};
+
+// Views into the response body; credits is -1 when absent
+struct WireResponse {
+    std::string_view translation;
+    std::string_view error;
+    double credits;
+};
+
+void EncodeMsgPackRequest(PooledString& out, std::string_view sessionToken, std::string_view text,
+                          std::string_view from, std::string_view to);
+// Unknown keys are skipped so the proxy can add fields
+bool DecodeMsgPackResponse(std::string_view body, WireResponse& response);
+
+// Incremental reader for POST /api/translate/stream, newline-delimited JSON
+// sent as each sentence is translated:
+//   {"seq":0,"translation":"First sentence. "}
+//   {"seq":1,"translation":"Second sentence."}
+//   {"done":true,"creditsRemaining":1234}
+// or {"error":"..."} in place of any line. Sentence translations are joined
+// as sent. Bytes may arrive in any pieces; a line split across reads waits
+// for its newline. A plain /api/translate answer (one object, no "seq") is
+// taken as a single sentence and done.
+class TranslationStreamReader {
+public:
+    TranslationStreamReader();
+
+    // Returns the number of sentences these bytes completed
+    size_t Feed(std::string_view bytes);
+    // End of the body: a last line without a newline is parsed here
+    void Finish();
+
+    bool Done() const { return done; }
+    // Out-of-order sequence numbers or a line that is not a stream record
+    bool Malformed() const { return malformed; }
+    size_t Sentences() const { return sentences; }
+    const std::string& Translation() const { return translation; }
+    const std::string& Error() const { return error; }
+    double Credits() const { return credits; }   // -1 when absent
+
+private:
+    void ParseLine(std::string_view line);
+
+    std::string pending;       // Bytes after the last newline
+    std::string translation;
+    std::string error;
+    size_t sentences;
+    double credits;
+    bool done;
+    bool malformed;
+};
@@ -0,0 +1,872 @@
+// async_http.cpp - Async request engine: WinHTTP async mode with HTTP/2 multiplexing
+// (Win32), or one epoll thread pipelining HTTP/1.1 (POSIX, for host tools)
+
+#include <algorithm>
+#include <chrono>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#include "../include/async_http.h"
+#ifdef _WIN32
+#include "../include/logging.h"
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+#ifndef WINHTTP_OPTION_HTTP_PROTOCOL_USED
+#define WINHTTP_OPTION_HTTP_PROTOCOL_USED 134
+#endif
+#ifndef WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL
+#define WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL 133
+#define WINHTTP_PROTOCOL_FLAG_HTTP2 0x1
+#endif
+
+// One request's state. Callbacks for a request never overlap, so only
+// finished/closed, which Cancel also touches, are guarded by engineMutex.
+struct AsyncHttpEngine::Context {
+    AsyncHttpEngine* engine;
+    uint64_t id;
+    HINTERNET request;
+    char* buffer;            // The table slot's READ_BUFFER_BYTES
+    PooledString postData;   // Must outlive the send
+    PooledString response;
+    Completion done;
+    DataHandler onData;
+    DWORD statusCode;
+    bool finished;           // done has run (or was dropped)
+    bool closed;             // The request handle was closed; HANDLE_CLOSING follows
+
+    Context() : engine(nullptr), id(0), request(nullptr), buffer(nullptr), statusCode(0), finished(false),
+                closed(false) {}
+};
+
+AsyncHttpEngine::AsyncHttpEngine()
+    : session(nullptr), table(MAX_IN_FLIGHT), running(false), http2Enabled(false), submitted(0), completed(0),
+      failed(0), cancelled(0), rejected(0), http2Responses(0) {
+}
+
+AsyncHttpEngine::~AsyncHttpEngine() {
+    Stop();
+}
+
+bool AsyncHttpEngine::Start(const wchar_t* userAgent) {
+    session = WinHttpOpen(userAgent, WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME,
+                          WINHTTP_NO_PROXY_BYPASS, WINHTTP_FLAG_ASYNC);
+    if (!session) {
+        LOG_WARNING("WinHTTP async session unavailable; requests stay on the worker thread");
+        return false;
+    }
+
+    // Request handles inherit the callback from the session
+    if (WinHttpSetStatusCallback(session, &AsyncHttpEngine::StatusCallback,
+                                 WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS | WINHTTP_CALLBACK_FLAG_HANDLES,
+                                 0) == WINHTTP_INVALID_STATUS_CALLBACK) {
+        LOG_WARNING("WinHTTP async callback could not be set");
+        WinHttpCloseHandle(session);
+        session = nullptr;
+        return false;
+    }
+
+    DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+    http2Enabled = WinHttpSetOption(session, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &protocols, sizeof(protocols)) != FALSE;
+    DWORD connectionsPerServer = MAX_CONNECTIONS_PER_SERVER;
+    WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &connectionsPerServer, sizeof(connectionsPerServer));
+
+    running = true;
+    LOG_INFO(string("Async HTTP engine started (HTTP/2 ") + (http2Enabled ? "requested" : "unavailable") + ")");
+    return true;
+}
+
+void AsyncHttpEngine::AddEndpoint(const string& host, int port) {
+    HINTERNET connection = nullptr;
+    if (session) {
+        wstring wHost(host.begin(), host.end());
+        connection = WinHttpConnect(session, wHost.c_str(), static_cast<INTERNET_PORT>(port), 0);
+        if (!connection) {
+            LOG_WARNING("Async connection to " + host + " failed");
+        }
+    }
+    connections.push_back(connection);
+}
+
+void AsyncHttpEngine::Stop() {
+    if (!session) {
+        return;
+    }
+    running = false;
+
+    vector<uint64_t> ids;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        table.CollectIds(ids);
+    }
+    for (uint64_t id : ids) {
+        Cancel(id);
+    }
+
+    // Callbacks still reference this object until every handle has closed;
+    // if they do not in time the session is left open rather than freed
+    // under them
+    {
+        unique_lock<mutex> lock(engineMutex);
+        if (!drained.wait_for(lock, chrono::milliseconds(STOP_WAIT_MS), [this]() { return table.InFlight() == 0; })) {
+            LOG_WARNING("Async requests still closing; leaving the session open");
+            return;
+        }
+    }
+
+    for (HINTERNET connection : connections) {
+        if (connection) {
+            WinHttpCloseHandle(connection);
+        }
+    }
+    connections.clear();
+    WinHttpSetStatusCallback(session, nullptr, 0, 0);
+    WinHttpCloseHandle(session);
+    session = nullptr;
+}
+
+uint64_t AsyncHttpEngine::Submit(size_t endpoint, const string& path, string_view postData, bool binary,
+                                 uint32_t timeoutMs, Completion done, DataHandler onData) {
+    if (!running || endpoint >= connections.size() || !connections[endpoint]) {
+        return 0;
+    }
+
+    Context* ctx = new Context();
+    ctx->engine = this;
+    ctx->postData.assign(postData.data(), postData.size());
+    ctx->done = std::move(done);
+    ctx->onData = std::move(onData);
+    {
+        lock_guard<mutex> lock(engineMutex);
+        ctx->id = table.Acquire(ctx);
+        if (ctx->id == 0) {
+            rejected++;
+            delete ctx;
+            return 0;
+        }
+        ctx->buffer = table.Buffer(ctx->id);
+    }
+    uint64_t id = ctx->id;
+
+    wstring wPath(path.begin(), path.end());
+    ctx->request = WinHttpOpenRequest(connections[endpoint], L"POST", wPath.c_str(), nullptr, WINHTTP_NO_REFERER,
+                                      WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
+    if (!ctx->request) {
+        lock_guard<mutex> lock(engineMutex);
+        table.Release(id);
+        delete ctx;
+        return 0;
+    }
+
+    // Set before anything can fail, so HANDLE_CLOSING always finds the context
+    DWORD_PTR contextValue = reinterpret_cast<DWORD_PTR>(ctx);
+    WinHttpSetOption(ctx->request, WINHTTP_OPTION_CONTEXT_VALUE, &contextValue, sizeof(contextValue));
+    const wchar_t* headers = binary ? L"Content-Type: application/msgpack\r\nAccept: application/msgpack\r\n"
+                                    : L"Content-Type: application/json\r\n";
+    WinHttpAddRequestHeaders(ctx->request, headers, (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD);
+    if (timeoutMs > 0) {
+        int timeout = static_cast<int>(timeoutMs);
+        WinHttpSetTimeouts(ctx->request, timeout, timeout, timeout, timeout);
+    }
+
+    submitted++;
+    DWORD length = static_cast<DWORD>(ctx->postData.size());
+    if (!WinHttpSendRequest(ctx->request, WINHTTP_NO_ADDITIONAL_HEADERS, 0, (LPVOID)ctx->postData.data(), length,
+                            length, contextValue)) {
+        // Not started: the caller hears 0, not a completion
+        {
+            lock_guard<mutex> lock(engineMutex);
+            ctx->done = nullptr;
+        }
+        failed++;
+        Finish(ctx, false);
+        return 0;
+    }
+    // Callbacks may already have finished and freed ctx
+    return id;
+}
+
+bool AsyncHttpEngine::Cancel(uint64_t id) {
+    HINTERNET request = nullptr;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        Context* ctx = static_cast<Context*>(table.Find(id));
+        if (!ctx || ctx->closed || ctx->finished) {
+            return false;
+        }
+        ctx->closed = true;
+        request = ctx->request;
+    }
+    cancelled++;
+    // HANDLE_CLOSING (possibly on this thread) runs the completion
+    WinHttpCloseHandle(request);
+    return true;
+}
+
+void CALLBACK AsyncHttpEngine::StatusCallback(HINTERNET, DWORD_PTR context, DWORD status, LPVOID info,
+                                              DWORD infoLength) {
+    Context* ctx = reinterpret_cast<Context*>(context);
+    if (ctx) {
+        ctx->engine->OnStatus(ctx, status, info, infoLength);
+    }
+}
+
+// send -> receive -> (query data -> read)* -> finish
+void AsyncHttpEngine::OnStatus(Context* ctx, DWORD status, LPVOID info, DWORD infoLength) {
+    switch (status) {
+        case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+            if (!WinHttpReceiveResponse(ctx->request, nullptr)) {
+                Finish(ctx, false);
+            }
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE: {
+            DWORD size = sizeof(ctx->statusCode);
+            WinHttpQueryHeaders(ctx->request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                WINHTTP_HEADER_NAME_BY_INDEX, &ctx->statusCode, &size, WINHTTP_NO_HEADER_INDEX);
+            DWORD protocol = 0;
+            size = sizeof(protocol);
+            if (http2Enabled && WinHttpQueryOption(ctx->request, WINHTTP_OPTION_HTTP_PROTOCOL_USED, &protocol, &size) &&
+                (protocol & WINHTTP_PROTOCOL_FLAG_HTTP2)) {
+                http2Responses++;
+            }
+            if (ctx->statusCode >= 502 && ctx->statusCode <= 504) {
+                Finish(ctx, false);
+            } else {
+                ReadNext(ctx);
+            }
+            break;
+        }
+
+        case WINHTTP_CALLBACK_STATUS_DATA_AVAILABLE: {
+            DWORD available = *static_cast<DWORD*>(info);
+            if (available == 0) {
+                Finish(ctx, true);
+            } else if (!WinHttpReadData(ctx->request, ctx->buffer,
+                                        min(available, static_cast<DWORD>(RequestTable::READ_BUFFER_BYTES)), nullptr)) {
+                Finish(ctx, false);
+            }
+            break;
+        }
+
+        case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+            if (infoLength == 0) {
+                Finish(ctx, true);
+            } else {
+                ctx->response.append(static_cast<const char*>(info), infoLength);
+                if (ctx->onData) {
+                    ctx->onData(string_view(static_cast<const char*>(info), infoLength));
+                }
+                ReadNext(ctx);
+            }
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+            Finish(ctx, false);
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+            Closed(ctx);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AsyncHttpEngine::ReadNext(Context* ctx) {
+    if (!WinHttpQueryDataAvailable(ctx->request, nullptr)) {
+        Finish(ctx, false);
+    }
+}
+
+// Runs the completion once, then closes the handle unless Cancel already did
+void AsyncHttpEngine::Finish(Context* ctx, bool answered) {
+    Completion done;
+    HINTERNET request = nullptr;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        if (ctx->finished) {
+            return;
+        }
+        ctx->finished = true;
+        done = std::move(ctx->done);
+        if (!ctx->closed) {
+            ctx->closed = true;
+            request = ctx->request;
+        }
+    }
+
+    answered = answered && !ctx->response.empty();
+    if (done) {
+        if (answered) {
+            completed++;
+        } else {
+            failed++;
+        }
+        done(answered ? std::move(ctx->response) : PooledString(), ctx->statusCode);
+    }
+    if (request) {
+        WinHttpCloseHandle(request);
+    }
+}
+
+// Last callback for a request: cancelled requests complete here
+void AsyncHttpEngine::Closed(Context* ctx) {
+    Finish(ctx, false);
+    {
+        lock_guard<mutex> lock(engineMutex);
+        table.Release(ctx->id);
+        drained.notify_all();
+    }
+    delete ctx;
+}
+
+#else
+
+namespace {
+
+const uint32_t DEFAULT_TIMEOUT_MS = 30000;   // WinHTTP's default receive timeout
+const int LOOP_TICK_MS = 100;                // Granularity of request timeouts
+
+uint64_t NowMs() {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Value of header name in the header block [begin, end), or npos
+size_t FindHeader(const string& in, size_t begin, size_t end, const char* name) {
+    size_t nameLength = strlen(name);
+    for (size_t line = begin; line < end;) {
+        size_t lineEnd = in.find("\r\n", line);
+        if (lineEnd == string::npos || lineEnd > end) {
+            lineEnd = end;
+        }
+        if (lineEnd - line > nameLength && in[line + nameLength] == ':' &&
+            strncasecmp(in.c_str() + line, name, nameLength) == 0) {
+            size_t value = line + nameLength + 1;
+            while (value < lineEnd && in[value] == ' ') {
+                value++;
+            }
+            return value;
+        }
+        line = lineEnd + 2;
+    }
+    return string::npos;
+}
+
+// Parses the first response in "in": returns the bytes it takes, 0 while it
+// is incomplete, or npos when it is malformed. A response without
+// Content-Length or chunking ends with the connection (atEof).
+size_t ParseResponse(const string& in, bool atEof, uint32_t& statusCode, PooledString& body, bool& keepAlive) {
+    size_t headerEnd = in.find("\r\n\r\n");
+    if (headerEnd == string::npos) {
+        return 0;
+    }
+    if (in.compare(0, 5, "HTTP/") != 0 || in.find(' ') == string::npos) {
+        return string::npos;
+    }
+    statusCode = static_cast<uint32_t>(strtoul(in.c_str() + in.find(' ') + 1, nullptr, 10));
+    size_t bodyStart = headerEnd + 4;
+
+    size_t connection = FindHeader(in, 0, headerEnd, "Connection");
+    keepAlive = connection == string::npos || strncasecmp(in.c_str() + connection, "close", 5) != 0;
+
+    size_t encoding = FindHeader(in, 0, headerEnd, "Transfer-Encoding");
+    if (encoding != string::npos && strncasecmp(in.c_str() + encoding, "chunked", 7) == 0) {
+        PooledString decoded;
+        size_t at = bodyStart;
+        while (true) {
+            size_t sizeEnd = in.find("\r\n", at);
+            if (sizeEnd == string::npos) {
+                return 0;
+            }
+            size_t chunk = strtoul(in.c_str() + at, nullptr, 16);
+            at = sizeEnd + 2;
+            if (chunk == 0) {
+                // Optional trailers, then a blank line
+                size_t end = in.compare(at, 2, "\r\n") == 0 ? at + 2 : in.find("\r\n\r\n", at);
+                if (end == string::npos) {
+                    return 0;
+                }
+                body = std::move(decoded);
+                return end == at + 2 ? end : end + 4;
+            }
+            if (in.size() < at + chunk + 2) {
+                return 0;
+            }
+            decoded.append(in, at, chunk);
+            at += chunk + 2;
+        }
+    }
+
+    size_t length = FindHeader(in, 0, headerEnd, "Content-Length");
+    if (length != string::npos) {
+        size_t bodyLength = strtoul(in.c_str() + length, nullptr, 10);
+        if (in.size() < bodyStart + bodyLength) {
+            return 0;
+        }
+        body.assign(in, bodyStart, bodyLength);
+        return bodyStart + bodyLength;
+    }
+    if (statusCode == 204 || statusCode == 304) {
+        body.clear();
+        return bodyStart;
+    }
+    if (!atEof) {
+        return 0;
+    }
+    body.assign(in, bodyStart, string::npos);
+    keepAlive = false;
+    return in.size();
+}
+
+}  // namespace
+
+// Written once by Submit; the loop thread reads it under engineMutex
+struct AsyncHttpEngine::Context {
+    uint64_t id;
+    size_t endpoint;
+    PooledString request;    // The whole HTTP message
+    Completion done;
+    DataHandler onData;
+    uint64_t deadlineMs;
+
+    Context() : id(0), endpoint(0), deadlineMs(0) {}
+};
+
+// Loop thread only. Answers come back in the order requests were written,
+// so "waiting" maps each one to its id; a cancelled id's answer is read and
+// dropped.
+struct AsyncHttpEngine::Connection {
+    size_t endpoint;
+    int fd;                  // -1 while closed
+    bool connecting;
+    string out;
+    string in;
+    deque<uint64_t> waiting;
+
+    explicit Connection(size_t endpoint) : endpoint(endpoint), fd(-1), connecting(false) {}
+};
+
+AsyncHttpEngine::AsyncHttpEngine()
+    : epollFd(-1), wakeFd(-1), table(MAX_IN_FLIGHT), running(false), http2Enabled(false), submitted(0),
+      completed(0), failed(0), cancelled(0), rejected(0), http2Responses(0) {
+}
+
+AsyncHttpEngine::~AsyncHttpEngine() {
+    Stop();
+}
+
+bool AsyncHttpEngine::Start(const wchar_t* agent) {
+    userAgent.clear();
+    for (const wchar_t* c = agent; c && *c; ++c) {
+        userAgent += static_cast<char>(*c < 0x80 ? *c : '?');
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epollFd < 0 || wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0) {
+        if (epollFd >= 0) {
+            close(epollFd);
+        }
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        epollFd = wakeFd = -1;
+        return false;
+    }
+
+    running = true;
+    loop = thread(&AsyncHttpEngine::Run, this);
+    return true;
+}
+
+void AsyncHttpEngine::AddEndpoint(const string& host, int port) {
+    Endpoint endpoint = {};
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &found) == 0 && found) {
+        memcpy(&endpoint.address, found->ai_addr, found->ai_addrlen);
+        endpoint.addressLength = found->ai_addrlen;
+        freeaddrinfo(found);
+    }
+    endpoint.hostHeader = port == 80 ? host : host + ":" + to_string(port);
+    endpoints.push_back(endpoint);
+}
+
+void AsyncHttpEngine::Stop() {
+    if (!loop.joinable()) {
+        return;
+    }
+    running = false;
+    Wake();
+    loop.join();
+
+    // The loop is gone: whatever is left completes here, empty
+    vector<uint64_t> ids;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        table.CollectIds(ids);
+        pending.clear();
+    }
+    for (uint64_t id : ids) {
+        Cancel(id);
+    }
+    for (Connection* connection : connections) {
+        if (connection->fd >= 0) {
+            close(connection->fd);
+        }
+        delete connection;
+    }
+    connections.clear();
+    close(wakeFd);
+    close(epollFd);
+    epollFd = wakeFd = -1;
+}
+
+uint64_t AsyncHttpEngine::Submit(size_t endpoint, const string& path, string_view postData, bool binary,
+                                 uint32_t timeoutMs, Completion done, DataHandler onData) {
+    if (!running || endpoint >= endpoints.size() || endpoints[endpoint].addressLength == 0) {
+        return 0;
+    }
+
+    Context* ctx = new Context();
+    ctx->endpoint = endpoint;
+    ctx->done = std::move(done);
+    ctx->onData = std::move(onData);
+    ctx->deadlineMs = NowMs() + (timeoutMs > 0 ? timeoutMs : DEFAULT_TIMEOUT_MS);
+    ctx->request.append("POST ").append(path).append(" HTTP/1.1\r\nHost: ").append(endpoints[endpoint].hostHeader);
+    ctx->request.append("\r\nUser-Agent: ").append(userAgent).append("\r\n");
+    ctx->request.append(binary ? "Content-Type: application/msgpack\r\nAccept: application/msgpack\r\n"
+                               : "Content-Type: application/json\r\n");
+    ctx->request.append("Content-Length: ").append(to_string(postData.size())).append("\r\n\r\n");
+    ctx->request.append(postData.data(), postData.size());
+
+    uint64_t id;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        id = table.Acquire(ctx);
+        if (id == 0) {
+            rejected++;
+            delete ctx;
+            return 0;
+        }
+        ctx->id = id;
+        pending.push_back(id);
+    }
+    submitted++;
+    Wake();
+    return id;
+}
+
+// Completes on the caller; the answer, if it still comes, is dropped
+bool AsyncHttpEngine::Cancel(uint64_t id) {
+    Context* ctx = Take(id);
+    if (!ctx) {
+        return false;
+    }
+    cancelled++;
+    Complete(ctx, PooledString(), 0);
+    return true;
+}
+
+void AsyncHttpEngine::Run() {
+    epoll_event events[MAX_IN_FLIGHT];
+    while (running) {
+        deque<uint64_t> submittedIds;
+        {
+            lock_guard<mutex> lock(engineMutex);
+            submittedIds.swap(pending);
+        }
+        for (uint64_t id : submittedIds) {
+            Assign(id);
+        }
+
+        int count = epoll_wait(epollFd, events, static_cast<int>(MAX_IN_FLIGHT), LOOP_TICK_MS);
+        for (int i = 0; i < count; ++i) {
+            Connection* connection = static_cast<Connection*>(events[i].data.ptr);
+            if (!connection) {
+                uint64_t wakes;
+                while (read(wakeFd, &wakes, sizeof(wakes)) > 0) {
+                }
+                continue;
+            }
+            // Dropped by an earlier event of this batch
+            if (connection->fd < 0) {
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                Receive(connection);
+            }
+            if (connection->fd >= 0 && (events[i].events & EPOLLOUT)) {
+                if (connection->connecting) {
+                    int error = 0;
+                    socklen_t length = sizeof(error);
+                    getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                    if (error != 0) {
+                        Drop(connection);
+                        continue;
+                    }
+                    connection->connecting = false;
+                }
+                Flush(connection);
+            }
+        }
+        Expire(NowMs());
+    }
+}
+
+void AsyncHttpEngine::Wake() {
+    uint64_t one = 1;
+    if (wakeFd >= 0 && write(wakeFd, &one, sizeof(one)) < 0) {
+        // Already signalled (counter saturated); the loop wakes anyway
+    }
+}
+
+// The endpoint's least loaded connection takes the request, opening another
+// while there are fewer than MAX_CONNECTIONS_PER_SERVER and all are busy
+void AsyncHttpEngine::Assign(uint64_t id) {
+    size_t endpoint;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        Context* ctx = static_cast<Context*>(table.Find(id));
+        if (!ctx) {
+            return;
+        }
+        endpoint = ctx->endpoint;
+    }
+
+    Connection* best = nullptr;
+    Connection* closed = nullptr;
+    size_t open = 0;
+    for (Connection* connection : connections) {
+        if (connection->endpoint != endpoint) {
+            continue;
+        }
+        if (connection->fd < 0) {
+            closed = closed ? closed : connection;
+        } else {
+            open++;
+            if (!best || connection->waiting.size() < best->waiting.size()) {
+                best = connection;
+            }
+        }
+    }
+    if ((!best || !best->waiting.empty()) && open < MAX_CONNECTIONS_PER_SERVER) {
+        if (!closed) {
+            closed = new Connection(endpoint);
+            connections.push_back(closed);
+        }
+        if (closed && Open(closed)) {
+            best = closed;
+        }
+    }
+    if (!best) {
+        Context* ctx = Take(id);
+        if (ctx) {
+            Complete(ctx, PooledString(), 0);
+        }
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(engineMutex);
+        Context* ctx = static_cast<Context*>(table.Find(id));
+        if (!ctx) {
+            return;
+        }
+        best->out.append(ctx->request.data(), ctx->request.size());
+    }
+    best->waiting.push_back(id);
+    if (!best->connecting) {
+        Flush(best);
+    }
+}
+
+bool AsyncHttpEngine::Open(Connection* connection) {
+    const Endpoint& endpoint = endpoints[connection->endpoint];
+    int fd = socket(endpoint.address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&endpoint.address), endpoint.addressLength) != 0 &&
+        errno != EINPROGRESS) {
+        close(fd);
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.ptr = connection;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        close(fd);
+        return false;
+    }
+    connection->fd = fd;
+    connection->connecting = true;
+    return true;
+}
+
+void AsyncHttpEngine::Flush(Connection* connection) {
+    while (!connection->out.empty()) {
+        ssize_t sent = send(connection->fd, connection->out.data(), connection->out.size(), MSG_NOSIGNAL);
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (sent <= 0) {
+            Drop(connection);
+            return;
+        }
+        connection->out.erase(0, static_cast<size_t>(sent));
+    }
+    epoll_event event = {};
+    event.events = connection->out.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    event.data.ptr = connection;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+void AsyncHttpEngine::Receive(Connection* connection) {
+    char buffer[RequestTable::READ_BUFFER_BYTES];
+    ssize_t received;
+    while ((received = read(connection->fd, buffer, sizeof(buffer))) > 0) {
+        connection->in.append(buffer, static_cast<size_t>(received));
+    }
+    bool atEof = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+
+    while (!connection->waiting.empty()) {
+        uint32_t statusCode = 0;
+        PooledString body;
+        bool keepAlive = true;
+        size_t length = ParseResponse(connection->in, atEof, statusCode, body, keepAlive);
+        if (length == 0 || length == string::npos) {
+            break;
+        }
+        connection->in.erase(0, length);
+        uint64_t id = connection->waiting.front();
+        connection->waiting.pop_front();
+        Context* ctx = Take(id);
+        if (ctx) {
+            Complete(ctx, std::move(body), statusCode);
+        }
+        if (!keepAlive) {
+            atEof = true;
+            break;
+        }
+    }
+    // Bytes nobody asked for mean the stream is out of step
+    if (atEof || (connection->waiting.empty() && !connection->in.empty())) {
+        Drop(connection);
+    }
+}
+
+// Requests still waiting on the connection fail with it
+void AsyncHttpEngine::Drop(Connection* connection) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    close(connection->fd);
+    connection->fd = -1;
+    connection->connecting = false;
+    connection->in.clear();
+    connection->out.clear();
+    deque<uint64_t> waiting;
+    waiting.swap(connection->waiting);
+    for (uint64_t id : waiting) {
+        Context* ctx = Take(id);
+        if (ctx) {
+            Complete(ctx, PooledString(), 0);
+        }
+    }
+}
+
+// A request past its deadline takes its connection down: answers behind it
+// on the connection would only come after its own
+void AsyncHttpEngine::Expire(uint64_t nowMs) {
+    for (Connection* connection : connections) {
+        if (connection->fd < 0) {
+            continue;
+        }
+        bool expired = false;
+        {
+            lock_guard<mutex> lock(engineMutex);
+            for (uint64_t id : connection->waiting) {
+                Context* ctx = static_cast<Context*>(table.Find(id));
+                if (ctx && ctx->deadlineMs <= nowMs) {
+                    expired = true;
+                    break;
+                }
+            }
+        }
+        if (expired) {
+            Drop(connection);
+        }
+    }
+}
+
+AsyncHttpEngine::Context* AsyncHttpEngine::Take(uint64_t id) {
+    lock_guard<mutex> lock(engineMutex);
+    return static_cast<Context*>(table.Release(id));
+}
+
+// Gateway errors (502-504) complete empty, as on WinHTTP
+void AsyncHttpEngine::Complete(Context* ctx, PooledString response, uint32_t statusCode) {
+    bool answered = !response.empty() && (statusCode < 502 || statusCode > 504);
+    if (answered && ctx->onData) {
+        ctx->onData(string_view(response.data(), response.size()));
+    }
+    if (ctx->done) {
+        if (answered) {
+            completed++;
+        } else {
+            failed++;
+        }
+        ctx->done(answered ? std::move(response) : PooledString(), statusCode);
+    }
+    delete ctx;
+}
+
+#endif
+
+size_t AsyncHttpEngine::InFlight() const {
+    lock_guard<mutex> lock(engineMutex);
+    return table.InFlight();
+}
+
+AsyncHttpStats AsyncHttpEngine::GetStats() const {
+    AsyncHttpStats stats;
+    {
+        lock_guard<mutex> lock(engineMutex);
+        stats.inFlight = table.InFlight();
+        stats.peakInFlight = table.Peak();
+        stats.capacity = table.Capacity();
+        stats.tableBytes = table.BytesAllocated();
+    }
+    stats.running = running;
+    stats.http2Enabled = http2Enabled;
+    stats.submitted = submitted;
+    stats.completed = completed;
+    stats.failed = failed;
+    stats.cancelled = cancelled;
+    stats.rejected = rejected;
+    stats.http2Responses = http2Responses;
+    return stats;
+}
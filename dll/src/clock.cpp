@@ -0,0 +1,52 @@
+// clock.cpp - System and virtual time sources behind the Clock interface
+
+#include <chrono>
+#include <thread>
+
+#include "../include/clock.h"
+
+using namespace std;
+
+uint64_t SystemClock::Now() const {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool SystemClock::WaitFor(unique_lock<mutex>& lock, condition_variable& condition, uint32_t timeoutMs,
+                          const function<bool()>& ready) {
+    return condition.wait_for(lock, chrono::milliseconds(timeoutMs), ready);
+}
+
+void SystemClock::SleepFor(uint32_t ms) {
+    this_thread::sleep_for(chrono::milliseconds(ms));
+}
+
+void VirtualClock::Pass(uint64_t deadlineMs, const function<bool()>& ready) {
+    if (waitHandler) {
+        waitHandler(deadlineMs, ready);
+    }
+    if (!ready()) {
+        AdvanceTo(deadlineMs);
+    }
+}
+
+bool VirtualClock::WaitFor(unique_lock<mutex>& lock, condition_variable&, uint32_t timeoutMs,
+                           const function<bool()>& ready) {
+    if (ready()) {
+        return true;
+    }
+    // Whatever runs meanwhile takes the lock, as it would during a real wait
+    lock.unlock();
+    Pass(now + timeoutMs, ready);
+    lock.lock();
+    return ready();
+}
+
+void VirtualClock::SleepFor(uint32_t ms) {
+    Pass(now + ms, []() { return false; });
+}
+
+Clock& GetSystemClock() {
+    static SystemClock clock;
+    return clock;
+}
@@ -8,6 +8,8 @@
 #include "../include/translator_core.h"
 #include "../include/logging.h"
 #include "../include/utils.h"
+#include "../include/tracing.h"
+#include "../include/startup.h"
 
 using namespace std;
 
@@ -21,34 +23,20 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
     {
     case DLL_PROCESS_ATTACH:
     {
+        uint64_t attachStartUs = TraceNowUs();
+
         // Store module handle
         g_hModule = hModule;
 
-        // Initialize logging first
-        if (!InitializeLogging()) {
-            MessageBoxW(NULL, L"Failed to initialize logging system.", L"WoWTranslate", MB_OK | MB_ICONERROR);
-            return FALSE;
-        }
-
-        LOG_INFO("WoWTranslate: DLL_PROCESS_ATTACH");
-        LOG_INFO("Initializing WoWTranslate library v0.1...");
-
-        // Initialize translation client
-        g_translator = std::make_unique<TranslationClient>();
-        if (!g_translator) {
-            LOG_ERROR("Failed to create translation client");
-            MessageBoxW(NULL, L"Failed to initialize translation system.", L"WoWTranslate", MB_OK | MB_ICONERROR);
-            return FALSE;
-        }
+        // Only the hook is installed under the loader lock; logging, the
+        // translation client and WinHTTP are set up on the startup thread,
+        // which also reports a failed hook install
+        bool hooked = InitializeLuaInterface();
 
-        // Initialize Lua interface
-        if (!InitializeLuaInterface()) {
-            LOG_ERROR("Failed to initialize Lua interface");
-            MessageBoxW(NULL, L"Failed to initialize Lua interface.", L"WoWTranslate", MB_OK | MB_ICONERROR);
+        if (!BeginStartup(attachStartUs, hooked)) {
+            CleanupLuaInterface();
             return FALSE;
         }
-
-        LOG_INFO("WoWTranslate initialization complete");
         break;
     }
     case DLL_PROCESS_DETACH:
@@ -57,12 +45,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
 
         // Cleanup in reverse order
         CleanupLuaInterface();
+        ShutdownStartup();
 
-        if (g_translator) {
-            g_translator->Cleanup();
-            g_translator.reset();
-        }
-
+        StopTracing();
         CleanupLogging();
         break;
     }
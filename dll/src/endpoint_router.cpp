@@ -0,0 +1,174 @@
+// endpoint_router.cpp - Latency- and error-aware choice between proxy endpoints
+
+#include "../include/endpoint_router.h"
+
+using namespace std;
+
+EndpointRouter::EndpointRouter() : failovers(0) {
+}
+
+size_t EndpointRouter::Add(const string& name) {
+    lock_guard<mutex> lock(routerMutex);
+    if (endpoints.size() >= MAX_ENDPOINTS) {
+        return NO_ENDPOINT;
+    }
+
+    Endpoint endpoint;
+    endpoint.name = name;
+    endpoint.rttMs = -1.0;
+    endpoint.errorRate = 0.0;
+    endpoint.consecutiveFailures = 0;
+    endpoint.cooldownMs = BASE_COOLDOWN_MS;
+    endpoint.downUntilMs = 0;
+    endpoint.lastUsedMs = 0;
+    endpoint.ejected = false;
+    endpoint.probing = false;
+    endpoint.requests = 0;
+    endpoint.failures = 0;
+    endpoint.ejections = 0;
+    endpoints.push_back(endpoint);
+    return endpoints.size() - 1;
+}
+
+size_t EndpointRouter::Count() const {
+    lock_guard<mutex> lock(routerMutex);
+    return endpoints.size();
+}
+
+string EndpointRouter::Name(size_t endpoint) const {
+    lock_guard<mutex> lock(routerMutex);
+    return endpoint < endpoints.size() ? endpoints[endpoint].name : string();
+}
+
+double EndpointRouter::ScoreLocked(const Endpoint& endpoint) const {
+    return endpoint.rttMs * (1.0 + ERROR_PENALTY * endpoint.errorRate);
+}
+
+// Order of preference: a due probe, an unmeasured endpoint, an idle one due
+// for re-measuring, then the best score; ejected endpoints only as a last resort
+EndpointChoice EndpointRouter::Select(uint64_t nowMs, uint32_t excluded) {
+    lock_guard<mutex> lock(routerMutex);
+
+    size_t best = NO_ENDPOINT;
+    size_t stale = NO_ENDPOINT;
+    size_t due = NO_ENDPOINT;
+    double bestScore = 0.0;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        if (excluded & (1u << i)) {
+            continue;
+        }
+
+        Endpoint& endpoint = endpoints[i];
+        if (endpoint.ejected) {
+            if (!endpoint.probing && nowMs >= endpoint.downUntilMs) {
+                endpoint.probing = true;
+                return EndpointChoice{ i, true };
+            }
+            if (due == NO_ENDPOINT || endpoint.downUntilMs < endpoints[due].downUntilMs) {
+                due = i;
+            }
+            continue;
+        }
+
+        if (endpoint.rttMs < 0.0) {
+            return EndpointChoice{ i, false };
+        }
+        if (stale == NO_ENDPOINT && nowMs >= endpoint.lastUsedMs + REMEASURE_MS) {
+            stale = i;
+        }
+        double score = ScoreLocked(endpoint);
+        if (best == NO_ENDPOINT || score < bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    if (stale != NO_ENDPOINT) {
+        // Claimed now so concurrent requests do not all go to re-measure it
+        endpoints[stale].lastUsedMs = nowMs;
+        return EndpointChoice{ stale, false };
+    }
+    if (best != NO_ENDPOINT) {
+        endpoints[best].lastUsedMs = nowMs;
+        return EndpointChoice{ best, false };
+    }
+    return EndpointChoice{ due, false };
+}
+
+void EndpointRouter::EjectLocked(Endpoint& endpoint, uint64_t nowMs) {
+    endpoint.ejected = true;
+    endpoint.probing = false;
+    endpoint.downUntilMs = nowMs + endpoint.cooldownMs;
+    endpoint.cooldownMs = endpoint.cooldownMs * 2 < MAX_COOLDOWN_MS ? endpoint.cooldownMs * 2 : MAX_COOLDOWN_MS;
+    ++endpoint.ejections;
+}
+
+void EndpointRouter::Record(size_t endpoint, uint64_t nowMs, uint32_t rttMs, bool ok) {
+    lock_guard<mutex> lock(routerMutex);
+    if (endpoint >= endpoints.size()) {
+        return;
+    }
+
+    Endpoint& e = endpoints[endpoint];
+    ++e.requests;
+    if (ok) {
+        e.rttMs = e.rttMs < 0.0 ? rttMs : e.rttMs + RTT_WEIGHT * (rttMs - e.rttMs);
+        e.errorRate *= 1.0 - ERROR_WEIGHT;
+        e.consecutiveFailures = 0;
+        e.lastUsedMs = nowMs;
+        if (e.ejected) {
+            e.ejected = false;
+            e.probing = false;
+            e.cooldownMs = BASE_COOLDOWN_MS;
+        }
+        return;
+    }
+
+    ++e.failures;
+    e.errorRate += ERROR_WEIGHT * (1.0 - e.errorRate);
+    ++e.consecutiveFailures;
+    if (e.probing || (!e.ejected && e.consecutiveFailures >= EJECT_AFTER_FAILURES)) {
+        EjectLocked(e, nowMs);
+    }
+}
+
+void EndpointRouter::ReleaseProbe(size_t endpoint) {
+    lock_guard<mutex> lock(routerMutex);
+    if (endpoint < endpoints.size()) {
+        endpoints[endpoint].probing = false;
+    }
+}
+
+uint64_t EndpointRouter::GetFailovers() const {
+    lock_guard<mutex> lock(routerMutex);
+    return failovers;
+}
+
+void EndpointRouter::RecordFailover() {
+    lock_guard<mutex> lock(routerMutex);
+    ++failovers;
+}
+
+vector<EndpointStats> EndpointRouter::GetStats(uint64_t nowMs) const {
+    lock_guard<mutex> lock(routerMutex);
+    vector<EndpointStats> stats;
+    stats.reserve(endpoints.size());
+    for (const Endpoint& e : endpoints) {
+        EndpointStats s;
+        s.name = e.name;
+        if (!e.ejected) {
+            s.state = EndpointState::UP;
+        } else if (e.probing || nowMs >= e.downUntilMs) {
+            s.state = EndpointState::PROBING;
+        } else {
+            s.state = EndpointState::DOWN;
+        }
+        s.rttMs = e.rttMs < 0.0 ? 0 : static_cast<uint32_t>(e.rttMs + 0.5);
+        s.errorPercent = static_cast<uint32_t>(e.errorRate * 100.0 + 0.5);
+        s.requests = e.requests;
+        s.failures = e.failures;
+        s.ejections = e.ejections;
+        stats.push_back(s);
+    }
+    return stats;
+}
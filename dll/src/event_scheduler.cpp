@@ -0,0 +1,47 @@
+// event_scheduler.cpp - Deterministic discrete-event loop on virtual time
+
+#include "../include/event_scheduler.h"
+
+using namespace std;
+
+EventScheduler::EventScheduler(VirtualClock& clock) : clock(clock), nextSequence(0), eventsRun(0) {
+    clock.SetWaitHandler([this](uint64_t deadlineMs, const function<bool()>& ready) { RunUntil(deadlineMs, ready); });
+}
+
+EventScheduler::~EventScheduler() {
+    clock.SetWaitHandler(VirtualClock::WaitHandler());
+}
+
+void EventScheduler::At(uint64_t timeMs, Event event) {
+    Scheduled scheduled;
+    scheduled.timeMs = timeMs > clock.Now() ? timeMs : clock.Now();
+    scheduled.sequence = nextSequence++;
+    scheduled.event = std::move(event);
+    events.push(std::move(scheduled));
+}
+
+void EventScheduler::After(uint64_t delayMs, Event event) {
+    At(clock.Now() + delayMs, std::move(event));
+}
+
+size_t EventScheduler::RunUntil(uint64_t endMs) {
+    return RunUntil(endMs, []() { return false; });
+}
+
+size_t EventScheduler::RunUntil(uint64_t endMs, const function<bool()>& done) {
+    size_t run = 0;
+    while (!events.empty() && events.top().timeMs <= endMs) {
+        // Popped before running so the event can schedule more
+        Event event = events.top().event;
+        clock.AdvanceTo(events.top().timeMs);
+        events.pop();
+        event();
+        ++run;
+        ++eventsRun;
+        if (done()) {
+            return run;
+        }
+    }
+    clock.AdvanceTo(endMs);
+    return run;
+}
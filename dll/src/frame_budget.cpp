@@ -0,0 +1,100 @@
+// frame_budget.cpp - Per-frame time accounting for the UnitXP bridge
+
+#include "../include/frame_budget.h"
+
+using namespace std;
+
+FrameBudget::FrameBudget(uint32_t budgetMicros)
+    : budgetMicros(budgetMicros), inFrame(false), frameHint(0), frameIndex(0), frameMicros(0),
+      frameWorstCall(0), frameWorstCause(nullptr), callStart(0), lastCallEnd(0),
+      frames(0), overBudgetFrames(0), calls(0), maxFrameMicros(0), maxCallMicros(0),
+      partialPolls(0), deferredRequests(0), refusedRequests(0), overruns(), overrunCount(0) {
+}
+
+void FrameBudget::CloseFrame() {
+    if (!inFrame) {
+        return;
+    }
+
+    ++frames;
+    if (frameMicros > maxFrameMicros) {
+        maxFrameMicros = frameMicros;
+    }
+    if (budgetMicros && frameMicros > budgetMicros) {
+        ++overBudgetFrames;
+        BudgetOverrun& overrun = overruns[overrunCount % OVERRUN_HISTORY];
+        overrun.frame = frameIndex;
+        overrun.frameMicros = static_cast<uint32_t>(frameMicros);
+        overrun.callMicros = static_cast<uint32_t>(frameWorstCall);
+        overrun.cause = frameWorstCause;
+        ++overrunCount;
+    }
+    inFrame = false;
+}
+
+void FrameBudget::BeginCall(uint64_t nowMicros, double hint) {
+    bool quiet = !inFrame || nowMicros - lastCallEnd > FRAME_GAP_MICROS;
+
+    bool newFrame;
+    if (hint != 0) {
+        // A frame opened by a hint-less call (chat events run before
+        // OnUpdate) adopts the first hint seen shortly after it
+        newFrame = frameHint != 0 ? hint != frameHint : quiet;
+    } else {
+        newFrame = quiet;
+    }
+
+    if (newFrame) {
+        CloseFrame();
+        inFrame = true;
+        ++frameIndex;
+        frameMicros = 0;
+        frameWorstCall = 0;
+        frameWorstCause = nullptr;
+        frameHint = hint;
+    } else if (hint != 0) {
+        frameHint = hint;
+    }
+    callStart = nowMicros;
+}
+
+void FrameBudget::EndCall(uint64_t nowMicros, const char* cause) {
+    uint64_t elapsed = nowMicros - callStart;
+    ++calls;
+    frameMicros += elapsed;
+    lastCallEnd = nowMicros;
+    if (elapsed > maxCallMicros) {
+        maxCallMicros = elapsed;
+    }
+    if (elapsed >= frameWorstCall) {
+        frameWorstCall = elapsed;
+        frameWorstCause = cause;
+    }
+}
+
+bool FrameBudget::Exhausted(uint64_t nowMicros) const {
+    return budgetMicros != 0 && frameMicros + (nowMicros - callStart) >= budgetMicros;
+}
+
+FrameBudgetStats FrameBudget::GetStats() const {
+    FrameBudgetStats stats;
+    stats.budgetMicros = budgetMicros;
+    stats.frames = frames;
+    stats.overBudgetFrames = overBudgetFrames;
+    stats.calls = calls;
+    stats.maxFrameMicros = maxFrameMicros;
+    stats.maxCallMicros = maxCallMicros;
+    stats.partialPolls = partialPolls;
+    stats.deferredRequests = deferredRequests;
+    stats.refusedRequests = refusedRequests;
+    return stats;
+}
+
+size_t FrameBudget::GetOverruns(BudgetOverrun* out, size_t maxCount) const {
+    size_t available = overrunCount < OVERRUN_HISTORY ? overrunCount : OVERRUN_HISTORY;
+    size_t count = maxCount < available ? maxCount : available;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = overruns[(overrunCount - 1 - i) % OVERRUN_HISTORY];
+    }
+    return count;
+}
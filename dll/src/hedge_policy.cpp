@@ -0,0 +1,89 @@
+// hedge_policy.cpp - Adaptive threshold and budget for hedged proxy requests
+
+#include <algorithm>
+
+#include "../include/hedge_policy.h"
+
+using namespace std;
+
+HedgePolicy::HedgePolicy()
+    : enabled(false), budgetPercent(DEFAULT_BUDGET_PERCENT), samples(), sampleCount(0), nextSample(0),
+      cachedThreshold(0), thresholdStale(false), tokens(0), requests(0), hedges(0), hedgeWins(0),
+      budgetDenied(0) {
+}
+
+void HedgePolicy::Configure(bool enable, uint32_t percent) {
+    lock_guard<mutex> lock(policyMutex);
+    enabled = enable;
+    budgetPercent = min<uint32_t>(percent, 100);
+}
+
+bool HedgePolicy::IsEnabled() const {
+    lock_guard<mutex> lock(policyMutex);
+    return enabled;
+}
+
+uint32_t HedgePolicy::BeginRequest() {
+    lock_guard<mutex> lock(policyMutex);
+    ++requests;
+    if (!enabled) {
+        return 0;
+    }
+    tokens = min(tokens + budgetPercent / 100.0, static_cast<double>(MAX_BURST_TOKENS));
+    return ThresholdLocked();
+}
+
+bool HedgePolicy::TryHedge() {
+    lock_guard<mutex> lock(policyMutex);
+    if (tokens < 1.0) {
+        ++budgetDenied;
+        return false;
+    }
+    tokens -= 1.0;
+    ++hedges;
+    return true;
+}
+
+void HedgePolicy::RecordLatency(uint32_t latencyMs) {
+    lock_guard<mutex> lock(policyMutex);
+    samples[nextSample] = latencyMs;
+    nextSample = (nextSample + 1) % SAMPLE_WINDOW;
+    if (sampleCount < SAMPLE_WINDOW) {
+        ++sampleCount;
+    }
+    thresholdStale = true;
+}
+
+void HedgePolicy::RecordHedgeWin() {
+    lock_guard<mutex> lock(policyMutex);
+    ++hedgeWins;
+}
+
+// Percentile of the recent window, recomputed only after new samples
+uint32_t HedgePolicy::ThresholdLocked() const {
+    if (sampleCount < MIN_SAMPLES) {
+        return 0;
+    }
+    if (thresholdStale) {
+        uint32_t sorted[SAMPLE_WINDOW];
+        copy(samples, samples + sampleCount, sorted);
+        size_t rank = (sampleCount * DEFAULT_PERCENTILE) / 100;
+        nth_element(sorted, sorted + rank, sorted + sampleCount);
+        cachedThreshold = sorted[rank] > MIN_THRESHOLD_MS ? sorted[rank] : MIN_THRESHOLD_MS;
+        thresholdStale = false;
+    }
+    return cachedThreshold;
+}
+
+HedgeStats HedgePolicy::GetStats() const {
+    lock_guard<mutex> lock(policyMutex);
+    HedgeStats stats;
+    stats.enabled = enabled;
+    stats.budgetPercent = budgetPercent;
+    stats.thresholdMs = ThresholdLocked();
+    stats.requests = requests;
+    stats.hedges = hedges;
+    stats.hedgeWins = hedgeWins;
+    stats.budgetDenied = budgetDenied;
+    return stats;
+}
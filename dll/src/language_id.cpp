@@ -0,0 +1,391 @@
+// language_id.cpp - Script and character-trigram language identification
+
+#include <array>
+#include <cstdint>
+
+#include "../include/language_id.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+namespace {
+
+enum Language : uint8_t {
+    LANG_EN, LANG_DE, LANG_FR, LANG_ES, LANG_PT, LANG_RU, LANG_ZH, LANG_COUNT
+};
+
+constexpr string_view kLanguageCodes[LANG_COUNT] = { "en", "de", "fr", "es", "pt", "ru", "zh" };
+
+// ============================================================================
+// Trigram profiles for Latin-script text ('_' marks a word boundary).
+// LANG_RU is romanized Russian and LANG_ZH is pinyin. Weight 3 marks
+// trigrams that are distinctive for the language, 1 those shared widely.
+// ============================================================================
+
+struct TrigramWeight {
+    const char* gram;
+    Language language;
+    uint8_t weight;
+};
+
+constexpr TrigramWeight kTrigrams[] = {
+    // English
+    { "_th", LANG_EN, 3 }, { "the", LANG_EN, 3 }, { "he_", LANG_EN, 1 }, { "and", LANG_EN, 2 },
+    { "nd_", LANG_EN, 1 }, { "_to", LANG_EN, 2 }, { "ing", LANG_EN, 2 }, { "ng_", LANG_EN, 1 },
+    { "_yo", LANG_EN, 2 }, { "you", LANG_EN, 2 }, { "ou_", LANG_EN, 1 }, { "_is", LANG_EN, 1 },
+    { "_wh", LANG_EN, 3 }, { "hat", LANG_EN, 2 }, { "tha", LANG_EN, 2 }, { "_of", LANG_EN, 2 },
+    { "of_", LANG_EN, 2 }, { "for", LANG_EN, 2 }, { "ed_", LANG_EN, 2 }, { "ave", LANG_EN, 1 },
+    { "ith", LANG_EN, 2 }, { "wit", LANG_EN, 2 }, { "_an", LANG_EN, 1 }, { "ll_", LANG_EN, 1 },
+    { "ly_", LANG_EN, 3 }, { "_wa", LANG_EN, 2 }, { "ght", LANG_EN, 3 }, { "_lf", LANG_EN, 3 },
+    { "lfg", LANG_EN, 3 }, { "_wt", LANG_EN, 3 }, { "_ne", LANG_EN, 1 }, { "eed", LANG_EN, 2 },
+    { "_it", LANG_EN, 2 }, { "it_", LANG_EN, 1 }, { "_me", LANG_EN, 1 }, { "thi", LANG_EN, 2 },
+    { "his", LANG_EN, 2 }, { "oul", LANG_EN, 2 }, { "ck_", LANG_EN, 2 }, { "_ca", LANG_EN, 1 },
+
+    // German
+    { "ich", LANG_DE, 3 }, { "_ic", LANG_DE, 2 }, { "ch_", LANG_DE, 2 }, { "der", LANG_DE, 2 },
+    { "die", LANG_DE, 3 }, { "_di", LANG_DE, 1 }, { "und", LANG_DE, 3 }, { "_un", LANG_DE, 1 },
+    { "ein", LANG_DE, 3 }, { "_ei", LANG_DE, 2 }, { "sch", LANG_DE, 3 }, { "cht", LANG_DE, 3 },
+    { "ist", LANG_DE, 2 }, { "das", LANG_DE, 2 }, { "nic", LANG_DE, 3 }, { "mit", LANG_DE, 2 },
+    { "auf", LANG_DE, 3 }, { "ung", LANG_DE, 3 }, { "gen", LANG_DE, 2 }, { "eit", LANG_DE, 2 },
+    { "den", LANG_DE, 2 }, { "ber", LANG_DE, 2 }, { "_zu", LANG_DE, 3 }, { "sie", LANG_DE, 2 },
+    { "hab", LANG_DE, 3 }, { "_wi", LANG_DE, 1 }, { "wir", LANG_DE, 3 }, { "_au", LANG_DE, 1 },
+    { "ach", LANG_DE, 2 }, { "och", LANG_DE, 2 }, { "_ge", LANG_DE, 2 }, { "ier", LANG_DE, 2 },
+    { "hen", LANG_DE, 2 }, { "_kn", LANG_DE, 1 }, { "uch", LANG_DE, 3 }, { "_ja", LANG_DE, 1 },
+
+    // French
+    { "_le", LANG_FR, 2 }, { "les", LANG_FR, 3 }, { "_la", LANG_FR, 1 }, { "_qu", LANG_FR, 2 },
+    { "que", LANG_FR, 2 }, { "_et", LANG_FR, 2 }, { "est", LANG_FR, 1 }, { "_pa", LANG_FR, 1 },
+    { "pas", LANG_FR, 2 }, { "ous", LANG_FR, 3 }, { "vou", LANG_FR, 3 }, { "_vo", LANG_FR, 1 },
+    { "_je", LANG_FR, 3 }, { "je_", LANG_FR, 3 }, { "ais", LANG_FR, 3 }, { "ait", LANG_FR, 3 },
+    { "our", LANG_FR, 2 }, { "pou", LANG_FR, 3 }, { "eur", LANG_FR, 3 }, { "une", LANG_FR, 2 },
+    { "_ce", LANG_FR, 2 }, { "ent", LANG_FR, 1 }, { "_de", LANG_FR, 1 }, { "_un", LANG_FR, 1 },
+    { "oi_", LANG_FR, 3 }, { "moi", LANG_FR, 3 }, { "_ou", LANG_FR, 2 }, { "eux", LANG_FR, 3 },
+    { "ez_", LANG_FR, 3 }, { "_av", LANG_FR, 2 }, { "tou", LANG_FR, 2 }, { "_il", LANG_FR, 2 },
+    { "ien", LANG_FR, 1 }, { "_ch", LANG_FR, 1 }, { "on_", LANG_FR, 1 }, { "lle", LANG_FR, 1 },
+
+    // Spanish
+    { "_de", LANG_ES, 1 }, { "que", LANG_ES, 2 }, { "_qu", LANG_ES, 1 }, { "_el", LANG_ES, 3 },
+    { "el_", LANG_ES, 2 }, { "_la", LANG_ES, 1 }, { "los", LANG_ES, 3 }, { "_lo", LANG_ES, 2 },
+    { "os_", LANG_ES, 1 }, { "_es", LANG_ES, 1 }, { "_en", LANG_ES, 1 }, { "_co", LANG_ES, 1 },
+    { "con", LANG_ES, 1 }, { "por", LANG_ES, 2 }, { "_po", LANG_ES, 1 }, { "ado", LANG_ES, 2 },
+    { "ada", LANG_ES, 2 }, { "_un", LANG_ES, 1 }, { "una", LANG_ES, 2 }, { "est", LANG_ES, 1 },
+    { "mos", LANG_ES, 3 }, { "amo", LANG_ES, 2 }, { "_y_", LANG_ES, 3 }, { "ien", LANG_ES, 1 },
+    { "ero", LANG_ES, 2 }, { "par", LANG_ES, 1 }, { "ara", LANG_ES, 1 },
+    { "alg", LANG_ES, 3 }, { "uie", LANG_ES, 3 }, { "nec", LANG_ES, 2 }, { "_mu", LANG_ES, 1 },
+    { "_ho", LANG_ES, 1 }, { "ola", LANG_ES, 2 }, { "_si", LANG_ES, 1 }, { "aci", LANG_ES, 2 },
+    { "cia", LANG_ES, 2 }, { "ias", LANG_ES, 2 }, { "igo", LANG_ES, 2 }, { "_gr", LANG_ES, 1 },
+
+    // Portuguese
+    { "_de", LANG_PT, 1 }, { "que", LANG_PT, 1 }, { "_qu", LANG_PT, 1 }, { "_o_", LANG_PT, 3 },
+    { "os_", LANG_PT, 1 }, { "as_", LANG_PT, 1 }, { "com", LANG_PT, 2 }, { "_co", LANG_PT, 1 },
+    { "voc", LANG_PT, 3 }, { "oce", LANG_PT, 3 }, { "_um", LANG_PT, 3 }, { "um_", LANG_PT, 3 },
+    { "uma", LANG_PT, 2 }, { "ndo", LANG_PT, 2 }, { "nte", LANG_PT, 1 }, { "lho", LANG_PT, 3 },
+    { "nho", LANG_PT, 3 }, { "nha", LANG_PT, 3 }, { "eu_", LANG_PT, 2 }, { "_eu", LANG_PT, 3 },
+    { "_na", LANG_PT, 1 }, { "_no", LANG_PT, 1 }, { "_ta", LANG_PT, 1 }, { "ado", LANG_PT, 1 },
+    { "_pr", LANG_PT, 1 }, { "_pa", LANG_PT, 1 }, { "ra_", LANG_PT, 1 }, { "_em", LANG_PT, 3 },
+    { "_ma", LANG_PT, 1 }, { "ais", LANG_PT, 1 }, { "mai", LANG_PT, 2 }, { "ao_", LANG_PT, 2 },
+    { "obr", LANG_PT, 2 }, { "_fa", LANG_PT, 1 }, { "_ob", LANG_PT, 1 }, { "_se", LANG_PT, 1 },
+    { "zer", LANG_PT, 2 }, { "faz", LANG_PT, 3 }, { "orr", LANG_PT, 1 }, { "_vo", LANG_PT, 1 },
+
+    // Romanized Russian
+    { "pri", LANG_RU, 2 }, { "riv", LANG_RU, 3 }, { "ive", LANG_RU, 1 }, { "vet", LANG_RU, 3 },
+    { "_ka", LANG_RU, 1 }, { "kak", LANG_RU, 3 }, { "ak_", LANG_RU, 1 }, { "_ne", LANG_RU, 1 },
+    { "eto", LANG_RU, 3 }, { "_et", LANG_RU, 1 }, { "cht", LANG_RU, 1 }, { "hto", LANG_RU, 3 },
+    { "sht", LANG_RU, 3 }, { "ogo", LANG_RU, 3 }, { "ego", LANG_RU, 2 }, { "_ya", LANG_RU, 3 },
+    { "ya_", LANG_RU, 3 }, { "_ty", LANG_RU, 3 }, { "ty_", LANG_RU, 2 }, { "_vy", LANG_RU, 3 },
+    { "_my", LANG_RU, 2 }, { "kh_", LANG_RU, 3 }, { "ykh", LANG_RU, 3 }, { "_zh", LANG_RU, 1 },
+    { "sya", LANG_RU, 3 }, { "tsy", LANG_RU, 3 }, { "och", LANG_RU, 1 }, { "che", LANG_RU, 1 },
+    { "_kt", LANG_RU, 3 }, { "kto", LANG_RU, 3 }, { "gde", LANG_RU, 3 }, { "_gd", LANG_RU, 3 },
+    { "ade", LANG_RU, 1 }, { "del", LANG_RU, 1 }, { "ela", LANG_RU, 1 }, { "tak", LANG_RU, 2 },
+    { "_sp", LANG_RU, 1 }, { "sib", LANG_RU, 3 }, { "ibo", LANG_RU, 3 }, { "_da", LANG_RU, 1 },
+    { "oy_", LANG_RU, 3 }, { "iy_", LANG_RU, 3 }, { "yy_", LANG_RU, 3 }, { "ny_", LANG_RU, 2 },
+    { "nuz", LANG_RU, 3 }, { "uzh", LANG_RU, 3 }, { "_pr", LANG_RU, 1 }, { "rya", LANG_RU, 3 },
+    { "_bu", LANG_RU, 1 }, { "ras", LANG_RU, 1 }, { "est", LANG_RU, 1 }, { "_ch", LANG_RU, 1 },
+
+    // Pinyin
+    { "_ni", LANG_ZH, 1 }, { "ni_", LANG_ZH, 3 }, { "_wo", LANG_ZH, 1 }, { "wo_", LANG_ZH, 3 },
+    { "shi", LANG_ZH, 3 }, { "hi_", LANG_ZH, 2 }, { "zai", LANG_ZH, 3 }, { "ai_", LANG_ZH, 1 },
+    { "men", LANG_ZH, 1 }, { "hao", LANG_ZH, 3 }, { "ao_", LANG_ZH, 1 }, { "_bu", LANG_ZH, 1 },
+    { "bu_", LANG_ZH, 3 }, { "zhe", LANG_ZH, 2 }, { "_ge", LANG_ZH, 1 }, { "ge_", LANG_ZH, 2 },
+    { "_ma", LANG_ZH, 1 }, { "ma_", LANG_ZH, 2 }, { "_le", LANG_ZH, 1 }, { "le_", LANG_ZH, 1 },
+    { "ang", LANG_ZH, 2 }, { "ong", LANG_ZH, 2 }, { "uan", LANG_ZH, 3 }, { "ian", LANG_ZH, 2 },
+    { "iao", LANG_ZH, 3 }, { "xia", LANG_ZH, 3 }, { "jia", LANG_ZH, 3 }, { "qin", LANG_ZH, 3 },
+    { "xie", LANG_ZH, 3 }, { "zhi", LANG_ZH, 3 }, { "chi", LANG_ZH, 2 }, { "_qu", LANG_ZH, 1 },
+    { "ren", LANG_ZH, 2 }, { "zhu", LANG_ZH, 3 }, { "dui", LANG_ZH, 3 }, { "lai", LANG_ZH, 3 },
+    { "zuo", LANG_ZH, 3 }, { "_xi", LANG_ZH, 3 }, { "_zh", LANG_ZH, 2 },
+    { "_zu", LANG_ZH, 1 }, { "uo_", LANG_ZH, 3 }, { "ui_", LANG_ZH, 2 },
+    { "eng", LANG_ZH, 2 }, { "_ta", LANG_ZH, 1 }, { "ta_", LANG_ZH, 2 }, { "_de", LANG_ZH, 1 },
+};
+
+constexpr size_t kTrigramCount = sizeof(kTrigrams) / sizeof(kTrigrams[0]);
+
+constexpr uint32_t PackTrigram(char a, char b, char c) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(a)) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(c));
+}
+
+// One row per distinct trigram, with a weight for every language
+struct TrigramRow {
+    uint32_t code;
+    uint8_t weights[LANG_COUNT];
+};
+
+struct TrigramTable {
+    array<TrigramRow, kTrigramCount> rows;
+    size_t size;
+};
+
+constexpr bool TrigramsWellFormed() {
+    for (size_t i = 0; i < kTrigramCount; ++i) {
+        const char* g = kTrigrams[i].gram;
+        if (kTrigrams[i].weight == 0 || g[0] == '\0' || g[1] == '\0' || g[2] == '\0' || g[3] != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(TrigramsWellFormed(), "Trigram profile entries must be three characters with a nonzero weight");
+
+constexpr TrigramTable BuildTrigramTable() {
+    TrigramTable table{};
+    table.size = 0;
+    for (size_t i = 0; i < kTrigramCount; ++i) {
+        const char* g = kTrigrams[i].gram;
+        uint32_t code = PackTrigram(g[0], g[1], g[2]);
+
+        size_t pos = 0;
+        while (pos < table.size && table.rows[pos].code < code) {
+            ++pos;
+        }
+        if (pos == table.size || table.rows[pos].code != code) {
+            for (size_t k = table.size; k > pos; --k) {
+                table.rows[k] = table.rows[k - 1];
+            }
+            table.rows[pos] = TrigramRow{};
+            table.rows[pos].code = code;
+            ++table.size;
+        }
+        table.rows[pos].weights[kTrigrams[i].language] = kTrigrams[i].weight;
+    }
+    return table;
+}
+
+constexpr TrigramTable kTrigramTable = BuildTrigramTable();
+
+const TrigramRow* FindTrigram(uint32_t code) {
+    size_t lo = 0, hi = kTrigramTable.size;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (kTrigramTable.rows[mid].code < code) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < kTrigramTable.size && kTrigramTable.rows[lo].code == code) ? &kTrigramTable.rows[lo] : nullptr;
+}
+
+// ============================================================================
+// Han disambiguation: Japanese shinjitai/kokuji with no Simplified Chinese
+// use, and Simplified Chinese characters and particles absent from Japanese.
+// ============================================================================
+
+template <size_t N>
+constexpr array<uint32_t, N> SortedCodepoints(const uint32_t (&input)[N]) {
+    array<uint32_t, N> out{};
+    for (size_t i = 0; i < N; ++i) {
+        size_t pos = i;
+        while (pos > 0 && out[pos - 1] > input[i]) {
+            out[pos] = out[pos - 1];
+            --pos;
+        }
+        out[pos] = input[i];
+    }
+    return out;
+}
+
+constexpr uint32_t kJapaneseKanjiList[] = {
+    0x6C17, 0x8AAD, 0x5186, 0x99C5, 0x56F3, 0x6B73,  // 気読円駅図歳
+    0x6255, 0x6CA2, 0x52B4, 0x58F2, 0x69D8, 0x8FBC,  // 払沢労売様込
+    0x50CD, 0x7551, 0x5CE0, 0x8FBA, 0x5263, 0x6226,  // 働畑峠辺剣戦
+    0x697D, 0x95A2, 0x5E83, 0x9ED2, 0x770C, 0x5909,  // 楽関広黒県変
+    0x5BFE, 0x5358, 0x55B6, 0x5B9F, 0x767A, 0x7D4C,  // 対単営実発経
+    0x7D9A, 0x7D75, 0x4FA1, 0x899A, 0x89B3, 0x9244,  // 続絵価覚観鉄
+    0x967A, 0x691C, 0x9A13, 0x5E30, 0x4E21, 0x4E57,  // 険検験帰両乗
+    0x4EEE, 0x4F1D, 0x6E08, 0x96A3, 0x983C, 0x51E6,  // 仮伝済隣頼処
+    0x8B72,  // 譲
+};
+
+constexpr uint32_t kSimplifiedChineseList[] = {
+    0x4EEC, 0x8FD9, 0x4E2A, 0x8BF4, 0x65F6, 0x4E48,  // 们这个说时么
+    0x5417, 0x5462, 0x5427, 0x7ED9, 0x8FD8, 0x8BA9,  // 吗呢吧给还让
+    0x5BF9, 0x8FC7, 0x4E3A, 0x4ECE, 0x95E8, 0x95EE,  // 对过为从门问
+    0x95F4, 0x4E1C, 0x8F66, 0x957F, 0x89C1, 0x5173,  // 间东车长见关
+    0x4E70, 0x5356, 0x5E26, 0x7EC4, 0x961F, 0x5E2E,  // 买卖带组队帮
+    0x8C01, 0x600E, 0x6837, 0x94B1, 0x5907, 0x554A,  // 谁怎样钱备啊
+    0x54E6, 0x55EF, 0x54EA, 0x7F3A, 0x5976, 0x56E2,  // 哦嗯哪缺奶团
+    0x8FDB,  // 进
+};
+
+constexpr auto kJapaneseKanji = SortedCodepoints(kJapaneseKanjiList);
+constexpr auto kSimplifiedChinese = SortedCodepoints(kSimplifiedChineseList);
+
+template <size_t N>
+bool ContainsCodepoint(const array<uint32_t, N>& set, uint32_t cp) {
+    size_t lo = 0, hi = N;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (set[mid] < cp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < N && set[lo] == cp;
+}
+
+// Latin-1 and Latin Extended-A letters that hint at one language
+void AddDiacriticHints(uint32_t cp, int* scores) {
+    switch (cp) {
+        case 0xDF: case 0xE4: case 0xF6: case 0xFC:                 // ß ä ö ü
+            scores[LANG_DE] += 4; break;
+        case 0xF1: case 0xBF: case 0xA1:                            // ñ ¿ ¡
+            scores[LANG_ES] += 4; break;
+        case 0xE3: case 0xF5:                                       // ã õ
+            scores[LANG_PT] += 4; break;
+        case 0xE7:                                                  // ç
+            scores[LANG_FR] += 2; scores[LANG_PT] += 2; break;
+        case 0xE8: case 0xEA: case 0xE0: case 0xF9: case 0xE2: case 0xEE: case 0xFB: case 0x153:
+            scores[LANG_FR] += 3; break;                            // è ê à ù â î û œ
+        case 0xE9:                                                  // é
+            scores[LANG_FR] += 1; scores[LANG_ES] += 1; scores[LANG_PT] += 1; break;
+        case 0xE1: case 0xED: case 0xF3: case 0xFA:                 // á í ó ú
+            scores[LANG_ES] += 2; scores[LANG_PT] += 2; break;
+        case 0xF4:                                                  // ô
+            scores[LANG_FR] += 2; scores[LANG_PT] += 2; break;
+        default: break;
+    }
+}
+
+float Clamp01(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+} // namespace
+
+LanguageGuess IdentifyLanguage(string_view text) {
+    size_t han = 0, kana = 0, hangul = 0, cyrillic = 0, latin = 0;
+    size_t japaneseKanji = 0, simplifiedChinese = 0;
+    int scores[LANG_COUNT] = {};
+    size_t grams = 0;
+
+    // Rolling trigram over lowercased ASCII letters, '_' at word boundaries
+    char window[3] = { '_', '_', '_' };
+    bool inWord = false;
+    auto pushLetter = [&](char c) {
+        window[0] = window[1];
+        window[1] = window[2];
+        window[2] = c;
+        if (window[1] == '_' && window[2] == '_') {
+            return;
+        }
+        if (const TrigramRow* row = FindTrigram(PackTrigram(window[0], window[1], window[2]))) {
+            for (int lang = 0; lang < LANG_COUNT; ++lang) {
+                scores[lang] += row->weights[lang];
+            }
+        }
+        ++grams;
+    };
+
+    for (size_t pos = 0; pos < text.size();) {
+        uint32_t cp = NextCodepoint(text, pos);
+
+        if (cp < 0x80 && ((cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z'))) {
+            if (!inWord) {
+                window[1] = '_';
+                window[2] = '_';
+                inWord = true;
+            }
+            pushLetter(static_cast<char>(cp | 0x20));
+            ++latin;
+            continue;
+        }
+
+        if (inWord) {
+            pushLetter('_');
+            inWord = false;
+        }
+
+        if (cp >= 0xA1 && cp <= 0x17F) {
+            AddDiacriticHints(cp, scores);
+            if (cp >= 0xC0) {
+                ++latin;
+            }
+        } else if (cp >= 0x3040 && cp <= 0x30FF) {
+            ++kana;
+        } else if ((cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0x3400 && cp <= 0x4DBF)) {
+            ++han;
+            if (ContainsCodepoint(kJapaneseKanji, cp)) {
+                ++japaneseKanji;
+            } else if (ContainsCodepoint(kSimplifiedChinese, cp)) {
+                ++simplifiedChinese;
+            }
+        } else if ((cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0x1100 && cp <= 0x11FF) || (cp >= 0x3130 && cp <= 0x318F)) {
+            ++hangul;
+        } else if (cp >= 0x0400 && cp <= 0x04FF) {
+            ++cyrillic;
+        }
+    }
+    if (inWord) {
+        pushLetter('_');
+    }
+
+    // Latin letters in CJK chat are mostly names and abbreviations (MC, BWL,
+    // DPS), so they count at half weight against a script-based decision
+    size_t letters = han + kana + hangul + cyrillic + latin;
+    if (letters == 0) {
+        return LanguageGuess{ string_view(), 0.0f };
+    }
+    float scriptTotal = static_cast<float>(han + kana + hangul + cyrillic) + 0.5f * static_cast<float>(latin);
+
+    if (hangul > 0 && hangul >= kana && hangul * 2 >= han) {
+        return LanguageGuess{ "ko", Clamp01(static_cast<float>(hangul + han) / scriptTotal) };
+    }
+    if (kana > 0) {
+        return LanguageGuess{ "ja", Clamp01(static_cast<float>(kana + han) / scriptTotal) };
+    }
+    if (han > 0) {
+        float share = Clamp01(static_cast<float>(han) / scriptTotal);
+        if (japaneseKanji > simplifiedChinese) {
+            // Kanji-only Japanese: only as sure as the marker characters make us
+            float evidence = static_cast<float>(japaneseKanji - simplifiedChinese) / static_cast<float>(japaneseKanji + 1);
+            return LanguageGuess{ "ja", share * evidence };
+        }
+        float evidence = simplifiedChinese > 0 ? 1.0f : 0.8f;
+        return LanguageGuess{ "zh", share * evidence };
+    }
+    if (cyrillic > 0 && cyrillic * 2 >= latin) {
+        return LanguageGuess{ "ru", Clamp01(static_cast<float>(cyrillic) / scriptTotal) };
+    }
+
+    int best = -1, second = 0;
+    for (int lang = 0; lang < LANG_COUNT; ++lang) {
+        if (best < 0 || scores[lang] > scores[best]) {
+            best = lang;
+        }
+    }
+    for (int lang = 0; lang < LANG_COUNT; ++lang) {
+        if (lang != best && scores[lang] > second) {
+            second = scores[lang];
+        }
+    }
+    if (scores[best] <= 0) {
+        return LanguageGuess{ string_view(), 0.0f };
+    }
+
+    // Margin over the runner-up, discounted for short lines ("lol", "gg")
+    float margin = static_cast<float>(scores[best] - second) / static_cast<float>(scores[best]);
+    float coverage = Clamp01(static_cast<float>(grams) / 16.0f);
+    return LanguageGuess{ kLanguageCodes[best], margin * coverage };
+}
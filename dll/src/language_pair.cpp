@@ -0,0 +1,91 @@
+// language_pair.cpp - Interned language pair table for WoWTranslate
+// Entries are append-only, so lookups read published slots without locking
+
+#include <atomic>
+#include <mutex>
+
+#include "../include/language_pair.h"
+
+using namespace std;
+
+static const size_t MAX_LANGUAGE_CODE_LENGTH = 16;
+
+struct LanguagePairTable {
+    LanguagePair pairs[MAX_LANGUAGE_PAIRS];
+    atomic<size_t> count{ 0 };
+    mutex insertMutex;
+
+    LanguagePairTable() {
+        // Pre-seed the default direction so DEFAULT_LANGUAGE_PAIR is always valid
+        pairs[0] = { "zh", "en" };
+        count.store(1, memory_order_release);
+    }
+};
+
+static LanguagePairTable& Table() {
+    static LanguagePairTable table;
+    return table;
+}
+
+bool IsValidLanguageCode(string_view code) {
+    if (code.empty() || code.size() > MAX_LANGUAGE_CODE_LENGTH) {
+        return false;
+    }
+    for (char c : code) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static LanguagePairId FindPair(const LanguagePairTable& table, size_t count, string_view source, string_view target) {
+    for (size_t i = 0; i < count; ++i) {
+        if (table.pairs[i].source == source && table.pairs[i].target == target) {
+            return static_cast<LanguagePairId>(i);
+        }
+    }
+    return INVALID_LANGUAGE_PAIR;
+}
+
+LanguagePairId InternLanguagePair(string_view source, string_view target) {
+    LanguagePairTable& table = Table();
+
+    // Fast path: already interned
+    LanguagePairId id = FindPair(table, table.count.load(memory_order_acquire), source, target);
+    if (id != INVALID_LANGUAGE_PAIR) {
+        return id;
+    }
+
+    if (!IsValidLanguageCode(source) || !IsValidLanguageCode(target)) {
+        return INVALID_LANGUAGE_PAIR;
+    }
+
+    lock_guard<mutex> lock(table.insertMutex);
+    size_t count = table.count.load(memory_order_relaxed);
+    id = FindPair(table, count, source, target);
+    if (id != INVALID_LANGUAGE_PAIR) {
+        return id;
+    }
+    if (count >= MAX_LANGUAGE_PAIRS) {
+        return INVALID_LANGUAGE_PAIR;
+    }
+
+    table.pairs[count] = { string(source), string(target) };
+    table.count.store(count + 1, memory_order_release);
+    return static_cast<LanguagePairId>(count);
+}
+
+const LanguagePair& GetLanguagePair(LanguagePairId id) {
+    LanguagePairTable& table = Table();
+    if (id >= table.count.load(memory_order_acquire)) {
+        return table.pairs[DEFAULT_LANGUAGE_PAIR];
+    }
+    return table.pairs[id];
+}
+
+bool IsCjkLanguage(string_view code) {
+    string_view base = code.substr(0, code.find_first_of("-_"));
+    return base == "zh" || base == "ja" || base == "ko";
+}
@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <sstream>
 #include <mutex>
+#include <atomic>
 
 #include "../include/logging.h"
 #include "../include/utils.h"
@@ -15,7 +16,7 @@
 using namespace std;
 
 // Global logging state
-static bool g_loggingInitialized = false;
+static atomic<bool> g_loggingInitialized{ false };  // Set on the startup thread, read everywhere
 static string g_logFilePath;
 static mutex g_logMutex;
 
@@ -28,15 +29,11 @@ bool InitializeLogging() {
 
     try {
         // Get the DLL directory
-        string dllPath = GetDllPath();
-        if (dllPath.empty()) {
+        string dllDir = GetDllFolder();
+        if (dllDir.empty()) {
             return false;
         }
 
-        // Extract directory from DLL path
-        size_t lastSlash = dllPath.find_last_of("\\/");
-        string dllDir = dllPath.substr(0, lastSlash);
-
         // Create log file path
         g_logFilePath = dllDir + "\\WoWTranslate_debug.log";
 
@@ -3,8 +3,14 @@
 
 #include <windows.h>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
 
 #ifdef MINHOOK_AVAILABLE
 #include "MinHook.h"
@@ -14,6 +20,11 @@
 #include "../include/translator_core.h"
 #include "../include/logging.h"
 #include "../include/utils.h"
+#include "../include/tracing.h"
+#include "../include/startup.h"
+#include "../include/frame_budget.h"
+#include "../include/push_delivery.h"
+#include "../include/subcommand_table.h"
 
 using namespace std;
 
@@ -50,6 +61,13 @@ static LUA_CFUNCTION p_original_UnitXP = nullptr;
 // State tracking
 static bool g_initialized = false;
 
+// InitializeLuaInterface runs in DllMain before the log is open, so it
+// records how the hook install went for LogHookInstall to report later
+static const char* g_hookFailedStep = nullptr;
+#ifdef MINHOOK_AVAILABLE
+static MH_STATUS g_hookStatus = MH_OK;
+#endif
+
 // Helper functions
 void* GetLuaContext() {
     void* result = p_GetContext();
@@ -65,6 +83,12 @@ void lua_pushstring(void* L, const string& str) {
     }
 }
 
+void lua_pushstring(void* L, const char* str) {
+    if (p_lua_pushstring && L) {
+        p_lua_pushstring(L, str);
+    }
+}
+
 void lua_pushboolean(void* L, bool value) {
     if (p_lua_pushboolean && L) {
         p_lua_pushboolean(L, value ? 1 : 0);
@@ -89,6 +113,13 @@ string lua_tostring(void* L, int index) {
     return ptr ? string(ptr) : "";
 }
 
+// Zero-copy view of a Lua string; valid while the value stays on the Lua stack
+string_view lua_tostringview(void* L, int index) {
+    if (!p_lua_tostring || !L) return string_view();
+    const char* ptr = p_lua_tostring(L, index);
+    return ptr ? string_view(ptr) : string_view();
+}
+
 double lua_tonumber(void* L, int index) {
     if (!p_lua_tonumber || !L) return 0.0;
     return p_lua_tonumber(L, index);
@@ -114,212 +145,1257 @@ bool lua_isstring(void* L, int index) {
     return p_lua_isstring(L, index) != 0;
 }
 
+// ============================================================================
+// Game-thread time budget
+// ============================================================================
+
+static FrameBudget g_frameBudget;
+
+// translate_async calls that arrived after this frame's budget ran out. They
+// are queued, in order, by a later poll (game thread only, so no lock).
+struct DeferredRequest {
+    string requestId;
+    string text;
+    LanguagePairId languagePair;
+    vector<LanguagePairId> fanOut;
+    string supersedeKey;
+};
+static vector<DeferredRequest> g_deferredRequests;
+
+static bool QueueRequest(const DeferredRequest& request) {
+    if (!request.fanOut.empty()) {
+        return g_translator->TranslateAsync(request.requestId, request.text, request.fanOut);
+    }
+    return g_translator->TranslateAsync(request.requestId, request.text, request.languagePair, request.supersedeKey);
+}
+
+// Queue deferred requests while budget remains (all of them when force is set).
+// The addon was already told "ok", so one that fails to queue is answered
+// through poll instead of never coming back.
+static void FlushDeferredRequests(bool force) {
+    size_t flushed = 0;
+    while (flushed < g_deferredRequests.size() && (force || !g_frameBudget.Exhausted(TraceNowUs()))) {
+        const DeferredRequest& request = g_deferredRequests[flushed];
+        if (!QueueRequest(request)) {
+            LOG_ERROR("Failed to queue deferred request " + request.requestId);
+            g_translator->PushError(request.requestId, request.fanOut, "failed to queue request");
+        }
+        ++flushed;
+    }
+    g_deferredRequests.erase(g_deferredRequests.begin(), g_deferredRequests.begin() + flushed);
+}
+
+// Queue now, or on a later frame once this one has used its budget. Requests
+// behind a deferred one wait too, so the worker still sees them in order.
+static bool QueueOrDefer(string_view requestId, string_view text, LanguagePairId languagePair,
+                         vector<LanguagePairId> fanOut, string_view supersedeKey) {
+    FlushDeferredRequests(false);
+    if (g_deferredRequests.empty() && !g_frameBudget.Exhausted(TraceNowUs())) {
+        if (!fanOut.empty()) {
+            return g_translator->TranslateAsync(string(requestId), text, fanOut);
+        }
+        return g_translator->TranslateAsync(string(requestId), text, languagePair, supersedeKey);
+    }
+    g_deferredRequests.push_back(DeferredRequest{ string(requestId), string(text), languagePair,
+                                                  std::move(fanOut), string(supersedeKey) });
+    g_frameBudget.RecordDeferred();
+    return true;
+}
+
+// ============================================================================
+// Push delivery
+// ============================================================================
+
+static PushDelivery g_pushDelivery;
+
+// Called from the addon's OnUpdate, the top of the UI's frame: true when
+// results (or deferred requests) are waiting and the addon should drain
+// them with poll_batch, which keeps the frame budget
+static bool PushTick() {
+    if (!g_pushDelivery.IsEnabled()) {
+        return false;
+    }
+    bool waiting = IsStartupComplete() && g_translator &&
+                   (g_translator->HasResults() || !g_deferredRequests.empty());
+    return g_pushDelivery.ShouldDeliver(TraceNowUs(), waiting);
+}
+
+static const char* TranslationErrorString(TranslationResult tr) {
+    switch (tr) {
+        case TranslationResult::NETWORK_ERROR: return "network error";
+        case TranslationResult::API_ERROR: return "API error";
+        case TranslationResult::ENCODING_ERROR: return "encoding error";
+        case TranslationResult::TIMEOUT_ERROR: return "timeout";
+        case TranslationResult::INVALID_PARAMS: return "invalid parameters";
+        default: return "unknown error";
+    }
+}
+
+// PING - Check if DLL is loaded
+static int HandlePing(void* L) {
+    lua_pushstring(L, "pong");
+    return 1;
+}
+
+// VERSION - Get version string
+static int HandleVersion(void* L) {
+    lua_pushstring(L, "WoWTranslate v0.2 - Multi-language Translation via Proxy Server");
+    return 1;
+}
+
+// STATUS - Get current status
+static int HandleStatus(void* L) {
+    string status = "WoWTranslate Status: DLL Active, Translator ";
+    if (!IsStartupComplete()) {
+        lua_pushstring(L, status + "Starting");
+        return 1;
+    }
+    status += (g_translator && g_translator->IsInitialized()) ? "Ready" : "Not Ready";
+    if (g_translator) {
+        status += ", Server: " + g_translator->GetServerInfo();
+        status += ", Pending: " + to_string(g_translator->GetPendingCount());
+        double credits = g_translator->GetCreditsRemaining();
+        if (credits >= 0) {
+            status += ", Credits: " + to_string(static_cast<int>(credits)) + " cents";
+        }
+    }
+    lua_pushstring(L, status);
+    return 1;
+}
+
+// SETKEY - Set the WoWTranslate API key
+// Never blocks the frame: the key is applied immediately or, while the
+// startup thread is still running, when it finishes
+static int HandleSetKey(void* L, int argc) {
+    if (argc >= 3) {
+        string apiKey{ lua_tostringview(L, 3) };
+
+        if (SubmitApiKey(apiKey)) {
+            lua_pushstring(L, "ok");
+            LOG_INFO("API key set in " + to_string(GetStartupTimings().lastSetKeyMicros) + " us");
+        } else {
+            lua_pushstring(L, "error|initialization failed");
+            LOG_ERROR("Failed to initialize with API key");
+        }
+        return 1;
+    }
+    lua_pushstring(L, "error|API key required");
+    return 1;
+}
+
+// CREDITS - Get credits remaining
+static int HandleCredits(void* L) {
+    if (g_translator) {
+        double credits = g_translator->GetCreditsRemaining();
+        if (credits >= 0) {
+            lua_pushnumber(L, credits);
+        } else {
+            lua_pushstring(L, "unknown");
+        }
+    } else {
+        lua_pushstring(L, "error|translator not available");
+    }
+    return 1;
+}
+
+// TRACE - Toggle request-lifecycle tracing (WoWTranslate_trace.json)
+static int HandleTrace(void* L, int argc) {
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on") {
+            lua_pushstring(L, StartTracing() ? "ok" : "error|failed to open trace file");
+        } else if (mode == "off") {
+            StopTracing();
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+    lua_pushstring(L, IsTracingEnabled() ? "on" : "off");
+    return 1;
+}
+
+static const size_t MAX_FAN_OUT_TARGETS = 8;
+
+// TRANSLATE_ASYNC - Queue async translation request
+// Args: requestId, text, [sourceLang|"auto"], [targetLang or "ru,en,..."], [supersedeKey]
+// Optional language params default to zh->en for backward compatibility
+static int HandleTranslateAsync(void* L, int argc) {
+    if (argc < 4) {
+        lua_pushstring(L, "error|requestId and text required");
+        return 1;
+    }
+
+    string_view requestId = lua_tostringview(L, 3);
+    string_view text = lua_tostringview(L, 4);
+
+    // Optional language parameters (default zh->en for backward compat)
+    string_view sourceLang = "zh";
+    string_view targetLang = "en";
+    if (argc >= 6) {
+        sourceLang = lua_tostringview(L, 5);
+        targetLang = lua_tostringview(L, 6);
+    }
+
+    if (!g_translator || !g_translator->IsInitialized()) {
+        lua_pushstring(L, "error|translator not initialized");
+        return 1;
+    }
+
+    if (text.empty()) {
+        lua_pushstring(L, "error|empty text");
+        return 1;
+    }
+
+    // "ru,en,de" fans out to several targets in one proxy call; results come
+    // back as "requestId@ru", "requestId@en", ...
+    if (targetLang.find(',') != string_view::npos) {
+        // Check the whole list before interning any of it: the pair table
+        // holds MAX_LANGUAGE_PAIRS for the life of the process
+        vector<string_view> targets;
+        while (!targetLang.empty()) {
+            size_t comma = targetLang.find(',');
+            string_view target = targetLang.substr(0, comma);
+            targetLang = comma == string_view::npos ? string_view() : targetLang.substr(comma + 1);
+
+            if (!IsValidLanguageCode(sourceLang) || !IsValidLanguageCode(target)) {
+                lua_pushstring(L, "error|invalid language pair");
+                return 1;
+            }
+            if (find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(target);
+            }
+            if (targets.size() > MAX_FAN_OUT_TARGETS) {
+                lua_pushstring(L, "error|too many target languages");
+                return 1;
+            }
+        }
+
+        vector<LanguagePairId> pairs;
+        for (string_view target : targets) {
+            LanguagePairId pair = InternLanguagePair(sourceLang, target);
+            if (pair == INVALID_LANGUAGE_PAIR) {
+                lua_pushstring(L, "error|invalid language pair");
+                return 1;
+            }
+            pairs.push_back(pair);
+        }
+
+        if (QueueOrDefer(requestId, text, pairs.front(), std::move(pairs), string_view())) {
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|failed to queue request");
+        }
+        return 1;
+    }
+
+    LanguagePairId languagePair = InternLanguagePair(sourceLang, targetLang);
+    if (languagePair == INVALID_LANGUAGE_PAIR) {
+        lua_pushstring(L, "error|invalid language pair");
+        return 1;
+    }
+
+    // Optional supersede key: a newer request with the same key replaces this one
+    string_view supersedeKey;
+    if (argc >= 7) {
+        supersedeKey = lua_tostringview(L, 7);
+    }
+
+    if (QueueOrDefer(requestId, text, languagePair, {}, supersedeKey)) {
+        lua_pushstring(L, "ok");
+    } else {
+        lua_pushstring(L, "error|failed to queue request");
+    }
+    return 1;
+}
+
+// Comma-separated result flags for the poll payload, e.g. "near" or "same,lang=en:92"
+static void AppendResultFlags(string& out, const TranslationInfo& info) {
+    size_t start = out.size();
+    auto add = [&](const char* flag) {
+        if (out.size() > start) {
+            out += ',';
+        }
+        out += flag;
+    };
+
+    if (info.flags & TRANSLATION_FLAG_NEAR_DUPLICATE) add("near");
+    if (info.flags & TRANSLATION_FLAG_SAME_LANGUAGE) add("same");
+    if (info.flags & TRANSLATION_FLAG_UNDETERMINED) add("unknown");
+    if (info.flags & TRANSLATION_FLAG_APPROXIMATE) add("approx");
+    if (info.flags & TRANSLATION_FLAG_UNCHANGED) add("unchanged");
+    if (info.flags & TRANSLATION_FLAG_PARTIAL) {
+        char partial[24];
+        snprintf(partial, sizeof(partial), "partial=%u", static_cast<unsigned>(info.partialSequence));
+        add(partial);
+    }
+    if (!info.detectedLanguage.empty()) {
+        char detected[32];
+        snprintf(detected, sizeof(detected), "lang=%.*s:%d", static_cast<int>(info.detectedLanguage.size()),
+                 info.detectedLanguage.data(), static_cast<int>(info.confidence * 100.0f + 0.5f));
+        add(detected);
+    }
+}
+
+// POLL - Poll for completed translation
+// Returns: "requestId|translation|error|credits|flags" or ""
+// Only ever called on the game thread, so the buffers below are reused across
+// calls and an idle poll does not touch the heap.
+// Format: requestId|translation|error|credits|flags
+static void AppendPollRecord(string& payload, const string& requestId, const PooledString& translation,
+                             const PooledString& error, const TranslationInfo& info) {
+    double credits = g_translator->GetCreditsRemaining();
+    payload += requestId;
+    payload += '|';
+    payload += translation;
+    payload += '|';
+    payload += error;
+    payload += '|';
+    if (credits >= 0) {
+        char creditsStr[16];
+        snprintf(creditsStr, sizeof(creditsStr), "%d", static_cast<int>(credits));
+        payload += creditsStr;
+    }
+    payload += '|';
+    AppendResultFlags(payload, info);
+}
+
+static int HandlePoll(void* L) {
+    static string requestId, payload;
+    static PooledString translation, error;
+    TranslationInfo info;
+
+    if (g_translator && !g_deferredRequests.empty()) {
+        FlushDeferredRequests(false);
+    }
+
+    if (!g_translator || !g_translator->PollResult(requestId, translation, error, info)) {
+        lua_pushstring(L, "");
+        return 1;
+    }
+
+    payload.clear();
+    AppendPollRecord(payload, requestId, translation, error, info);
+    lua_pushstring(L, payload);
+    return 1;
+}
+
+static const size_t DEFAULT_POLL_BATCH = 8;
+static const size_t MAX_POLL_BATCH = 32;
+static const char POLL_RECORD_SEPARATOR = '\x1e';  // ASCII record separator
+
+// POLL_BATCH - Several results per call, cut short when the frame budget runs out
+// Args: [max results], [frame time from GetTime()]. Records are poll payloads
+// joined by "\030"; at least one result is returned when any is ready.
+static int HandlePollBatch(void* L, int argc) {
+    static string requestId, payload;
+    static PooledString translation, error;
+
+    size_t maxResults = DEFAULT_POLL_BATCH;
+    if (argc >= 3) {
+        int requested = atoi(string(lua_tostringview(L, 3)).c_str());
+        if (requested > 0) {
+            maxResults = min(static_cast<size_t>(requested), MAX_POLL_BATCH);
+        }
+    }
+
+    payload.clear();
+    if (!g_translator) {
+        lua_pushstring(L, payload);
+        return 1;
+    }
+
+    if (!g_deferredRequests.empty()) {
+        FlushDeferredRequests(false);
+    }
+
+    size_t count = 0;
+    while (count < maxResults && (count == 0 || !g_frameBudget.Exhausted(TraceNowUs()))) {
+        TranslationInfo info;
+        if (!g_translator->PollResult(requestId, translation, error, info)) {
+            break;
+        }
+        if (count > 0) {
+            payload += POLL_RECORD_SEPARATOR;
+        }
+        AppendPollRecord(payload, requestId, translation, error, info);
+        ++count;
+    }
+
+    if (count > 0 && count < maxResults && g_translator->HasResults()) {
+        g_frameBudget.RecordPartialPoll();
+    }
+    lua_pushstring(L, payload);
+    return 1;
+}
+
+// NAMES - Item/quest names for hyperlinks from the mapped name index
+// Args: language ("en" or "zh"), comma-separated "item:ID"/"quest:ID" keys.
+// Returns one name per key, in order, joined by "\030"; unknown keys give "".
+static const size_t MAX_NAME_KEYS = 64;
+
+static int HandleNames(void* L, int argc) {
+    static string payload;
+
+    if (argc < 4) {
+        lua_pushstring(L, "error|language and keys required");
+        return 1;
+    }
+    if (!g_translator || !g_translator->GetNameIndex().IsOpen()) {
+        lua_pushstring(L, "error|no name index");
+        return 1;
+    }
+
+    string_view language = lua_tostringview(L, 3);
+    if (language != "en" && language != "zh") {
+        lua_pushstring(L, "error|expected en or zh");
+        return 1;
+    }
+    NameLanguage nameLanguage = language == "en" ? NAME_LANGUAGE_EN : NAME_LANGUAGE_ZH;
+
+    NameIndex& index = g_translator->GetNameIndex();
+    string_view keys = lua_tostringview(L, 4);
+    auto start = chrono::steady_clock::now();
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    payload.clear();
+    size_t count = 0;
+    while (!keys.empty() && count < MAX_NAME_KEYS) {
+        size_t comma = keys.find(',');
+        string_view key = keys.substr(0, comma);
+        keys = comma == string_view::npos ? string_view() : keys.substr(comma + 1);
+
+        if (count++ > 0) {
+            payload += POLL_RECORD_SEPARATOR;
+        }
+
+        NameKind kind;
+        if (key.compare(0, 5, "item:") == 0) {
+            kind = NAME_KIND_ITEM;
+            key.remove_prefix(5);
+        } else if (key.compare(0, 6, "quest:") == 0) {
+            kind = NAME_KIND_QUEST;
+            key.remove_prefix(6);
+        } else {
+            ++misses;
+            continue;
+        }
+
+        uint32_t id = 0;
+        bool valid = !key.empty() && key.size() <= 9;
+        for (char c : key) {
+            valid = valid && c >= '0' && c <= '9';
+            id = id * 10 + static_cast<uint32_t>(c - '0');
+        }
+
+        string_view name;
+        if (valid && index.Lookup(kind, id, nameLanguage, name)) {
+            payload.append(name.data(), name.size());
+            ++hits;
+        } else {
+            ++misses;
+        }
+    }
+
+    index.RecordLookups(hits, misses, static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()));
+    lua_pushstring(L, payload);
+    return 1;
+}
+
+// TRANSLATE (synchronous) - For testing
+// Args: text, [sourceLang], [targetLang]
+static int HandleTranslate(void* L, int argc) {
+    if (argc < 3) {
+        lua_pushstring(L, "error|text required");
+        return 1;
+    }
+
+    string text{ lua_tostringview(L, 3) };
+
+    // Optional language parameters (default zh->en for backward compat)
+    LanguagePairId languagePair = DEFAULT_LANGUAGE_PAIR;
+    if (argc >= 5) {
+        languagePair = InternLanguagePair(lua_tostringview(L, 4), lua_tostringview(L, 5));
+        if (languagePair == INVALID_LANGUAGE_PAIR) {
+            lua_pushstring(L, "error|invalid language pair");
+            return 1;
+        }
+    }
+
+    if (!g_translator || !g_translator->IsInitialized()) {
+        lua_pushstring(L, "error|translator not initialized");
+        return 1;
+    }
+
+    PooledString result;
+
+    // Out of frame budget: answer from local data or not at all, never block on the network
+    if (g_frameBudget.Exhausted(TraceNowUs())) {
+        if (g_translator->TranslateLocal(text, result, languagePair)) {
+            lua_pushstring(L, result.c_str());
+        } else {
+            g_frameBudget.RecordRefused();
+            lua_pushstring(L, "error|frame budget exceeded");
+        }
+        return 1;
+    }
+
+    TranslationResult tr = g_translator->TranslateText(text, result, languagePair);
+
+    if (tr == TranslationResult::SUCCESS) {
+        lua_pushstring(L, result.c_str());
+        LOG_DEBUG("Sync translation: " + text + " -> " + string(result.c_str()));
+    } else {
+        lua_pushstring(L, string("error|") + TranslationErrorString(tr));
+    }
+    return 1;
+}
+
+// MEMSTATS - Payload pool counters for long-session footprint checks
+static int HandleMemStats(void* L) {
+    PayloadPoolStats stats = PayloadPool::GetStats();
+    string result = "allocs=" + to_string(stats.allocations);
+    result += " recycled=" + to_string(stats.recycled);
+    result += " oversize=" + to_string(stats.oversize);
+    result += " inUse=" + to_string(stats.bytesInUse);
+    result += " peak=" + to_string(stats.peakBytesInUse);
+    result += " slabs=" + to_string(stats.slabBytes);
+    result += " released=" + to_string(stats.slabsReleased);
+    lua_pushstring(L, result);
+    return 1;
+}
+
+static const char* WireProtocolName(WireProtocol protocol) {
+    switch (protocol) {
+        case WireProtocol::JSON: return "json";
+        case WireProtocol::MSGPACK: return "msgpack";
+        default: return "unknown";
+    }
+}
+
+// CACHESTATS - Cache size, memory per entry, hit rate and mean lookup time
+static int HandleCacheStats(void* L) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    TranslationCacheStats stats = g_translator->GetCacheStats();
+    uint64_t lookups = stats.hits + stats.misses;
+    string result = "entries=" + to_string(stats.entries);
+    result += " bytes=" + to_string(stats.approximateBytes);
+    result += " bytesPerEntry=" + to_string(stats.entries ? stats.approximateBytes / stats.entries : 0);
+    result += " hits=" + to_string(stats.hits);
+    result += " misses=" + to_string(stats.misses);
+    result += " collisions=" + to_string(stats.collisions);
+    result += " lookupNs=" + to_string(lookups ? stats.lookupNanos / lookups : 0);
+    result += " templateHits=" + to_string(g_translator->GetTemplateHits());
+
+    uint64_t skipped = 0;
+    for (int kind = 1; kind < PREFLIGHT_CLASS_COUNT; ++kind) {
+        skipped += g_translator->GetPreflightSkipped(static_cast<PreflightClass>(kind));
+    }
+    NegativeCacheStats negative = g_translator->GetNegativeCacheStats();
+    result += " preflightSkipped=" + to_string(skipped);
+    result += " negativeEntries=" + to_string(negative.entries);
+    result += " negativeHits=" + to_string(negative.unchangedHits + negative.rejectedHits);
+
+    TranslationMemoryStats memory = g_translator->GetSegmentMemoryStats();
+    result += " segments=" + to_string(memory.segments);
+    result += " segmentHits=" + to_string(memory.segmentHits);
+    result += " segmentMisses=" + to_string(memory.segmentMisses);
+    result += " localChars=" + to_string(memory.localChars) + "/" + to_string(memory.totalChars);
+
+    PhrasebookStats phrases = g_translator->GetPhrasebookStats();
+    uint64_t phraseLookups = phrases.hits + phrases.misses;
+    result += " phrasebook=" + to_string(phrases.entries);
+    result += " phrasebookMapUs=" + to_string(phrases.openMicros);
+    result += " phrasebookHits=" + to_string(phrases.hits) + "/" + to_string(phraseLookups);
+    result += " phrasebookNs=" + to_string(phraseLookups ? phrases.lookupNanos / phraseLookups : 0);
+
+    NameIndexStats names = g_translator->GetNameIndexStats();
+    uint64_t nameLookups = names.hits + names.misses;
+    result += " nameItems=" + to_string(names.items);
+    result += " nameQuests=" + to_string(names.quests);
+    result += " nameMapUs=" + to_string(names.openMicros);
+    result += " nameHits=" + to_string(names.hits) + "/" + to_string(nameLookups);
+    result += " nameNs=" + to_string(nameLookups ? names.lookupNanos / nameLookups : 0);
+
+    NearDuplicateStats near = g_translator->GetNearDuplicateStats();
+    result += " nearEntries=" + to_string(near.entries);
+    result += " nearHits=" + to_string(near.matches) + "/" + to_string(near.queries);
+    result += " nearScanNs=" + to_string(near.queries ? near.scanNanos / near.queries : 0);
+
+    OfflineEngineStats offline = g_translator->GetOfflineStats();
+    result += " offlineEntries=" + to_string(offline.entries);
+    result += " offlineBytes=" + to_string(offline.approximateBytes);
+    result += " offlineGlosses=" + to_string(offline.fullCoverage) + "/" + to_string(offline.translations);
+    result += " offlineNs=" + to_string(offline.translations ? offline.glossNanos / offline.translations : 0);
+    result += " fanOut=" + to_string(g_translator->GetFanOutRequests());
+    result += " fanOutTargets=" + to_string(g_translator->GetFanOutTargets());
+
+    SharedCacheStats shared = g_translator->GetSharedCacheStats();
+    uint64_t sharedLookups = shared.hits + shared.misses;
+    result += " sharedHits=" + to_string(shared.hits) + "/" + to_string(sharedLookups);
+    result += " sharedPublishes=" + to_string(shared.publishes);
+    result += " sharedWaits=" + to_string(shared.waitHits) + "/" + to_string(shared.waits);
+    result += " sharedNs=" + to_string(sharedLookups ? shared.lookupNanos / sharedLookups : 0);
+    result += " chunked=" + to_string(g_translator->GetChunkedMessages());
+    result += " chunkRequests=" + to_string(g_translator->GetChunkRequests());
+    result += " chunkHits=" + to_string(g_translator->GetChunkCacheHits());
+
+    HedgeStats hedge = g_translator->GetHedgeStats();
+    result += " hedgeMs=" + to_string(hedge.thresholdMs);
+    result += " hedges=" + to_string(hedge.hedges) + "/" + to_string(hedge.requests);
+    result += " hedgeWins=" + to_string(hedge.hedgeWins);
+    result += " hedgeDenied=" + to_string(hedge.budgetDenied);
+    result += " failovers=" + to_string(g_translator->GetFailovers());
+
+    WireProtocolStats wire = g_translator->GetWireStats();
+    result += " wire=" + string(WireProtocolName(wire.protocol));
+    result += " wireRequests=" + to_string(wire.requests);
+    result += " wireSent=" + to_string(wire.bytesSent);
+    result += " wireReceived=" + to_string(wire.bytesReceived);
+    result += " wireEncodeNs=" + to_string(wire.requests ? wire.encodeNanos / wire.requests : 0);
+    result += " wireDecodeNs=" + to_string(wire.requests ? wire.decodeNanos / wire.requests : 0);
+    lua_pushstring(L, result);
+    return 1;
+}
+
+// TEMPLATE - Toggle number/name templating of cache keys
+static int HandleTemplate(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on" || mode == "off") {
+            g_translator->SetTemplatingEnabled(mode == "on");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+    lua_pushstring(L, g_translator->IsTemplatingEnabled() ? "on" : "off");
+    return 1;
+}
+
+// TEMPLATE_NAMES - Replace the player names lifted into template slots
+// Args: comma-separated names (e.g. the current raid roster)
+static int HandleTemplateNames(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    vector<string> names;
+    if (argc >= 3) {
+        for (const string& name : SplitString(string(lua_tostringview(L, 3)), ',')) {
+            string trimmed = TrimString(name);
+            if (trimmed.size() >= 2) {
+                names.push_back(trimmed);
+            }
+        }
+    }
+
+    // Longest names first so "Arthasx" is not split by a shorter "Arthas"
+    sort(names.begin(), names.end(), [](const string& a, const string& b) { return a.size() > b.size(); });
+    size_t count = names.size();
+    g_translator->SetTemplateNames(std::move(names));
+    lua_pushstring(L, "ok|" + to_string(count));
+    return 1;
+}
+
+// SEGMENTS - Toggle segment-level translation memory
+static int HandleSegments(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on" || mode == "off") {
+            g_translator->SetSegmentMemoryEnabled(mode == "on");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+    lua_pushstring(L, g_translator->IsSegmentMemoryEnabled() ? "on" : "off");
+    return 1;
+}
+
+// CHUNKS - Toggle parallel chunked translation of long messages
+static int HandleChunks(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on" || mode == "off") {
+            g_translator->SetChunkingEnabled(mode == "on");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+    lua_pushstring(L, g_translator->IsChunkingEnabled() ? "on" : "off");
+    return 1;
+}
+
+// PREFLIGHT - Toggle answering lines with nothing to translate (numbers,
+// links, raid markers, emoticons, shared abbreviations) without the proxy.
+// Returns "on|numbers=N coordinates=N ...|negative=entries/unchanged/rejected" with no args.
+static int HandlePreflight(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on" || mode == "off") {
+            g_translator->SetPreflightEnabled(mode == "on");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+
+    string result = g_translator->IsPreflightEnabled() ? "on|" : "off|";
+    for (int kind = 1; kind < PREFLIGHT_CLASS_COUNT; ++kind) {
+        PreflightClass preflight = static_cast<PreflightClass>(kind);
+        if (kind > 1) {
+            result += ' ';
+        }
+        result += string(PreflightClassName(preflight)) + "=" + to_string(g_translator->GetPreflightSkipped(preflight));
+    }
+    NegativeCacheStats negative = g_translator->GetNegativeCacheStats();
+    result += "|negative=" + to_string(negative.entries) + "/" + to_string(negative.unchangedHits) + "/" +
+              to_string(negative.rejectedHits);
+    lua_pushstring(L, result);
+    return 1;
+}
+
+// STREAM - Toggle sentence-by-sentence results for long messages; partial
+// poll records carry "partial=N" and the final record follows as usual.
+// Returns "on|supported|messages|partials|avgFirstMs|avgFullMs" with no args.
+static int HandleStream(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on" || mode == "off") {
+            g_translator->SetStreamingEnabled(mode == "on");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+
+    uint64_t messages = g_translator->GetStreamedMessages();
+    char stats[160];
+    snprintf(stats, sizeof(stats), "%s|%d|%llu|%llu|%.0f|%.0f", g_translator->IsStreamingEnabled() ? "on" : "off",
+             g_translator->IsStreamingSupported() ? 1 : 0, static_cast<unsigned long long>(messages),
+             static_cast<unsigned long long>(g_translator->GetStreamPartials()),
+             messages ? g_translator->GetStreamFirstSentenceMicros() / 1000.0 / messages : 0.0,
+             messages ? g_translator->GetStreamFullMicros() / 1000.0 / messages : 0.0);
+    lua_pushstring(L, stats);
+    return 1;
+}
+
+// MULTIPLEX - Toggle sending queued requests and chunks on the async HTTP
+// engine. Returns "on|http2|http2Responses|inFlight|peak|prefetched|used|
+// wasted|fallbacks" with no args.
+static int HandleMultiplex(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "on" || mode == "off") {
+            g_translator->SetMultiplexEnabled(mode == "on");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected on or off");
+        }
+        return 1;
+    }
+
+    AsyncHttpStats engine = g_translator->GetAsyncHttpStats();
+    char stats[192];
+    snprintf(stats, sizeof(stats), "%s|%d|%llu|%zu|%zu|%llu|%llu|%llu|%llu",
+             g_translator->IsMultiplexEnabled() && engine.running ? "on" : "off", engine.http2Enabled ? 1 : 0,
+             static_cast<unsigned long long>(engine.http2Responses), engine.inFlight, engine.peakInFlight,
+             static_cast<unsigned long long>(g_translator->GetPrefetchSubmitted()),
+             static_cast<unsigned long long>(g_translator->GetPrefetchUsed()),
+             static_cast<unsigned long long>(g_translator->GetPrefetchWasted()),
+             static_cast<unsigned long long>(g_translator->GetPrefetchFallbacks()));
+    lua_pushstring(L, stats);
+    return 1;
+}
+
+// WIRE - Choose the request body format
+// Args: "msgpack" (negotiate a binary session, the default) or "json".
+// With no argument returns "preferred|negotiated".
+static int HandleWire(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "msgpack" || mode == "json") {
+            g_translator->SetBinaryProtocolEnabled(mode == "msgpack");
+            lua_pushstring(L, "ok");
+        } else {
+            lua_pushstring(L, "error|expected msgpack or json");
+        }
+        return 1;
+    }
+    string result = g_translator->IsBinaryProtocolEnabled() ? "msgpack|" : "json|";
+    result += WireProtocolName(g_translator->GetWireStats().protocol);
+    lua_pushstring(L, result);
+    return 1;
+}
+
+// CANCEL - Drop a queued request or abandon it in flight
+// Args: requestId. The request still completes through poll, with error "cancelled".
+static int HandleCancel(void* L, int argc) {
+    if (argc < 3) {
+        lua_pushstring(L, "error|requestId required");
+        return 1;
+    }
+
+    if (!g_translator || !g_translator->IsInitialized()) {
+        lua_pushstring(L, "error|translator not initialized");
+        return 1;
+    }
+
+    // A deferred request never reached the translator: answer it here and
+    // leave the rest of the deferred queue to the frame budget
+    string requestId(lua_tostringview(L, 3));
+    auto deferred = find_if(g_deferredRequests.begin(), g_deferredRequests.end(),
+                            [&](const DeferredRequest& request) { return request.requestId == requestId; });
+    if (deferred != g_deferredRequests.end()) {
+        g_translator->PushError(deferred->requestId, deferred->fanOut, "cancelled");
+        g_deferredRequests.erase(deferred);
+        lua_pushstring(L, "ok");
+        return 1;
+    }
+
+    bool cancelled = g_translator->CancelRequest(requestId);
+    lua_pushstring(L, cancelled ? "ok" : "error|not pending");
+    return 1;
+}
+
+// DETECT - Identify the language of a line without translating it
+// Returns: "lang|confidence" (confidence 0-100), or "|0" when undetermined
+static int HandleDetect(void* L, int argc) {
+    if (argc < 3) {
+        lua_pushstring(L, "error|text required");
+        return 1;
+    }
+
+    LanguageGuess guess = IdentifyLanguage(lua_tostringview(L, 3));
+    lua_pushstring(L, string(guess.language) + "|" + to_string(static_cast<int>(guess.confidence * 100.0f + 0.5f)));
+    return 1;
+}
+
+// NEARDUP - Toggle SimHash near-duplicate reuse
+// Args: "on"|"off", [threshold in bits, 0-16]
+static int HandleNearDup(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode != "on" && mode != "off") {
+            lua_pushstring(L, "error|expected on or off");
+            return 1;
+        }
+
+        int threshold = g_translator->GetNearDuplicateThreshold();
+        if (argc >= 4) {
+            threshold = atoi(string(lua_tostringview(L, 4)).c_str());
+            if (threshold < 0 || threshold > 16) {
+                lua_pushstring(L, "error|threshold must be 0-16");
+                return 1;
+            }
+        }
+        g_translator->SetNearDuplicateEnabled(mode == "on", threshold);
+        lua_pushstring(L, "ok");
+        return 1;
+    }
+    lua_pushstring(L, string(g_translator->IsNearDuplicateEnabled() ? "on" : "off") + "|" +
+                      to_string(g_translator->GetNearDuplicateThreshold()));
+    return 1;
+}
+
+// HEDGE - Toggle duplicating slow proxy requests
+// Args: "on"|"off", [extra-load budget in percent]. Returns "on|percent|thresholdMs" with no args.
+static int HandleHedge(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    HedgeStats stats = g_translator->GetHedgeStats();
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode != "on" && mode != "off") {
+            lua_pushstring(L, "error|expected on or off");
+            return 1;
+        }
+
+        int percent = static_cast<int>(stats.budgetPercent);
+        if (argc >= 4) {
+            percent = atoi(string(lua_tostringview(L, 4)).c_str());
+            if (percent < 1 || percent > 50) {
+                lua_pushstring(L, "error|budget must be 1-50 percent");
+                return 1;
+            }
+        }
+        g_translator->SetHedging(mode == "on", static_cast<uint32_t>(percent));
+        lua_pushstring(L, "ok");
+        return 1;
+    }
+    lua_pushstring(L, string(stats.enabled ? "on" : "off") + "|" + to_string(stats.budgetPercent) + "|" +
+                      to_string(stats.thresholdMs));
+    return 1;
+}
+
+// ENDPOINTS - Routing state of each configured proxy endpoint, healthy and fastest first
+// Returns "name|state|rttMs|errorPercent|requests|failures" records joined by "\030"
+static int HandleEndpoints(void* L) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    static const char* const stateNames[] = { "up", "down", "probing" };
+    vector<EndpointStats> endpoints = g_translator->GetEndpointStats();
+    stable_sort(endpoints.begin(), endpoints.end(), [](const EndpointStats& a, const EndpointStats& b) {
+        return a.state < b.state || (a.state == b.state && a.rttMs < b.rttMs);
+    });
+
+    string result;
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        if (i > 0) {
+            result += POLL_RECORD_SEPARATOR;
+        }
+        const EndpointStats& endpoint = endpoints[i];
+        result += endpoint.name;
+        result += "|" + string(stateNames[static_cast<int>(endpoint.state)]);
+        result += "|" + to_string(endpoint.rttMs);
+        result += "|" + to_string(endpoint.errorPercent);
+        result += "|" + to_string(endpoint.requests);
+        result += "|" + to_string(endpoint.failures);
+    }
+    lua_pushstring(L, result);
+    return 1;
+}
+
+// PUSH - Tell the addon when to drain, from its per-frame OnUpdate
+// Args: "on" | "off" | "tick". "tick" returns "1" when results are waiting and
+// the addon should call poll_batch now, "" otherwise. Returns
+// "on|checks|deliveries|throttled" (or "off|...") with no args. Enabling
+// works during startup; ticks report results once it completes.
+static int HandlePush(void* L, int argc) {
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode == "tick") {
+            lua_pushstring(L, PushTick() ? "1" : "");
+            return 1;
+        }
+        if (mode != "on" && mode != "off") {
+            lua_pushstring(L, "error|expected on, off or tick");
+            return 1;
+        }
+        g_pushDelivery.SetEnabled(mode == "on");
+        lua_pushstring(L, "ok");
+        return 1;
+    }
+
+    PushDeliveryStats stats = g_pushDelivery.GetStats();
+    lua_pushstring(L, string(stats.enabled ? "on" : "off") + "|" + to_string(stats.checks) + "|" +
+                      to_string(stats.deliveries) + "|" + to_string(stats.throttled));
+    return 1;
+}
+
+// OFFLINE - Choose when the local dictionary gloss answers instead of the proxy
+// Args: "off"|"fallback"|"first", [first-pass max chars]. Returns "mode|chars" with no args.
+static int HandleOffline(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    static const char* const modeNames[] = { "off", "fallback", "first" };
+
+    if (argc >= 3) {
+        string_view name = lua_tostringview(L, 3);
+        int mode = -1;
+        for (int i = 0; i < 3; ++i) {
+            if (name == modeNames[i]) {
+                mode = i;
+            }
+        }
+        if (mode < 0) {
+            lua_pushstring(L, "error|expected off, fallback or first");
+            return 1;
+        }
+
+        int maxChars = 0;
+        if (argc >= 4) {
+            maxChars = atoi(string(lua_tostringview(L, 4)).c_str());
+            if (maxChars < 1 || maxChars > 64) {
+                lua_pushstring(L, "error|max chars must be 1-64");
+                return 1;
+            }
+        }
+        g_translator->SetOfflineMode(static_cast<OfflineMode>(mode), maxChars);
+        lua_pushstring(L, "ok");
+        return 1;
+    }
+    lua_pushstring(L, string(modeNames[static_cast<int>(g_translator->GetOfflineMode())]) + "|" +
+                      to_string(g_translator->GetOfflineFirstPassChars()));
+    return 1;
+}
+
+// SHARED - Toggle the cache tier shared with other clients on this machine
+static int HandleShared(void* L, int argc) {
+    if (!g_translator) {
+        lua_pushstring(L, "error|translator not available");
+        return 1;
+    }
+
+    if (argc >= 3) {
+        string_view mode = lua_tostringview(L, 3);
+        if (mode != "on" && mode != "off") {
+            lua_pushstring(L, "error|expected on or off");
+        } else if (!g_translator->SetSharedCacheEnabled(mode == "on")) {
+            lua_pushstring(L, "error|shared memory unavailable");
+        } else {
+            lua_pushstring(L, "ok");
+        }
+        return 1;
+    }
+    lua_pushstring(L, g_translator->IsSharedCacheEnabled() ? "on" : "off");
+    return 1;
+}
+
+// BUDGET - Frame budget stats, or set the budget in microseconds (0 = unlimited)
+// Returns key=value stats; "overruns" lists recent frames as cause:frameUs/callUs
+static int HandleBudget(void* L, int argc) {
+    if (argc >= 3) {
+        string arg(lua_tostringview(L, 3));
+        char* end = nullptr;
+        long micros = strtol(arg.c_str(), &end, 10);
+        if (arg.empty() || *end != '\0' || micros < 0 || micros > 100000) {
+            lua_pushstring(L, "error|budget must be 0-100000 microseconds");
+            return 1;
+        }
+        g_frameBudget.SetBudgetMicros(static_cast<uint32_t>(micros));
+        LOG_INFO("Frame budget: " + to_string(micros) + " us");
+        lua_pushstring(L, "ok");
+        return 1;
+    }
+
+    FrameBudgetStats stats = g_frameBudget.GetStats();
+    string result = "budgetUs=" + to_string(stats.budgetMicros);
+    result += " frames=" + to_string(stats.frames);
+    result += " overFrames=" + to_string(stats.overBudgetFrames);
+    result += " calls=" + to_string(stats.calls);
+    result += " maxFrameUs=" + to_string(stats.maxFrameMicros);
+    result += " maxCallUs=" + to_string(stats.maxCallMicros);
+    result += " partialPolls=" + to_string(stats.partialPolls);
+    result += " deferred=" + to_string(stats.deferredRequests);
+    result += " deferredPending=" + to_string(g_deferredRequests.size());
+    result += " refused=" + to_string(stats.refusedRequests);
+
+    BudgetOverrun overruns[FrameBudget::OVERRUN_HISTORY];
+    size_t count = g_frameBudget.GetOverruns(overruns, FrameBudget::OVERRUN_HISTORY);
+    result += " overruns=";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            result += ',';
+        }
+        result += overruns[i].cause ? overruns[i].cause : "unknown";
+        result += ':' + to_string(overruns[i].frameMicros) + '/' + to_string(overruns[i].callMicros);
+    }
+    lua_pushstring(L, result);
+    return 1;
+}
+
+// STARTUP - Deferred startup state and timings
+// Returns: "state|attachUs|logUs|clientUs|totalUs|setkeyUs"
+static int HandleStartup(void* L) {
+    static const char* const stateNames[] = { "not_started", "running", "ready", "failed" };
+    StartupTimings timings = GetStartupTimings();
+    string result = stateNames[static_cast<int>(GetStartupState())];
+    result += "|" + to_string(timings.attachMicros);
+    result += "|" + to_string(timings.logMicros);
+    result += "|" + to_string(timings.clientMicros);
+    result += "|" + to_string(timings.totalMicros);
+    result += "|" + to_string(timings.lastSetKeyMicros);
+    lua_pushstring(L, result);
+    return 1;
+}
+
+// Subcommands that work before the startup thread has created g_translator
+static bool AvailableDuringStartup(Subcommand id) {
+    switch (id) {
+        case Subcommand::Ping:
+        case Subcommand::Version:
+        case Subcommand::Status:
+        case Subcommand::SetKey:
+        case Subcommand::Trace:
+        case Subcommand::MemStats:
+        case Subcommand::Detect:
+        case Subcommand::Startup:
+        case Subcommand::Budget:
+        case Subcommand::Push:
+        case Subcommand::Unknown:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static int RunSubcommand(void* L, int argc, Subcommand id, string_view subcmd) {
+    if (!AvailableDuringStartup(id) && !IsStartupComplete()) {
+        // An idle poll is the normal answer while nothing can be pending
+        bool poll = id == Subcommand::Poll || id == Subcommand::PollBatch;
+        lua_pushstring(L, poll ? "" : "error|starting");
+        return 1;
+    }
+
+    switch (id) {
+        case Subcommand::Ping: return HandlePing(L);
+        case Subcommand::Version: return HandleVersion(L);
+        case Subcommand::Status: return HandleStatus(L);
+        case Subcommand::SetKey: return HandleSetKey(L, argc);
+        case Subcommand::Credits: return HandleCredits(L);
+        case Subcommand::Trace: return HandleTrace(L, argc);
+        case Subcommand::TranslateAsync: return HandleTranslateAsync(L, argc);
+        case Subcommand::Poll: return HandlePoll(L);
+        case Subcommand::Translate: return HandleTranslate(L, argc);
+        case Subcommand::MemStats: return HandleMemStats(L);
+        case Subcommand::CacheStats: return HandleCacheStats(L);
+        case Subcommand::Template: return HandleTemplate(L, argc);
+        case Subcommand::TemplateNames: return HandleTemplateNames(L, argc);
+        case Subcommand::Segments: return HandleSegments(L, argc);
+        case Subcommand::NearDup: return HandleNearDup(L, argc);
+        case Subcommand::Detect: return HandleDetect(L, argc);
+        case Subcommand::Cancel: return HandleCancel(L, argc);
+        case Subcommand::Offline: return HandleOffline(L, argc);
+        case Subcommand::Startup: return HandleStartup(L);
+        case Subcommand::Shared: return HandleShared(L, argc);
+        case Subcommand::Chunks: return HandleChunks(L, argc);
+        case Subcommand::PollBatch: return HandlePollBatch(L, argc);
+        case Subcommand::Budget: return HandleBudget(L, argc);
+        case Subcommand::Wire: return HandleWire(L, argc);
+        case Subcommand::Names: return HandleNames(L, argc);
+        case Subcommand::Hedge: return HandleHedge(L, argc);
+        case Subcommand::Endpoints: return HandleEndpoints(L);
+        case Subcommand::Push: return HandlePush(L, argc);
+        case Subcommand::Preflight: return HandlePreflight(L, argc);
+        case Subcommand::Stream: return HandleStream(L, argc);
+        case Subcommand::Multiplex: return HandleMultiplex(L, argc);
+        case Subcommand::Unknown: break;
+    }
+
+    lua_pushstring(L, "error|unknown command: " + string(subcmd));
+    return 1;
+}
+
+// Every call is charged to the current frame; poll_batch carries the frame time
+static int DispatchSubcommand(void* L, int argc) {
+    if (argc < 2) {
+        lua_pushstring(L, "error|no subcommand specified");
+        return 1;
+    }
+
+    string_view subcmd = lua_tostringview(L, 2);
+    Subcommand id = LookupSubcommand(subcmd);
+
+    double frameHint = (id == Subcommand::PollBatch && argc >= 4) ? lua_tonumber(L, 4) : 0.0;
+    g_frameBudget.BeginCall(TraceNowUs(), frameHint);
+    int results = RunSubcommand(L, argc, id, subcmd);
+    g_frameBudget.EndCall(TraceNowUs(), SubcommandName(id));
+    return results;
+}
+
 // Main WoWTranslate command handler
 // Commands:
 //   UnitXP("WoWTranslate", "ping") -> "pong"
 //   UnitXP("WoWTranslate", "setkey", apiKey) -> "ok" or error
-//   UnitXP("WoWTranslate", "translate_async", requestId, text) -> "ok" or error
-//   UnitXP("WoWTranslate", "poll") -> "requestId|translation|error|credits" or ""
+//   UnitXP("WoWTranslate", "translate_async", requestId, text, [from|"auto"], [to], [supersedeKey]) -> "ok" or error
+//       (to = "ru,en" fans out; results are polled as "requestId@ru" and "requestId@en")
+//   UnitXP("WoWTranslate", "cancel", requestId) -> "ok" or "error|not pending"
+//   UnitXP("WoWTranslate", "poll") -> "requestId|translation|error|credits|flags" or ""
+//   UnitXP("WoWTranslate", "poll_batch", [max], [GetTime()]) -> poll records joined by "\030"
 //   UnitXP("WoWTranslate", "status") -> status string
 //   UnitXP("WoWTranslate", "credits") -> get credits remaining
+//   UnitXP("WoWTranslate", "trace", ["on"|"off"]) -> "ok", or "on"/"off" with no argument
+//   UnitXP("WoWTranslate", "memstats") -> payload pool counters
+//   UnitXP("WoWTranslate", "cachestats") -> cache entries, bytes, hit/miss, lookup time
+//   UnitXP("WoWTranslate", "template", ["on"|"off"]) -> toggle number/name templating
+//   UnitXP("WoWTranslate", "template_names", "A,B,C") -> "ok|count"
+//   UnitXP("WoWTranslate", "segments", ["on"|"off"]) -> toggle segment translation memory
+//   UnitXP("WoWTranslate", "neardup", ["on"|"off"], [bits]) -> toggle near-duplicate reuse
+//   UnitXP("WoWTranslate", "detect", text) -> "lang|confidence"
+//   UnitXP("WoWTranslate", "offline", ["off"|"fallback"|"first"], [chars]) -> offline gloss mode
+//   UnitXP("WoWTranslate", "startup") -> "state|attachUs|logUs|clientUs|totalUs|setkeyUs"
+//   UnitXP("WoWTranslate", "shared", ["on"|"off"]) -> toggle the cross-process cache
+//   UnitXP("WoWTranslate", "chunks", ["on"|"off"]) -> toggle parallel chunks for long messages
+//   UnitXP("WoWTranslate", "budget", [micros]) -> frame budget stats, or set the budget
+//   UnitXP("WoWTranslate", "wire", ["msgpack"|"json"]) -> request format, or "preferred|negotiated"
+//   UnitXP("WoWTranslate", "names", "en"|"zh", "item:19019,quest:4123") -> names joined by "\030"
+//   UnitXP("WoWTranslate", "hedge", ["on"|"off"], [percent]) -> toggle hedged requests
+//   UnitXP("WoWTranslate", "endpoints") -> "name|state|rttMs|errors%|requests|failures" records joined by "\030"
+//   UnitXP("WoWTranslate", "push", ["on"|"off"|"tick"]) -> per-frame tick says when results are ready to drain
+//   UnitXP("WoWTranslate", "preflight", ["on"|"off"]) -> toggle answering untranslatable lines locally
+//   UnitXP("WoWTranslate", "stream", ["on"|"off"]) -> toggle partial results for long messages
+//   UnitXP("WoWTranslate", "multiplex", ["on"|"off"]) -> toggle sending queued requests ahead on the async engine
 int __fastcall detoured_UnitXP(void* L) {
-    try {
-        if (lua_gettop(L) >= 1) {
-            string cmd{ lua_tostring(L, 1) };
-
-            // Check if this is a WoWTranslate command
-            if (cmd == "WoWTranslate") {
-                LOG_DEBUG("WoWTranslate command intercepted");
-
-                if (lua_gettop(L) >= 2) {
-                    string subcmd{ lua_tostring(L, 2) };
-
-                    // PING - Check if DLL is loaded
-                    if (subcmd == "ping") {
-                        lua_pushstring(L, "pong");
-                        LOG_DEBUG("Ping -> Pong");
-                        return 1;
-                    }
-
-                    // VERSION - Get version string
-                    else if (subcmd == "version") {
-                        lua_pushstring(L, "WoWTranslate v0.2 - Multi-language Translation via Proxy Server");
-                        return 1;
-                    }
-
-                    // STATUS - Get current status
-                    else if (subcmd == "status") {
-                        string status = "WoWTranslate Status: DLL Active, Translator ";
-                        status += (g_translator && g_translator->IsInitialized()) ? "Ready" : "Not Ready";
-                        if (g_translator) {
-                            status += ", Server: " + g_translator->GetServerInfo();
-                            status += ", Pending: " + to_string(g_translator->GetPendingCount());
-                            double credits = g_translator->GetCreditsRemaining();
-                            if (credits >= 0) {
-                                status += ", Credits: " + to_string(static_cast<int>(credits)) + " cents";
-                            }
-                        }
-                        lua_pushstring(L, status);
-                        return 1;
-                    }
-
-                    // SETKEY - Set the WoWTranslate API key
-                    else if (subcmd == "setkey") {
-                        if (lua_gettop(L) >= 3) {
-                            string apiKey{ lua_tostring(L, 3) };
-
-                            if (g_translator && g_translator->Initialize(apiKey)) {
-                                lua_pushstring(L, "ok");
-                                LOG_INFO("API key set successfully");
-                            } else {
-                                lua_pushstring(L, "error|initialization failed");
-                                LOG_ERROR("Failed to initialize with API key");
-                            }
-                            return 1;
-                        }
-                        lua_pushstring(L, "error|API key required");
-                        return 1;
-                    }
-
-                    // CREDITS - Get credits remaining
-                    else if (subcmd == "credits") {
-                        if (g_translator) {
-                            double credits = g_translator->GetCreditsRemaining();
-                            if (credits >= 0) {
-                                lua_pushnumber(L, credits);
-                            } else {
-                                lua_pushstring(L, "unknown");
-                            }
-                        } else {
-                            lua_pushstring(L, "error|translator not available");
-                        }
-                        return 1;
-                    }
-
-                    // TRANSLATE_ASYNC - Queue async translation request
-                    // Args: requestId, text, [sourceLang], [targetLang]
-                    // Optional language params default to zh->en for backward compatibility
-                    else if (subcmd == "translate_async") {
-                        if (lua_gettop(L) >= 4) {
-                            string requestId{ lua_tostring(L, 3) };
-                            string text{ lua_tostring(L, 4) };
-
-                            // Optional language parameters (default zh->en for backward compat)
-                            string sourceLang = "zh";
-                            string targetLang = "en";
-                            if (lua_gettop(L) >= 6) {
-                                sourceLang = lua_tostring(L, 5);
-                                targetLang = lua_tostring(L, 6);
-                            }
-
-                            if (!g_translator || !g_translator->IsInitialized()) {
-                                lua_pushstring(L, "error|translator not initialized");
-                                return 1;
-                            }
-
-                            if (text.empty()) {
-                                lua_pushstring(L, "error|empty text");
-                                return 1;
-                            }
-
-                            if (g_translator->TranslateAsync(requestId, text, sourceLang, targetLang)) {
-                                lua_pushstring(L, "ok");
-                                LOG_DEBUG("Async translation queued: " + requestId + " (" + sourceLang + " -> " + targetLang + ")");
-                            } else {
-                                lua_pushstring(L, "error|failed to queue request");
-                            }
-                            return 1;
-                        }
-                        lua_pushstring(L, "error|requestId and text required");
-                        return 1;
-                    }
-
-                    // POLL - Poll for completed translation
-                    // Returns: "requestId|translation|error|credits" or ""
-                    else if (subcmd == "poll") {
-                        if (!g_translator) {
-                            lua_pushstring(L, "");
-                            return 1;
-                        }
-
-                        string requestId, translation, error;
-                        if (g_translator->PollResult(requestId, translation, error)) {
-                            // Format: requestId|translation|error|credits
-                            double credits = g_translator->GetCreditsRemaining();
-                            string creditsStr = (credits >= 0) ? to_string(static_cast<int>(credits)) : "";
-                            string result = requestId + "|" + translation + "|" + error + "|" + creditsStr;
-                            lua_pushstring(L, result);
-                            LOG_DEBUG("Poll returned: " + requestId + " (credits: " + creditsStr + ")");
-                        } else {
-                            // No results available
-                            lua_pushstring(L, "");
-                        }
-                        return 1;
-                    }
-
-                    // TRANSLATE (synchronous) - For testing
-                    // Args: text, [sourceLang], [targetLang]
-                    else if (subcmd == "translate") {
-                        if (lua_gettop(L) >= 3) {
-                            string text{ lua_tostring(L, 3) };
-
-                            // Optional language parameters (default zh->en for backward compat)
-                            string sourceLang = "zh";
-                            string targetLang = "en";
-                            if (lua_gettop(L) >= 5) {
-                                sourceLang = lua_tostring(L, 4);
-                                targetLang = lua_tostring(L, 5);
-                            }
-
-                            if (!g_translator || !g_translator->IsInitialized()) {
-                                lua_pushstring(L, "error|translator not initialized");
-                                return 1;
-                            }
-
-                            string result;
-                            TranslationResult tr = g_translator->TranslateText(text, result, sourceLang, targetLang);
-
-                            if (tr == TranslationResult::SUCCESS) {
-                                lua_pushstring(L, result);
-                                LOG_DEBUG("Sync translation: " + text + " -> " + result);
-                            } else {
-                                string error = "error|";
-                                switch (tr) {
-                                    case TranslationResult::NETWORK_ERROR: error += "network error"; break;
-                                    case TranslationResult::API_ERROR: error += "API error"; break;
-                                    case TranslationResult::ENCODING_ERROR: error += "encoding error"; break;
-                                    case TranslationResult::TIMEOUT_ERROR: error += "timeout"; break;
-                                    case TranslationResult::INVALID_PARAMS: error += "invalid parameters"; break;
-                                    default: error += "unknown error"; break;
-                                }
-                                lua_pushstring(L, error);
-                            }
-                            return 1;
-                        }
-                        lua_pushstring(L, "error|text required");
-                        return 1;
-                    }
-
-                    else {
-                        string error = "error|unknown command: " + subcmd;
-                        lua_pushstring(L, error);
-                        return 1;
-                    }
-                } else {
-                    lua_pushstring(L, "error|no subcommand specified");
-                    return 1;
-                }
-            }
-        }
-
-        // Not our command - call original UnitXP if available
+    // Fast path: every UnitXP call in the game lands here, so calls meant for
+    // other addons are recognised from the raw Lua string and forwarded
+    // without allocating or entering a try block.
+    int argc = lua_gettop(L);
+    if (argc < 1 || lua_tostringview(L, 1) != UNITXP_NAMESPACE) {
         if (p_original_UnitXP) {
             return p_original_UnitXP(L);
         }
 
         // Fallback - return 0 if no original function
         return 0;
+    }
 
+    try {
+        return DispatchSubcommand(L, argc);
     } catch (const exception& e) {
         string error = "WoWTranslate Exception: " + string(e.what());
         LOG_ERROR(error);
@@ -340,38 +1416,48 @@ bool InitializeLuaInterface() {
         return true;
     }
 
-    LOG_INFO("Initializing WoWTranslate Lua interface...");
-
 #ifdef MINHOOK_AVAILABLE
     // Initialize MinHook
-    if (MH_Initialize() != MH_OK) {
-        LOG_ERROR("Failed to initialize MinHook");
+    g_hookStatus = MH_Initialize();
+    if (g_hookStatus != MH_OK) {
+        g_hookFailedStep = "MH_Initialize";
         return false;
     }
 
     // Hook the UnitXP function with our handler
-    if (MH_CreateHook(reinterpret_cast<LPVOID>(p_UnitXP),
-                      reinterpret_cast<LPVOID>(detoured_UnitXP),
-                      reinterpret_cast<LPVOID*>(&p_original_UnitXP)) != MH_OK) {
-        LOG_ERROR("Failed to create hook for UnitXP function");
+    g_hookStatus = MH_CreateHook(reinterpret_cast<LPVOID>(p_UnitXP),
+                                 reinterpret_cast<LPVOID>(detoured_UnitXP),
+                                 reinterpret_cast<LPVOID*>(&p_original_UnitXP));
+    if (g_hookStatus != MH_OK) {
+        g_hookFailedStep = "MH_CreateHook";
         return false;
     }
 
-    if (MH_EnableHook(reinterpret_cast<LPVOID>(p_UnitXP)) != MH_OK) {
-        LOG_ERROR("Failed to enable hook for UnitXP function");
+    g_hookStatus = MH_EnableHook(reinterpret_cast<LPVOID>(p_UnitXP));
+    if (g_hookStatus != MH_OK) {
+        g_hookFailedStep = "MH_EnableHook";
         return false;
     }
-
-    LOG_INFO("Successfully hooked UnitXP function");
-#else
-    LOG_WARNING("MinHook not available - hooks not installed");
 #endif
 
     g_initialized = true;
-    LOG_INFO("WoWTranslate Lua interface initialization complete");
     return true;
 }
 
+// Reports the outcome of InitializeLuaInterface once logging is up
+void LogHookInstall() {
+#ifdef MINHOOK_AVAILABLE
+    if (g_hookFailedStep) {
+        LOG_ERROR(string("Failed to install UnitXP hook: ") + g_hookFailedStep + " returned " +
+                  MH_StatusToString(g_hookStatus));
+    } else if (g_initialized) {
+        LOG_INFO("Successfully hooked UnitXP function");
+    }
+#else
+    LOG_WARNING("MinHook not available - hooks not installed");
+#endif
+}
+
 // Cleanup the Lua interface
 void CleanupLuaInterface() {
     if (!g_initialized) {
@@ -381,7 +1467,8 @@ void CleanupLuaInterface() {
     LOG_INFO("Cleaning up WoWTranslate Lua interface...");
 
 #ifdef MINHOOK_AVAILABLE
-    // Disable and remove hook
+    // Disable and remove hooks
+    g_pushDelivery.SetEnabled(false);
     MH_DisableHook(reinterpret_cast<LPVOID>(p_UnitXP));
     MH_RemoveHook(reinterpret_cast<LPVOID>(p_UnitXP));
     MH_Uninitialize();
@@ -0,0 +1,109 @@
+// message_chunker.cpp - Sentence-boundary splitting of long messages
+
+#include "../include/message_chunker.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+enum class BreakKind {
+    None,
+    Clause,
+    Sentence
+};
+
+static bool IsSpaceCodepoint(uint32_t cp) {
+    return cp == ' ' || cp == '\t' || cp == '\r' || cp == '\n' || cp == 0x3000;
+}
+
+// next is the byte after cp; ASCII '.' only ends a sentence before a space
+// or the end of the text, so "1.5k" and "..." stay whole
+static BreakKind ClassifyBreak(uint32_t cp, string_view text, size_t next) {
+    switch (cp) {
+        case '\n':
+        case '!': case '?': case ';':
+        case 0x3002: case 0xFF01: case 0xFF1F: case 0xFF1B: case 0x2026:   // 。！？；…
+            return BreakKind::Sentence;
+        case '.':
+            return (next == text.size() || text[next] == ' ') ? BreakKind::Sentence : BreakKind::None;
+        case ',': case ' ': case 0x3000:
+        case 0xFF0C: case 0x3001:                                          // ，、
+            return BreakKind::Clause;
+        default:
+            return BreakKind::None;
+    }
+}
+
+static string_view TrimSpaces(string_view text) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t pos = start;
+        if (!IsSpaceCodepoint(NextCodepoint(text, pos))) {
+            break;
+        }
+        start = pos;
+    }
+    size_t end = text.size();
+    while (end > start) {
+        size_t lead = end - 1;
+        while (lead > start && (static_cast<unsigned char>(text[lead]) & 0xC0) == 0x80) {
+            --lead;
+        }
+        size_t pos = lead;
+        if (!IsSpaceCodepoint(NextCodepoint(text, pos))) {
+            break;
+        }
+        end = lead;
+    }
+    return text.substr(start, end - start);
+}
+
+vector<string_view> SplitLongMessage(string_view text, size_t maxChunkBytes) {
+    vector<string_view> chunks;
+    auto emit = [&](size_t start, size_t end) {
+        string_view chunk = TrimSpaces(text.substr(start, end - start));
+        if (!chunk.empty()) {
+            chunks.push_back(chunk);
+        }
+    };
+
+    size_t chunkStart = 0;
+    size_t lastSentence = 0;   // Byte offsets just past a break; 0 = none in this chunk
+    size_t lastClause = 0;
+    size_t pos = 0;
+
+    while (pos < text.size()) {
+        size_t cpStart = pos;
+        uint32_t cp = NextCodepoint(text, pos);
+
+        if (pos - chunkStart > maxChunkBytes) {
+            size_t cut = lastSentence ? lastSentence : lastClause ? lastClause : cpStart;
+            if (cut <= chunkStart) {
+                cut = pos;   // A single codepoint wider than the limit
+            }
+            emit(chunkStart, cut);
+            chunkStart = cut;
+            lastSentence = 0;
+            lastClause = lastClause > cut ? lastClause : 0;
+        }
+
+        BreakKind kind = ClassifyBreak(cp, text, pos);
+        if (kind == BreakKind::Sentence) {
+            lastSentence = pos;
+        } else if (kind == BreakKind::Clause) {
+            lastClause = pos;
+        }
+    }
+    emit(chunkStart, text.size());
+    return chunks;
+}
+
+void JoinChunkTranslations(string& out, string_view translation, bool cjkTarget) {
+    translation = TrimSpaces(translation);
+    if (translation.empty()) {
+        return;
+    }
+    if (!out.empty() && !cjkTarget) {
+        out += ' ';
+    }
+    out.append(translation.data(), translation.size());
+}
@@ -0,0 +1,157 @@
+// name_index.cpp - Memory-mapped item/quest name index reader
+
+#include <chrono>
+#include <cstring>
+
+#include "../include/name_index.h"
+
+using namespace std;
+
+NameIndex::NameIndex()
+    : header(nullptr), tables(), pages(), pageCounts(), counts(), pageShift(0), strings(nullptr), openMicros(0),
+      hits(0), misses(0), lookupNanos(0) {
+}
+
+bool NameIndex::Open(const string& path) {
+    Close();
+
+    auto start = chrono::steady_clock::now();
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    const unsigned char* base = file.Data();
+    size_t size = file.Size();
+    if (size < sizeof(NameIndexHeader)) {
+        file.Close();
+        return false;
+    }
+
+    const NameIndexHeader* h = reinterpret_cast<const NameIndexHeader*>(base);
+    uint64_t entryCount = uint64_t(h->itemCount) + h->questCount;
+    uint64_t pageEnd = static_cast<uint64_t>(h->pageOffset) +
+                       (uint64_t(h->itemPageCount) + h->questPageCount + 2) * sizeof(uint32_t);
+    uint64_t entryEnd = static_cast<uint64_t>(h->entryOffset) + entryCount * sizeof(NameIndexEntry);
+    uint64_t stringEnd = static_cast<uint64_t>(h->stringOffset) + h->stringBytes;
+    if (memcmp(h->magic, NAME_INDEX_MAGIC, sizeof(NAME_INDEX_MAGIC)) != 0 ||
+        h->version != NAME_INDEX_VERSION || entryCount == 0 || h->pageShift >= 32 ||
+        pageEnd > size || entryEnd > size || stringEnd > size) {
+        file.Close();
+        return false;
+    }
+
+    // Every name must lie inside the string block, each table must be
+    // strictly ascending and every page must cover exactly its IDs, so
+    // Lookup needs no further checks
+    const NameIndexEntry* e = reinterpret_cast<const NameIndexEntry*>(base + h->entryOffset);
+    const uint32_t* p = reinterpret_cast<const uint32_t*>(base + h->pageOffset);
+    const NameIndexEntry* kindTables[NAME_KIND_COUNT] = { e, e + h->itemCount };
+    const uint32_t* kindPages[NAME_KIND_COUNT] = { p, p + h->itemPageCount + 1 };
+    uint32_t kindPageCounts[NAME_KIND_COUNT] = { h->itemPageCount, h->questPageCount };
+    uint32_t kindCounts[NAME_KIND_COUNT] = { h->itemCount, h->questCount };
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        const uint32_t* kindPage = kindPages[kind];
+        if (kindPage[0] != 0 || kindPage[kindPageCounts[kind]] != kindCounts[kind]) {
+            file.Close();
+            return false;
+        }
+        for (uint32_t page = 0; page < kindPageCounts[kind]; ++page) {
+            if (kindPage[page] > kindPage[page + 1]) {
+                file.Close();
+                return false;
+            }
+            for (uint32_t i = kindPage[page]; i < kindPage[page + 1]; ++i) {
+                if ((kindTables[kind][i].id >> h->pageShift) != page) {
+                    file.Close();
+                    return false;
+                }
+            }
+        }
+    }
+
+    for (uint64_t i = 0; i < entryCount; ++i) {
+        for (uint32_t language = 0; language < NAME_LANGUAGE_COUNT; ++language) {
+            if (uint64_t(e[i].nameOffset[language]) + e[i].nameLength[language] > h->stringBytes) {
+                file.Close();
+                return false;
+            }
+        }
+        if (i > 0 && i != h->itemCount && e[i].id <= e[i - 1].id) {
+            file.Close();
+            return false;
+        }
+    }
+
+    header = h;
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        tables[kind] = kindTables[kind];
+        pages[kind] = kindPages[kind];
+        pageCounts[kind] = kindPageCounts[kind];
+        counts[kind] = kindCounts[kind];
+    }
+    pageShift = h->pageShift;
+    strings = reinterpret_cast<const char*>(base + h->stringOffset);
+    openMicros = static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+void NameIndex::Close() {
+    header = nullptr;
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        tables[kind] = nullptr;
+        pages[kind] = nullptr;
+        pageCounts[kind] = 0;
+        counts[kind] = 0;
+    }
+    strings = nullptr;
+    file.Close();
+}
+
+bool NameIndex::Lookup(NameKind kind, uint32_t id, NameLanguage language, string_view& name) const {
+    if (!header || kind >= NAME_KIND_COUNT || language >= NAME_LANGUAGE_COUNT) {
+        return false;
+    }
+
+    uint32_t page = id >> pageShift;
+    if (page >= pageCounts[kind]) {
+        return false;
+    }
+
+    const NameIndexEntry* table = tables[kind];
+    uint32_t low = pages[kind][page];
+    uint32_t end = pages[kind][page + 1];
+    uint32_t high = end;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (table[mid].id < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == end || table[low].id != id || table[low].nameLength[language] == 0) {
+        return false;
+    }
+    name = string_view(strings + table[low].nameOffset[language], table[low].nameLength[language]);
+    return true;
+}
+
+void NameIndex::RecordLookups(uint64_t hitCount, uint64_t missCount, uint64_t nanos) {
+    hits += hitCount;
+    misses += missCount;
+    lookupNanos += nanos;
+}
+
+NameIndexStats NameIndex::GetStats() const {
+    NameIndexStats stats = {};
+    stats.items = counts[NAME_KIND_ITEM];
+    stats.quests = counts[NAME_KIND_QUEST];
+    stats.mappedBytes = header ? file.Size() : 0;
+    stats.openMicros = openMicros;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.lookupNanos = lookupNanos;
+    return stats;
+}
@@ -0,0 +1,155 @@
+// near_duplicate.cpp - SimHash near-duplicate detection for spam variants
+
+#include <chrono>
+
+#include "../include/near_duplicate.h"
+#include "../include/hash.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+static const uint64_t SIMHASH_GRAM_SEED = 0x53696D4861736831ULL;
+
+static int PopCount64(uint64_t v) {
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((v * 0x0101010101010101ULL) >> 56);
+}
+
+// Letters, digits and CJK ideographs/kana/hangul carry the content of a
+// message; symbols, emoji and punctuation are what spammers vary, so they
+// are left out of the fingerprint
+static bool IsContentCodepoint(uint32_t cp) {
+    if (cp < 0x80) {
+        return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+    }
+    if (cp >= 0xC0 && cp <= 0x24F) {
+        return cp != 0xD7 && cp != 0xF7;
+    }
+    if (cp >= 0x3040 && cp <= 0x9FFF) {
+        return true;
+    }
+    return (cp >= 0xAC00 && cp <= 0xD7AF) || (cp >= 0xF900 && cp <= 0xFAFF);
+}
+
+NearDuplicateIndex::NearDuplicateIndex(size_t capacity)
+    : capacity(capacity), nextSlot(0), queries(0), matches(0), scanNanos(0) {
+    fingerprints.reserve(capacity);
+    entries.reserve(capacity);
+}
+
+uint64_t NearDuplicateIndex::Fingerprint(string_view normalizedText) {
+    vector<uint32_t> content;
+    content.reserve(normalizedText.size());
+    for (size_t pos = 0; pos < normalizedText.size();) {
+        uint32_t cp = NextCodepoint(normalizedText, pos);
+        if (IsContentCodepoint(cp)) {
+            content.push_back(cp);
+        }
+    }
+
+    size_t chars = content.size();
+    size_t gramSize = chars >= 3 ? 3 : chars;
+    if (gramSize == 0) {
+        return 0;
+    }
+
+    int weights[64] = {};
+    for (size_t i = 0; i + gramSize <= chars; ++i) {
+        uint64_t h = HashBytes(&content[i], gramSize * sizeof(uint32_t), SIMHASH_GRAM_SEED);
+        for (int bit = 0; bit < 64; ++bit) {
+            weights[bit] += ((h >> bit) & 1) ? 1 : -1;
+        }
+    }
+
+    uint64_t fingerprint = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (weights[bit] > 0) {
+            fingerprint |= 1ULL << bit;
+        }
+    }
+    return fingerprint;
+}
+
+bool NearDuplicateIndex::FindNearest(string_view normalizedText, LanguagePairId pair, int maxDistance,
+                                     PooledString& translation, int& distance) {
+    size_t chars = CountCodepoints(normalizedText);
+    if (chars < MIN_CHARS) {
+        return false;
+    }
+
+    auto start = chrono::steady_clock::now();
+    uint64_t fingerprint = Fingerprint(normalizedText);
+
+    lock_guard<mutex> lock(indexMutex);
+    ++queries;
+
+    size_t best = entries.size();
+    int bestDistance = maxDistance + 1;
+    for (size_t i = 0; i < fingerprints.size(); ++i) {
+        int d = PopCount64(fingerprints[i] ^ fingerprint);
+        if (d >= bestDistance || entries[i].pair != pair) {
+            continue;
+        }
+        // Length within 25% so a short line cannot match inside a long advert
+        size_t otherChars = entries[i].chars;
+        size_t diff = otherChars > chars ? otherChars - chars : chars - otherChars;
+        if (diff * 4 > (chars > otherChars ? chars : otherChars)) {
+            continue;
+        }
+        best = i;
+        bestDistance = d;
+    }
+
+    scanNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+
+    if (best == entries.size()) {
+        return false;
+    }
+
+    ++matches;
+    translation.assign(entries[best].translation.data(), entries[best].translation.size());
+    distance = bestDistance;
+    return true;
+}
+
+void NearDuplicateIndex::Insert(string_view normalizedText, LanguagePairId pair, string_view translation) {
+    size_t chars = CountCodepoints(normalizedText);
+    if (chars < MIN_CHARS || capacity == 0) {
+        return;
+    }
+
+    uint64_t fingerprint = Fingerprint(normalizedText);
+
+    lock_guard<mutex> lock(indexMutex);
+    Entry entry{ static_cast<uint32_t>(chars), pair, string(translation) };
+
+    // Ring buffer: overwrite the oldest entry once full
+    if (entries.size() < capacity) {
+        fingerprints.push_back(fingerprint);
+        entries.push_back(std::move(entry));
+    } else {
+        fingerprints[nextSlot] = fingerprint;
+        entries[nextSlot] = std::move(entry);
+        nextSlot = (nextSlot + 1) % capacity;
+    }
+}
+
+void NearDuplicateIndex::Clear() {
+    lock_guard<mutex> lock(indexMutex);
+    fingerprints.clear();
+    entries.clear();
+    nextSlot = 0;
+}
+
+NearDuplicateStats NearDuplicateIndex::GetStats() {
+    lock_guard<mutex> lock(indexMutex);
+    NearDuplicateStats stats = {};
+    stats.entries = entries.size();
+    stats.queries = queries;
+    stats.matches = matches;
+    stats.scanNanos = scanNanos;
+    return stats;
+}
@@ -0,0 +1,115 @@
+// negative_cache.cpp - Remembers unchanged and rejected lines for a short while
+
+#include "../include/negative_cache.h"
+#include "../include/translation_cache.h"
+
+using namespace std;
+
+NegativeCache::NegativeCache() : count(0), unchangedHits(0), rejectedHits(0), inserts(0) {
+}
+
+bool NegativeCache::Lookup(string_view text, LanguagePairId pair, uint32_t now, NegativeResult& kind,
+                           PooledString& error) {
+    uint64_t key = TranslationCache::MakeKey(text, pair);
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+
+    const Entry& entry = it->second;
+    if (now - entry.timestamp >= entry.ttlMs) {
+        entries.erase(it);
+        count.store(entries.size(), memory_order_relaxed);
+        return false;
+    }
+    if (entry.pair != pair || entry.source != text) {
+        return false;
+    }
+
+    kind = entry.kind;
+    error.assign(entry.error.data(), entry.error.size());
+    if (kind == NegativeResult::UNCHANGED) {
+        ++unchangedHits;
+    } else {
+        ++rejectedHits;
+    }
+    return true;
+}
+
+bool NegativeCache::Contains(string_view text, LanguagePairId pair, uint32_t now) {
+    uint64_t key = TranslationCache::MakeKey(text, pair);
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = entries.find(key);
+    return it != entries.end() && now - it->second.timestamp < it->second.ttlMs && it->second.pair == pair &&
+           it->second.source == text;
+}
+
+void NegativeCache::Insert(string_view text, LanguagePairId pair, NegativeResult kind, string_view error,
+                           uint32_t now) {
+    uint64_t key = TranslationCache::MakeKey(text, pair);
+
+    lock_guard<mutex> lock(cacheMutex);
+    if (entries.size() >= MAX_ENTRIES && entries.find(key) == entries.end()) {
+        EvictLocked(now);
+    }
+
+    // On a hash collision the newer entry wins
+    Entry& entry = entries[key];
+    entry.source.assign(text.data(), text.size());
+    entry.error.assign(error.data(), error.size());
+    entry.timestamp = now;
+    entry.ttlMs = kind == NegativeResult::UNCHANGED ? UNCHANGED_TTL_MS : REJECTED_TTL_MS;
+    entry.pair = pair;
+    entry.kind = kind;
+    ++inserts;
+    count.store(entries.size(), memory_order_relaxed);
+}
+
+// Drops expired entries, then those in the oldest quarter of the age range
+// if that freed nothing
+void NegativeCache::EvictLocked(uint32_t now) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (now - it->second.timestamp >= it->second.ttlMs) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (entries.size() < MAX_ENTRIES) {
+        return;
+    }
+
+    uint32_t oldest = 0;
+    for (const auto& kv : entries) {
+        uint32_t age = now - kv.second.timestamp;
+        oldest = age > oldest ? age : oldest;
+    }
+    uint32_t cutoff = oldest - oldest / 4;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (now - it->second.timestamp >= cutoff) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void NegativeCache::Clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    entries.clear();
+    count.store(0, memory_order_relaxed);
+}
+
+NegativeCacheStats NegativeCache::GetStats() {
+    lock_guard<mutex> lock(cacheMutex);
+
+    NegativeCacheStats stats = {};
+    stats.entries = entries.size();
+    stats.unchangedHits = unchangedHits;
+    stats.rejectedHits = rejectedHits;
+    stats.inserts = inserts;
+    return stats;
+}
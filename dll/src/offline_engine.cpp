@@ -0,0 +1,292 @@
+// offline_engine.cpp - Dictionary-based fallback gloss for CJK chat text
+
+#include <chrono>
+#include <fstream>
+
+#include "../include/offline_engine.h"
+#include "../include/hash.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+struct GlossaryEntry {
+    const char* key;
+    const char* gloss;
+};
+
+// Common WoW chat vocabulary; an empty gloss drops the word (particles).
+// WoWTranslate_dictionary.tsv next to the DLL extends or overrides these.
+static const GlossaryEntry BUILTIN_GLOSSARY[] = {
+    // Group finding and trade
+    { "求组", "LFG" }, { "组人", "LFM" }, { "缺", "need" }, { "组", "group" },
+    { "队伍", "party" }, { "团队", "raid" }, { "副本", "dungeon" }, { "公会", "guild" },
+    { "工会", "guild" }, { "招人", "recruiting" }, { "邀请", "invite" }, { "密我", "whisper me" },
+    { "密", "whisper" }, { "出售", "selling" }, { "收购", "buying" }, { "收", "buy" },
+    { "卖", "sell" }, { "金币", "gold" }, { "金", "gold" }, { "银", "silver" },
+    { "材料", "materials" }, { "附魔", "enchant" }, { "锻造", "blacksmithing" }, { "药水", "potion" },
+    // Roles and classes
+    { "坦克", "tank" }, { "治疗", "healer" }, { "输出", "dps" }, { "战士", "warrior" },
+    { "法师", "mage" }, { "牧师", "priest" }, { "盗贼", "rogue" }, { "猎人", "hunter" },
+    { "术士", "warlock" }, { "德鲁伊", "druid" }, { "圣骑士", "paladin" }, { "萨满", "shaman" },
+    // Game terms
+    { "任务", "quest" }, { "装备", "gear" }, { "坐骑", "mount" }, { "等级", "level" },
+    { "级", "level" }, { "经验", "XP" }, { "技能", "skill" }, { "天赋", "talents" },
+    { "怪", "mob" }, { "首领", "boss" }, { "老板", "boss" }, { "掉", "drop" },
+    { "拾取", "loot" }, { "复活", "resurrect" }, { "拉", "pull" }, { "打", "fight" },
+    { "部落", "Horde" }, { "联盟", "Alliance" }, { "奥格瑞玛", "Orgrimmar" }, { "暴风城", "Stormwind" },
+    { "熔火之心", "Molten Core" }, { "黑翼之巢", "Blackwing Lair" }, { "祖尔格拉布", "Zul'Gurub" },
+    { "黑石深渊", "Blackrock Depths" }, { "斯坦索姆", "Stratholme" }, { "通灵学院", "Scholomance" },
+    { "厄运之槌", "Dire Maul" },
+    // Everyday words
+    { "你好", "hello" }, { "大家好", "hi all" }, { "谢谢", "thanks" }, { "再见", "bye" },
+    { "好的", "ok" }, { "好", "good" }, { "是", "is" }, { "不是", "not" },
+    { "不", "not" }, { "没有", "don't have" }, { "有", "have" }, { "要", "want" },
+    { "需要", "need" }, { "可以", "can" }, { "我", "I" }, { "你", "you" },
+    { "他", "he" }, { "她", "she" }, { "我们", "we" }, { "你们", "you all" },
+    { "他们", "they" }, { "人", "people" }, { "朋友", "friend" }, { "兄弟", "bro" },
+    { "在", "at" }, { "哪里", "where" }, { "这里", "here" }, { "那里", "there" },
+    { "什么", "what" }, { "怎么", "how" }, { "为什么", "why" }, { "多少", "how much" },
+    { "哪个", "which" }, { "现在", "now" }, { "马上", "right away" }, { "速来", "come quick" },
+    { "来", "come" }, { "等一下", "wait a moment" }, { "等", "wait" }, { "走", "go" },
+    { "去", "go to" }, { "一起", "together" }, { "帮忙", "help" }, { "帮", "help" },
+    { "开始", "start" }, { "开", "start" }, { "还", "still" }, { "也", "also" },
+    { "很", "very" }, { "太", "too" }, { "多", "many" }, { "少", "few" },
+    { "大", "big" }, { "小", "small" }, { "新", "new" }, { "老", "old" },
+    { "死", "dead" }, { "几", "a few" }, { "一", "one" }, { "二", "two" },
+    { "三", "three" }, { "五", "five" }, { "十", "ten" }, { "和", "and" },
+    { "价格", "price" }, { "便宜", "cheap" }, { "贵", "expensive" },
+    // Particles and measure words
+    { "的", "" }, { "了", "" }, { "吗", "?" }, { "呢", "" },
+    { "吧", "" }, { "啊", "" }, { "个", "" }, { "一下", "" },
+};
+
+// Full-width and CJK punctuation mapped to ASCII; 0 if not punctuation
+static char PunctuationFor(uint32_t cp) {
+    switch (cp) {
+    case 0xFF0C: case 0x3001: return ',';   // ， 、
+    case 0x3002: return '.';                // 。
+    case 0xFF01: return '!';
+    case 0xFF1F: return '?';
+    case 0xFF1A: return ':';
+    case 0xFF1B: return ';';
+    case 0xFF08: return '(';
+    case 0xFF09: return ')';
+    case 0x3010: return '[';                // 【
+    case 0x3011: return ']';                // 】
+    case 0x300A: case 0x300B: return '"';   // 《 》
+    case 0x201C: case 0x201D: return '"';
+    case 0xFF5E: return '~';
+    default: return 0;
+    }
+}
+
+// Kana and hangul are content the dictionary cannot gloss; they count
+// against coverage like unknown ideographs
+static bool IsUnglossedScript(uint32_t cp) {
+    return (cp >= 0x3040 && cp <= 0x30FF) || (cp >= 0xAC00 && cp <= 0xD7AF);
+}
+
+static string_view Trim(string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+// Appends a word with a separating space; closing punctuation attaches to
+// the previous word and opening punctuation to the next one
+static void AppendWord(string& out, string_view word, bool& glueNext) {
+    if (word.empty()) {
+        return;
+    }
+    char first = word.front();
+    bool closing = word.size() == 1 && (first == ',' || first == '.' || first == '!' ||
+                                        first == '?' || first == ':' || first == ';' ||
+                                        first == ')' || first == ']');
+    if (!out.empty() && !glueNext && !closing) {
+        out += ' ';
+    }
+    out.append(word.data(), word.size());
+    glueNext = word.size() == 1 && (first == '(' || first == '[');
+}
+
+OfflineEngine::OfflineEngine()
+    : maxKeyChars(0), entryBytes(0), translations(0), fullCoverage(0), glossNanos(0) {
+    entries.reserve(sizeof(BUILTIN_GLOSSARY) / sizeof(BUILTIN_GLOSSARY[0]));
+    for (const GlossaryEntry& entry : BUILTIN_GLOSSARY) {
+        Add(entry.key, entry.gloss);
+    }
+}
+
+bool OfflineEngine::Add(string_view key, string_view gloss) {
+    if (key.empty() || entries.size() >= UINT32_MAX) {
+        return false;
+    }
+
+    uint64_t hash = HashText(key);
+    auto it = index.find(hash);
+    if (it != index.end()) {
+        Entry& existing = entries[it->second];
+        if (existing.key != key) {
+            return false;   // 64-bit collision; keep the first key
+        }
+        entryBytes -= existing.gloss.size();
+        existing.gloss.assign(gloss.data(), gloss.size());
+        entryBytes += existing.gloss.size();
+        return true;
+    }
+
+    index.emplace(hash, static_cast<uint32_t>(entries.size()));
+    entries.push_back({ string(key), string(gloss) });
+    entryBytes += key.size() + gloss.size();
+
+    size_t chars = CountCodepoints(key);
+    if (chars > maxKeyChars) {
+        maxKeyChars = chars;
+    }
+    return true;
+}
+
+const OfflineEngine::Entry* OfflineEngine::Find(string_view key) const {
+    auto it = index.find(HashText(key));
+    if (it == index.end()) {
+        return nullptr;
+    }
+    const Entry& entry = entries[it->second];
+    return entry.key == key ? &entry : nullptr;
+}
+
+int OfflineEngine::LoadDictionary(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        return -1;
+    }
+
+    int added = 0;
+    string line;
+    while (getline(file, line)) {
+        string_view view = line;
+        if (view.empty() || view.front() == '#') {
+            continue;
+        }
+        size_t tab = view.find('\t');
+        if (tab == string_view::npos) {
+            continue;
+        }
+        if (Add(Trim(view.substr(0, tab)), Trim(view.substr(tab + 1)))) {
+            ++added;
+        }
+    }
+    return added;
+}
+
+bool OfflineEngine::Gloss(string_view text, string& out, bool& coveredAll) {
+    auto start = chrono::steady_clock::now();
+
+    out.clear();
+    out.reserve(text.size() * 2);
+    bool glueNext = false;
+    size_t content = 0;
+    size_t uncovered = 0;
+    size_t pendingStart = string_view::npos;   // Run of unknown characters or non-CJK text
+
+    // Byte offsets of the next maxKeyChars ideographs, for longest-match lookup
+    vector<size_t> ends;
+    ends.reserve(maxKeyChars);
+
+    auto flushPending = [&](size_t end) {
+        if (pendingStart != string_view::npos) {
+            AppendWord(out, Trim(text.substr(pendingStart, end - pendingStart)), glueNext);
+            pendingStart = string_view::npos;
+        }
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t next = pos;
+        uint32_t cp = NextCodepoint(text, next);
+
+        if (IsCjkCodepoint(cp)) {
+            ++content;
+            ends.clear();
+            for (size_t scan = pos; scan < text.size() && ends.size() < maxKeyChars;) {
+                size_t after = scan;
+                if (!IsCjkCodepoint(NextCodepoint(text, after))) {
+                    break;
+                }
+                ends.push_back(after);
+                scan = after;
+            }
+
+            const Entry* match = nullptr;
+            size_t matchEnd = 0;
+            for (size_t k = ends.size(); k > 0 && !match; --k) {
+                match = Find(text.substr(pos, ends[k - 1] - pos));
+                matchEnd = ends[k - 1];
+            }
+
+            if (match) {
+                flushPending(pos);
+                AppendWord(out, match->gloss, glueNext);
+                content += CountCodepoints(text.substr(next, matchEnd - next));
+                pos = matchEnd;
+                continue;
+            }
+
+            // Unknown ideograph: pass it through untranslated, grouped with its neighbours
+            ++uncovered;
+            if (pendingStart == string_view::npos) {
+                pendingStart = pos;
+            }
+            pos = next;
+            continue;
+        }
+
+        char punctuation = PunctuationFor(cp);
+        if (punctuation) {
+            flushPending(pos);
+            AppendWord(out, string_view(&punctuation, 1), glueNext);
+        } else if (cp == ' ') {
+            flushPending(pos);
+        } else {
+            if (IsUnglossedScript(cp)) {
+                ++content;
+                ++uncovered;
+            }
+            if (pendingStart == string_view::npos) {
+                pendingStart = pos;
+            }
+        }
+        pos = next;
+    }
+    flushPending(text.size());
+
+    coveredAll = content > 0 && uncovered == 0;
+    bool glossed = content > uncovered;
+
+    if (glossed) {
+        ++translations;
+        if (coveredAll) {
+            ++fullCoverage;
+        }
+    }
+    glossNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    return glossed;
+}
+
+OfflineEngineStats OfflineEngine::GetStats() const {
+    OfflineEngineStats stats;
+    stats.entries = entries.size();
+    // Strings plus vector storage and hash nodes (key, value, next pointer, cached hash)
+    stats.approximateBytes = entryBytes + entries.capacity() * sizeof(Entry) +
+                             index.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*)) +
+                             index.bucket_count() * sizeof(void*);
+    stats.translations = translations;
+    stats.fullCoverage = fullCoverage;
+    stats.glossNanos = glossNanos;
+    return stats;
+}
@@ -0,0 +1,335 @@
+// payload_pool.cpp - Size-class slab pool for WoWTranslate message payloads
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#include "../include/payload_pool.h"
+
+using namespace std;
+
+// Size classes: 32 B .. 16 KB, powers of two
+static const size_t MIN_CLASS_SHIFT = 5;
+static const size_t CLASS_COUNT = 10;
+// One allocation-granularity unit on Windows, so VirtualAlloc hands slabs
+// out aligned and a block finds its slab by masking its address
+static const size_t SLAB_SIZE = 64 * 1024;
+static const size_t THREAD_CACHE_BYTES = 8 * 1024;   // Per size class, per thread
+static const size_t MAX_EMPTY_SLABS = 1;             // Per size class, kept for the next burst
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Bookkeeping lives outside the slab so a 16 KB class still fits four blocks
+struct Slab {
+    char* memory;
+    char* cursor;           // Start of the never-used tail
+    FreeBlock* freeList;    // Blocks returned to this slab
+    size_t live;            // Blocks out of the slab, thread caches included
+    size_t classIndex;
+    Slab* prev;             // Links in the class's list of slabs with room
+    Slab* next;
+    bool listed;
+};
+
+struct SizeClass {
+    Slab* available = nullptr;
+    size_t emptySlabs = 0;
+};
+
+struct PoolState {
+    mutex poolMutex;
+    SizeClass classes[CLASS_COUNT];
+    unordered_map<uintptr_t, Slab*> slabs;   // By base address
+    size_t bytesInUse = 0;
+    size_t peakBytesInUse = 0;
+    size_t slabBytes = 0;
+    uint64_t carved = 0;                     // Blocks taken from fresh slab space
+    uint64_t slabsReleased = 0;
+    atomic<uint64_t> allocations{ 0 };
+    atomic<uint64_t> oversize{ 0 };
+};
+
+// Intentionally never destroyed: pooled strings with static storage in other
+// translation units may be released after this one's statics are torn down.
+static PoolState& State() {
+    static PoolState* state = new PoolState();
+    return *state;
+}
+
+static size_t ClassIndex(size_t bytes) {
+    size_t index = 0;
+    size_t classSize = size_t(1) << MIN_CLASS_SHIFT;
+    while (classSize < bytes) {
+        classSize <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+static size_t ClassSize(size_t index) {
+    return size_t(1) << (MIN_CLASS_SHIFT + index);
+}
+
+static size_t CacheCapacity(size_t index) {
+    size_t blocks = THREAD_CACHE_BYTES / ClassSize(index);
+    return blocks < 2 ? 2 : blocks;
+}
+
+static char* MapSlab() {
+#ifdef _WIN32
+    return static_cast<char*>(VirtualAlloc(nullptr, SLAB_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    return static_cast<char*>(aligned_alloc(SLAB_SIZE, SLAB_SIZE));
+#endif
+}
+
+static void UnmapSlab(char* memory) {
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    free(memory);
+#endif
+}
+
+static void Unlink(SizeClass& sc, Slab* slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        sc.available = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->prev = slab->next = nullptr;
+    slab->listed = false;
+}
+
+static void Link(SizeClass& sc, Slab* slab) {
+    slab->prev = nullptr;
+    slab->next = sc.available;
+    if (sc.available) {
+        sc.available->prev = slab;
+    }
+    sc.available = slab;
+    slab->listed = true;
+}
+
+// Hands count blocks of one class to a thread cache. poolMutex held.
+static FreeBlock* TakeBlocks(PoolState& state, size_t index, size_t count) {
+    SizeClass& sc = state.classes[index];
+    size_t classSize = ClassSize(index);
+    FreeBlock* blocks = nullptr;
+
+    for (size_t taken = 0; taken < count; ++taken) {
+        Slab* slab = sc.available;
+        bool created = !slab;
+        if (created) {
+            char* memory = MapSlab();
+            if (!memory) {
+                if (blocks) {
+                    break;
+                }
+                throw bad_alloc();
+            }
+            slab = new Slab{ memory, memory, nullptr, 0, index, nullptr, nullptr, false };
+            state.slabs[reinterpret_cast<uintptr_t>(memory)] = slab;
+            state.slabBytes += SLAB_SIZE;
+            Link(sc, slab);
+        }
+
+        FreeBlock* block;
+        if (slab->freeList) {
+            block = slab->freeList;
+            slab->freeList = block->next;
+        } else {
+            block = reinterpret_cast<FreeBlock*>(slab->cursor);
+            slab->cursor += classSize;
+            ++state.carved;
+        }
+        if (slab->live++ == 0 && !created) {
+            --sc.emptySlabs;   // Reused a slab that had drained
+        }
+        if (!slab->freeList && slab->cursor + classSize > slab->memory + SLAB_SIZE) {
+            Unlink(sc, slab);
+        }
+
+        block->next = blocks;
+        blocks = block;
+        state.bytesInUse += classSize;
+    }
+
+    if (state.bytesInUse > state.peakBytesInUse) {
+        state.peakBytesInUse = state.bytesInUse;
+    }
+    return blocks;
+}
+
+// Returns one block to its slab; a drained slab beyond the spare is
+// released. poolMutex held.
+static void ReturnBlock(PoolState& state, size_t index, FreeBlock* block) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(block) & ~static_cast<uintptr_t>(SLAB_SIZE - 1);
+    Slab* slab = state.slabs.find(base)->second;
+    SizeClass& sc = state.classes[index];
+
+    block->next = slab->freeList;
+    slab->freeList = block;
+    state.bytesInUse -= ClassSize(index);
+    if (!slab->listed) {
+        Link(sc, slab);
+    }
+
+    if (--slab->live == 0) {
+        if (sc.emptySlabs < MAX_EMPTY_SLABS) {
+            ++sc.emptySlabs;
+            return;
+        }
+        Unlink(sc, slab);
+        state.slabs.erase(base);
+        state.slabBytes -= SLAB_SIZE;
+        ++state.slabsReleased;
+        UnmapSlab(slab->memory);
+        delete slab;
+    }
+}
+
+// Each thread keeps a few free blocks per class, so the common
+// allocate/free pair never takes the pool mutex. Blocks freed on another
+// thread (results built on the worker, released by the game thread after
+// PollResult) flow back to the pool once that thread's cache overflows.
+struct ThreadCache {
+    FreeBlock* blocks[CLASS_COUNT] = {};
+    size_t counts[CLASS_COUNT] = {};
+    uint64_t allocations = 0;   // Not yet added to the pool's counters
+    uint64_t oversize = 0;
+    bool destroyed = false;
+
+    ~ThreadCache() {
+        Flush();
+        destroyed = true;
+    }
+
+    void PublishCounters(PoolState& state) {
+        state.allocations.fetch_add(allocations, memory_order_relaxed);
+        state.oversize.fetch_add(oversize, memory_order_relaxed);
+        allocations = 0;
+        oversize = 0;
+    }
+
+    // Keeps keep blocks of class index, returning the rest. poolMutex held.
+    void Trim(PoolState& state, size_t index, size_t keep) {
+        while (counts[index] > keep) {
+            FreeBlock* block = blocks[index];
+            blocks[index] = block->next;
+            --counts[index];
+            ReturnBlock(state, index, block);
+        }
+    }
+
+    void Flush() {
+        PoolState& state = State();
+        lock_guard<mutex> lock(state.poolMutex);
+        for (size_t index = 0; index < CLASS_COUNT; ++index) {
+            Trim(state, index, 0);
+        }
+        PublishCounters(state);
+    }
+};
+
+static thread_local ThreadCache t_cache;
+
+void* PayloadPool::Allocate(size_t bytes) {
+    ThreadCache& cache = t_cache;
+    ++cache.allocations;
+    if (bytes > MAX_POOLED_SIZE) {
+        ++cache.oversize;
+        return ::operator new(bytes);
+    }
+
+    size_t index = ClassIndex(bytes);
+    if (cache.destroyed) {
+        PoolState& state = State();
+        lock_guard<mutex> lock(state.poolMutex);
+        cache.PublishCounters(state);
+        return TakeBlocks(state, index, 1);
+    }
+    if (cache.counts[index] == 0) {
+        PoolState& state = State();
+        lock_guard<mutex> lock(state.poolMutex);
+        size_t refill = CacheCapacity(index) / 2;
+        FreeBlock* blocks = TakeBlocks(state, index, refill);
+        for (FreeBlock* block = blocks; block; block = block->next) {
+            ++cache.counts[index];
+        }
+        cache.blocks[index] = blocks;
+        cache.PublishCounters(state);
+    }
+
+    FreeBlock* block = cache.blocks[index];
+    cache.blocks[index] = block->next;
+    --cache.counts[index];
+    return block;
+}
+
+void PayloadPool::Deallocate(void* ptr, size_t bytes) {
+    if (!ptr) {
+        return;
+    }
+
+    if (bytes > MAX_POOLED_SIZE) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    size_t index = ClassIndex(bytes);
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    ThreadCache& cache = t_cache;
+    if (cache.destroyed) {
+        // Static strings released during thread or process teardown
+        PoolState& state = State();
+        lock_guard<mutex> lock(state.poolMutex);
+        ReturnBlock(state, index, block);
+        return;
+    }
+
+    block->next = cache.blocks[index];
+    cache.blocks[index] = block;
+    size_t capacity = CacheCapacity(index);
+    if (++cache.counts[index] > capacity) {
+        PoolState& state = State();
+        lock_guard<mutex> lock(state.poolMutex);
+        cache.Trim(state, index, capacity / 2);
+        cache.PublishCounters(state);
+    }
+}
+
+void PayloadPool::ReleaseThreadCache() {
+    if (!t_cache.destroyed) {
+        t_cache.Flush();
+    }
+}
+
+PayloadPoolStats PayloadPool::GetStats() {
+    PoolState& state = State();
+    t_cache.PublishCounters(state);
+    lock_guard<mutex> lock(state.poolMutex);
+    PayloadPoolStats stats;
+    stats.allocations = state.allocations.load(memory_order_relaxed);
+    stats.oversize = state.oversize.load(memory_order_relaxed);
+    // Blocks carved into a thread cache count before they are handed out
+    uint64_t pooled = stats.allocations - stats.oversize;
+    stats.recycled = pooled > state.carved ? pooled - state.carved : 0;
+    stats.bytesInUse = state.bytesInUse;
+    stats.peakBytesInUse = state.peakBytesInUse;
+    stats.slabBytes = state.slabBytes;
+    stats.slabsReleased = state.slabsReleased;
+    return stats;
+}
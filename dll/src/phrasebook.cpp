@@ -0,0 +1,127 @@
+// phrasebook.cpp - Memory-mapped minimal-perfect-hash phrasebook reader
+
+#include <chrono>
+#include <cstring>
+
+#include "../include/phrasebook.h"
+
+using namespace std;
+
+static string_view FixedString(const char* field, size_t size) {
+    size_t length = 0;
+    while (length < size && field[length] != '\0') {
+        ++length;
+    }
+    return string_view(field, length);
+}
+
+Phrasebook::Phrasebook()
+    : header(nullptr), displacements(nullptr), entries(nullptr), strings(nullptr), openMicros(0),
+      hits(0), misses(0), lookupNanos(0) {
+}
+
+bool Phrasebook::Open(const string& path) {
+    Close();
+
+    auto start = chrono::steady_clock::now();
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    const unsigned char* base = file.Data();
+    size_t size = file.Size();
+    if (size < sizeof(PhrasebookHeader)) {
+        file.Close();
+        return false;
+    }
+
+    const PhrasebookHeader* h = reinterpret_cast<const PhrasebookHeader*>(base);
+    uint64_t displacementEnd = static_cast<uint64_t>(h->displacementOffset) + uint64_t(h->bucketCount) * sizeof(uint32_t);
+    uint64_t entryEnd = static_cast<uint64_t>(h->entryOffset) + uint64_t(h->entryCount) * sizeof(PhrasebookEntry);
+    uint64_t stringEnd = static_cast<uint64_t>(h->stringOffset) + h->stringBytes;
+    if (memcmp(h->magic, PHRASEBOOK_MAGIC, sizeof(PHRASEBOOK_MAGIC)) != 0 ||
+        h->version != PHRASEBOOK_VERSION || h->entryCount == 0 || h->bucketCount == 0 ||
+        displacementEnd > size || entryEnd > size || stringEnd > size ||
+        h->displacementOffset % alignof(uint32_t) != 0) {
+        file.Close();
+        return false;
+    }
+
+    // Every entry must point inside the string block, so Lookup needs no bounds checks
+    const PhrasebookEntry* e = reinterpret_cast<const PhrasebookEntry*>(base + h->entryOffset);
+    for (uint32_t i = 0; i < h->entryCount; ++i) {
+        if (uint64_t(e[i].keyOffset) + e[i].keyLength > h->stringBytes ||
+            uint64_t(e[i].valueOffset) + e[i].valueLength > h->stringBytes) {
+            file.Close();
+            return false;
+        }
+    }
+
+    header = h;
+    displacements = reinterpret_cast<const uint32_t*>(base + h->displacementOffset);
+    entries = e;
+    strings = reinterpret_cast<const char*>(base + h->stringOffset);
+    openMicros = static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+void Phrasebook::Close() {
+    header = nullptr;
+    displacements = nullptr;
+    entries = nullptr;
+    strings = nullptr;
+    file.Close();
+}
+
+string_view Phrasebook::SourceLanguage() const {
+    return header ? FixedString(header->sourceLang, sizeof(header->sourceLang)) : string_view();
+}
+
+string_view Phrasebook::TargetLanguage() const {
+    return header ? FixedString(header->targetLang, sizeof(header->targetLang)) : string_view();
+}
+
+bool Phrasebook::Lookup(string_view normalizedKey, string_view& translation) {
+    if (!header) {
+        return false;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    uint32_t bucket = PhrasebookBucket(normalizedKey, header->bucketCount);
+    uint32_t slot = PhrasebookSlot(normalizedKey, displacements[bucket], header->entryCount);
+    const PhrasebookEntry& entry = entries[slot];
+    bool found = string_view(strings + entry.keyOffset, entry.keyLength) == normalizedKey;
+    if (found) {
+        translation = string_view(strings + entry.valueOffset, entry.valueLength);
+        ++hits;
+    } else {
+        ++misses;
+    }
+
+    lookupNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    return found;
+}
+
+bool Phrasebook::Contains(string_view normalizedKey) const {
+    if (!header) {
+        return false;
+    }
+    uint32_t bucket = PhrasebookBucket(normalizedKey, header->bucketCount);
+    uint32_t slot = PhrasebookSlot(normalizedKey, displacements[bucket], header->entryCount);
+    const PhrasebookEntry& entry = entries[slot];
+    return string_view(strings + entry.keyOffset, entry.keyLength) == normalizedKey;
+}
+
+PhrasebookStats Phrasebook::GetStats() const {
+    PhrasebookStats stats = {};
+    stats.entries = header ? header->entryCount : 0;
+    stats.mappedBytes = header ? file.Size() : 0;
+    stats.openMicros = openMicros;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.lookupNanos = lookupNanos;
+    return stats;
+}
@@ -0,0 +1,224 @@
+// preflight.cpp - Recognises chat lines with nothing to translate
+
+#include "../include/preflight.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+// Latin-letter shorthand from the addon's glossary that Chinese and English
+// players both write as-is. Words that are also English ("if") are left out.
+static const char* const kAbbreviations[] = {
+    "afk", "aq20", "aq40", "av", "bfd", "bg", "brb", "brd", "brm", "bwl", "cd", "dm", "dme", "dmn", "dmw",
+    "dps", "dz", "epl", "g", "gg", "gnomer", "gy", "hps", "kt", "lbrs", "lf", "lfg", "lfm", "lol", "lr",
+    "mara", "mc", "ms", "mt", "nax", "naxx", "ok", "ony", "org", "ot", "pve", "pvp", "qs", "rfc", "rfd",
+    "rfk", "scholo", "sfk", "sm", "ss", "st", "stocks", "strat", "stv", "sw", "t1", "t2", "t3", "tb",
+    "tps", "ubrs", "uc", "ulda", "vc", "wc", "wpl", "wsg", "wtb", "wtf", "wts", "wtt", "xd", "zf", "zg", "zs",
+};
+
+// Emoticons that contain letters; letter-free ones (":)", "^^") count as punctuation
+static const char* const kEmoticons[] = {
+    ":d", ":p", ";p", "=d", "=p", ":o", "d:", "xd", "t_t", "t.t", "o/", "\\o/", "o.o", "o_o", "orz", "qaq",
+};
+
+static const char* const kRaidMarkers[] = {
+    "star", "circle", "diamond", "triangle", "moon", "square", "cross", "x", "skull",
+    "rt1", "rt2", "rt3", "rt4", "rt5", "rt6", "rt7", "rt8",
+    "星形", "圆形", "菱形", "三角", "月亮", "方块", "十字", "骷髅",
+};
+
+static const string_view LINK_PLACEHOLDER = "http://ph.wt/";
+
+static char LowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+template <size_t N>
+static bool MatchesAny(string_view token, const char* const (&list)[N]) {
+    for (const char* entry : list) {
+        string_view candidate(entry);
+        if (candidate.size() != token.size()) {
+            continue;
+        }
+        size_t i = 0;
+        while (i < token.size() && LowerAscii(token[i]) == candidate[i]) {
+            ++i;
+        }
+        if (i == token.size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool IsAsciiLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// CJK and full-width punctuation Chinese players type around numbers
+static bool IsWidePunctuation(uint32_t cp) {
+    return (cp >= 0x3000 && cp <= 0x303F) || (cp >= 0xFF01 && cp <= 0xFF0F) || (cp >= 0xFF1A && cp <= 0xFF20) ||
+           (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65) || cp == 0x2026 || cp == 0x00B7;
+}
+
+enum class TokenKind { WORD, NUMBERS, EMOTICON, ABBREVIATION };
+
+// Counts digit groups ("45.2" is one) so two numbers alone read as coordinates
+static TokenKind ClassifyToken(string_view token, int& numberGroups, bool& unitLetters) {
+    if (MatchesAny(token, kEmoticons)) {
+        return TokenKind::EMOTICON;
+    }
+
+    // "MC?" and "LFM," are still shorthand
+    size_t first = 0;
+    size_t last = token.size();
+    while (first < last && !IsAsciiLetter(token[first]) && !(token[first] >= '0' && token[first] <= '9') &&
+           static_cast<unsigned char>(token[first]) < 0x80) {
+        ++first;
+    }
+    while (last > first && !IsAsciiLetter(token[last - 1]) && !(token[last - 1] >= '0' && token[last - 1] <= '9') &&
+           static_cast<unsigned char>(token[last - 1]) < 0x80) {
+        --last;
+    }
+    string_view core = token.substr(first, last - first);
+    if (!core.empty() && IsAsciiLetter(core[0]) && MatchesAny(core, kAbbreviations)) {
+        return TokenKind::ABBREVIATION;
+    }
+
+    // Digits and punctuation, with g/s/c/k/x allowed next to digits for prices and counts
+    bool digits = false;
+    bool letters = false;
+    bool inGroup = false;
+    int groups = 0;
+    size_t pos = 0;
+    while (pos < token.size()) {
+        uint32_t cp = NextCodepoint(token, pos);
+        bool digit = (cp >= '0' && cp <= '9') || (cp >= 0xFF10 && cp <= 0xFF19);
+        if (digit) {
+            digits = true;
+            if (!inGroup) {
+                ++groups;
+                inGroup = true;
+            }
+            continue;
+        }
+        if (cp == '.' && inGroup && pos < token.size() && token[pos] >= '0' && token[pos] <= '9') {
+            continue;
+        }
+        inGroup = false;
+        if (cp < 0x80 && IsAsciiLetter(static_cast<char>(cp))) {
+            char lower = LowerAscii(static_cast<char>(cp));
+            if (lower != 'g' && lower != 's' && lower != 'c' && lower != 'k' && lower != 'x') {
+                return TokenKind::WORD;
+            }
+            letters = true;
+        } else if (cp >= 0x80 && !IsWidePunctuation(cp)) {
+            return TokenKind::WORD;
+        }
+    }
+    if (letters && !digits) {
+        return TokenKind::WORD;
+    }
+    numberGroups += groups;
+    unitLetters = unitLetters || letters;
+    return TokenKind::NUMBERS;
+}
+
+PreflightClass ClassifyMessage(string_view text) {
+    bool links = false;
+    bool markers = false;
+    bool emoticons = false;
+    bool abbreviations = false;
+    bool unitLetters = false;
+    int numberGroups = 0;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        char c = text[pos];
+        if (IsSpace(c)) {
+            ++pos;
+            continue;
+        }
+
+        // Colour and hyperlink escapes: |cAARRGGBB, |r, |H...|h[name]|h
+        if (c == '|' && pos + 1 < text.size()) {
+            char escape = text[pos + 1];
+            if (escape == 'c') {
+                pos += 10;
+            } else if (escape == 'r' || escape == 'h') {
+                pos += 2;
+            } else if (escape == 'H') {
+                size_t end = text.find("|h", pos + 2);
+                if (end == string_view::npos) {
+                    return PreflightClass::TRANSLATE;
+                }
+                pos = end + 2;
+                if (pos < text.size() && text[pos] == '[') {
+                    size_t close = text.find("]|h", pos);
+                    if (close == string_view::npos) {
+                        return PreflightClass::TRANSLATE;
+                    }
+                    pos = close + 3;
+                }
+                links = true;
+            } else {
+                return PreflightClass::TRANSLATE;
+            }
+            continue;
+        }
+
+        if (text.compare(pos, LINK_PLACEHOLDER.size(), LINK_PLACEHOLDER) == 0) {
+            pos += LINK_PLACEHOLDER.size();
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                ++pos;
+            }
+            links = true;
+            continue;
+        }
+
+        if (c == '{') {
+            size_t close = text.find('}', pos);
+            if (close == string_view::npos || !MatchesAny(text.substr(pos + 1, close - pos - 1), kRaidMarkers)) {
+                return PreflightClass::TRANSLATE;
+            }
+            pos = close + 1;
+            markers = true;
+            continue;
+        }
+
+        size_t end = pos;
+        while (end < text.size() && !IsSpace(text[end]) && text[end] != '|' && text[end] != '{') {
+            ++end;
+        }
+        switch (ClassifyToken(text.substr(pos, end - pos), numberGroups, unitLetters)) {
+            case TokenKind::WORD: return PreflightClass::TRANSLATE;
+            case TokenKind::EMOTICON: emoticons = true; break;
+            case TokenKind::ABBREVIATION: abbreviations = true; break;
+            case TokenKind::NUMBERS: break;
+        }
+        pos = end;
+    }
+
+    if (abbreviations) return PreflightClass::ABBREVIATIONS;
+    if (emoticons) return PreflightClass::EMOTICONS;
+    if (links) return PreflightClass::LINKS;
+    if (markers) return PreflightClass::RAID_MARKERS;
+    if (numberGroups == 2 && !unitLetters) return PreflightClass::COORDINATES;
+    return PreflightClass::NUMBERS;
+}
+
+const char* PreflightClassName(PreflightClass kind) {
+    switch (kind) {
+        case PreflightClass::TRANSLATE: return "translate";
+        case PreflightClass::NUMBERS: return "numbers";
+        case PreflightClass::COORDINATES: return "coordinates";
+        case PreflightClass::RAID_MARKERS: return "markers";
+        case PreflightClass::LINKS: return "links";
+        case PreflightClass::EMOTICONS: return "emoticons";
+        case PreflightClass::ABBREVIATIONS: return "abbreviations";
+    }
+    return "translate";
+}
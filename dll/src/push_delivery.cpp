@@ -0,0 +1,40 @@
+// push_delivery.cpp - When to tell the addon to drain finished translations
+
+#include "../include/push_delivery.h"
+
+using namespace std;
+
+PushDelivery::PushDelivery()
+    : enabled(false), delivered(false), lastDeliveryUs(0), checks(0), deliveries(0), throttled(0) {
+}
+
+void PushDelivery::SetEnabled(bool on) {
+    enabled = on;
+}
+
+bool PushDelivery::ShouldDeliver(uint64_t nowUs, bool resultsWaiting) {
+    if (!enabled) {
+        return false;
+    }
+    ++checks;
+    if (!resultsWaiting) {
+        return false;
+    }
+    if (delivered && nowUs < lastDeliveryUs + MIN_INTERVAL_US) {
+        ++throttled;
+        return false;
+    }
+    delivered = true;
+    lastDeliveryUs = nowUs;
+    ++deliveries;
+    return true;
+}
+
+PushDeliveryStats PushDelivery::GetStats() const {
+    PushDeliveryStats stats;
+    stats.enabled = enabled;
+    stats.checks = checks;
+    stats.deliveries = deliveries;
+    stats.throttled = throttled;
+    return stats;
+}
@@ -0,0 +1,79 @@
+// request_scheduler.cpp - Queueing, request sharing and the idle wait of the async path
+
+#include "../include/request_scheduler.h"
+
+using namespace std;
+
+RequestScheduler::RequestScheduler(const SchedulingPolicy& policy, Clock& clock) : policy(policy), clock(clock) {
+}
+
+const string* RequestScheduler::Join(const string& requestId, string_view text, LanguagePairId languagePair) {
+    if (!policy.coalesceIdentical) {
+        return nullptr;
+    }
+    if (inFlight.active && !inFlight.abandoned && inFlight.fanOut.empty() && inFlight.languagePair == languagePair &&
+        inFlight.text == text) {
+        inFlight.followers.push_back(requestId);
+        return &inFlight.requestId;
+    }
+    for (AsyncRequest& request : queued) {
+        if (request.fanOut.empty() && request.languagePair == languagePair && request.text == text) {
+            request.followers.push_back(requestId);
+            return &request.requestId;
+        }
+    }
+    return nullptr;
+}
+
+void RequestScheduler::Enqueue(AsyncRequest request) {
+    request.timestamp = clock.NowMs();
+    queued.push_back(std::move(request));
+    workAvailable.notify_one();
+}
+
+bool RequestScheduler::StartNext(AsyncRequest& request) {
+    if (queued.empty()) {
+        return false;
+    }
+    request = std::move(queued.front());
+    queued.pop_front();
+
+    inFlight.active = true;
+    inFlight.leaderCancelled = false;
+    inFlight.abandoned = false;
+    inFlight.requestId = request.requestId;
+    inFlight.supersedeKey = request.supersedeKey;
+    inFlight.text = request.text;
+    inFlight.languagePair = request.languagePair;
+    inFlight.fanOut = request.fanOut;
+    inFlight.followers = std::move(request.followers);
+    inFlight.asyncCalls.clear();
+    inFlight.prefetch = std::move(request.prefetch);
+    return true;
+}
+
+vector<string> RequestScheduler::Finish(const string& leaderId) {
+    vector<string> recipients;
+    if (!inFlight.leaderCancelled) {
+        recipients.push_back(leaderId);
+    }
+    for (string& follower : inFlight.followers) {
+        recipients.push_back(std::move(follower));
+    }
+    inFlight = InFlightRequest();
+    return recipients;
+}
+
+void RequestScheduler::WaitForWork(unique_lock<mutex>& lock, const function<bool()>& stop) {
+    if (policy.wakeOnEnqueue) {
+        clock.WaitFor(lock, workAvailable, policy.idleWaitMs, [&]() { return !queued.empty() || stop(); });
+    } else {
+        lock.unlock();
+        clock.SleepFor(policy.idleWaitMs);
+        lock.lock();
+    }
+}
+
+void RequestScheduler::WakeWorker() {
+    workAvailable.notify_all();
+}
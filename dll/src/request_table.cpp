@@ -0,0 +1,87 @@
+// request_table.cpp - Slots and read buffers for requests in flight on the async HTTP engine
+
+#include "../include/request_table.h"
+
+#include <algorithm>
+
+using namespace std;
+
+RequestTable::RequestTable(size_t capacity)
+    : slots(min(max<size_t>(capacity, 1), MAX_CAPACITY)), generation(0), inFlight(0), peak(0) {
+    freeSlots.reserve(slots.size());
+    for (size_t i = slots.size(); i > 0; --i) {
+        freeSlots.push_back(static_cast<uint16_t>(i - 1));
+    }
+    for (Slot& slot : slots) {
+        slot.id = 0;
+        slot.context = nullptr;
+    }
+}
+
+// id = generation << 16 | (index + 1); never 0
+uint64_t RequestTable::Acquire(void* context) {
+    if (freeSlots.empty()) {
+        return 0;
+    }
+    uint16_t index = freeSlots.back();
+    freeSlots.pop_back();
+
+    Slot& slot = slots[index];
+    slot.id = (++generation << 16) | (static_cast<uint64_t>(index) + 1);
+    slot.context = context;
+    if (!slot.buffer) {
+        slot.buffer.reset(new char[READ_BUFFER_BYTES]);
+    }
+    peak = max(peak, ++inFlight);
+    return slot.id;
+}
+
+const RequestTable::Slot* RequestTable::Lookup(uint64_t id) const {
+    size_t index = static_cast<size_t>(id & 0xFFFF);
+    if (index == 0 || index > slots.size() || slots[index - 1].id != id) {
+        return nullptr;
+    }
+    return &slots[index - 1];
+}
+
+void* RequestTable::Find(uint64_t id) const {
+    const Slot* slot = Lookup(id);
+    return slot ? slot->context : nullptr;
+}
+
+char* RequestTable::Buffer(uint64_t id) {
+    const Slot* slot = Lookup(id);
+    return slot ? slot->buffer.get() : nullptr;
+}
+
+void* RequestTable::Release(uint64_t id) {
+    const Slot* found = Lookup(id);
+    if (!found) {
+        return nullptr;
+    }
+    Slot& slot = slots[found - slots.data()];
+    void* context = slot.context;
+    slot.id = 0;
+    slot.context = nullptr;
+    freeSlots.push_back(static_cast<uint16_t>(&slot - slots.data()));
+    --inFlight;
+    return context;
+}
+
+void RequestTable::CollectIds(vector<uint64_t>& ids) const {
+    for (const Slot& slot : slots) {
+        if (slot.id != 0) {
+            ids.push_back(slot.id);
+        }
+    }
+}
+
+size_t RequestTable::BytesAllocated() const {
+    size_t bytes = slots.capacity() * sizeof(Slot) + freeSlots.capacity() * sizeof(uint16_t);
+    for (const Slot& slot : slots) {
+        if (slot.buffer) {
+            bytes += READ_BUFFER_BYTES;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,131 @@
+// shared_memory.cpp - Named shared memory (Win32 file mapping, POSIX shm_open)
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <thread>
+
+#include "../include/shared_memory.h"
+
+using namespace std;
+
+#ifdef _WIN32
+
+SharedMemoryRegion::SharedMemoryRegion() : data(nullptr), size(0), mappingHandle(nullptr) {}
+
+bool SharedMemoryRegion::Open(const string& name, size_t regionSize) {
+    Close();
+
+    string fullName = "Local\\" + name;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        0, static_cast<DWORD>(regionSize), fullName.c_str());
+    if (!mapping) {
+        return false;
+    }
+
+    // An existing mapping keeps its original size; a smaller one is unusable
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, regionSize);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    mappingHandle = mapping;
+    data = static_cast<unsigned char*>(view);
+    size = regionSize;
+    return true;
+}
+
+void SharedMemoryRegion::Close() {
+    if (data) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    size = 0;
+}
+
+void SharedMemoryRegion::Remove(const string&) {
+}
+
+#else
+
+SharedMemoryRegion::SharedMemoryRegion() : data(nullptr), size(0), fd(-1) {}
+
+bool SharedMemoryRegion::Open(const string& name, size_t regionSize) {
+    Close();
+
+    string fullName = "/" + name;
+    int file = shm_open(fullName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file >= 0) {
+        if (ftruncate(file, static_cast<off_t>(regionSize)) != 0) {
+            close(file);
+            shm_unlink(fullName.c_str());
+            return false;
+        }
+    } else if (errno == EEXIST) {
+        file = shm_open(fullName.c_str(), O_RDWR, 0600);
+        if (file < 0) {
+            return false;
+        }
+
+        // The creator may not have sized it yet
+        struct stat st;
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            if (fstat(file, &st) != 0 || static_cast<size_t>(st.st_size) >= regionSize) {
+                break;
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        if (fstat(file, &st) != 0 || static_cast<size_t>(st.st_size) < regionSize) {
+            close(file);
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    void* view = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (view == MAP_FAILED) {
+        close(file);
+        return false;
+    }
+
+    fd = file;
+    data = static_cast<unsigned char*>(view);
+    size = regionSize;
+    return true;
+}
+
+void SharedMemoryRegion::Close() {
+    if (data) {
+        munmap(data, size);
+        data = nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    size = 0;
+}
+
+void SharedMemoryRegion::Remove(const string& name) {
+    shm_unlink(("/" + name).c_str());
+}
+
+#endif
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    Close();
+}
@@ -0,0 +1,336 @@
+// shared_translation_cache.cpp - Seqlock hash table in shared memory for multiboxing
+
+#include <chrono>
+#include <thread>
+#include <random>
+#include <cstring>
+
+#include "../include/shared_translation_cache.h"
+#include "../include/hash.h"
+
+using namespace std;
+
+static_assert(atomic<uint32_t>::is_always_lock_free && atomic<uint64_t>::is_always_lock_free,
+              "Shared-memory atomics must be lock-free to work across processes");
+
+static const uint32_t SHARED_CACHE_MAGIC = 0x43535457;   // "WTSC"
+static const uint32_t SHARED_CACHE_VERSION = 2;
+static const uint32_t CLAIM_TTL_MS = 10000;             // A crashed claimant blocks a line at most this long
+static const uint32_t WAIT_POLL_MS = 25;
+
+enum : uint32_t {
+    HEADER_EMPTY = 0,
+    HEADER_INITIALIZING = 1,
+    HEADER_READY = 2
+};
+
+struct SharedTranslationCache::Header {
+    atomic<uint32_t> state;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t claimCount;
+    uint32_t slotDataBytes;
+};
+
+// sequence is odd while a writer owns the slot. Readers copy the slot and
+// retry if sequence changed underneath them; key 0 marks an empty slot.
+struct SharedTranslationCache::Slot {
+    atomic<uint32_t> sequence;
+    atomic<uint32_t> timestamp;
+    atomic<uint64_t> key;
+    uint16_t sourceLength;
+    uint16_t translationLength;
+    char data[SLOT_DATA_BYTES];
+};
+
+static uint32_t NowMs() {
+    return static_cast<uint32_t>(
+        chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Wrapping-safe "a is before b" for 32-bit millisecond ticks
+static bool TickBefore(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) < 0;
+}
+
+// lease packs the owner's claim id (high half) with its deadline (low half)
+// so taking, checking and releasing a claim are each a single atomic step.
+// A release compares the whole lease, so a claimant whose claim lapsed and
+// was taken over cannot clear the new owner's. 0 = free.
+struct SharedTranslationCache::Claim {
+    atomic<uint64_t> key;
+    atomic<uint64_t> lease;
+};
+
+static uint32_t LeaseDeadline(uint64_t lease) {
+    return static_cast<uint32_t>(lease);
+}
+
+static bool LeaseLive(uint64_t lease, uint32_t now) {
+    return lease != 0 && TickBefore(now, LeaseDeadline(lease));
+}
+
+SharedTranslationCache::SharedTranslationCache(uint32_t expiryMs)
+    : header(nullptr), slots(nullptr), claims(nullptr), expiryMs(expiryMs),
+      hits(0), misses(0), publishes(0), waits(0), waitHits(0), lookupNanos(0) {
+    // Claim ids only have to differ between the clients sharing the table
+    random_device seed;
+    nextClaimId = seed();
+}
+
+uint64_t SharedTranslationCache::MakeKey(string_view text, string_view source, string_view target) {
+    uint64_t seed = HashText(target, HashText(source));
+    uint64_t key = HashText(text, seed);
+    return key ? key : 1;
+}
+
+bool SharedTranslationCache::Open(const string& name) {
+    Close();
+
+    size_t bytes = sizeof(Header) + sizeof(Slot) * SLOT_COUNT + sizeof(Claim) * CLAIM_COUNT;
+    if (!region.Open(name, bytes)) {
+        return false;
+    }
+
+    Header* mapped = reinterpret_cast<Header*>(region.Data());
+
+    // The region starts zeroed; the first process to flip the state lays out the header
+    uint32_t expected = HEADER_EMPTY;
+    if (mapped->state.compare_exchange_strong(expected, HEADER_INITIALIZING, memory_order_acquire)) {
+        mapped->magic = SHARED_CACHE_MAGIC;
+        mapped->version = SHARED_CACHE_VERSION;
+        mapped->slotCount = SLOT_COUNT;
+        mapped->claimCount = CLAIM_COUNT;
+        mapped->slotDataBytes = SLOT_DATA_BYTES;
+        mapped->state.store(HEADER_READY, memory_order_release);
+    } else {
+        for (int attempt = 0; attempt < 100 && mapped->state.load(memory_order_acquire) != HEADER_READY; ++attempt) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+
+    if (mapped->state.load(memory_order_acquire) != HEADER_READY || mapped->magic != SHARED_CACHE_MAGIC ||
+        mapped->version != SHARED_CACHE_VERSION || mapped->slotCount != SLOT_COUNT ||
+        mapped->claimCount != CLAIM_COUNT || mapped->slotDataBytes != SLOT_DATA_BYTES) {
+        region.Close();
+        return false;
+    }
+
+    header = mapped;
+    slots = reinterpret_cast<Slot*>(region.Data() + sizeof(Header));
+    claims = reinterpret_cast<Claim*>(region.Data() + sizeof(Header) + sizeof(Slot) * SLOT_COUNT);
+    return true;
+}
+
+void SharedTranslationCache::Close() {
+    header = nullptr;
+    slots = nullptr;
+    claims = nullptr;
+    region.Close();
+}
+
+// Seqlock read of one slot; true when it held text's translation and was not torn
+bool SharedTranslationCache::ReadSlot(Slot& slot, uint64_t key, string_view text, uint32_t now,
+                                      PooledString& translation) {
+    char buffer[SLOT_DATA_BYTES];
+
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        uint32_t before = slot.sequence.load(memory_order_acquire);
+        if (before & 1) {
+            continue;   // Writer active; retry
+        }
+        if (slot.key.load(memory_order_relaxed) != key) {
+            return false;
+        }
+
+        uint32_t timestamp = slot.timestamp.load(memory_order_relaxed);
+        size_t sourceLength = slot.sourceLength;
+        size_t translationLength = slot.translationLength;
+        if (sourceLength + translationLength > SLOT_DATA_BYTES) {
+            continue;   // Torn lengths; the sequence check would reject this copy anyway
+        }
+        memcpy(buffer, slot.data, sourceLength + translationLength);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (slot.sequence.load(memory_order_relaxed) != before) {
+            continue;
+        }
+
+        if (!TickBefore(now, timestamp + expiryMs) || string_view(buffer, sourceLength) != text) {
+            return false;
+        }
+        translation.assign(buffer + sourceLength, translationLength);
+        return true;
+    }
+    return false;
+}
+
+bool SharedTranslationCache::Lookup(string_view text, string_view source, string_view target,
+                                    PooledString& translation) {
+    if (!header) {
+        return false;
+    }
+
+    auto start = chrono::steady_clock::now();
+    uint64_t key = MakeKey(text, source, target);
+    uint32_t now = NowMs();
+
+    bool found = false;
+    for (uint32_t probe = 0; probe < MAX_PROBE && !found; ++probe) {
+        Slot& slot = slots[(key + probe) & (SLOT_COUNT - 1)];
+        found = ReadSlot(slot, key, text, now, translation);
+    }
+
+    if (found) {
+        ++hits;
+    } else {
+        ++misses;
+    }
+    lookupNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    return found;
+}
+
+void SharedTranslationCache::Publish(string_view text, string_view source, string_view target,
+                                     string_view translation, uint64_t claim) {
+    if (!header) {
+        return;
+    }
+
+    uint64_t key = MakeKey(text, source, target);
+    if (text.size() + translation.size() <= SLOT_DATA_BYTES) {
+        // Reuse this key's slot, else an empty one, else the oldest in the probe window
+        uint32_t now = NowMs();
+        Slot* victim = nullptr;
+        for (uint32_t probe = 0; probe < MAX_PROBE; ++probe) {
+            Slot& slot = slots[(key + probe) & (SLOT_COUNT - 1)];
+            uint64_t slotKey = slot.key.load(memory_order_relaxed);
+            if (slotKey == key || slotKey == 0) {
+                victim = &slot;
+                break;
+            }
+            if (!victim || TickBefore(slot.timestamp.load(memory_order_relaxed),
+                                      victim->timestamp.load(memory_order_relaxed))) {
+                victim = &slot;
+            }
+        }
+
+        // Try-lock: if another client is writing this slot, its entry wins
+        uint32_t sequence = victim->sequence.load(memory_order_relaxed);
+        if (!(sequence & 1) &&
+            victim->sequence.compare_exchange_strong(sequence, sequence + 1, memory_order_acquire)) {
+            atomic_thread_fence(memory_order_release);
+            victim->key.store(key, memory_order_relaxed);
+            victim->timestamp.store(now, memory_order_relaxed);
+            victim->sourceLength = static_cast<uint16_t>(text.size());
+            victim->translationLength = static_cast<uint16_t>(translation.size());
+            memcpy(victim->data, text.data(), text.size());
+            memcpy(victim->data + text.size(), translation.data(), translation.size());
+            victim->sequence.store(sequence + 2, memory_order_release);
+            ++publishes;
+        }
+    }
+
+    ReleaseClaim(text, source, target, claim);
+}
+
+bool SharedTranslationCache::TryClaim(string_view text, string_view source, string_view target,
+                                      uint64_t& claim) {
+    claim = 0;
+    if (!header) {
+        return true;
+    }
+
+    uint64_t key = MakeKey(text, source, target);
+    uint32_t now = NowMs();
+
+    Claim* freeClaim = nullptr;
+    uint64_t freeLease = 0;
+    for (uint32_t probe = 0; probe < MAX_PROBE; ++probe) {
+        Claim& entry = claims[(key + probe) & (CLAIM_COUNT - 1)];
+        uint64_t lease = entry.lease.load(memory_order_acquire);
+        bool live = LeaseLive(lease, now);
+        if (live && entry.key.load(memory_order_relaxed) == key) {
+            return false;
+        }
+        if (!live && !freeClaim) {
+            freeClaim = &entry;
+            freeLease = lease;
+        }
+    }
+
+    // Swapping in our lease makes the entry ours; if the window is full
+    // (or we lose the race) we simply fetch without a claim
+    if (freeClaim) {
+        uint32_t id = ++nextClaimId;
+        uint64_t lease = (static_cast<uint64_t>(id ? id : 1) << 32) | ((now + CLAIM_TTL_MS) | 1);
+        if (freeClaim->lease.compare_exchange_strong(freeLease, lease, memory_order_acq_rel)) {
+            freeClaim->key.store(key, memory_order_release);
+            claim = lease;
+        }
+    }
+    return true;
+}
+
+void SharedTranslationCache::ReleaseClaim(string_view text, string_view source, string_view target,
+                                          uint64_t claim) {
+    if (!header || claim == 0) {
+        return;
+    }
+
+    uint64_t key = MakeKey(text, source, target);
+    for (uint32_t probe = 0; probe < MAX_PROBE; ++probe) {
+        Claim& entry = claims[(key + probe) & (CLAIM_COUNT - 1)];
+        uint64_t lease = claim;
+        if (entry.lease.compare_exchange_strong(lease, 0, memory_order_acq_rel)) {
+            return;
+        }
+    }
+}
+
+bool SharedTranslationCache::WaitFor(string_view text, string_view source, string_view target,
+                                     uint32_t timeoutMs, PooledString& translation) {
+    if (!header) {
+        return false;
+    }
+
+    ++waits;
+    uint64_t key = MakeKey(text, source, target);
+    uint32_t start = NowMs();
+
+    while (TickBefore(NowMs(), start + timeoutMs)) {
+        this_thread::sleep_for(chrono::milliseconds(WAIT_POLL_MS));
+
+        uint32_t now = NowMs();
+        for (uint32_t probe = 0; probe < MAX_PROBE; ++probe) {
+            if (ReadSlot(slots[(key + probe) & (SLOT_COUNT - 1)], key, text, now, translation)) {
+                ++waitHits;
+                return true;
+            }
+        }
+
+        // Claimant gave up (failure) or its claim lapsed: stop waiting
+        bool claimed = false;
+        for (uint32_t probe = 0; probe < MAX_PROBE && !claimed; ++probe) {
+            Claim& entry = claims[(key + probe) & (CLAIM_COUNT - 1)];
+            claimed = LeaseLive(entry.lease.load(memory_order_acquire), now) &&
+                      entry.key.load(memory_order_relaxed) == key;
+        }
+        if (!claimed) {
+            return false;
+        }
+    }
+    return false;
+}
+
+SharedCacheStats SharedTranslationCache::GetStats() const {
+    SharedCacheStats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.publishes = publishes;
+    stats.waits = waits;
+    stats.waitHits = waitHits;
+    stats.lookupNanos = lookupNanos;
+    return stats;
+}
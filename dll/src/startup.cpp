@@ -0,0 +1,156 @@
+// startup.cpp - Background initialization off the loader lock
+
+#include <windows.h>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+#include "../include/startup.h"
+#include "../include/lua_interface.h"
+#include "../include/translator_core.h"
+#include "../include/logging.h"
+#include "../include/tracing.h"
+
+using namespace std;
+
+static atomic<StartupState> g_startupState{ StartupState::NOT_STARTED };
+static HANDLE g_startupThread = nullptr;
+static bool g_hookInstalled = false;
+static uint64_t g_attachStartUs = 0;
+
+// Guards the pending key and the hand-over of g_translator to the game thread
+static mutex g_startupMutex;
+static string g_pendingApiKey;
+static bool g_hasPendingKey = false;
+static bool g_shutdownRequested = false;   // Set on detach; the client is then never published
+
+// Written by the startup thread before READY/FAILED is published
+static StartupTimings g_timings = {};
+static atomic<uint64_t> g_lastSetKeyMicros{ 0 };
+
+static DWORD WINAPI StartupThreadProc(LPVOID) {
+    uint64_t logStartUs = TraceNowUs();
+    bool logging = InitializeLogging();
+    g_timings.logMicros = TraceNowUs() - logStartUs;
+
+    // Without a log file the addon still works; there is just nothing to read
+    if (logging) {
+        LOG_INFO("WoWTranslate: DLL_PROCESS_ATTACH took " + to_string(g_timings.attachMicros) + " us");
+        LOG_INFO("Initializing WoWTranslate library v0.1 on startup thread...");
+    }
+
+    LogHookInstall();
+    if (!g_hookInstalled) {
+        MessageBoxW(NULL, L"Failed to initialize Lua interface.", L"WoWTranslate", MB_OK | MB_ICONERROR);
+    }
+
+    uint64_t clientStartUs = TraceNowUs();
+    auto client = make_unique<TranslationClient>();
+    bool started = client->Start();
+    g_timings.clientMicros = TraceNowUs() - clientStartUs;
+
+    {
+        lock_guard<mutex> lock(g_startupMutex);
+        if (!g_shutdownRequested) {
+            g_translator = std::move(client);
+            if (g_hasPendingKey) {
+                g_translator->SetApiKey(g_pendingApiKey);
+                g_pendingApiKey.clear();
+                g_hasPendingKey = false;
+                LOG_INFO("Applied API key submitted during startup");
+            }
+            g_timings.totalMicros = TraceNowUs() - g_attachStartUs;
+            g_startupState = started ? StartupState::READY : StartupState::FAILED;
+        }
+    }
+
+    // The DLL was detached while Start() ran; nobody else will tear this down
+    if (client) {
+        client->Cleanup();
+        return 0;
+    }
+
+    if (started) {
+        LOG_INFO("WoWTranslate startup complete: log " + to_string(g_timings.logMicros) + " us, client " +
+                 to_string(g_timings.clientMicros) + " us, total " + to_string(g_timings.totalMicros) + " us");
+    } else {
+        LOG_ERROR("Translation client failed to start");
+    }
+    return 0;
+}
+
+bool BeginStartup(uint64_t attachStartUs, bool hookInstalled) {
+    g_attachStartUs = attachStartUs;
+    g_hookInstalled = hookInstalled;
+    g_startupState = StartupState::RUNNING;
+    g_timings.attachMicros = TraceNowUs() - attachStartUs;
+
+    // Its start routine runs only after DllMain returns and releases the loader lock
+    g_startupThread = CreateThread(nullptr, 0, StartupThreadProc, nullptr, 0, nullptr);
+    if (!g_startupThread) {
+        g_startupState = StartupState::NOT_STARTED;
+        return false;
+    }
+    return true;
+}
+
+void ShutdownStartup() {
+    // No waiting under the loader lock: a startup thread still inside
+    // WinHTTP or loader work could not make progress. Once the flag is set
+    // it keeps its client and cleans it up itself.
+    unique_ptr<TranslationClient> client;
+    {
+        lock_guard<mutex> lock(g_startupMutex);
+        g_shutdownRequested = true;
+        if (IsStartupComplete()) {
+            client = std::move(g_translator);
+        }
+    }
+
+    if (client) {
+        client->Cleanup();
+    }
+
+    if (g_startupThread) {
+        CloseHandle(g_startupThread);
+        g_startupThread = nullptr;
+    }
+}
+
+StartupState GetStartupState() {
+    return g_startupState;
+}
+
+bool IsStartupComplete() {
+    StartupState state = g_startupState;
+    return state == StartupState::READY || state == StartupState::FAILED;
+}
+
+bool SubmitApiKey(const string& key) {
+    uint64_t startUs = TraceNowUs();
+    bool accepted = true;
+    {
+        lock_guard<mutex> lock(g_startupMutex);
+        if (!IsStartupComplete()) {
+            g_pendingApiKey = key;
+            g_hasPendingKey = true;
+        } else if (g_startupState == StartupState::READY) {
+            g_translator->SetApiKey(key);
+        } else {
+            accepted = false;
+        }
+    }
+    g_lastSetKeyMicros = TraceNowUs() - startUs;
+    return accepted;
+}
+
+StartupTimings GetStartupTimings() {
+    StartupTimings timings = {};
+    if (IsStartupComplete()) {
+        timings = g_timings;
+    } else {
+        timings.attachMicros = g_timings.attachMicros;
+    }
+    timings.lastSetKeyMicros = g_lastSetKeyMicros;
+    return timings;
+}
@@ -0,0 +1,107 @@
+// subcommand_table.cpp - Perfect-hash lookup of WoWTranslate subcommand names
+
+#include "../include/subcommand_table.h"
+
+using namespace std;
+
+struct SubcommandEntry {
+    string_view name;
+    Subcommand id;
+};
+
+static constexpr SubcommandEntry kSubcommands[] = {
+    { "ping",            Subcommand::Ping },
+    { "version",         Subcommand::Version },
+    { "status",          Subcommand::Status },
+    { "setkey",          Subcommand::SetKey },
+    { "credits",         Subcommand::Credits },
+    { "trace",           Subcommand::Trace },
+    { "translate_async", Subcommand::TranslateAsync },
+    { "poll",            Subcommand::Poll },
+    { "translate",       Subcommand::Translate },
+    { "memstats",        Subcommand::MemStats },
+    { "cachestats",      Subcommand::CacheStats },
+    { "template",        Subcommand::Template },
+    { "template_names",  Subcommand::TemplateNames },
+    { "segments",        Subcommand::Segments },
+    { "neardup",         Subcommand::NearDup },
+    { "detect",          Subcommand::Detect },
+    { "cancel",          Subcommand::Cancel },
+    { "offline",         Subcommand::Offline },
+    { "startup",         Subcommand::Startup },
+    { "shared",          Subcommand::Shared },
+    { "chunks",          Subcommand::Chunks },
+    { "poll_batch",      Subcommand::PollBatch },
+    { "budget",          Subcommand::Budget },
+    { "wire",            Subcommand::Wire },
+    { "names",           Subcommand::Names },
+    { "hedge",           Subcommand::Hedge },
+    { "endpoints",       Subcommand::Endpoints },
+    { "push",            Subcommand::Push },
+    { "preflight",       Subcommand::Preflight },
+    { "stream",          Subcommand::Stream },
+    { "multiplex",       Subcommand::Multiplex },
+};
+
+static constexpr size_t SUBCOMMAND_COUNT = sizeof(kSubcommands) / sizeof(kSubcommands[0]);
+static constexpr size_t SUBCOMMAND_TABLE_SIZE = 64;  // Power of two
+
+// Found by subcommand_seed; when a new subcommand makes the static_assert
+// below fire, run it again and paste the seed it prints
+static constexpr uint32_t SUBCOMMAND_HASH_SEED = 958;
+
+static constexpr uint32_t HashSubcommand(string_view name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+struct SubcommandTable {
+    int8_t slots[SUBCOMMAND_TABLE_SIZE];
+    bool perfect;
+};
+
+// One pass over the names; perfect when each lands in its own slot
+static constexpr SubcommandTable BuildSubcommandTable(uint32_t seed) {
+    SubcommandTable table{};
+    table.perfect = true;
+    for (size_t i = 0; i < SUBCOMMAND_TABLE_SIZE; ++i) {
+        table.slots[i] = -1;
+    }
+    for (size_t i = 0; i < SUBCOMMAND_COUNT; ++i) {
+        size_t slot = HashSubcommand(kSubcommands[i].name, seed) & (SUBCOMMAND_TABLE_SIZE - 1);
+        if (table.slots[slot] != -1) {
+            table.perfect = false;
+        }
+        table.slots[slot] = static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+static constexpr SubcommandTable kSubcommandTable = BuildSubcommandTable(SUBCOMMAND_HASH_SEED);
+static_assert(kSubcommandTable.perfect, "Subcommand names collide under SUBCOMMAND_HASH_SEED - run subcommand_seed");
+
+Subcommand LookupSubcommand(string_view name) {
+    size_t slot = HashSubcommand(name, SUBCOMMAND_HASH_SEED) & (SUBCOMMAND_TABLE_SIZE - 1);
+    int8_t index = kSubcommandTable.slots[slot];
+    if (index < 0 || kSubcommands[index].name != name) {
+        return Subcommand::Unknown;
+    }
+    return kSubcommands[index].id;
+}
+
+const char* SubcommandName(Subcommand id) {
+    for (const SubcommandEntry& entry : kSubcommands) {
+        if (entry.id == id) {
+            return entry.name.data();
+        }
+    }
+    return "unknown";
+}
+
+bool IsPerfectSubcommandSeed(uint32_t seed) {
+    return BuildSubcommandTable(seed).perfect;
+}
@@ -0,0 +1,165 @@
+// text_normalize.cpp - Cache-key normalization and number/name templating
+
+#include <string>
+
+#include "../include/text_normalize.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+static const int MAX_REPEATED_CHARS = 3;
+static const size_t MAX_TEMPLATE_SLOTS = 9;
+
+static bool IsAsciiSpace(uint32_t cp) {
+    return cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == '\f' || cp == '\v';
+}
+
+static bool IsAsciiDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool IsAsciiAlnum(char c) {
+    return IsAsciiDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+string NormalizeForCache(string_view text) {
+    string out;
+    out.reserve(text.size());
+
+    bool pendingSpace = false;
+    uint32_t lastCp = 0;
+    int runLength = 0;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        uint32_t cp = NextCodepoint(text, pos);
+
+        // Width folding: FF01-FF5E mirror ASCII 21-7E, U+3000 is the ideographic space
+        if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            cp -= 0xFEE0;
+        } else if (cp == 0x3000) {
+            cp = ' ';
+        }
+
+        if (IsAsciiSpace(cp)) {
+            pendingSpace = !out.empty();
+            lastCp = ' ';
+            runLength = 0;
+            continue;
+        }
+
+        if (cp >= 'A' && cp <= 'Z') {
+            cp += 'a' - 'A';
+        }
+
+        if (cp == lastCp) {
+            if (++runLength > MAX_REPEATED_CHARS) {
+                continue;
+            }
+        } else {
+            lastCp = cp;
+            runLength = 1;
+        }
+
+        if (pendingSpace) {
+            out += ' ';
+            pendingSpace = false;
+        }
+        AppendCodepoint(out, cp);
+    }
+
+    return out;
+}
+
+// Matches a known name at pos; ASCII names must sit on word boundaries
+static size_t MatchName(string_view text, size_t pos, const vector<string>& names) {
+    for (const string& name : names) {
+        if (name.size() < 2 || text.compare(pos, name.size(), name) != 0) {
+            continue;
+        }
+
+        bool asciiName = static_cast<unsigned char>(name[0]) < 0x80;
+        if (asciiName) {
+            size_t end = pos + name.size();
+            if (pos > 0 && IsAsciiAlnum(text[pos - 1])) continue;
+            if (end < text.size() && IsAsciiAlnum(text[end])) continue;
+        }
+        return name.size();
+    }
+    return 0;
+}
+
+bool ExtractTemplate(string_view text, const vector<string>& names, TextTemplate& out) {
+    out.text.clear();
+    out.slots.clear();
+
+    // Existing braces (raid markers like {skull}) would be ambiguous with slot markers
+    if (text.find('{') != string_view::npos || text.find('}') != string_view::npos) {
+        return false;
+    }
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t slotLength = 0;
+
+        if (IsAsciiDigit(text[pos])) {
+            size_t end = pos;
+            while (end < text.size() && IsAsciiDigit(text[end])) ++end;
+            // Keep decimals ("1.5k") in one slot
+            if (end + 1 < text.size() && (text[end] == '.' || text[end] == ',') &&
+                IsAsciiDigit(text[end + 1])) {
+                ++end;
+                while (end < text.size() && IsAsciiDigit(text[end])) ++end;
+            }
+            slotLength = end - pos;
+        } else {
+            slotLength = MatchName(text, pos, names);
+        }
+
+        if (slotLength > 0) {
+            if (out.slots.size() >= MAX_TEMPLATE_SLOTS) {
+                return false;
+            }
+            out.text += '{';
+            out.text += static_cast<char>('0' + out.slots.size());
+            out.text += '}';
+            out.slots.emplace_back(text.substr(pos, slotLength));
+            pos += slotLength;
+        } else {
+            out.text += text[pos];
+            ++pos;
+        }
+    }
+
+    return !out.slots.empty();
+}
+
+bool FillTemplate(string_view translatedTemplate, const vector<string>& slots, string& out) {
+    out.clear();
+    out.reserve(translatedTemplate.size() + 16);
+
+    vector<bool> used(slots.size(), false);
+    size_t pos = 0;
+    while (pos < translatedTemplate.size()) {
+        if (translatedTemplate[pos] == '{' && pos + 2 < translatedTemplate.size() &&
+            IsAsciiDigit(translatedTemplate[pos + 1]) && translatedTemplate[pos + 2] == '}') {
+            size_t index = static_cast<size_t>(translatedTemplate[pos + 1] - '0');
+            if (index >= slots.size()) {
+                return false;
+            }
+            out += slots[index];
+            used[index] = true;
+            pos += 3;
+        } else {
+            out += translatedTemplate[pos];
+            ++pos;
+        }
+    }
+
+    for (bool u : used) {
+        if (!u) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,172 @@
+// tracing.cpp - Chrome trace-event span tracing for WoWTranslate
+// Spans are buffered in memory and appended to a JSON array file in batches
+
+#include <windows.h>
+#include <string>
+#include <fstream>
+#include <mutex>
+
+#include "../include/tracing.h"
+#include "../include/logging.h"
+#include "../include/utils.h"
+
+using namespace std;
+
+atomic<bool> g_tracingEnabled{ false };
+
+// Global tracing state
+static mutex g_traceMutex;
+static string g_traceFilePath;
+static string g_traceBuffer;
+static bool g_traceFirstEvent = true;
+static const size_t TRACE_FLUSH_BYTES = 64 * 1024;
+
+static thread_local const string* t_traceRequestId = nullptr;
+
+static const string& EmptyRequestId() {
+    static const string empty;
+    return empty;
+}
+
+TraceRequestScope::TraceRequestScope(const string& requestId)
+    : previous(t_traceRequestId) {
+    t_traceRequestId = &requestId;
+}
+
+TraceRequestScope::~TraceRequestScope() {
+    t_traceRequestId = previous;
+}
+
+const string& TraceRequestScope::Current() {
+    return t_traceRequestId ? *t_traceRequestId : EmptyRequestId();
+}
+
+uint64_t TraceNowUs() {
+    static LONGLONG frequency = 0;
+    if (frequency == 0) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        frequency = freq.QuadPart;
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split to avoid overflowing 64 bits on long uptimes
+    LONGLONG seconds = counter.QuadPart / frequency;
+    LONGLONG remainder = counter.QuadPart % frequency;
+    return static_cast<uint64_t>(seconds) * 1000000ULL +
+           static_cast<uint64_t>(remainder * 1000000LL / frequency);
+}
+
+// Caller must hold g_traceMutex
+static void FlushTraceBuffer() {
+    if (g_traceBuffer.empty()) {
+        return;
+    }
+
+    ofstream traceFile(g_traceFilePath, ios::app | ios::binary);
+    if (traceFile.is_open()) {
+        traceFile << g_traceBuffer;
+    }
+    g_traceBuffer.clear();
+}
+
+static void AppendJsonEscaped(string& out, const string& value) {
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out += c;
+        }
+    }
+}
+
+bool StartTracing() {
+    lock_guard<mutex> lock(g_traceMutex);
+
+    if (g_tracingEnabled) {
+        return true;
+    }
+
+    string dllDir = GetDllFolder();
+    if (dllDir.empty()) {
+        return false;
+    }
+    g_traceFilePath = dllDir + "\\WoWTranslate_trace.json";
+
+    // Start a fresh JSON array; StopTracing closes it
+    ofstream traceFile(g_traceFilePath, ios::trunc | ios::binary);
+    if (!traceFile.is_open()) {
+        LOG_ERROR("Failed to open trace file: " + g_traceFilePath);
+        return false;
+    }
+    traceFile << "[\n";
+    traceFile.close();
+
+    g_traceBuffer.clear();
+    g_traceBuffer.reserve(TRACE_FLUSH_BYTES + 1024);
+    g_traceFirstEvent = true;
+    g_tracingEnabled = true;
+
+    LOG_INFO("Tracing started: " + g_traceFilePath);
+    return true;
+}
+
+void StopTracing() {
+    lock_guard<mutex> lock(g_traceMutex);
+
+    if (!g_tracingEnabled) {
+        return;
+    }
+
+    g_tracingEnabled = false;
+    g_traceBuffer += "\n]\n";
+    FlushTraceBuffer();
+    g_traceBuffer.shrink_to_fit();
+
+    LOG_INFO("Tracing stopped: " + g_traceFilePath);
+}
+
+void TraceComplete(const char* name, uint64_t startUs, uint64_t endUs, const string& requestId) {
+    if (!IsTracingEnabled()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(g_traceMutex);
+
+    // Re-check under the lock; StopTracing may have closed the array
+    if (!g_tracingEnabled) {
+        return;
+    }
+
+    if (!g_traceFirstEvent) {
+        g_traceBuffer += ",\n";
+    }
+    g_traceFirstEvent = false;
+
+    g_traceBuffer += "{\"name\":\"";
+    g_traceBuffer += name;
+    g_traceBuffer += "\",\"cat\":\"wowtranslate\",\"ph\":\"X\",\"ts\":";
+    g_traceBuffer += to_string(startUs);
+    g_traceBuffer += ",\"dur\":";
+    g_traceBuffer += to_string(endUs >= startUs ? endUs - startUs : 0);
+    g_traceBuffer += ",\"pid\":";
+    g_traceBuffer += to_string(GetCurrentProcessId());
+    g_traceBuffer += ",\"tid\":";
+    g_traceBuffer += to_string(GetCurrentThreadId());
+    g_traceBuffer += ",\"args\":{\"requestId\":\"";
+    AppendJsonEscaped(g_traceBuffer, requestId);
+    g_traceBuffer += "\"}}";
+}
+
+void FlushTracing() {
+    if (!IsTracingEnabled()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(g_traceMutex);
+    if (g_tracingEnabled && g_traceBuffer.size() >= TRACE_FLUSH_BYTES) {
+        FlushTraceBuffer();
+    }
+}
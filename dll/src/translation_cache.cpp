@@ -0,0 +1,126 @@
+// translation_cache.cpp - Hashed-key translation cache for WoWTranslate
+
+#include <chrono>
+
+#include "../include/translation_cache.h"
+#include "../include/hash.h"
+
+using namespace std;
+
+// Arbitrary constant separating cache keys from other HashText users
+static const uint64_t CACHE_KEY_SEED = 0x5754436163686531ULL;
+
+TranslationCache::TranslationCache(size_t maxEntries, uint32_t expiryMs)
+    : maxEntries(maxEntries), expiryMs(expiryMs), hits(0), misses(0), collisions(0), lookupNanos(0),
+      lookupTicker(0) {
+}
+
+uint64_t TranslationCache::MakeKey(string_view text, LanguagePairId pair) {
+    return HashText(text, CACHE_KEY_SEED + pair);
+}
+
+bool TranslationCache::Lookup(string_view text, LanguagePairId pair, uint32_t now, PooledString& translation) {
+    // Two clock reads cost more than the lookup itself, so only a sample is timed
+    bool timed = lookupTicker.fetch_add(1, memory_order_relaxed) % LOOKUP_TIMING_SAMPLE == 0;
+    chrono::steady_clock::time_point start;
+    if (timed) {
+        start = chrono::steady_clock::now();
+    }
+    uint64_t key = MakeKey(text, pair);
+
+    lock_guard<mutex> lock(cacheMutex);
+    bool hit = false;
+
+    auto it = entries.find(key);
+    if (it != entries.end() && (now - it->second.timestamp) < expiryMs) {
+        if (it->second.pair == pair && it->second.source == text) {
+            translation.assign(it->second.translation.data(), it->second.translation.size());
+            hit = true;
+        } else {
+            ++collisions;
+        }
+    }
+
+    if (hit) {
+        ++hits;
+    } else {
+        ++misses;
+    }
+    if (timed) {
+        lookupNanos += LOOKUP_TIMING_SAMPLE * static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    }
+    return hit;
+}
+
+bool TranslationCache::Contains(string_view text, LanguagePairId pair, uint32_t now) {
+    uint64_t key = MakeKey(text, pair);
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = entries.find(key);
+    return it != entries.end() && (now - it->second.timestamp) < expiryMs && it->second.pair == pair &&
+           it->second.source == text;
+}
+
+void TranslationCache::Insert(string_view text, LanguagePairId pair, string_view translation, uint32_t now) {
+    uint64_t key = MakeKey(text, pair);
+
+    lock_guard<mutex> lock(cacheMutex);
+    // On a hash collision the newer entry wins
+    Entry& entry = entries[key];
+    entry.source.assign(text.data(), text.size());
+    entry.translation.assign(translation.data(), translation.size());
+    entry.timestamp = now;
+    entry.pair = pair;
+}
+
+void TranslationCache::CleanExpired(uint32_t now) {
+    lock_guard<mutex> lock(cacheMutex);
+
+    auto it = entries.begin();
+    while (it != entries.end()) {
+        if (now - it->second.timestamp > expiryMs) {
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (entries.size() > maxEntries) {
+        size_t removeCount = entries.size() - maxEntries / 2;
+        for (size_t i = 0; i < removeCount && !entries.empty(); ++i) {
+            entries.erase(entries.begin());
+        }
+    }
+}
+
+void TranslationCache::Clear() {
+    lock_guard<mutex> lock(cacheMutex);
+    entries.clear();
+}
+
+size_t TranslationCache::Size() {
+    lock_guard<mutex> lock(cacheMutex);
+    return entries.size();
+}
+
+TranslationCacheStats TranslationCache::GetStats() {
+    lock_guard<mutex> lock(cacheMutex);
+
+    TranslationCacheStats stats = {};
+    stats.entries = entries.size();
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.collisions = collisions;
+    stats.lookupNanos = lookupNanos;
+
+    // Node: key + entry + bucket pointer + list link
+    const size_t nodeOverhead = sizeof(uint64_t) + sizeof(Entry) + 2 * sizeof(void*);
+    stats.approximateBytes = entries.bucket_count() * sizeof(void*);
+    for (const auto& kv : entries) {
+        stats.approximateBytes += nodeOverhead;
+        if (kv.second.source.capacity() > 15) stats.approximateBytes += kv.second.source.capacity() + 1;
+        if (kv.second.translation.capacity() > 15) stats.approximateBytes += kv.second.translation.capacity() + 1;
+    }
+    return stats;
+}
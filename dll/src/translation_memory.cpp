@@ -0,0 +1,171 @@
+// translation_memory.cpp - Segment-level translation memory for WoWTranslate
+
+#include "../include/translation_memory.h"
+#include "../include/text_normalize.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+enum class DelimiterKind {
+    None,
+    Space,
+    Punctuation
+};
+
+// Sentence/clause punctuation, ASCII and CJK, with its ASCII rendering
+static DelimiterKind ClassifyDelimiter(uint32_t cp, const char** ascii) {
+    *ascii = nullptr;
+    switch (cp) {
+        case ' ': case '\t': case 0x3000:
+            return DelimiterKind::Space;
+        case ',': case '.': case '!': case '?': case ';':
+            return DelimiterKind::Punctuation;
+        case 0x3002: *ascii = "."; return DelimiterKind::Punctuation;  // 。
+        case 0xFF01: *ascii = "!"; return DelimiterKind::Punctuation;  // ！
+        case 0xFF1F: *ascii = "?"; return DelimiterKind::Punctuation;  // ？
+        case 0xFF0C: *ascii = ","; return DelimiterKind::Punctuation;  // ，
+        case 0xFF1B: *ascii = ";"; return DelimiterKind::Punctuation;  // ；
+        case 0x3001: *ascii = ","; return DelimiterKind::Punctuation;  // 、
+        case 0xFF0E: *ascii = "."; return DelimiterKind::Punctuation;  // ．
+        case 0x2026: *ascii = "..."; return DelimiterKind::Punctuation;  // …
+        default:
+            return DelimiterKind::None;
+    }
+}
+
+static bool IsAsciiDigitByte(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool IsAllAscii(string_view text) {
+    for (char c : text) {
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TranslationMemory::TranslationMemory(size_t maxSegments, uint32_t expiryMs)
+    : segments(maxSegments, expiryMs), localChars(0), totalChars(0) {
+}
+
+vector<TextSegment> TranslationMemory::Split(string_view text, bool passThroughAscii) {
+    // Spaces only separate clauses in CJK text; in Latin text they separate words
+    bool splitOnSpaces = false;
+    for (size_t pos = 0; pos < text.size();) {
+        if (IsCjkCodepoint(NextCodepoint(text, pos))) {
+            splitOnSpaces = true;
+            break;
+        }
+    }
+
+    vector<TextSegment> result;
+    size_t segmentStart = 0;
+    size_t delimiterStart = string_view::npos;
+    size_t pos = 0;
+
+    while (pos < text.size()) {
+        size_t cpStart = pos;
+        const char* ascii;
+        DelimiterKind kind = ClassifyDelimiter(NextCodepoint(text, pos), &ascii);
+
+        // Spaces trailing punctuation always belong to the delimiter run
+        bool isDelimiter = kind == DelimiterKind::Punctuation ||
+                           (kind == DelimiterKind::Space && (splitOnSpaces || delimiterStart != string_view::npos));
+
+        // "1.5" and "1,000" are numbers, not clause breaks
+        if (isDelimiter && kind == DelimiterKind::Punctuation && pos - cpStart == 1 &&
+            cpStart > 0 && pos < text.size() && IsAsciiDigitByte(text[cpStart - 1]) && IsAsciiDigitByte(text[pos])) {
+            isDelimiter = false;
+        }
+
+        if (isDelimiter) {
+            if (delimiterStart == string_view::npos) {
+                delimiterStart = cpStart;
+            }
+        } else if (delimiterStart != string_view::npos) {
+            string_view segmentText = text.substr(segmentStart, delimiterStart - segmentStart);
+            result.push_back({ segmentText, text.substr(delimiterStart, cpStart - delimiterStart),
+                               passThroughAscii && IsAllAscii(segmentText) });
+            segmentStart = cpStart;
+            delimiterStart = string_view::npos;
+        }
+    }
+
+    size_t segmentEnd = delimiterStart == string_view::npos ? text.size() : delimiterStart;
+    string_view segmentText = text.substr(segmentStart, segmentEnd - segmentStart);
+    result.push_back({ segmentText, text.substr(segmentEnd), passThroughAscii && IsAllAscii(segmentText) });
+    return result;
+}
+
+void TranslationMemory::AppendDelimiter(string& out, string_view delimiter, bool cjkTarget, bool last) {
+    if (cjkTarget) {
+        out += delimiter;
+        return;
+    }
+
+    // Render each delimiter run as ASCII punctuation followed by one space
+    bool wroteSpace = false;
+    for (size_t pos = 0; pos < delimiter.size();) {
+        size_t cpStart = pos;
+        const char* ascii;
+        DelimiterKind kind = ClassifyDelimiter(NextCodepoint(delimiter, pos), &ascii);
+        if (kind == DelimiterKind::Punctuation) {
+            if (ascii) {
+                out += ascii;
+            } else {
+                out += delimiter.substr(cpStart, pos - cpStart);
+            }
+            wroteSpace = false;
+        } else if (!wroteSpace) {
+            out += ' ';
+            wroteSpace = true;
+        }
+    }
+    if (!last && !wroteSpace && !delimiter.empty()) {
+        out += ' ';
+    }
+}
+
+size_t TranslationMemory::CountChars(string_view text) {
+    size_t count = 0;
+    for (char c : text) {
+        if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+bool TranslationMemory::Lookup(string_view segment, LanguagePairId pair, uint32_t now, PooledString& translation) {
+    return segments.Lookup(NormalizeForCache(segment), pair, now, translation);
+}
+
+void TranslationMemory::Insert(string_view segment, LanguagePairId pair, string_view translation, uint32_t now) {
+    segments.Insert(NormalizeForCache(segment), pair, translation, now);
+}
+
+void TranslationMemory::CleanExpired(uint32_t now) {
+    segments.CleanExpired(now);
+}
+
+void TranslationMemory::RecordMessage(size_t local, size_t total) {
+    localChars += local;
+    totalChars += total;
+}
+
+void TranslationMemory::Clear() {
+    segments.Clear();
+}
+
+TranslationMemoryStats TranslationMemory::GetStats() {
+    TranslationCacheStats cacheStats = segments.GetStats();
+    TranslationMemoryStats stats = {};
+    stats.segments = cacheStats.entries;
+    stats.segmentHits = cacheStats.hits;
+    stats.segmentMisses = cacheStats.misses;
+    stats.localChars = localChars;
+    stats.totalChars = totalChars;
+    return stats;
+}
@@ -11,157 +11,47 @@
 #include <locale>
 #include <vector>
 #include <cstdio>
+#include <system_error>
+#include <chrono>
+#include <fstream>
 
 #include "../include/translator_core.h"
 #include "../include/logging.h"
 #include "../include/utils.h"
+#include "../include/tracing.h"
+#include "../include/text_normalize.h"
+#include "../include/language_id.h"
+#include "../include/utf8.h"
+#include "../include/wire_format.h"
 
 using namespace std;
 
-// Simple JSON parser for proxy server responses
-class SimpleJsonParser {
-public:
-    static string extractField(const string& json, const string& fieldName) {
-        string searchKey = "\"" + fieldName + "\"";
-        size_t keyPos = json.find(searchKey);
-        if (keyPos == string::npos) {
-            return "";
-        }
-
-        size_t colonPos = json.find(":", keyPos + searchKey.length());
-        if (colonPos == string::npos) {
-            return "";
-        }
-
-        size_t start = colonPos + 1;
-        while (start < json.length() && (json[start] == ' ' || json[start] == '\t' || json[start] == '\n' || json[start] == '\r')) {
-            start++;
-        }
-
-        if (start >= json.length()) {
-            return "";
-        }
-
-        // Check if it's a string value (starts with quote)
-        if (json[start] == '"') {
-            start++;
-            size_t end = start;
-            while (end < json.length() && json[end] != '"') {
-                if (json[end] == '\\' && end + 1 < json.length()) {
-                    end += 2; // Skip escaped character
-                } else {
-                    end++;
-                }
-            }
-            return unescapeJson(json.substr(start, end - start));
-        }
-
-        // It's a number or boolean
-        size_t end = start;
-        while (end < json.length() && json[end] != ',' && json[end] != '}' && json[end] != '\n') {
-            end++;
-        }
-        string value = json.substr(start, end - start);
-        // Trim whitespace
-        while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r')) {
-            value.pop_back();
-        }
-        return value;
-    }
-
-    static double extractNumber(const string& json, const string& fieldName) {
-        string value = extractField(json, fieldName);
-        if (value.empty()) return -1;
-        try {
-            return stod(value);
-        } catch (...) {
-            return -1;
-        }
-    }
-
-private:
-    static string unescapeJson(const string& input) {
-        string result = input;
-        size_t pos = 0;
-
-        // Unescape basic characters
-        while ((pos = result.find("\\\"", pos)) != string::npos) {
-            result.replace(pos, 2, "\"");
-            pos += 1;
-        }
-        pos = 0;
-        while ((pos = result.find("\\\\", pos)) != string::npos) {
-            result.replace(pos, 2, "\\");
-            pos += 1;
-        }
-        pos = 0;
-        while ((pos = result.find("\\n", pos)) != string::npos) {
-            result.replace(pos, 2, "\n");
-            pos += 1;
-        }
-        pos = 0;
-        while ((pos = result.find("\\r", pos)) != string::npos) {
-            result.replace(pos, 2, "\r");
-            pos += 1;
-        }
-        pos = 0;
-        while ((pos = result.find("\\t", pos)) != string::npos) {
-            result.replace(pos, 2, "\t");
-            pos += 1;
-        }
-
-        // Handle Unicode escape sequences \uXXXX
-        pos = 0;
-        while ((pos = result.find("\\u", pos)) != string::npos) {
-            if (pos + 5 < result.length()) {
-                string hexStr = result.substr(pos + 2, 4);
-                try {
-                    unsigned int codepoint = stoul(hexStr, nullptr, 16);
-                    string utf8_char = ConvertCodepointToUTF8(codepoint);
-                    result.replace(pos, 6, utf8_char);
-                    pos += utf8_char.length();
-                } catch (...) {
-                    pos += 6;
-                }
-            } else {
-                break;
-            }
-        }
-
-        return result;
-    }
-
-    static string ConvertCodepointToUTF8(unsigned int codepoint) {
-        string result;
-
-        if (codepoint <= 0x7F) {
-            result += static_cast<char>(codepoint);
-        } else if (codepoint <= 0x7FF) {
-            result += static_cast<char>(0xC0 | (codepoint >> 6));
-            result += static_cast<char>(0x80 | (codepoint & 0x3F));
-        } else if (codepoint <= 0xFFFF) {
-            result += static_cast<char>(0xE0 | (codepoint >> 12));
-            result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-            result += static_cast<char>(0x80 | (codepoint & 0x3F));
-        } else if (codepoint <= 0x10FFFF) {
-            result += static_cast<char>(0xF0 | (codepoint >> 18));
-            result += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
-            result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
-            result += static_cast<char>(0x80 | (codepoint & 0x3F));
-        }
-
-        return result;
-    }
-};
-
 // Global variables
 unique_ptr<TranslationClient> g_translator = nullptr;
-char g_translation_buffer[4096] = {0};
-char g_error_buffer[256] = {0};
 
-TranslationClient::TranslationClient()
-    : hSession(nullptr), hConnect(nullptr), initialized(false), running(false),
-      creditsRemaining(-1) {
+// Set on the worker thread and on the chunk and hedge threads working for
+// it: their engine calls are registered with the in-flight request so a
+// cancel can stop them
+static thread_local bool t_cancellableRequests = false;
+
+TranslationClient::TranslationClient(Clock& clock, const SchedulingPolicy& schedulingPolicy)
+    : clock(clock), hSession(nullptr),
+      cache(schedulingPolicy.cacheEntries, schedulingPolicy.cacheExpiryMs), initialized(false),
+      requests(schedulingPolicy, clock), running(false), resultCount(0), hedgeBusy(false), creditsRemaining(-1), templatingEnabled(false), templateHits(0), preflightEnabled(true),
+      preflightSkipped(),
+      segmentMemory(MAX_SEGMENT_MEMORY_SIZE, SEGMENT_MEMORY_EXPIRY_MS), segmentMemoryEnabled(false),
+      phrasebookPair(INVALID_LANGUAGE_PAIR),
+      nearDuplicates(MAX_NEAR_DUPLICATE_SIZE), nearDuplicateEnabled(false),
+      nearDuplicateThreshold(DEFAULT_NEAR_DUPLICATE_THRESHOLD), offlineMode(OfflineMode::OFF),
+      offlineFirstPassChars(DEFAULT_OFFLINE_FIRST_PASS_CHARS), fanOutSupported(true), fanOutRequests(0),
+      fanOutTargets(0), sharedCache(schedulingPolicy.cacheExpiryMs), sharedCacheEnabled(false),
+      chunkingEnabled(true), chunkedMessages(0), chunkRequests(0), chunkCacheHits(0), streamingEnabled(false),
+      streamSupported(true), streamedMessages(0), streamPartials(0), streamFirstSentenceMicros(0),
+      streamFullMicros(0),
+      wireProtocol(WireProtocol::UNKNOWN), binaryProtocolEnabled(true), keyGeneration(0), sessionGeneration(0),
+      sessionExpiry(0), sessionHandshaking(false), wireRequests(0), wireBytesSent(0), wireBytesReceived(0), wireEncodeNanos(0),
+      wireDecodeNanos(0), multiplexEnabled(true), dispatchEnqueues(0), prefetchSubmitted(0), prefetchUsed(0),
+      prefetchWasted(0), prefetchFallbacks(0) {
 }
 
 TranslationClient::~TranslationClient() {
@@ -169,18 +59,32 @@ TranslationClient::~TranslationClient() {
 }
 
 string TranslationClient::GetServerInfo() const {
-    return string("https://") + SERVER_HOST + ":" + to_string(SERVER_PORT);
-}
+    size_t count = router.Count();
+    if (count == 0) {
+        return string("https://") + DEFAULT_SERVER_HOST + ":" + to_string(DEFAULT_SERVER_PORT);
+    }
 
-bool TranslationClient::Initialize(const string& key) {
-    if (initialized) {
-        Cleanup();
+    string info;
+    for (size_t i = 0; i < count; ++i) {
+        info += (i > 0 ? ", https://" : "https://") + router.Name(i);
     }
+    return info;
+}
 
-    apiKey = key;
+vector<EndpointStats> TranslationClient::GetEndpointStats() const {
+    return router.GetStats(clock.Now());
+}
 
-    LOG_INFO("Initializing translation client");
-    LOG_INFO("Server: " + GetServerInfo());
+// Runs once on the startup thread: maps local data, opens the WinHTTP
+// session and warms each endpoint's connection so the first translation
+// skips the TLS handshake and the router starts with a latency for every
+// endpoint. The client accepts requests once SetApiKey is called.
+bool TranslationClient::Start() {
+    LOG_INFO("Starting translation client");
+
+    LoadPhrasebook();
+    LoadNameIndex();
+    LoadOfflineDictionary();
 
     // Initialize WinHTTP
     hSession = WinHttpOpen(L"WoWTranslate/0.2",
@@ -193,59 +97,293 @@ bool TranslationClient::Initialize(const string& key) {
         LOG_ERROR("Failed to initialize WinHTTP session");
         return false;
     }
+    // Without it every request stays on the worker thread, as before
+    asyncHttp.Start(L"WoWTranslate/0.2");
 
-    // Convert host to wide string
-    wstring wHost;
-    for (const char* p = SERVER_HOST; *p; ++p) {
-        wHost += static_cast<wchar_t>(*p);
-    }
-
-    // Connect to the proxy server
-    hConnect = WinHttpConnect(hSession,
-                             wHost.c_str(),
-                             static_cast<INTERNET_PORT>(SERVER_PORT),
-                             0);
-
-    if (!hConnect) {
-        LOG_ERROR("Failed to connect to server: " + string(SERVER_HOST));
+    LoadEndpoints();
+    if (connections.empty()) {
+        LOG_ERROR("Failed to connect to any server");
+        asyncHttp.Stop();
         WinHttpCloseHandle(hSession);
         hSession = nullptr;
         return false;
     }
+    LOG_INFO("Server: " + GetServerInfo());
+
+    // Endpoints are warmed in parallel so one that is down costs a single timeout
+    vector<thread> warmUps;
+    for (size_t i = 0; i < connections.size(); ++i) {
+        warmUps.emplace_back(&TranslationClient::WarmUpConnection, this, i);
+    }
+    for (thread& warmUp : warmUps) {
+        warmUp.join();
+    }
 
     // Start worker thread for async translations
     running = true;
     workerThread = thread(&TranslationClient::WorkerThreadFunc, this);
+    hedgeThread = thread(&TranslationClient::HedgeThreadFunc, this);
 
-    initialized = true;
-    LOG_INFO("Translation client initialized successfully");
+    LOG_INFO("Translation client started");
     return true;
 }
 
+// Cheap enough for the game thread: no handles are opened or threads joined
+void TranslationClient::SetApiKey(const string& key) {
+    {
+        lock_guard<mutex> lock(keyMutex);
+        apiKey = key;
+    }
+    keyGeneration++;
+    creditsRemaining = -1;
+    initialized = !connections.empty();
+}
+
+// Read WoWTranslate_endpoints.txt ("host[:port]" per line, # comments) and
+// open a connection handle per endpoint; without the file the production
+// proxy is the only endpoint. Handles are opened here and never replaced,
+// so request threads read connections without locking.
+void TranslationClient::LoadEndpoints() {
+    vector<pair<string, int>> configured;
+    string dllDir = GetDllFolder();
+    if (!dllDir.empty()) {
+        string path = dllDir + "\\WoWTranslate_endpoints.txt";
+        ifstream file(path);
+        string line;
+        while (getline(file, line)) {
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == string::npos || line[first] == '#') {
+                continue;
+            }
+            size_t last = line.find_last_not_of(" \t\r");
+            string entry = line.substr(first, last - first + 1);
+
+            int port = DEFAULT_SERVER_PORT;
+            size_t colon = entry.rfind(':');
+            if (colon != string::npos) {
+                port = atoi(entry.c_str() + colon + 1);
+                entry.resize(colon);
+            }
+            if (entry.empty() || entry.find_first_of(" \t/") != string::npos || port <= 0 || port > 65535) {
+                LOG_WARNING("Ignoring endpoint line in " + path + ": " + line);
+                continue;
+            }
+            configured.emplace_back(entry, port);
+        }
+        if (!configured.empty()) {
+            LOG_INFO("Endpoints: " + to_string(configured.size()) + " from " + path);
+        }
+    }
+    if (configured.empty()) {
+        configured.emplace_back(DEFAULT_SERVER_HOST, DEFAULT_SERVER_PORT);
+    }
+
+    for (const auto& endpoint : configured) {
+        if (connections.size() >= EndpointRouter::MAX_ENDPOINTS) {
+            LOG_WARNING("Only the first " + to_string(EndpointRouter::MAX_ENDPOINTS) + " endpoints are used");
+            break;
+        }
+
+        wstring wHost(endpoint.first.begin(), endpoint.first.end());
+        HINTERNET connection = WinHttpConnect(hSession, wHost.c_str(),
+                                              static_cast<INTERNET_PORT>(endpoint.second), 0);
+        if (!connection) {
+            LOG_ERROR("Failed to connect to server: " + endpoint.first);
+            continue;
+        }
+        connections.push_back(connection);
+        asyncHttp.AddEndpoint(endpoint.first, endpoint.second);
+        router.Add(endpoint.first + ":" + to_string(endpoint.second));
+    }
+}
+
+// A HEAD request opens the TCP/TLS connection, which WinHTTP then keeps
+// alive in the session pool for the first real request; its time is the
+// router's first latency sample for the endpoint. Start() waits for it, so
+// it gets a probe's timeout rather than WinHTTP's 60 s connect default.
+void TranslationClient::WarmUpConnection(size_t endpoint) {
+    uint64_t startMs = clock.Now();
+
+    HINTERNET hRequest = WinHttpOpenRequest(connections[endpoint], L"HEAD", L"/", nullptr, WINHTTP_NO_REFERER,
+                                            WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
+    if (!hRequest) {
+        return;
+    }
+    int timeout = static_cast<int>(EndpointRouter::PROBE_TIMEOUT_MS);
+    WinHttpSetTimeouts(hRequest, timeout, timeout, timeout, timeout);
+    bool connected = WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+                                        WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+                     WinHttpReceiveResponse(hRequest, nullptr);
+    WinHttpCloseHandle(hRequest);
+
+    uint64_t nowMs = clock.Now();
+    router.Record(endpoint, nowMs, static_cast<uint32_t>(nowMs - startMs), connected);
+    LOG_INFO("Connection warm-up to " + router.Name(endpoint) + (connected ? " done" : " failed") + " in " +
+             to_string(nowMs - startMs) + " ms");
+}
+
 void TranslationClient::Cleanup() {
     // Stop worker thread
     if (running) {
         running = false;
+        {
+            lock_guard<mutex> lock(requestMutex);
+            requests.WakeWorker();
+        }
+        {
+            lock_guard<mutex> lock(dispatchMutex);
+            dispatchChanged.notify_all();
+        }
         if (workerThread.joinable()) {
             workerThread.join();
         }
+        {
+            lock_guard<mutex> lock(requestMutex);
+            hedgeWork.notify_all();
+        }
+        if (hedgeThread.joinable()) {
+            hedgeThread.join();
+        }
     }
+    asyncHttp.Stop();
 
-    if (hConnect) {
-        WinHttpCloseHandle(hConnect);
-        hConnect = nullptr;
+    for (HINTERNET connection : connections) {
+        WinHttpCloseHandle(connection);
     }
+    connections.clear();
 
     if (hSession) {
         WinHttpCloseHandle(hSession);
         hSession = nullptr;
     }
 
-    cache.clear();
+    cache.Clear();
+    negativeCache.Clear();
+    segmentMemory.Clear();
+    nearDuplicates.Clear();
+    phrasebook.Close();
+    phrasebookPair = INVALID_LANGUAGE_PAIR;
+    nameIndex.Close();
+    sharedCacheEnabled = false;
+    sharedCache.Close();
     initialized = false;
     LOG_INFO("Translation client cleanup complete");
 }
 
+// Map the optional prebuilt phrasebook; missing or invalid files are not an error
+void TranslationClient::LoadPhrasebook() {
+    string dllDir = GetDllFolder();
+    if (dllDir.empty()) {
+        return;
+    }
+
+    string path = dllDir + "\\WoWTranslate_phrasebook.wtpb";
+    if (!phrasebook.Open(path)) {
+        LOG_DEBUG("No phrasebook loaded from " + path);
+        return;
+    }
+
+    phrasebookPair = InternLanguagePair(phrasebook.SourceLanguage(), phrasebook.TargetLanguage());
+    PhrasebookStats stats = phrasebook.GetStats();
+    LOG_INFO("Phrasebook mapped: " + to_string(stats.entries) + " phrases, " + to_string(stats.mappedBytes) +
+             " bytes in " + to_string(stats.openMicros) + " us (" + string(phrasebook.SourceLanguage()) +
+             " -> " + string(phrasebook.TargetLanguage()) + ")");
+}
+
+// Map the optional item/quest name index; missing or invalid files are not an error
+void TranslationClient::LoadNameIndex() {
+    string dllDir = GetDllFolder();
+    if (dllDir.empty()) {
+        return;
+    }
+
+    string path = dllDir + "\\WoWTranslate_names.wtni";
+    if (!nameIndex.Open(path)) {
+        LOG_DEBUG("No name index loaded from " + path);
+        return;
+    }
+
+    NameIndexStats stats = nameIndex.GetStats();
+    LOG_INFO("Name index mapped: " + to_string(stats.items) + " items, " + to_string(stats.quests) + " quests, " +
+             to_string(stats.mappedBytes) + " bytes in " + to_string(stats.openMicros) + " us");
+}
+
+// Extend the built-in offline glossary; a missing file is not an error
+void TranslationClient::LoadOfflineDictionary() {
+    string dllDir = GetDllFolder();
+    if (dllDir.empty()) {
+        return;
+    }
+
+    string path = dllDir + "\\WoWTranslate_dictionary.tsv";
+    int added = offlineEngine.LoadDictionary(path);
+    if (added < 0) {
+        LOG_DEBUG("No offline dictionary loaded from " + path);
+        return;
+    }
+
+    OfflineEngineStats stats = offlineEngine.GetStats();
+    LOG_INFO("Offline dictionary: " + to_string(added) + " entries from " + path + " (" +
+             to_string(stats.entries) + " total, ~" + to_string(stats.approximateBytes / 1024) + " KB)");
+}
+
+void TranslationClient::SetOfflineMode(OfflineMode mode, int maxChars) {
+    offlineMode = mode;
+    if (maxChars > 0) {
+        offlineFirstPassChars = maxChars;
+    }
+    LOG_INFO("Offline engine: mode " + to_string(static_cast<int>(mode)) +
+             ", first pass up to " + to_string(offlineFirstPassChars.load()) + " chars");
+}
+
+bool TranslationClient::SetSharedCacheEnabled(bool enabled) {
+    lock_guard<mutex> lock(sharedCacheMutex);
+    if (enabled && !sharedCache.IsOpen() && !sharedCache.Open(SHARED_CACHE_NAME)) {
+        LOG_WARNING("Shared translation cache unavailable");
+        return false;
+    }
+    sharedCacheEnabled = enabled;
+    LOG_INFO(string("Shared translation cache: ") + (enabled ? "on" : "off"));
+    return true;
+}
+
+// Gloss text locally; requireFullCoverage rejects glosses with untranslated characters
+bool TranslationClient::TranslateOffline(string_view text, LanguagePairId languagePair, bool requireFullCoverage,
+                                         PooledString& result, TranslationInfo& info) {
+    if (languagePair != OFFLINE_LANGUAGE_PAIR) {
+        return false;
+    }
+
+    TRACE_SPAN("offline_gloss");
+    string gloss;
+    bool fullCoverage = false;
+    if (!offlineEngine.Gloss(text, gloss, fullCoverage) || (requireFullCoverage && !fullCoverage)) {
+        return false;
+    }
+
+    result.assign(gloss.data(), gloss.size());
+    info.flags |= TRANSLATION_FLAG_APPROXIMATE;
+    return true;
+}
+
+// Replace a failed proxy request with an approximate gloss when the proxy is
+// unreachable or out of credits; other failures are returned unchanged
+TranslationResult TranslationClient::FallBackOffline(string_view text, LanguagePairId languagePair,
+                                                     TranslationResult failure, PooledString& result,
+                                                     TranslationInfo& info) {
+    bool unreachable = failure == TranslationResult::NETWORK_ERROR || failure == TranslationResult::TIMEOUT_ERROR;
+    bool noCredits = failure == TranslationResult::API_ERROR && result == "INSUFFICIENT_CREDITS";
+    if (offlineMode == OfflineMode::OFF || !(unreachable || noCredits)) {
+        return failure;
+    }
+
+    if (!TranslateOffline(text, languagePair, false, result, info)) {
+        return failure;
+    }
+    LOG_DEBUG("Offline fallback for: " + string(text.substr(0, 50)));
+    return TranslationResult::SUCCESS;
+}
+
 string TranslationClient::UrlEncode(const string& text) {
     ostringstream encoded;
     encoded.fill('0');
@@ -264,87 +402,180 @@ string TranslationClient::UrlEncode(const string& text) {
     return encoded.str();
 }
 
-string TranslationClient::GenerateCacheKey(const string& text, const string& sourceLang, const string& targetLang) {
-    return sourceLang + "->" + targetLang + ":" + text;
-}
-
-void TranslationClient::CleanExpiredCache() {
-    DWORD currentTime = GetTickCount();
-    auto it = cache.begin();
+// POST to one endpoint; empty on network errors and gateway failures (502-504),
+// which mean the endpoint rather than the request is at fault. The request
+// goes out on the async engine when it runs, so a cancel from any thread
+// can stop it there; a synchronous WinHTTP handle is only ever closed by
+// the thread that opened it.
+PooledString TranslationClient::HttpsRequest(size_t endpoint, const string& path, string_view postData,
+                                             bool binary, HedgeRace* race, int lane, DWORD timeoutMs,
+                                             const function<void(string_view)>* onData) {
+    if (endpoint >= connections.size()) {
+        return "";
+    }
 
-    while (it != cache.end()) {
-        if (currentTime - it->second.timestamp > CACHE_EXPIRY_MS) {
-            it = cache.erase(it);
-        } else {
-            ++it;
+    // Worker requests register their engine call so CancelRequest can cancel
+    // it, which ends the wait in EngineExchange at once
+    bool cancellable = t_cancellableRequests;
+    shared_ptr<AsyncCall> call;
+    if (asyncHttp.IsRunning()) {
+        call = make_shared<AsyncCall>(string_view(), DEFAULT_LANGUAGE_PAIR);
+    }
+    if (cancellable || race) {
+        lock_guard<mutex> lock(requestMutex);
+        if ((cancellable && requests.inFlight.abandoned) || (race && race->winner >= 0)) {
+            return "";
+        }
+        if (cancellable && call) {
+            requests.inFlight.asyncCalls.push_back(call);
+        }
+        // The winning lane cancels the other lane's call
+        if (race && call) {
+            race->calls[lane] = call;
         }
     }
 
-    if (cache.size() > MAX_CACHE_SIZE) {
-        size_t removeCount = cache.size() - MAX_CACHE_SIZE / 2;
-        for (size_t i = 0; i < removeCount && !cache.empty(); ++i) {
-            cache.erase(cache.begin());
+    PooledString response;
+    if (call && EngineExchange(call, endpoint, path, postData, binary, timeoutMs, onData)) {
+        if (call->statusCode >= 502 && call->statusCode <= 504) {
+            LOG_WARNING("Gateway error " + to_string(call->statusCode) + " from " + router.Name(endpoint));
         }
+        response = std::move(call->response);
+    } else {
+        response = BlockingRequest(endpoint, path, postData, binary, timeoutMs, onData);
     }
-}
 
-// Escape a string for JSON
-static string escapeJsonString(const string& input) {
-    ostringstream ss;
-    for (char c : input) {
-        switch (c) {
-            case '"': ss << "\\\""; break;
-            case '\\': ss << "\\\\"; break;
-            case '\b': ss << "\\b"; break;
-            case '\f': ss << "\\f"; break;
-            case '\n': ss << "\\n"; break;
-            case '\r': ss << "\\r"; break;
-            case '\t': ss << "\\t"; break;
-            default:
-                if ('\x00' <= c && c <= '\x1f') {
-                    ss << "\\u" << hex << setw(4) << setfill('0') << (int)c;
-                } else {
-                    ss << c;
-                }
+    // An answer nobody is waiting for any more is dropped here, by the
+    // thread that fetched it
+    if (cancellable || race) {
+        lock_guard<mutex> lock(requestMutex);
+        if (cancellable && call) {
+            auto registered = find(requests.inFlight.asyncCalls.begin(), requests.inFlight.asyncCalls.end(), call);
+            if (registered != requests.inFlight.asyncCalls.end()) {
+                requests.inFlight.asyncCalls.erase(registered);
+            }
+        }
+        if (race && call && race->calls[lane] == call) {
+            race->calls[lane].reset();
+        }
+        if ((cancellable && requests.inFlight.abandoned) || (race && race->winner >= 0)) {
+            return "";
         }
     }
-    return ss.str();
+    return response;
 }
 
-string TranslationClient::HttpsRequest(const string& host, const string& path, const string& postData) {
-    if (!hConnect) {
-        return "";
+// Send call on the async engine and wait for its answer in call->response.
+// False when the engine would not take the request (every slot in use), so
+// the caller sends it the blocking way; true with an empty response when
+// the call was cancelled first.
+bool TranslationClient::EngineExchange(const shared_ptr<AsyncCall>& call, size_t endpoint, const string& path,
+                                       string_view postData, bool binary, DWORD timeoutMs,
+                                       const function<void(string_view)>* onData) {
+    TRACE_SPAN("http_async");
+    uint64_t id = asyncHttp.Submit(endpoint, path, postData, binary, timeoutMs,
+                                   [this, call](PooledString response, uint32_t statusCode) {
+        {
+            lock_guard<mutex> lock(dispatchMutex);
+            call->done = true;
+            call->httpId = 0;
+            call->statusCode = statusCode;
+            call->response = std::move(response);
+        }
+        dispatchChanged.notify_all();
+    }, onData ? AsyncHttpEngine::DataHandler(*onData) : nullptr);
+
+    unique_lock<mutex> lock(dispatchMutex);
+    if (id == 0) {
+        return call->cancelled;
+    }
+    // The completion may already have run on a WinHTTP thread
+    if (!call->done) {
+        call->httpId = id;
+        if (call->cancelled) {
+            lock.unlock();
+            asyncHttp.Cancel(id);
+            lock.lock();
+        }
     }
+    while (!call->done) {
+        dispatchChanged.wait(lock, [&]() { return call->done || !running; });
+        // Shutting down: cancel it, the engine completes it right away
+        if (!call->done && !running && !call->cancelled) {
+            call->cancelled = true;
+            uint64_t httpId = call->httpId;
+            lock.unlock();
+            asyncHttp.Cancel(httpId);
+            lock.lock();
+        } else if (!call->done) {
+            dispatchChanged.wait(lock, [&]() { return call->done; });
+        }
+    }
+    return true;
+}
 
+// Synchronous WinHTTP exchange on the calling thread. A cancel cannot reach
+// it; HttpsRequest drops the answer if nobody wants it by then.
+PooledString TranslationClient::BlockingRequest(size_t endpoint, const string& path, string_view postData,
+                                                bool binary, DWORD timeoutMs,
+                                                const function<void(string_view)>* onData) {
     wstring wPath(path.begin(), path.end());
 
     DWORD flags = WINHTTP_FLAG_SECURE;  // Always use HTTPS
 
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect,
-                                           L"POST",
-                                           wPath.c_str(),
-                                           nullptr,
-                                           WINHTTP_NO_REFERER,
-                                           WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                           flags);
+    HINTERNET hRequest;
+    {
+        TRACE_SPAN("http_open");
+        hRequest = WinHttpOpenRequest(connections[endpoint],
+                                      L"POST",
+                                      wPath.c_str(),
+                                      nullptr,
+                                      WINHTTP_NO_REFERER,
+                                      WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                      flags);
+
+        if (!hRequest) {
+            LOG_ERROR("Failed to open HTTP request");
+            return "";
+        }
 
-    if (!hRequest) {
-        LOG_ERROR("Failed to open HTTP request");
-        return "";
+        // Set headers
+        const wchar_t* headers = binary ? L"Content-Type: application/msgpack\r\nAccept: application/msgpack\r\n"
+                                        : L"Content-Type: application/json\r\n";
+        WinHttpAddRequestHeaders(hRequest, headers, (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD);
+        if (timeoutMs > 0) {
+            int timeout = static_cast<int>(timeoutMs);
+            WinHttpSetTimeouts(hRequest, timeout, timeout, timeout, timeout);
+        }
     }
 
-    // Set headers
-    wstring headers = L"Content-Type: application/json\r\n";
-    WinHttpAddRequestHeaders(hRequest, headers.c_str(), (DWORD)-1, WINHTTP_ADDREQ_FLAG_ADD);
-
     // Send request
-    BOOL result = WinHttpSendRequest(hRequest,
+    BOOL result;
+    {
+        TRACE_SPAN("http_send");
+        result = WinHttpSendRequest(hRequest,
                                     WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                                    (LPVOID)postData.c_str(), (DWORD)postData.length(),
+                                    (LPVOID)postData.data(), (DWORD)postData.length(),
                                     (DWORD)postData.length(), 0);
+    }
+
+    BOOL received = FALSE;
+    DWORD statusCode = 0;
+    if (result) {
+        TRACE_SPAN("http_receive");
+        received = WinHttpReceiveResponse(hRequest, nullptr);
+        DWORD statusSize = sizeof(statusCode);
+        if (received) {
+            WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &statusSize, WINHTTP_NO_HEADER_INDEX);
+        }
+    }
 
-    string response;
-    if (result && WinHttpReceiveResponse(hRequest, nullptr)) {
+    PooledString response;
+    if (statusCode >= 502 && statusCode <= 504) {
+        LOG_WARNING("Gateway error " + to_string(statusCode) + " from " + router.Name(endpoint));
+    } else if (received) {
+        TRACE_SPAN("http_read");
         DWORD bytesAvailable = 0;
         char buffer[8192];
 
@@ -353,8 +584,10 @@ string TranslationClient::HttpsRequest(const string& host, const string& path, c
             DWORD bytesToRead = min(bytesAvailable, (DWORD)(sizeof(buffer) - 1));
 
             if (WinHttpReadData(hRequest, buffer, bytesToRead, &bytesRead)) {
-                buffer[bytesRead] = '\0';
-                response += string(buffer, bytesRead);
+                response.append(buffer, bytesRead);
+                if (onData && bytesRead > 0) {
+                    (*onData)(string_view(buffer, bytesRead));
+                }
             } else {
                 break;
             }
@@ -368,194 +601,2016 @@ string TranslationClient::HttpsRequest(const string& host, const string& path, c
     return response;
 }
 
-string TranslationClient::ParseTranslationResponse(const string& jsonResponse) {
-    // Extract translation from proxy server response
-    return SimpleJsonParser::extractField(jsonResponse, "translation");
+// True when an empty response came from a cancel or a lost hedge race
+// rather than from the endpoint
+bool TranslationClient::RequestAbandoned(HedgeRace* race) {
+    bool cancellable = t_cancellableRequests;
+    if (!cancellable && !race) {
+        return false;
+    }
+    lock_guard<mutex> lock(requestMutex);
+    return (cancellable && requests.inFlight.abandoned) || (race && race->winner >= 0);
 }
 
-// Synchronous translation via proxy server
-TranslationResult TranslationClient::TranslateText(const string& text, string& result,
-                                                   const string& sourceLang, const string& targetLang) {
-    if (!initialized) {
-        LOG_ERROR("Translation client not initialized");
-        return TranslationResult::INVALID_PARAMS;
-    }
+// POST to the endpoint the router prefers, failing over to the next best
+// when it does not answer. Cancelled requests are neither retried nor held
+// against the endpoint.
+PooledString TranslationClient::RoutedRequest(const string& path, string_view postData, bool binary,
+                                              HedgeRace* race, int lane,
+                                              const function<void(string_view)>* onData) {
+    uint32_t tried = 0;
+    for (uint32_t attempt = 0; attempt < EndpointRouter::MAX_ATTEMPTS; ++attempt) {
+        EndpointChoice choice = router.Select(clock.Now(), tried);
+        if (choice.endpoint == EndpointRouter::NO_ENDPOINT) {
+            break;
+        }
+        if (attempt > 0) {
+            router.RecordFailover();
+            LOG_WARNING("Failing over to " + router.Name(choice.endpoint));
+        }
+        tried |= 1u << choice.endpoint;
+
+        uint64_t startMs = clock.Now();
+        PooledString response = HttpsRequest(choice.endpoint, path, postData, binary, race, lane,
+                                             choice.probe ? EndpointRouter::PROBE_TIMEOUT_MS : 0, onData);
+        uint64_t nowMs = clock.Now();
+        if (response.empty() && RequestAbandoned(race)) {
+            if (choice.probe) {
+                router.ReleaseProbe(choice.endpoint);
+            }
+            return response;
+        }
 
-    if (text.empty()) {
-        LOG_ERROR("Invalid translation parameters: empty text");
-        return TranslationResult::INVALID_PARAMS;
+        router.Record(choice.endpoint, nowMs, static_cast<uint32_t>(nowMs - startMs), !response.empty());
+        if (!response.empty()) {
+            return response;
+        }
     }
+    return PooledString();
+}
 
-    // Check local cache first (DLL-side cache)
-    string cacheKey = GenerateCacheKey(text, sourceLang, targetLang);
-    auto cacheIt = cache.find(cacheKey);
-    if (cacheIt != cache.end() && (GetTickCount() - cacheIt->second.timestamp) < CACHE_EXPIRY_MS) {
-        result = cacheIt->second.translation;
-        LOG_DEBUG("Local cache hit for: " + text.substr(0, 50));
-        return TranslationResult::SUCCESS;
+// POST to the proxy, duplicating the request on a second connection when it
+// runs past the hedge threshold; the first answer is returned
+PooledString TranslationClient::HedgedRequest(const string& path, string_view postData, bool binary) {
+    uint64_t startMs = clock.Now();
+    auto elapsedMs = [this, startMs]() { return static_cast<uint32_t>(clock.Now() - startMs); };
+
+    uint32_t thresholdMs = hedgePolicy.BeginRequest();
+    if (thresholdMs == 0) {
+        PooledString response = RoutedRequest(path, postData, binary);
+        if (!response.empty()) {
+            hedgePolicy.RecordLatency(elapsedMs());
+        }
+        return response;
     }
 
-    CleanExpiredCache();
+    auto race = make_shared<HedgeRace>();
+    {
+        lock_guard<mutex> lock(requestMutex);
+        if (!hedgeBusy && running) {
+            hedgeBusy = true;
+            PooledString body(postData.data(), postData.size());
+            bool cancellable = t_cancellableRequests;
+            string traceId = TraceRequestScope::Current();
+            hedgeJob = [this, race, path, body, binary, thresholdMs, cancellable, traceId]() {
+                t_cancellableRequests = cancellable;
+                TraceRequestScope traceScope(traceId);
+                RunHedgeLane(race, path, body, binary, thresholdMs);
+            };
+            hedgeWork.notify_one();
+        } else {
+            race->finished[1] = true;
+        }
+    }
 
-    // Build JSON request body for proxy server
-    // Format: { "apiKey": "WT-xxx", "text": "...", "from": "zh", "to": "en" }
-    string requestBody = "{";
-    requestBody += "\"apiKey\":\"" + escapeJsonString(apiKey) + "\",";
-    requestBody += "\"text\":\"" + escapeJsonString(text) + "\",";
-    requestBody += "\"from\":\"" + sourceLang + "\",";
-    requestBody += "\"to\":\"" + targetLang + "\"";
-    requestBody += "}";
+    FinishHedgeLane(*race, 0, RoutedRequest(path, postData, binary, race.get(), 0));
+
+    // Lane 1 is only waited for while it can still win
+    int winner;
+    PooledString response;
+    {
+        unique_lock<mutex> lock(requestMutex);
+        race->changed.wait(lock, [&]() { return race->winner >= 0 || race->finished[1]; });
+        winner = race->winner;
+        if (winner >= 0) {
+            response = std::move(race->responses[winner]);
+        }
+    }
 
-    string path = "/api/translate";
+    // A cancelled original still tells us the latency was at least this long
+    if (winner >= 0) {
+        hedgePolicy.RecordLatency(elapsedMs());
+    }
+    if (winner == 1) {
+        hedgePolicy.RecordHedgeWin();
+    }
+    return response;
+}
 
-    LOG_DEBUG("Requesting translation from proxy: " + text.substr(0, 50) + " (" + sourceLang + " -> " + targetLang + ")");
+// Lane 1 of a race, on the hedge thread: waits out the threshold, then sends
+// the duplicate unless lane 0 has finished or the budget says no
+void TranslationClient::RunHedgeLane(const shared_ptr<HedgeRace>& race, const string& path,
+                                     const PooledString& postData, bool binary, uint32_t thresholdMs) {
+    bool hedge;
+    {
+        unique_lock<mutex> lock(requestMutex);
+        hedge = !clock.WaitFor(lock, race->changed, thresholdMs, [&]() { return race->finished[0]; });
+    }
+    if (hedge && hedgePolicy.TryHedge()) {
+        TRACE_SPAN("hedge");
+        LOG_DEBUG("Hedging request after " + to_string(thresholdMs) + " ms");
+        FinishHedgeLane(*race, 1, RoutedRequest(path, postData, binary, race.get(), 1));
+        return;
+    }
+    lock_guard<mutex> lock(requestMutex);
+    race->finished[1] = true;
+    race->changed.notify_all();
+}
 
-    // Make HTTP request to proxy server
-    string response = HttpsRequest(SERVER_HOST, path, requestBody);
+void TranslationClient::HedgeThreadFunc() {
+    unique_lock<mutex> lock(requestMutex);
+    while (true) {
+        hedgeWork.wait(lock, [this]() { return hedgeJob || !running; });
+        if (!hedgeJob) {
+            break;
+        }
+        function<void()> job = std::move(hedgeJob);
+        hedgeJob = nullptr;
+        lock.unlock();
+        job();
+        lock.lock();
+        hedgeBusy = false;
+    }
+}
 
-    if (response.empty()) {
-        LOG_ERROR("Empty response from proxy server");
-        return TranslationResult::NETWORK_ERROR;
+// First non-empty answer wins; the other lane's engine call is cancelled so
+// its wait returns at once. A losing lane on the blocking path finishes on
+// its own thread and RequestAbandoned tells it to drop the answer.
+void TranslationClient::FinishHedgeLane(HedgeRace& race, int lane, PooledString response) {
+    lock_guard<mutex> lock(requestMutex);
+    race.finished[lane] = true;
+    if (!response.empty() && race.winner < 0) {
+        race.winner = lane;
+        race.responses[lane] = std::move(response);
+
+        shared_ptr<AsyncCall> loser = std::move(race.calls[1 - lane]);
+        if (loser) {
+            CancelAsyncCall(loser);
+        }
     }
+    race.changed.notify_all();
+}
 
-    LOG_DEBUG("Proxy response: " + response.substr(0, 200));
+string TranslationClient::ParseTranslationResponse(string_view jsonResponse) {
+    // Extract translation from proxy server response
+    return SimpleJsonParser::extractField(jsonResponse, "translation");
+}
 
-    // Check for error in response
-    string error = SimpleJsonParser::extractField(response, "error");
-    if (!error.empty()) {
-        LOG_ERROR("Proxy error: " + error);
+// Map a proxy error message onto the codes the addon understands
+TranslationResult TranslationClient::InterpretProxyError(string_view error, PooledString& result) {
+    LOG_ERROR("Proxy error: " + string(error));
 
-        // Check for specific errors
-        if (error.find("Insufficient credits") != string::npos) {
-            result = "INSUFFICIENT_CREDITS";
-            return TranslationResult::API_ERROR;
+    if (error.find("Insufficient credits") != string_view::npos) {
+        creditsRemaining = 0;
+        result = "INSUFFICIENT_CREDITS";
+    } else if (error.find("Invalid API key") != string_view::npos || error.find("Unauthorized") != string_view::npos) {
+        result = "INVALID_API_KEY";
+    } else {
+        result.assign(error.data(), error.size());
+    }
+    return TranslationResult::API_ERROR;
+}
+
+// Returns the session token for the binary protocol, negotiating one with
+// POST /api/session when needed. False means "use JSON for this request":
+// the proxy has no binary protocol, or the handshake could not be made now.
+//   -> { "apiKey": "WT-xxx", "formats": ["msgpack"] }
+//   <- { "sessionToken": "...", "format": "msgpack", "expiresIn": 3600 }
+bool TranslationClient::AcquireSessionToken(string& token) {
+    // A new API key invalidates the session and the negotiated format
+    uint32_t generation = keyGeneration;
+    {
+        lock_guard<mutex> lock(sessionMutex);
+        if (generation != sessionGeneration) {
+            sessionGeneration = generation;
+            sessionToken.clear();
+            wireProtocol = WireProtocol::UNKNOWN;
         }
-        if (error.find("Invalid API key") != string::npos || error.find("Unauthorized") != string::npos) {
-            result = "INVALID_API_KEY";
-            return TranslationResult::API_ERROR;
+
+        if (!binaryProtocolEnabled || wireProtocol == WireProtocol::JSON) {
+            return false;
+        }
+        if (!sessionToken.empty() && static_cast<int32_t>(clock.NowMs() - sessionExpiry) < 0) {
+            token = sessionToken;
+            return true;
         }
+        // The handshake runs unlocked; requests meanwhile go out as JSON
+        // rather than queue behind it
+        if (sessionHandshaking) {
+            return false;
+        }
+        sessionHandshaking = true;
+    }
 
-        result = error;
-        return TranslationResult::API_ERROR;
+    TRACE_SPAN("session_handshake");
+    string key;
+    {
+        lock_guard<mutex> keyLock(keyMutex);
+        key = apiKey;
     }
+    PooledString requestBody;
+    requestBody += "{\"apiKey\":\"";
+    AppendJsonEscaped(requestBody, key);
+    requestBody += "\",\"formats\":[\"msgpack\"]}";
 
-    // Extract translation
-    string translation = ParseTranslationResponse(response);
+    PooledString response = RoutedRequest("/api/session", requestBody);
 
-    if (translation.empty()) {
-        LOG_ERROR("Failed to parse translation from response");
-        return TranslationResult::API_ERROR;
+    lock_guard<mutex> lock(sessionMutex);
+    sessionHandshaking = false;
+    // Negotiated for a key that has since been replaced
+    if (generation != sessionGeneration || generation != keyGeneration) {
+        return false;
     }
-
-    // Update credits from response
-    double credits = SimpleJsonParser::extractNumber(response, "creditsRemaining");
-    if (credits >= 0) {
-        creditsRemaining = credits;
+    if (response.empty()) {
+        return false;   // Network trouble; negotiate again on a later request
     }
 
-    // Cache the result locally
-    cache[cacheKey] = CacheEntry(translation);
+    string newToken = SimpleJsonParser::extractField(response, "sessionToken");
+    if (newToken.empty() || SimpleJsonParser::extractField(response, "format") != "msgpack") {
+        LOG_INFO("Proxy offers no binary protocol, using JSON");
+        wireProtocol = WireProtocol::JSON;
+        return false;
+    }
 
-    result = translation;
-    LOG_DEBUG("Translation successful: " + text.substr(0, 30) + " -> " + translation.substr(0, 50));
-    return TranslationResult::SUCCESS;
+    double expiresIn = SimpleJsonParser::extractNumber(response, "expiresIn");
+    if (expiresIn <= 0 || expiresIn > MAX_SESSION_SECONDS) {
+        expiresIn = MAX_SESSION_SECONDS;
+    }
+    // Renew early (a minute, or half of a short lifetime) so a token never
+    // expires in flight
+    DWORD lifetimeMs = static_cast<DWORD>(expiresIn * 1000);
+    DWORD renewMarginMs = lifetimeMs / 2 < SESSION_RENEW_MARGIN_MS ? lifetimeMs / 2 : SESSION_RENEW_MARGIN_MS;
+    sessionExpiry = clock.NowMs() + lifetimeMs - renewMarginMs;
+    sessionToken = std::move(newToken);
+    wireProtocol = WireProtocol::MSGPACK;
+    LOG_INFO("Negotiated MessagePack protocol (session " + to_string(static_cast<int>(expiresIn)) + " s)");
+
+    token = sessionToken;
+    return true;
 }
 
-// Queue async translation request
-bool TranslationClient::TranslateAsync(const string& requestId, const string& text,
-                                       const string& sourceLang, const string& targetLang) {
-    if (!initialized || !running) {
+// The negotiated session token, if one is valid now. Never negotiates:
+// requests sent ahead of their turn must not wait on a handshake.
+bool TranslationClient::CurrentSessionToken(string& token) {
+    lock_guard<mutex> lock(sessionMutex);
+    if (!binaryProtocolEnabled || wireProtocol != WireProtocol::MSGPACK || sessionGeneration != keyGeneration ||
+        sessionToken.empty() || static_cast<int32_t>(clock.NowMs() - sessionExpiry) >= 0) {
         return false;
     }
+    token = sessionToken;
+    return true;
+}
+
+// Expired or unknown session token; the request is retried with the API key
+bool TranslationClient::IsSessionError(string_view error) {
+    return error.find("SESSION_EXPIRED") != string_view::npos || error.find("INVALID_SESSION") != string_view::npos;
+}
+
+void TranslationClient::InvalidateSessionToken(const string& token) {
+    lock_guard<mutex> lock(sessionMutex);
+    if (sessionToken == token) {
+        LOG_DEBUG("Session token rejected, renegotiating on next request");
+        sessionToken.clear();
+    }
+}
+
+// Binary-protocol request. Returns false when the request should be retried
+// as JSON: the token was rejected or the proxy answered in JSON.
+bool TranslationClient::RequestTranslationBinary(string_view text, LanguagePairId languagePair, const string& token,
+                                                 PooledString& result, TranslationResult& status) {
+    const LanguagePair& langs = GetLanguagePair(languagePair);
+
+    PooledString requestBody;
+    auto encodeStart = chrono::steady_clock::now();
+    EncodeMsgPackRequest(requestBody, token, text, langs.source, langs.target);
+    wireEncodeNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - encodeStart).count());
+
+    LOG_DEBUG("Requesting translation from proxy (msgpack): " + string(text.substr(0, 50)) + " (" +
+              langs.source + " -> " + langs.target + ")");
+
+    PooledString response = HedgedRequest("/api/translate", requestBody, true);
+    wireRequests++;
+    wireBytesSent += requestBody.size();
+    wireBytesReceived += response.size();
+    return ParseBinaryTranslation(response, token, result, status);
+}
+
+// Translation from a MessagePack answer sent with token. False when the
+// request should be retried as JSON, as for RequestTranslationBinary.
+bool TranslationClient::ParseBinaryTranslation(const PooledString& response, const string& token,
+                                               PooledString& result, TranslationResult& status) {
+    if (response.empty()) {
+        LOG_ERROR("Empty response from proxy server");
+        status = TranslationResult::NETWORK_ERROR;
+        return true;
+    }
+
+    // JSON back means either an error the proxy reports before looking at
+    // the body format, or a proxy that ignored the binary request altogether
+    if (response[0] == '{') {
+        string error = SimpleJsonParser::extractField(response, "error");
+        if (IsSessionError(error)) {
+            InvalidateSessionToken(token);
+            return false;
+        }
+        if (!error.empty()) {
+            status = InterpretProxyError(error, result);
+            return true;
+        }
+        LOG_INFO("Proxy answered a binary request in JSON, switching to JSON");
+        wireProtocol = WireProtocol::JSON;
+        return false;
+    }
+
+    TRACE_SPAN("parse");
+    WireResponse wire;
+    auto decodeStart = chrono::steady_clock::now();
+    bool decoded = DecodeMsgPackResponse(response, wire);
+    wireDecodeNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - decodeStart).count());
+
+    if (!decoded) {
+        LOG_ERROR("Malformed MessagePack response from proxy");
+        status = TranslationResult::API_ERROR;
+        return true;
+    }
+
+    if (!wire.error.empty()) {
+        if (IsSessionError(wire.error)) {
+            InvalidateSessionToken(token);
+            return false;
+        }
+        status = InterpretProxyError(wire.error, result);
+        return true;
+    }
+
+    if (wire.translation.empty()) {
+        LOG_ERROR("Failed to parse translation from response");
+        status = TranslationResult::API_ERROR;
+        return true;
+    }
+
+    if (wire.credits >= 0) {
+        creditsRemaining = wire.credits;
+    }
+    result.assign(wire.translation.data(), wire.translation.size());
+    status = TranslationResult::SUCCESS;
+    return true;
+}
+
+// Send one translation request to the proxy server (no caching). A request
+// the worker already sent while it was queued is answered from that.
+TranslationResult TranslationClient::RequestTranslation(string_view text, LanguagePairId languagePair,
+                                                        PooledString& result) {
+    TranslationResult status;
+    shared_ptr<AsyncCall> prefetch = TakePrefetch(text, languagePair);
+    if (prefetch) {
+        TRACE_SPAN("prefetch_wait");
+        PooledString response;
+        shared_ptr<AsyncCall> answered = WaitAsyncCall(prefetch, response);
+        if (answered) {
+            prefetchUsed++;
+            wireRequests++;
+            wireBytesSent += answered->bytesSent;
+            wireBytesReceived += response.size();
+            if (ParseAsyncCall(*answered, response, result, status)) {
+                return status;
+            }
+        } else if (!running || RequestAbandoned(nullptr)) {
+            return TranslationResult::NETWORK_ERROR;
+        }
+        prefetchFallbacks++;
+        LOG_DEBUG("Prefetched request failed, sending again: " + string(text.substr(0, 50)));
+    }
+
+    string token;
+    if (AcquireSessionToken(token) && RequestTranslationBinary(text, languagePair, token, result, status)) {
+        return status;
+    }
+
+    const LanguagePair& langs = GetLanguagePair(languagePair);
+    const string& sourceLang = langs.source;
+    const string& targetLang = langs.target;
+
+    // Build JSON request body for proxy server
+    PooledString requestBody;
+    string key;
+    {
+        lock_guard<mutex> lock(keyMutex);
+        key = apiKey;
+    }
+    auto encodeStart = chrono::steady_clock::now();
+    EncodeJsonRequest(requestBody, key, text, sourceLang, targetLang);
+    wireEncodeNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - encodeStart).count());
+
+    string path = "/api/translate";
+
+    LOG_DEBUG("Requesting translation from proxy: " + string(text.substr(0, 50)) + " (" + sourceLang + " -> " + targetLang + ")");
+
+    // Make HTTP request to proxy server
+    PooledString response = HedgedRequest(path, requestBody, false);
+    wireRequests++;
+    wireBytesSent += requestBody.size();
+    wireBytesReceived += response.size();
+
+    if (response.empty()) {
+        LOG_ERROR("Empty response from proxy server");
+        return TranslationResult::NETWORK_ERROR;
+    }
+
+    LOG_DEBUG("Proxy response: " + string(string_view(response).substr(0, 200)));
+
+    status = ParseJsonTranslation(response, result);
+    if (status == TranslationResult::SUCCESS) {
+        LOG_DEBUG("Translation successful: " + string(text.substr(0, 30)) + " -> " +
+                  string(string_view(result).substr(0, 50)));
+    }
+    return status;
+}
+
+// Error, translation and credits from a JSON /api/translate answer
+TranslationResult TranslationClient::ParseJsonTranslation(string_view response, PooledString& result) {
+    TRACE_SPAN("parse");
+    auto decodeStart = chrono::steady_clock::now();
+
+    // Check for error in response
+    string error = SimpleJsonParser::extractField(response, "error");
+    if (!error.empty()) {
+        return InterpretProxyError(error, result);
+    }
+
+    // Extract translation
+    string translation = ParseTranslationResponse(response);
+
+    if (translation.empty()) {
+        LOG_ERROR("Failed to parse translation from response");
+        return TranslationResult::API_ERROR;
+    }
+
+    // Update credits from response
+    double credits = SimpleJsonParser::extractNumber(response, "creditsRemaining");
+    if (credits >= 0) {
+        creditsRemaining = credits;
+    }
+    wireDecodeNanos += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - decodeStart).count());
+
+    result = translation;
+    return TranslationResult::SUCCESS;
+}
+
+// One proxy call translating text into every target of pairs (same source).
+// results[i] answers pairs[i]. unsupported is set when the proxy has no
+// fan-out endpoint or answered in a shape we cannot align with the targets.
+TranslationResult TranslationClient::RequestFanOut(string_view text, const vector<LanguagePairId>& pairs,
+                                                   vector<PooledString>& results, bool& unsupported) {
+    unsupported = false;
+    const string& sourceLang = GetLanguagePair(pairs.front()).source;
+
+    // Format: { "apiKey": "WT-xxx", "text": "...", "from": "zh", "to": ["ru", "en"] }
+    PooledString requestBody;
+    string key;
+    {
+        lock_guard<mutex> lock(keyMutex);
+        key = apiKey;
+    }
+    requestBody.reserve(key.size() + text.size() + 64 + pairs.size() * 8);
+    requestBody += "{\"apiKey\":\"";
+    AppendJsonEscaped(requestBody, key);
+    requestBody += "\",\"text\":\"";
+    AppendJsonEscaped(requestBody, text);
+    requestBody += "\",\"from\":\"";
+    requestBody += sourceLang;
+    requestBody += "\",\"to\":[";
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        requestBody += i > 0 ? ",\"" : "\"";
+        requestBody += GetLanguagePair(pairs[i]).target;
+        requestBody += "\"";
+    }
+    requestBody += "]}";
+
+    LOG_DEBUG("Requesting fan-out translation from proxy: " + string(text.substr(0, 50)) + " (" + sourceLang +
+              " -> " + to_string(pairs.size()) + " targets)");
+
+    PooledString response = RoutedRequest("/api/translate/multi", requestBody);
+    if (response.empty()) {
+        LOG_ERROR("Empty response from proxy server");
+        return TranslationResult::NETWORK_ERROR;
+    }
+
+    TRACE_SPAN("parse");
+
+    string error = SimpleJsonParser::extractField(response, "error");
+    if (error.find("Insufficient credits") != string::npos) {
+        creditsRemaining = 0;
+        results.assign(1, PooledString("INSUFFICIENT_CREDITS"));
+        return TranslationResult::API_ERROR;
+    }
+    if (error.find("Invalid API key") != string::npos || error.find("Unauthorized") != string::npos) {
+        results.assign(1, PooledString("INVALID_API_KEY"));
+        return TranslationResult::API_ERROR;
+    }
+
+    // Anything else without an aligned array (404 page, "Cannot POST", an
+    // older proxy) means the per-target path has to be used instead
+    vector<string> translations;
+    if (!SimpleJsonParser::extractStringArray(response, "translations", translations) ||
+        translations.size() != pairs.size()) {
+        LOG_DEBUG("Fan-out response unusable: " + string(string_view(response).substr(0, 200)));
+        unsupported = true;
+        return TranslationResult::API_ERROR;
+    }
+
+    double credits = SimpleJsonParser::extractNumber(response, "creditsRemaining");
+    if (credits >= 0) {
+        creditsRemaining = credits;
+    }
+
+    results.clear();
+    for (const string& translation : translations) {
+        results.emplace_back(translation.data(), translation.size());
+    }
+    return TranslationResult::SUCCESS;
+}
+
+// Translate text into several targets, one cache key per target. Targets
+// already cached are answered locally; the rest share one proxy round trip,
+// or go out one by one (full TranslateText path) if fan-out is unavailable.
+void TranslationClient::TranslateFanOut(string_view text, const vector<LanguagePairId>& pairs,
+                                        vector<PooledString>& translations, vector<PooledString>& errors,
+                                        vector<TranslationInfo>& infos) {
+    string cacheKeyText = NormalizeForCache(text);
+    DWORD now = clock.NowMs();
+
+    vector<size_t> missing;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        string_view phrase;
+        if (pairs[i] == phrasebookPair && phrasebook.Lookup(cacheKeyText, phrase)) {
+            translations[i].assign(phrase.data(), phrase.size());
+        } else if (!cache.Lookup(cacheKeyText, pairs[i], now, translations[i])) {
+            missing.push_back(i);
+        }
+    }
+
+    bool sameSource = true;
+    for (size_t index : missing) {
+        sameSource = sameSource && GetLanguagePair(pairs[index]).source == GetLanguagePair(pairs[missing[0]]).source;
+    }
+
+    if (missing.size() >= 2 && sameSource && fanOutSupported) {
+        TRACE_SPAN("fan_out");
+        vector<LanguagePairId> missingPairs;
+        for (size_t index : missing) {
+            missingPairs.push_back(pairs[index]);
+        }
+
+        vector<PooledString> results;
+        bool unsupported = false;
+        TranslationResult tr = RequestFanOut(text, missingPairs, results, unsupported);
+
+        if (tr == TranslationResult::SUCCESS) {
+            fanOutRequests++;
+            fanOutTargets += missing.size();
+            for (size_t k = 0; k < missing.size(); ++k) {
+                translations[missing[k]] = std::move(results[k]);
+                cache.Insert(cacheKeyText, pairs[missing[k]], translations[missing[k]], now);
+            }
+            return;
+        }
+
+        if (!unsupported) {
+            // The proxy is unreachable or refused us: answer every target
+            // now (offline gloss if enabled) rather than failing N more times
+            PooledString failure = results.empty() ? PooledString() : std::move(results.front());
+            for (size_t index : missing) {
+                translations[index] = failure;
+                TranslationResult status = FallBackOffline(text, pairs[index], tr, translations[index], infos[index]);
+                if (status != TranslationResult::SUCCESS) {
+                    DescribeFailure(status, translations[index], errors[index]);
+                }
+            }
+            return;
+        }
+
+        fanOutSupported = false;
+        LOG_INFO("Proxy has no fan-out endpoint; translating targets separately");
+    }
+
+    for (size_t index : missing) {
+        TranslationResult tr = TranslateText(text, translations[index], pairs[index], &infos[index]);
+        if (tr != TranslationResult::SUCCESS) {
+            DescribeFailure(tr, translations[index], errors[index]);
+        }
+    }
+}
+
+// Holds this process's claim on a line in the shared cache until the
+// translation is published or TranslateText returns without one. cache is
+// set only once TryClaim handed the line to us, so a client that waited on
+// someone else's claim never publishes over or releases it.
+struct SharedCacheClaim {
+    SharedTranslationCache* cache;
+    uint64_t claim;
+    string_view text;
+    const LanguagePair& langs;
+
+    SharedCacheClaim(string_view text, const LanguagePair& langs)
+        : cache(nullptr), claim(0), text(text), langs(langs) {}
+    ~SharedCacheClaim() {
+        if (cache) {
+            cache->ReleaseClaim(text, langs.source, langs.target, claim);
+        }
+    }
+
+    void Publish(string_view translation) {
+        if (cache) {
+            cache->Publish(text, langs.source, langs.target, translation, claim);
+            cache = nullptr;
+        }
+    }
+};
+
+// Synchronous translation via proxy server
+TranslationResult TranslationClient::TranslateText(string_view text, PooledString& result,
+                                                   LanguagePairId languagePair, TranslationInfo* info) {
+    if (!initialized) {
+        LOG_ERROR("Translation client not initialized");
+        return TranslationResult::INVALID_PARAMS;
+    }
+
+    if (text.empty()) {
+        LOG_ERROR("Invalid translation parameters: empty text");
+        return TranslationResult::INVALID_PARAMS;
+    }
+
+    TranslationInfo localInfo;
+    if (!info) {
+        info = &localInfo;
+    }
+    if (AnswerPreflight(text, *info) || !ResolveAutoSource(text, languagePair, *info)) {
+        result.assign(text.data(), text.size());
+        return TranslationResult::SUCCESS;
+    }
+
+    // Cache keys use normalized text so width, spacing and case variants share an entry
+    string cacheKeyText = NormalizeForCache(text);
+
+    // Common phrases come straight from the mapped phrasebook
+    if (languagePair == phrasebookPair) {
+        string_view phrase;
+        if (phrasebook.Lookup(cacheKeyText, phrase)) {
+            result.assign(phrase.data(), phrase.size());
+            LOG_DEBUG("Phrasebook hit for: " + string(text.substr(0, 50)));
+            return TranslationResult::SUCCESS;
+        }
+    }
+
+    // Check local cache first (DLL-side cache)
+    {
+        TRACE_SPAN("cache_lookup");
+        if (cache.Lookup(cacheKeyText, languagePair, clock.NowMs(), result)) {
+            LOG_DEBUG("Local cache hit for: " + string(text.substr(0, 50)));
+            return TranslationResult::SUCCESS;
+        }
+    }
+
+    {
+        PooledString rejection;
+        if (RecallNegative(cacheKeyText, text, languagePair, result, rejection, *info)) {
+            if (rejection.empty()) {
+                return TranslationResult::SUCCESS;
+            }
+            result = std::move(rejection);
+            return TranslationResult::API_ERROR;
+        }
+    }
+
+    cache.CleanExpired(clock.NowMs());
+
+    // Short messages the dictionary fully covers, and everything once credits
+    // are known to be gone, are glossed locally instead of costing a request.
+    // Approximate results are not cached so a later real translation wins.
+    OfflineMode offline = offlineMode;
+    if (offline != OfflineMode::OFF) {
+        bool creditsGone = creditsRemaining == 0;
+        bool firstPass = offline == OfflineMode::FIRST_PASS &&
+                         CountCodepoints(text) <= static_cast<size_t>(offlineFirstPassChars.load());
+        if ((firstPass || creditsGone) && TranslateOffline(text, languagePair, !creditsGone, result, *info)) {
+            LOG_DEBUG("Offline gloss for: " + string(text.substr(0, 50)));
+            return TranslationResult::SUCCESS;
+        }
+    }
+
+    // Another client on this machine may already have the line, or be
+    // fetching it now; only the claim holder asks the proxy, the rest wait.
+    // Only background threads wait: a sync translate runs on the game
+    // thread and fetches for itself rather than stall the frame.
+    SharedCacheClaim sharedClaim(cacheKeyText, GetLanguagePair(languagePair));
+    if (sharedCacheEnabled) {
+        TRACE_SPAN("shared_cache");
+        const LanguagePair& langs = sharedClaim.langs;
+        bool found = sharedCache.Lookup(cacheKeyText, langs.source, langs.target, result);
+        if (!found) {
+            if (sharedCache.TryClaim(cacheKeyText, langs.source, langs.target, sharedClaim.claim)) {
+                sharedClaim.cache = &sharedCache;
+            } else if (t_cancellableRequests) {
+                found = sharedCache.WaitFor(cacheKeyText, langs.source, langs.target, SHARED_CACHE_WAIT_MS, result);
+            }
+        }
+        if (found) {
+            cache.Insert(cacheKeyText, languagePair, result, clock.NowMs());
+            LOG_DEBUG("Shared cache hit for: " + string(text.substr(0, 50)));
+            return TranslationResult::SUCCESS;
+        }
+    }
+
+    // Templating: numbers and player names become slots around a shared cached template
+    TextTemplate textTemplate;
+    string templateKeyText;
+    bool templated = false;
+    if (templatingEnabled) {
+        shared_ptr<const vector<string>> names;
+        {
+            lock_guard<mutex> lock(templateMutex);
+            names = templateNames;
+        }
+        static const vector<string> noNames;
+        templated = ExtractTemplate(text, names ? *names : noNames, textTemplate);
+    }
+
+    if (templated) {
+        templateKeyText = NormalizeForCache(textTemplate.text);
+
+        PooledString templateTranslation;
+        string filled;
+        if (cache.Lookup(templateKeyText, languagePair, clock.NowMs(), templateTranslation) &&
+            FillTemplate(templateTranslation, textTemplate.slots, filled)) {
+            templateHits++;
+            result.assign(filled.data(), filled.size());
+            cache.Insert(cacheKeyText, languagePair, result, clock.NowMs());
+            sharedClaim.Publish(result);
+            LOG_DEBUG("Template cache hit for: " + string(text.substr(0, 50)));
+            return TranslationResult::SUCCESS;
+        }
+
+        TranslationResult tr = RequestTranslation(textTemplate.text, languagePair, result);
+        if (tr != TranslationResult::SUCCESS) {
+            RememberRejection(cacheKeyText, languagePair, tr, result);
+            return FallBackOffline(text, languagePair, tr, result, *info);
+        }
+
+        if (FillTemplate(result, textTemplate.slots, filled)) {
+            TRACE_SPAN("cache_insert");
+            cache.Insert(templateKeyText, languagePair, result, clock.NowMs());
+            result.assign(filled.data(), filled.size());
+            cache.Insert(cacheKeyText, languagePair, result, clock.NowMs());
+            sharedClaim.Publish(result);
+            return TranslationResult::SUCCESS;
+        }
+
+        // The proxy dropped or mangled a slot marker; fall back to the literal text
+        LOG_DEBUG("Template slots lost in translation, retrying without template");
+    }
+
+    // Spam variants (an emoji, a price or a server name changed) reuse the
+    // closest earlier translation instead of costing another request
+    if (nearDuplicateEnabled) {
+        TRACE_SPAN("near_duplicate");
+        int distance = 0;
+        if (nearDuplicates.FindNearest(cacheKeyText, languagePair, nearDuplicateThreshold, result, distance)) {
+            LOG_DEBUG("Near-duplicate hit (distance " + to_string(distance) + ") for: " + string(text.substr(0, 50)));
+            info->flags |= TRANSLATION_FLAG_NEAR_DUPLICATE;
+            return TranslationResult::SUCCESS;
+        }
+    }
+
+    TranslationResult tr;
+    if (!TranslateStreaming(text, languagePair, result, tr) &&
+        !(chunkingEnabled && TranslateInChunks(text, languagePair, result, tr)) &&
+        !(segmentMemoryEnabled && TranslateBySegments(text, languagePair, result, tr))) {
+        tr = RequestTranslation(text, languagePair, result);
+    }
+    if (tr != TranslationResult::SUCCESS) {
+        RememberRejection(cacheKeyText, languagePair, tr, result);
+        return FallBackOffline(text, languagePair, tr, result, *info);
+    }
+
+    // Handed back unchanged: remembered briefly rather than cached like a
+    // translation, so it neither takes a cache slot nor feeds near-duplicates
+    if (NormalizeForCache(result) == cacheKeyText) {
+        negativeCache.Insert(cacheKeyText, languagePair, NegativeResult::UNCHANGED, string_view(), clock.NowMs());
+        return TranslationResult::SUCCESS;
+    }
+
+    // Cache the result locally
+    {
+        TRACE_SPAN("cache_insert");
+        cache.Insert(cacheKeyText, languagePair, result, clock.NowMs());
+        if (nearDuplicateEnabled) {
+            nearDuplicates.Insert(cacheKeyText, languagePair, result);
+        }
+        sharedClaim.Publish(result);
+    }
+    return TranslationResult::SUCCESS;
+}
+
+bool TranslationClient::TranslateLocal(string_view text, PooledString& result, LanguagePairId languagePair) {
+    if (!initialized || text.empty() || GetLanguagePair(languagePair).source == AUTO_LANGUAGE) {
+        return false;
+    }
+
+    string cacheKeyText = NormalizeForCache(text);
+    if (languagePair == phrasebookPair) {
+        string_view phrase;
+        if (phrasebook.Lookup(cacheKeyText, phrase)) {
+            result.assign(phrase.data(), phrase.size());
+            return true;
+        }
+    }
+    return cache.Lookup(cacheKeyText, languagePair, clock.NowMs(), result);
+}
+
+// Numbers, links, raid markers and the like: answered with the text as-is
+bool TranslationClient::AnswerPreflight(string_view text, TranslationInfo& info) {
+    if (!preflightEnabled) {
+        return false;
+    }
+
+    PreflightClass kind = ClassifyMessage(text);
+    if (kind == PreflightClass::TRANSLATE) {
+        return false;
+    }
+    preflightSkipped[static_cast<int>(kind)]++;
+    info.flags |= TRANSLATION_FLAG_UNCHANGED;
+    return true;
+}
+
+// A line the proxy recently returned unchanged (translation is set to the
+// text) or rejected (error is set to its error) is answered the same way
+bool TranslationClient::RecallNegative(string_view cacheKeyText, string_view text, LanguagePairId languagePair,
+                                       PooledString& translation, PooledString& error, TranslationInfo& info) {
+    if (negativeCache.Empty()) {
+        return false;
+    }
+
+    NegativeResult kind;
+    if (!negativeCache.Lookup(cacheKeyText, languagePair, clock.NowMs(), kind, error)) {
+        return false;
+    }
+    if (kind == NegativeResult::UNCHANGED) {
+        translation.assign(text.data(), text.size());
+        info.flags |= TRANSLATION_FLAG_UNCHANGED;
+        LOG_DEBUG("Negative cache: unchanged " + string(text.substr(0, 50)));
+    } else {
+        LOG_DEBUG("Negative cache: rejected " + string(text.substr(0, 50)));
+    }
+    return true;
+}
+
+// Proxy errors about the text itself come back the same on a retry. Credit,
+// key, session, rate-limit and availability errors do not, and neither do
+// network failures, so those are never remembered.
+void TranslationClient::RememberRejection(string_view cacheKeyText, LanguagePairId languagePair, TranslationResult tr,
+                                          string_view error) {
+    if (tr != TranslationResult::API_ERROR || error.empty() || error == "INSUFFICIENT_CREDITS" ||
+        error == "INVALID_API_KEY" || IsSessionError(error)) {
+        return;
+    }
+
+    static const char* const transient[] = {
+        "rate", "limit", "quota", "again", "unavailable", "busy", "overload", "timeout", "timed out",
+        "internal", "credit", "key", "upstream",
+    };
+    string lower(error);
+    for (char& c : lower) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    for (const char* marker : transient) {
+        if (lower.find(marker) != string::npos) {
+            return;
+        }
+    }
+    negativeCache.Insert(cacheKeyText, languagePair, NegativeResult::REJECTED, error, clock.NowMs());
+}
+
+// Replace an "auto" source with the identified language. Returns false when
+// the text should be returned untranslated: it is already in the target
+// language, or its language could not be identified with confidence.
+bool TranslationClient::ResolveAutoSource(string_view text, LanguagePairId& languagePair, TranslationInfo& info) {
+    const LanguagePair& langs = GetLanguagePair(languagePair);
+    if (langs.source != AUTO_LANGUAGE) {
+        return true;
+    }
+
+    TRACE_SPAN("language_id");
+    LanguageGuess guess = IdentifyLanguage(text);
+    info.detectedLanguage = guess.language;
+    info.confidence = guess.confidence;
+
+    if (guess.language.empty() || guess.confidence < MIN_AUTO_CONFIDENCE) {
+        info.flags |= TRANSLATION_FLAG_UNDETERMINED;
+        return false;
+    }
+
+    // "zh" matches a "zh-TW" target and vice versa: same language, different script
+    string_view target = langs.target;
+    if (target.substr(0, target.find('-')) == guess.language) {
+        info.flags |= TRANSLATION_FLAG_SAME_LANGUAGE;
+        return false;
+    }
+
+    LanguagePairId resolved = InternLanguagePair(guess.language, target);
+    if (resolved == INVALID_LANGUAGE_PAIR) {
+        info.flags |= TRANSLATION_FLAG_UNDETERMINED;
+        return false;
+    }
+    languagePair = resolved;
+    return true;
+}
+
+// Segment-level translation memory. Returns false when the message has fewer
+// than two translatable segments and should simply be translated whole;
+// otherwise status holds the outcome and result the reassembled translation.
+bool TranslationClient::TranslateBySegments(string_view text, LanguagePairId languagePair,
+                                            PooledString& result, TranslationResult& status) {
+    const LanguagePair& langs = GetLanguagePair(languagePair);
+    bool cjkTarget = IsCjkLanguage(langs.target);
+
+    vector<TextSegment> segments = TranslationMemory::Split(text, IsCjkLanguage(langs.source));
+    size_t translatable = 0;
+    for (const TextSegment& segment : segments) {
+        if (!segment.literal && !segment.text.empty()) {
+            ++translatable;
+        }
+    }
+    if (translatable < 2) {
+        return false;
+    }
+
+    TRACE_SPAN("segment_memory");
+
+    DWORD now = clock.NowMs();
+    segmentMemory.CleanExpired(now);
+
+    vector<PooledString> translations(segments.size());
+    vector<size_t> missing;
+    size_t localChars = 0;
+    size_t totalChars = 0;
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const TextSegment& segment = segments[i];
+        size_t chars = TranslationMemory::CountChars(segment.text);
+        totalChars += chars;
+
+        if (segment.literal || segment.text.empty()) {
+            translations[i].assign(segment.text.data(), segment.text.size());
+            localChars += chars;
+        } else if (segmentMemory.Lookup(segment.text, languagePair, now, translations[i])) {
+            localChars += chars;
+        } else {
+            missing.push_back(i);
+        }
+    }
+
+    if (!missing.empty()) {
+        // Unseen segments go out as one newline-separated request
+        PooledString batch;
+        for (size_t k = 0; k < missing.size(); ++k) {
+            if (k > 0) {
+                batch += '\n';
+            }
+            batch += segments[missing[k]].text;
+        }
+
+        PooledString batchResult;
+        status = RequestTranslation(batch, languagePair, batchResult);
+        if (status != TranslationResult::SUCCESS) {
+            result = std::move(batchResult);
+            return true;
+        }
+
+        vector<string_view> lines;
+        string_view remaining = batchResult;
+        size_t newline;
+        while ((newline = remaining.find('\n')) != string_view::npos) {
+            lines.push_back(remaining.substr(0, newline));
+            remaining.remove_prefix(newline + 1);
+        }
+        lines.push_back(remaining);
+
+        if (lines.size() == missing.size()) {
+            for (size_t k = 0; k < missing.size(); ++k) {
+                string trimmed = TrimString(string(lines[k]));
+                translations[missing[k]].assign(trimmed.data(), trimmed.size());
+            }
+        } else {
+            // The proxy merged or split lines, so alignment is lost; translate
+            // the missing segments individually (same characters billed)
+            LOG_DEBUG("Segment batch misaligned (" + to_string(lines.size()) + " lines for " +
+                      to_string(missing.size()) + " segments), translating individually");
+            for (size_t index : missing) {
+                status = RequestTranslation(segments[index].text, languagePair, translations[index]);
+                if (status != TranslationResult::SUCCESS) {
+                    result = std::move(translations[index]);
+                    return true;
+                }
+            }
+        }
+
+        for (size_t index : missing) {
+            segmentMemory.Insert(segments[index].text, languagePair, translations[index], now);
+        }
+    }
+
+    string assembled;
+    assembled.reserve(text.size() * 2);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        assembled += TrimString(string(translations[i].data(), translations[i].size()));
+        TranslationMemory::AppendDelimiter(assembled, segments[i].delimiter, cjkTarget, i + 1 == segments.size());
+    }
+
+    segmentMemory.RecordMessage(localChars, totalChars);
+    LOG_DEBUG("Segment memory served " + to_string(localChars) + "/" + to_string(totalChars) + " chars locally");
+
+    result.assign(assembled.data(), assembled.size());
+    status = TranslationResult::SUCCESS;
+    return true;
+}
+
+// Translate a long message as sentence-boundary chunks requested in parallel
+// and reassembled in order. Returns false when the text is short enough to
+// go out whole. Chunks are cached individually, so a failed message that is
+// retried only pays for the chunks that did not come back.
+bool TranslationClient::TranslateInChunks(string_view text, LanguagePairId languagePair,
+                                          PooledString& result, TranslationResult& status) {
+    if (text.size() < CHUNK_MIN_BYTES) {
+        return false;
+    }
+
+    vector<string_view> chunks = SplitLongMessage(text, CHUNK_MAX_BYTES);
+    if (chunks.size() < 2) {
+        return false;
+    }
+
+    TRACE_SPAN("chunked");
+    chunkedMessages++;
+
+    DWORD now = clock.NowMs();
+    vector<string> keys(chunks.size());
+    vector<PooledString> translations(chunks.size());
+    vector<TranslationResult> results(chunks.size(), TranslationResult::SUCCESS);
+    vector<size_t> missing;
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        keys[i] = NormalizeForCache(chunks[i]);
+        if (cache.Lookup(keys[i], languagePair, now, translations[i])) {
+            chunkCacheHits++;
+        } else {
+            missing.push_back(i);
+        }
+    }
+
+    if (!missing.empty()) {
+        chunkRequests += missing.size();
+
+        // All chunks at once on the async engine; without it this thread
+        // and up to MAX_PARALLEL_CHUNKS - 1 helpers take chunks in order
+        if (!RequestChunksAsync(chunks, missing, languagePair, translations, results)) {
+            atomic<size_t> next(0);
+            auto work = [&]() {
+                size_t k;
+                while ((k = next++) < missing.size()) {
+                    size_t index = missing[k];
+                    results[index] = RequestTranslation(chunks[index], languagePair, translations[index]);
+                }
+            };
+
+            bool cancellable = t_cancellableRequests;
+            const string& traceId = TraceRequestScope::Current();
+            vector<thread> helpers;
+            size_t helperCount = min(missing.size(), MAX_PARALLEL_CHUNKS) - 1;
+            for (size_t h = 0; h < helperCount; ++h) {
+                try {
+                    helpers.emplace_back([&, cancellable]() {
+                        t_cancellableRequests = cancellable;
+                        TraceRequestScope traceScope(traceId);
+                        work();
+                    });
+                } catch (const system_error&) {
+                    break;   // Out of threads: the remaining chunks run here
+                }
+            }
+            work();
+            for (thread& helper : helpers) {
+                helper.join();
+            }
+        }
+
+        for (size_t index : missing) {
+            if (results[index] == TranslationResult::SUCCESS) {
+                cache.Insert(keys[index], languagePair, translations[index], now);
+            }
+        }
+        for (size_t index : missing) {
+            if (results[index] != TranslationResult::SUCCESS) {
+                LOG_DEBUG("Chunk " + to_string(index + 1) + "/" + to_string(chunks.size()) + " failed");
+                status = results[index];
+                result = std::move(translations[index]);
+                return true;
+            }
+        }
+    }
+
+    bool cjkTarget = IsCjkLanguage(GetLanguagePair(languagePair).target);
+    string assembled;
+    assembled.reserve(text.size() * 2);
+    for (const PooledString& translation : translations) {
+        JoinChunkTranslations(assembled, translation, cjkTarget);
+    }
+
+    LOG_DEBUG("Chunked translation: " + to_string(chunks.size()) + " chunks, " +
+              to_string(missing.size()) + " requested");
+    result.assign(assembled.data(), assembled.size());
+    status = TranslationResult::SUCCESS;
+    return true;
+}
+
+// Translate a long message over POST /api/translate/stream, handing each
+// batch of finished sentences to the addon as a partial result while the
+// rest is still being translated. Only worker requests stream; they are
+// the ones with a requestId to tag partials with. Returns false when the
+// message should take the buffered path instead: too short, streaming
+// off, or the proxy has no stream endpoint or broke off mid-stream.
+//   -> { "apiKey": "WT-xxx", "text": "...", "from": "zh", "to": "en" }
+//   <- {"seq":0,"translation":"..."}\n ... {"done":true,"creditsRemaining":N}\n
+bool TranslationClient::TranslateStreaming(string_view text, LanguagePairId languagePair,
+                                           PooledString& result, TranslationResult& status) {
+    if (!streamingEnabled || !streamSupported || !t_cancellableRequests || text.size() < STREAM_MIN_BYTES) {
+        return false;
+    }
+
+    TRACE_SPAN("stream");
+    const LanguagePair& langs = GetLanguagePair(languagePair);
+    PooledString requestBody;
+    string key;
+    {
+        lock_guard<mutex> lock(keyMutex);
+        key = apiKey;
+    }
+    EncodeJsonRequest(requestBody, key, text, langs.source, langs.target);
+
+    auto start = chrono::steady_clock::now();
+    uint64_t firstSentenceMicros = 0;
+    uint32_t sequence = 0;
+    TranslationStreamReader reader;
+    function<void(string_view)> onData = [&](string_view bytes) {
+        if (reader.Feed(bytes) == 0) {
+            return;
+        }
+        if (firstSentenceMicros == 0) {
+            firstSentenceMicros = static_cast<uint64_t>(
+                chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+        }
+        // The final result follows at once when the stream ended in this read
+        if (!reader.Done() && reader.Error().empty() && !reader.Malformed()) {
+            PushPartial(reader.Translation(), ++sequence);
+        }
+    };
+
+    // Not hedged: a second stream would repeat sentences the addon already shows
+    PooledString response = RoutedRequest("/api/translate/stream", requestBody, false, nullptr, 0, &onData);
+    reader.Finish();
+    wireRequests++;
+    wireBytesSent += requestBody.size();
+    wireBytesReceived += response.size();
+
+    if (response.empty()) {
+        if (RequestAbandoned(nullptr)) {
+            status = TranslationResult::NETWORK_ERROR;
+            return true;
+        }
+        return false;   // Unreachable; the buffered path retries and reports it
+    }
+    if (!reader.Error().empty()) {
+        status = InterpretProxyError(reader.Error(), result);
+        return true;
+    }
+    if (!reader.Done()) {
+        if (reader.Sentences() == 0) {
+            streamSupported = false;
+            LOG_INFO("Proxy has no streaming endpoint; long messages go out buffered");
+        } else {
+            LOG_WARNING("Translation stream broke off after " + to_string(reader.Sentences()) + " sentences");
+        }
+        return false;
+    }
+
+    if (reader.Credits() >= 0) {
+        creditsRemaining = reader.Credits();
+    }
+    streamedMessages++;
+    streamPartials += sequence;
+    streamFirstSentenceMicros += firstSentenceMicros;
+    streamFullMicros += static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+    LOG_DEBUG("Streamed translation: " + to_string(reader.Sentences()) + " sentences, " +
+              to_string(sequence) + " partials");
+
+    result.assign(reader.Translation().data(), reader.Translation().size());
+    status = TranslationResult::SUCCESS;
+    return true;
+}
+
+// Queue the sentences translated so far for everyone waiting on the
+// in-flight request; nothing is sent once it was abandoned, nor for
+// fan-out targets, whose ids the addon only learns from the final results
+void TranslationClient::PushPartial(string_view translation, uint32_t sequence) {
+    vector<string> recipients;
+    {
+        lock_guard<mutex> lock(requestMutex);
+        if (!requests.inFlight.active || requests.inFlight.abandoned || !requests.inFlight.fanOut.empty()) {
+            return;
+        }
+        if (!requests.inFlight.leaderCancelled) {
+            recipients.push_back(requests.inFlight.requestId);
+        }
+        recipients.insert(recipients.end(), requests.inFlight.followers.begin(), requests.inFlight.followers.end());
+    }
+
+    TranslationInfo info;
+    info.flags = TRANSLATION_FLAG_PARTIAL;
+    info.partialSequence = sequence;
+    for (const string& recipient : recipients) {
+        PushResult(AsyncResult(recipient, PooledString(translation.data(), translation.size()), PooledString(), info));
+    }
+}
+
+// Send call on the endpoint the router prefers. Probes of a recovering
+// endpoint are left to the blocking path with its short probe timeout, and
+// so is failover: a call that fails is sent again that way.
+void TranslationClient::StartAsyncCall(const shared_ptr<AsyncCall>& call) {
+    uint64_t id = 0;
+    EndpointChoice choice = router.Select(clock.Now(), 0);
+    if (choice.endpoint != EndpointRouter::NO_ENDPOINT && choice.probe) {
+        router.ReleaseProbe(choice.endpoint);
+    } else if (choice.endpoint != EndpointRouter::NO_ENDPOINT) {
+        bool cancelled;
+        {
+            lock_guard<mutex> lock(dispatchMutex);
+            cancelled = call->cancelled;
+        }
+        if (!cancelled) {
+            // MessagePack once a session is negotiated; the handshake itself
+            // is left to the blocking path
+            const LanguagePair& langs = GetLanguagePair(call->languagePair);
+            PooledString requestBody;
+            bool binary = CurrentSessionToken(call->token);
+            if (binary) {
+                EncodeMsgPackRequest(requestBody, call->token, call->text, langs.source, langs.target);
+            } else {
+                string key;
+                {
+                    lock_guard<mutex> lock(keyMutex);
+                    key = apiKey;
+                }
+                EncodeJsonRequest(requestBody, key, call->text, langs.source, langs.target);
+            }
+            call->bytesSent = requestBody.size();
+
+            size_t endpoint = choice.endpoint;
+            uint64_t startMs = clock.Now();
+            call->sentMs = startMs;
+            id = asyncHttp.Submit(endpoint, "/api/translate", requestBody, binary, 0,
+                                  [this, call, endpoint, startMs](PooledString response, uint32_t) {
+                bool ok = !response.empty();
+                bool record;
+                {
+                    lock_guard<mutex> lock(dispatchMutex);
+                    record = !call->cancelled;
+                    call->done = true;
+                    call->httpId = 0;
+                    call->response = std::move(response);
+                }
+                if (record) {
+                    uint64_t nowMs = clock.Now();
+                    router.Record(endpoint, nowMs, static_cast<uint32_t>(nowMs - startMs), ok);
+                }
+                dispatchChanged.notify_all();
+            });
+        }
+    }
+
+    // The completion may already have run on a WinHTTP thread
+    bool cancel = false;
+    {
+        lock_guard<mutex> lock(dispatchMutex);
+        if (id == 0) {
+            call->done = true;
+        } else if (!call->done) {
+            call->httpId = id;
+            cancel = call->cancelled;
+        }
+    }
+    if (id == 0) {
+        dispatchChanged.notify_all();
+    } else if (cancel) {
+        asyncHttp.Cancel(id);
+    }
+}
+
+// Safe with requestMutex held; the completion runs with an empty response
+void TranslationClient::CancelAsyncCall(const shared_ptr<AsyncCall>& call) {
+    uint64_t id;
+    {
+        lock_guard<mutex> lock(dispatchMutex);
+        if (call->done || call->cancelled) {
+            return;
+        }
+        call->cancelled = true;
+        id = call->httpId;
+    }
+    // Not submitted yet: StartAsyncCall sees the flag
+    if (id != 0) {
+        asyncHttp.Cancel(id);
+    }
+}
+
+// Block until call is answered, sending requests queued meanwhile so they
+// are in flight too. Hedged like HedgedRequest: once call has run past the
+// hedge threshold a duplicate goes out on the engine, the first answer wins
+// and the other is cancelled. Returns the call that answered, or nullptr on
+// failure, cancel or shutdown.
+shared_ptr<AsyncCall> TranslationClient::WaitAsyncCall(const shared_ptr<AsyncCall>& call, PooledString& response) {
+    uint32_t thresholdMs = hedgePolicy.BeginRequest();
+    shared_ptr<AsyncCall> hedge;
+    shared_ptr<AsyncCall> winner;
+    {
+        unique_lock<mutex> lock(dispatchMutex);
+        uint64_t seen = dispatchEnqueues;
+        while (running) {
+            // A failed lane drops out; the race is lost once both have
+            if (call->done && !call->response.empty()) {
+                winner = call;
+                break;
+            }
+            if (hedge && hedge->done && !hedge->response.empty()) {
+                winner = hedge;
+                break;
+            }
+            if (call->done && (!hedge || hedge->done)) {
+                break;
+            }
+
+            auto changed = [&]() {
+                return call->done || (hedge && hedge->done) || !running || dispatchEnqueues != seen;
+            };
+            uint64_t nowMs = clock.Now();
+            bool hedgeDue = !hedge && thresholdMs > 0 && !call->done;
+            if (hedgeDue && nowMs < call->sentMs + thresholdMs) {
+                clock.WaitFor(lock, dispatchChanged, static_cast<uint32_t>(call->sentMs + thresholdMs - nowMs), changed);
+            } else if (!hedgeDue) {
+                dispatchChanged.wait(lock, changed);
+            } else {
+                thresholdMs = 0;
+                lock.unlock();
+                if (hedgePolicy.TryHedge()) {
+                    TRACE_SPAN("hedge");
+                    hedge = make_shared<AsyncCall>(call->text, call->languagePair);
+                    // Registered so a cancel reaches the duplicate too
+                    bool abandoned = false;
+                    if (t_cancellableRequests) {
+                        lock_guard<mutex> requestLock(requestMutex);
+                        abandoned = requests.inFlight.abandoned;
+                        if (!abandoned) {
+                            requests.inFlight.asyncCalls.push_back(hedge);
+                        }
+                    }
+                    if (!abandoned) {
+                        StartAsyncCall(hedge);
+                    }
+                    lock.lock();
+                    if (abandoned) {
+                        hedge->done = true;
+                    }
+                } else {
+                    lock.lock();
+                }
+                continue;
+            }
+
+            if (running && dispatchEnqueues != seen) {
+                seen = dispatchEnqueues;
+                lock.unlock();
+                PrefetchQueued();
+                lock.lock();
+            }
+        }
+        if (winner) {
+            response = std::move(winner->response);
+        }
+    }
+
+    if (hedge) {
+        CancelAsyncCall(winner == hedge ? call : hedge);
+        if (t_cancellableRequests) {
+            lock_guard<mutex> lock(requestMutex);
+            auto registered = find(requests.inFlight.asyncCalls.begin(), requests.inFlight.asyncCalls.end(), hedge);
+            if (registered != requests.inFlight.asyncCalls.end()) {
+                requests.inFlight.asyncCalls.erase(registered);
+            }
+        }
+    }
+    if (winner) {
+        hedgePolicy.RecordLatency(static_cast<uint32_t>(clock.Now() - call->sentMs));
+        if (winner == hedge) {
+            hedgePolicy.RecordHedgeWin();
+        }
+    }
+    return winner;
+}
+
+// Translation from an answered engine call. False when it must be sent
+// again the usual way: its session token was rejected, or the proxy
+// answered the MessagePack request in JSON.
+bool TranslationClient::ParseAsyncCall(const AsyncCall& call, const PooledString& response, PooledString& result,
+                                       TranslationResult& status) {
+    if (call.token.empty()) {
+        status = ParseJsonTranslation(response, result);
+        return true;
+    }
+    return ParseBinaryTranslation(response, call.token, result, status);
+}
+
+// Only requests bound for a plain RequestTranslation are sent ahead: long
+// messages are chunked or streamed, and the local tiers are checked here
+// so a prefetch is not wasted on a line they will answer
+bool TranslationClient::PrefetchEligible(const AsyncRequest& request) {
+    if (!request.fanOut.empty() || request.text.size() >= CHUNK_MIN_BYTES || request.text.size() >= STREAM_MIN_BYTES ||
+        templatingEnabled || segmentMemoryEnabled || sharedCacheEnabled || nearDuplicateEnabled ||
+        offlineMode != OfflineMode::OFF || GetLanguagePair(request.languagePair).source == AUTO_LANGUAGE) {
+        return false;
+    }
+
+    string cacheKeyText = NormalizeForCache(request.text);
+    DWORD now = clock.NowMs();
+    return !(request.languagePair == phrasebookPair && phrasebook.Contains(cacheKeyText)) &&
+           !cache.Contains(cacheKeyText, request.languagePair, now) &&
+           !negativeCache.Contains(cacheKeyText, request.languagePair, now);
+}
+
+// Send queued requests on the async engine, oldest first, while fewer than
+// MAX_PREFETCH engine requests are in flight
+void TranslationClient::PrefetchQueued() {
+    if (!multiplexEnabled || !asyncHttp.IsRunning()) {
+        return;
+    }
+    size_t room = MAX_PREFETCH - min(MAX_PREFETCH, asyncHttp.InFlight());
+
+    vector<shared_ptr<AsyncCall>> calls;
+    {
+        lock_guard<mutex> lock(requestMutex);
+        for (AsyncRequest& queued : requests.queued) {
+            if (calls.size() >= room) {
+                break;
+            }
+            if (queued.prefetchChecked) {
+                continue;
+            }
+            queued.prefetchChecked = true;
+            if (PrefetchEligible(queued)) {
+                queued.prefetch = make_shared<AsyncCall>(queued.text, queued.languagePair);
+                calls.push_back(queued.prefetch);
+            }
+        }
+    }
+
+    prefetchSubmitted += calls.size();
+    for (const shared_ptr<AsyncCall>& call : calls) {
+        StartAsyncCall(call);
+    }
+}
+
+// The in-flight request's prefetch, if it was sent for exactly this text
+shared_ptr<AsyncCall> TranslationClient::TakePrefetch(string_view text, LanguagePairId languagePair) {
+    if (!t_cancellableRequests) {
+        return nullptr;
+    }
+    shared_ptr<AsyncCall> call;
+    {
+        lock_guard<mutex> lock(requestMutex);
+        call = requests.inFlight.prefetch;
+        if (!call || !(call->languagePair == languagePair) || call->text != text) {
+            return nullptr;
+        }
+    }
+    lock_guard<mutex> lock(dispatchMutex);
+    if (call->taken) {
+        return nullptr;
+    }
+    call->taken = true;
+    return call;
+}
+
+// Send every missing chunk at once on the async engine and wait for them
+// all; a chunk whose call fails goes out again the blocking way. False
+// when the engine is not available, leaving the chunks to helper threads.
+bool TranslationClient::RequestChunksAsync(const vector<string_view>& chunks, const vector<size_t>& missing,
+                                           LanguagePairId languagePair, vector<PooledString>& translations,
+                                           vector<TranslationResult>& results) {
+    if (!t_cancellableRequests || !multiplexEnabled || !asyncHttp.IsRunning()) {
+        return false;
+    }
+
+    vector<shared_ptr<AsyncCall>> calls;
+    for (size_t index : missing) {
+        calls.push_back(make_shared<AsyncCall>(chunks[index], languagePair));
+    }
+    {
+        lock_guard<mutex> lock(requestMutex);
+        if (requests.inFlight.abandoned) {
+            for (size_t index : missing) {
+                results[index] = TranslationResult::NETWORK_ERROR;
+            }
+            return true;
+        }
+        requests.inFlight.asyncCalls.insert(requests.inFlight.asyncCalls.end(), calls.begin(), calls.end());
+    }
+    for (const shared_ptr<AsyncCall>& call : calls) {
+        StartAsyncCall(call);
+    }
+
+    for (size_t k = 0; k < missing.size(); ++k) {
+        size_t index = missing[k];
+        PooledString response;
+        shared_ptr<AsyncCall> answered = WaitAsyncCall(calls[k], response);
+        if (answered) {
+            wireRequests++;
+            wireBytesSent += answered->bytesSent;
+            wireBytesReceived += response.size();
+        }
+        if (answered && ParseAsyncCall(*answered, response, translations[index], results[index])) {
+            continue;
+        }
+        if (!answered && (!running || RequestAbandoned(nullptr))) {
+            results[index] = TranslationResult::NETWORK_ERROR;
+        } else {
+            results[index] = RequestTranslation(chunks[index], languagePair, translations[index]);
+        }
+    }
 
     lock_guard<mutex> lock(requestMutex);
-    requestQueue.push(AsyncRequest(requestId, text, sourceLang, targetLang));
-    LOG_DEBUG("Async request queued: " + requestId + " (" + sourceLang + " -> " + targetLang + ")");
+    for (const shared_ptr<AsyncCall>& call : calls) {
+        auto registered = find(requests.inFlight.asyncCalls.begin(), requests.inFlight.asyncCalls.end(), call);
+        if (registered != requests.inFlight.asyncCalls.end()) {
+            requests.inFlight.asyncCalls.erase(registered);
+        }
+    }
     return true;
 }
 
-// Poll for completed translation
-bool TranslationClient::PollResult(string& requestId, string& translation, string& error) {
+void TranslationClient::SetBinaryProtocolEnabled(bool enabled) {
+    binaryProtocolEnabled = enabled;
+    LOG_INFO(string("MessagePack protocol ") + (enabled ? "enabled" : "disabled"));
+}
+
+void TranslationClient::SetHedging(bool enabled, uint32_t budgetPercent) {
+    hedgePolicy.Configure(enabled, budgetPercent);
+    LOG_INFO(string("Request hedging ") + (enabled ? "enabled, budget " + to_string(budgetPercent) + "%" : "disabled"));
+}
+
+WireProtocolStats TranslationClient::GetWireStats() const {
+    WireProtocolStats stats;
+    stats.protocol = wireProtocol;
+    stats.requests = wireRequests;
+    stats.bytesSent = wireBytesSent;
+    stats.bytesReceived = wireBytesReceived;
+    stats.encodeNanos = wireEncodeNanos;
+    stats.decodeNanos = wireDecodeNanos;
+    return stats;
+}
+
+void TranslationClient::SetChunkingEnabled(bool enabled) {
+    chunkingEnabled = enabled;
+    LOG_INFO(string("Long-message chunking ") + (enabled ? "enabled" : "disabled"));
+}
+
+void TranslationClient::SetStreamingEnabled(bool enabled) {
+    streamingEnabled = enabled;
+    if (enabled) {
+        streamSupported = true;   // Ask the proxy again
+    }
+    LOG_INFO(string("Streaming of long messages ") + (enabled ? "enabled" : "disabled"));
+}
+
+void TranslationClient::SetPreflightEnabled(bool enabled) {
+    preflightEnabled = enabled;
+    LOG_INFO(string("Pre-flight skipping ") + (enabled ? "enabled" : "disabled"));
+}
+
+void TranslationClient::SetSegmentMemoryEnabled(bool enabled) {
+    segmentMemoryEnabled = enabled;
+    LOG_INFO(string("Segment translation memory ") + (enabled ? "enabled" : "disabled"));
+}
+
+void TranslationClient::SetNearDuplicateEnabled(bool enabled, int threshold) {
+    nearDuplicateThreshold = threshold;
+    nearDuplicateEnabled = enabled;
+    if (!enabled) {
+        nearDuplicates.Clear();
+    }
+    LOG_INFO(string("Near-duplicate reuse ") + (enabled ? "enabled" : "disabled") +
+             " (threshold " + to_string(threshold) + " bits)");
+}
+
+void TranslationClient::SetTemplatingEnabled(bool enabled) {
+    templatingEnabled = enabled;
+    LOG_INFO(string("Cache templating ") + (enabled ? "enabled" : "disabled"));
+}
+
+void TranslationClient::SetTemplateNames(vector<string> names) {
+    auto shared = make_shared<const vector<string>>(std::move(names));
+    lock_guard<mutex> lock(templateMutex);
+    templateNames = std::move(shared);
+}
+
+void TranslationClient::PushResult(AsyncResult result) {
     lock_guard<mutex> lock(resultMutex);
+    resultQueue.push(std::move(result));
+    resultCount.fetch_add(1, memory_order_release);
+}
+
+// Called with requestMutex held once nobody is waiting for the in-flight result
+void TranslationClient::AbandonInFlight() {
+    requests.inFlight.abandoned = true;
+    if (requests.inFlight.prefetch) {
+        CancelAsyncCall(requests.inFlight.prefetch);
+    }
+    for (const shared_ptr<AsyncCall>& call : requests.inFlight.asyncCalls) {
+        CancelAsyncCall(call);
+    }
+}
+
+// A fan-out request is answered once per target, as the worker would have
+void TranslationClient::PushError(const string& requestId, const vector<LanguagePairId>& fanOut,
+                                  const char* error) {
+    if (fanOut.empty()) {
+        PushResult(AsyncResult(requestId, PooledString(), PooledString(error)));
+        return;
+    }
+    for (LanguagePairId pair : fanOut) {
+        PushResult(AsyncResult(requestId + "@" + GetLanguagePair(pair).target, PooledString(), PooledString(error)));
+    }
+}
+
+// Answer requestId with an error result and stop work nobody else is waiting
+// for. Requests that have followers keep running for them. requestMutex held.
+bool TranslationClient::CancelLocked(const string& requestId, const char* reason) {
+    for (auto it = requests.queued.begin(); it != requests.queued.end(); ++it) {
+        auto follower = find(it->followers.begin(), it->followers.end(), requestId);
+        vector<LanguagePairId> fanOut;
+        if (it->requestId == requestId) {
+            fanOut = it->fanOut;
+            if (it->followers.empty()) {
+                if (it->prefetch) {
+                    prefetchWasted++;
+                    CancelAsyncCall(it->prefetch);
+                }
+                requests.queued.erase(it);
+            } else {
+                it->requestId = std::move(it->followers.front());
+                it->followers.erase(it->followers.begin());
+                it->supersedeKey.clear();
+            }
+        } else if (follower != it->followers.end()) {
+            it->followers.erase(follower);
+        } else {
+            continue;
+        }
+        PushError(requestId, fanOut, reason);
+        return true;
+    }
+
+    if (!requests.inFlight.active || requests.inFlight.abandoned) {
+        return false;
+    }
+
+    auto follower = find(requests.inFlight.followers.begin(), requests.inFlight.followers.end(), requestId);
+    if (requests.inFlight.requestId == requestId && !requests.inFlight.leaderCancelled) {
+        requests.inFlight.leaderCancelled = true;
+        requests.inFlight.supersedeKey.clear();
+        PushError(requestId, requests.inFlight.fanOut, reason);
+    } else if (follower != requests.inFlight.followers.end()) {
+        requests.inFlight.followers.erase(follower);
+        PushResult(AsyncResult(requestId, PooledString(), PooledString(reason)));
+    } else {
+        return false;
+    }
+
+    if (requests.inFlight.leaderCancelled && requests.inFlight.followers.empty()) {
+        AbandonInFlight();
+        LOG_DEBUG("Abandoned in-flight request: " + requests.inFlight.requestId);
+    }
+    return true;
+}
+
+bool TranslationClient::CancelRequest(const string& requestId) {
+    lock_guard<mutex> lock(requestMutex);
+    return CancelLocked(requestId, "cancelled");
+}
+
+// Queue async translation request
+bool TranslationClient::TranslateAsync(const string& requestId, string_view text,
+                                       LanguagePairId languagePair, string_view supersedeKey) {
+    if (!initialized || !running) {
+        return false;
+    }
+
+    TraceRequestScope traceScope(requestId);
+    TRACE_SPAN("enqueue");
+
+    TranslationInfo info;
+    if (AnswerPreflight(text, info)) {
+        PushResult(AsyncResult(requestId, PooledString(text.data(), text.size()), PooledString(), info));
+        LOG_DEBUG("Async request skipped: " + requestId + " (nothing to translate)");
+        return true;
+    }
+    if (!ResolveAutoSource(text, languagePair, info)) {
+        // Nothing to translate: hand the text straight back
+        PushResult(AsyncResult(requestId, PooledString(text.data(), text.size()), PooledString(), info));
+        LOG_DEBUG("Async request skipped: " + requestId + " (detected " + string(info.detectedLanguage) + ")");
+        return true;
+    }
+
+    // Recently returned unchanged or rejected: answer without queueing
+    if (!negativeCache.Empty()) {
+        PooledString translation;
+        PooledString error;
+        if (RecallNegative(NormalizeForCache(text), text, languagePair, translation, error, info)) {
+            PushResult(AsyncResult(requestId, std::move(translation), std::move(error), info));
+            return true;
+        }
+    }
+
+    lock_guard<mutex> lock(requestMutex);
+
+    // Older drafts under the same key are replaced before they reach HttpsRequest
+    if (!supersedeKey.empty()) {
+        vector<string> superseded;
+        for (const AsyncRequest& queued : requests.queued) {
+            if (queued.supersedeKey == supersedeKey && !(queued.languagePair == languagePair && queued.text == text)) {
+                superseded.push_back(queued.requestId);
+            }
+        }
+        const InFlightRequest& inFlight = requests.inFlight;
+        if (inFlight.active && !inFlight.leaderCancelled && inFlight.supersedeKey == supersedeKey &&
+            !(inFlight.languagePair == languagePair && inFlight.text == text)) {
+            superseded.push_back(inFlight.requestId);
+        }
+        for (const string& id : superseded) {
+            CancelLocked(id, "superseded");
+        }
+    }
+
+    // Identical text already queued or in flight: share its result
+    if (const string* leader = requests.Join(requestId, text, languagePair)) {
+        LOG_DEBUG("Async request " + requestId + " joined " + *leader);
+        return true;
+    }
+
+    AsyncRequest request(requestId, text, languagePair, info, supersedeKey);
+    request.traceEnqueueUs = IsTracingEnabled() ? TraceNowUs() : 0;
+    requests.Enqueue(std::move(request));
+    {
+        // A worker waiting on a multiplexed answer sends this one meanwhile
+        lock_guard<mutex> dispatchLock(dispatchMutex);
+        dispatchEnqueues++;
+    }
+    dispatchChanged.notify_all();
+    LOG_DEBUG("Async request queued: " + requestId + " (pair " + to_string(languagePair) + ")");
+    return true;
+}
+
+// Queue one text for several target languages. Each target is answered as
+// "requestId@target"; cancelling requestId cancels them all. Fan-out
+// requests are neither shared with identical requests nor superseded.
+bool TranslationClient::TranslateAsync(const string& requestId, string_view text,
+                                       const vector<LanguagePairId>& languagePairs) {
+    if (!initialized || !running) {
+        return false;
+    }
+
+    TraceRequestScope traceScope(requestId);
+    TRACE_SPAN("enqueue");
+
+    TranslationInfo skipped;
+    if (AnswerPreflight(text, skipped)) {
+        for (LanguagePairId pair : languagePairs) {
+            PushResult(AsyncResult(requestId + "@" + GetLanguagePair(pair).target,
+                                   PooledString(text.data(), text.size()), PooledString(), skipped));
+        }
+        return true;
+    }
+
+    AsyncRequest request(requestId, text);
+    for (LanguagePairId pair : languagePairs) {
+        TranslationInfo info;
+        if (!ResolveAutoSource(text, pair, info)) {
+            // Already in this target language (or undetermined): answer it now
+            PushResult(AsyncResult(requestId + "@" + GetLanguagePair(pair).target,
+                                   PooledString(text.data(), text.size()), PooledString(), info));
+            continue;
+        }
+        request.fanOut.push_back(pair);
+        request.info = info;  // Detection is per text, so any target's info will do
+    }
+
+    if (request.fanOut.empty()) {
+        return true;
+    }
+    request.languagePair = request.fanOut.front();
+
+    request.traceEnqueueUs = IsTracingEnabled() ? TraceNowUs() : 0;
+    lock_guard<mutex> lock(requestMutex);
+    requests.Enqueue(std::move(request));
+    LOG_DEBUG("Fan-out request queued: " + requestId + " (" + to_string(languagePairs.size()) + " targets)");
+    return true;
+}
 
-    if (resultQueue.empty()) {
+// Poll for completed translation
+bool TranslationClient::PollResult(string& requestId, PooledString& translation, PooledString& error,
+                                   TranslationInfo& info) {
+    // Idle polls skip the mutex entirely
+    if (resultCount.load(memory_order_acquire) == 0) {
         return false;
     }
 
-    AsyncResult result = resultQueue.front();
-    resultQueue.pop();
+    uint64_t traceReadyUs;
+    {
+        lock_guard<mutex> lock(resultMutex);
+
+        if (resultQueue.empty()) {
+            return false;
+        }
+
+        AsyncResult result = std::move(resultQueue.front());
+        resultQueue.pop();
+        resultCount.fetch_sub(1, memory_order_release);
+
+        traceReadyUs = result.traceReadyUs;
+        requestId = std::move(result.requestId);
+        translation = std::move(result.translation);
+        error = std::move(result.error);
+        info = result.info;
 
-    requestId = result.requestId;
-    translation = result.translation;
-    error = result.error;
+        // Everything delivered: the game thread's cached blocks go back to the
+        // pool for the worker to reuse
+        if (resultQueue.empty()) {
+            PayloadPool::ReleaseThreadCache();
+        }
+    }
 
-    // Append credits info to the result for the Lua side
-    // Format: translation|error|credits
-    if (!translation.empty() || !error.empty()) {
-        // Credits will be appended by the caller in lua_interface
+    // Time spent waiting for the addon's next poll, recorded outside the
+    // lock the worker needs to publish results
+    if (traceReadyUs && IsTracingEnabled()) {
+        TraceComplete("poll_handoff", traceReadyUs, TraceNowUs(), requestId);
     }
 
+    // Credits and flags are appended by the caller in lua_interface
     return true;
 }
 
 // Get count of pending requests
 size_t TranslationClient::GetPendingCount() {
     lock_guard<mutex> lock(requestMutex);
-    return requestQueue.size();
+    return requests.queued.size();
+}
+
+// Turn a failed TranslateText into the error string reported through poll;
+// translation holds the proxy's error text on entry and is cleared
+void TranslationClient::DescribeFailure(TranslationResult tr, PooledString& translation, PooledString& error) {
+    // Check if translation contains error message
+    if (!translation.empty() && (translation == "INSUFFICIENT_CREDITS" || translation == "INVALID_API_KEY")) {
+        error = translation;
+        translation = "";
+        return;
+    }
+
+    switch (tr) {
+        case TranslationResult::NETWORK_ERROR: error = "network error"; break;
+        case TranslationResult::API_ERROR: error = translation.empty() ? "API error" : translation; break;
+        case TranslationResult::ENCODING_ERROR: error = "encoding error"; break;
+        case TranslationResult::TIMEOUT_ERROR: error = "timeout"; break;
+        case TranslationResult::INVALID_PARAMS: error = "invalid parameters"; break;
+        default: error = "unknown error"; break;
+    }
+    translation = "";
 }
 
 // Worker thread for async translations
 void TranslationClient::WorkerThreadFunc() {
     LOG_INFO("Worker thread started");
+    t_cancellableRequests = true;
 
     while (running) {
         AsyncRequest request;
         bool hasRequest = false;
 
+        FlushTracing();
+        PrefetchQueued();
         {
             lock_guard<mutex> lock(requestMutex);
-            if (!requestQueue.empty()) {
-                request = requestQueue.front();
-                requestQueue.pop();
-                hasRequest = true;
-            }
+            hasRequest = requests.StartNext(request);
         }
 
         if (hasRequest) {
             LOG_DEBUG("Processing async request: " + request.requestId);
 
-            string translation;
-            string error;
+            TraceRequestScope traceScope(request.requestId);
+            if (request.traceEnqueueUs && IsTracingEnabled()) {
+                TraceComplete("queue_wait", request.traceEnqueueUs, TraceNowUs(), request.requestId);
+            }
+            TRACE_SPAN("process");
+
+            // Fan-out requests answer "requestId@target" once per target
+            if (!request.fanOut.empty()) {
+                size_t targets = request.fanOut.size();
+                vector<PooledString> translations(targets);
+                vector<PooledString> errors(targets);
+                vector<TranslationInfo> infos(targets, request.info);
+                TranslateFanOut(request.text, request.fanOut, translations, errors, infos);
+
+                bool deliver;
+                {
+                    // No followers: fan-out requests are never shared
+                    lock_guard<mutex> lock(requestMutex);
+                    deliver = !requests.Finish(request.requestId).empty();
+                }
+                if (deliver) {
+                    for (size_t i = 0; i < targets; ++i) {
+                        PushResult(AsyncResult(request.requestId + "@" + GetLanguagePair(request.fanOut[i]).target,
+                                               std::move(translations[i]), std::move(errors[i]), infos[i]));
+                    }
+                }
+                LOG_DEBUG("Fan-out request completed: " + request.requestId + " (" + to_string(targets) + " targets)");
+                continue;
+            }
+
+            PooledString translation;
+            PooledString error;
+            TranslationInfo info = request.info;
 
-            TranslationResult tr = TranslateText(request.text, translation, request.sourceLang, request.targetLang);
+            TranslationResult tr = TranslateText(request.text, translation, request.languagePair, &info);
 
             if (tr != TranslationResult::SUCCESS) {
-                // Check if translation contains error message
-                if (!translation.empty() && (translation == "INSUFFICIENT_CREDITS" || translation == "INVALID_API_KEY")) {
-                    error = translation;
-                    translation = "";
-                } else {
-                    switch (tr) {
-                        case TranslationResult::NETWORK_ERROR: error = "network error"; break;
-                        case TranslationResult::API_ERROR: error = translation.empty() ? "API error" : translation; break;
-                        case TranslationResult::ENCODING_ERROR: error = "encoding error"; break;
-                        case TranslationResult::TIMEOUT_ERROR: error = "timeout"; break;
-                        case TranslationResult::INVALID_PARAMS: error = "invalid parameters"; break;
-                        default: error = "unknown error"; break;
-                    }
-                    translation = "";
-                }
+                DescribeFailure(tr, translation, error);
             }
 
-            // Push result to result queue
+            // Collect everyone still waiting on this translation
+            vector<string> recipients;
+            shared_ptr<AsyncCall> prefetch;
             {
-                lock_guard<mutex> lock(resultMutex);
-                resultQueue.push(AsyncResult(request.requestId, translation, error));
+                lock_guard<mutex> lock(requestMutex);
+                prefetch = std::move(requests.inFlight.prefetch);
+                recipients = requests.Finish(request.requestId);
+            }
+            // Answered from a cache after all, or the request never reached RequestTranslation
+            if (prefetch) {
+                bool unused;
+                {
+                    lock_guard<mutex> lock(dispatchMutex);
+                    unused = !prefetch->taken;
+                }
+                if (unused) {
+                    prefetchWasted++;
+                    CancelAsyncCall(prefetch);
+                }
+            }
+
+            // Push results to the result queue (the last recipient takes the buffers)
+            for (size_t i = 0; i < recipients.size(); ++i) {
+                if (i + 1 == recipients.size()) {
+                    PushResult(AsyncResult(recipients[i], std::move(translation), std::move(error), info));
+                } else {
+                    PushResult(AsyncResult(recipients[i], translation, error, info));
+                }
             }
 
-            LOG_DEBUG("Async request completed: " + request.requestId);
+            LOG_DEBUG("Async request completed: " + request.requestId + " (" + to_string(recipients.size()) + " recipients)");
         } else {
-            Sleep(50);
+            unique_lock<mutex> lock(requestMutex);
+            requests.WaitForWork(lock, [this]() { return !running; });
         }
     }
 
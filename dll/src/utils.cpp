@@ -41,6 +41,16 @@ string GetDllPath() {
     return string(path);
 }
 
+string GetDllFolder() {
+    string dllPath = GetDllPath();
+    if (dllPath.empty()) {
+        return "";
+    }
+
+    size_t lastSlash = dllPath.find_last_of("\\/");
+    return dllPath.substr(0, lastSlash);
+}
+
 vector<string> SplitString(const string& str, char delimiter) {
     vector<string> tokens;
     stringstream ss(str);
@@ -0,0 +1,576 @@
+// wire_format.cpp - JSON and MessagePack encodings of proxy requests and responses
+
+#include <cstring>
+
+#include "../include/wire_format.h"
+
+using namespace std;
+
+string SimpleJsonParser::extractField(string_view json, string_view fieldName) {
+    string searchKey = "\"" + string(fieldName) + "\"";
+    size_t keyPos = json.find(searchKey);
+    if (keyPos == string::npos) {
+        return "";
+    }
+
+    size_t colonPos = json.find(":", keyPos + searchKey.length());
+    if (colonPos == string::npos) {
+        return "";
+    }
+
+    size_t start = colonPos + 1;
+    while (start < json.length() && (json[start] == ' ' || json[start] == '\t' || json[start] == '\n' || json[start] == '\r')) {
+        start++;
+    }
+
+    if (start >= json.length()) {
+        return "";
+    }
+
+    // Check if it's a string value (starts with quote)
+    if (json[start] == '"') {
+        start++;
+        size_t end = start;
+        while (end < json.length() && json[end] != '"') {
+            if (json[end] == '\\' && end + 1 < json.length()) {
+                end += 2; // Skip escaped character
+            } else {
+                end++;
+            }
+        }
+        return unescapeJson(json.substr(start, end - start));
+    }
+
+    // It's a number or boolean
+    size_t end = start;
+    while (end < json.length() && json[end] != ',' && json[end] != '}' && json[end] != '\n') {
+        end++;
+    }
+    string value{ json.substr(start, end - start) };
+    // Trim whitespace
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r')) {
+        value.pop_back();
+    }
+    return value;
+}
+
+bool SimpleJsonParser::extractStringArray(string_view json, string_view fieldName, vector<string>& values) {
+    string searchKey = "\"" + string(fieldName) + "\"";
+    size_t keyPos = json.find(searchKey);
+    if (keyPos == string::npos) {
+        return false;
+    }
+
+    size_t pos = json.find_first_not_of(" \t\r\n", keyPos + searchKey.length());
+    if (pos == string::npos || json[pos] != ':') {
+        return false;
+    }
+    pos = json.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == string::npos || json[pos] != '[') {
+        return false;
+    }
+
+    values.clear();
+    ++pos;
+    while (true) {
+        pos = json.find_first_not_of(" \t\r\n,", pos);
+        if (pos == string::npos) {
+            return false;
+        }
+        if (json[pos] == ']') {
+            return true;
+        }
+        if (json[pos] != '"') {
+            return false;
+        }
+
+        size_t start = ++pos;
+        while (pos < json.length() && json[pos] != '"') {
+            pos += (json[pos] == '\\' && pos + 1 < json.length()) ? 2 : 1;
+        }
+        if (pos >= json.length()) {
+            return false;
+        }
+        values.push_back(unescapeJson(json.substr(start, pos - start)));
+        ++pos;
+    }
+}
+
+double SimpleJsonParser::extractNumber(string_view json, string_view fieldName) {
+    string value = extractField(json, fieldName);
+    if (value.empty()) return -1;
+    try {
+        return stod(value);
+    } catch (...) {
+        return -1;
+    }
+}
+
+string SimpleJsonParser::unescapeJson(string_view input) {
+    string result{ input };
+    size_t pos = 0;
+
+    // Unescape basic characters
+    while ((pos = result.find("\\\"", pos)) != string::npos) {
+        result.replace(pos, 2, "\"");
+        pos += 1;
+    }
+    pos = 0;
+    while ((pos = result.find("\\\\", pos)) != string::npos) {
+        result.replace(pos, 2, "\\");
+        pos += 1;
+    }
+    pos = 0;
+    while ((pos = result.find("\\n", pos)) != string::npos) {
+        result.replace(pos, 2, "\n");
+        pos += 1;
+    }
+    pos = 0;
+    while ((pos = result.find("\\r", pos)) != string::npos) {
+        result.replace(pos, 2, "\r");
+        pos += 1;
+    }
+    pos = 0;
+    while ((pos = result.find("\\t", pos)) != string::npos) {
+        result.replace(pos, 2, "\t");
+        pos += 1;
+    }
+
+    // Handle Unicode escape sequences \uXXXX
+    pos = 0;
+    while ((pos = result.find("\\u", pos)) != string::npos) {
+        if (pos + 5 < result.length()) {
+            string hexStr = result.substr(pos + 2, 4);
+            try {
+                unsigned int codepoint = stoul(hexStr, nullptr, 16);
+                string utf8_char = ConvertCodepointToUTF8(codepoint);
+                result.replace(pos, 6, utf8_char);
+                pos += utf8_char.length();
+            } catch (...) {
+                pos += 6;
+            }
+        } else {
+            break;
+        }
+    }
+
+    return result;
+}
+
+string SimpleJsonParser::ConvertCodepointToUTF8(unsigned int codepoint) {
+    string result;
+
+    if (codepoint <= 0x7F) {
+        result += static_cast<char>(codepoint);
+    } else if (codepoint <= 0x7FF) {
+        result += static_cast<char>(0xC0 | (codepoint >> 6));
+        result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint <= 0xFFFF) {
+        result += static_cast<char>(0xE0 | (codepoint >> 12));
+        result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint <= 0x10FFFF) {
+        result += static_cast<char>(0xF0 | (codepoint >> 18));
+        result += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        result += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        result += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+
+    return result;
+}
+
+void AppendJsonEscaped(PooledString& out, string_view input) {
+    static const char hexDigits[] = "0123456789abcdef";
+    for (char c : input) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ('\x00' <= c && c <= '\x1f') {
+                    out += "\\u00";
+                    out += hexDigits[(c >> 4) & 0xF];
+                    out += hexDigits[c & 0xF];
+                } else {
+                    out += c;
+                }
+        }
+    }
+}
+
+void EncodeJsonRequest(PooledString& out, string_view apiKey, string_view text, string_view from, string_view to) {
+    out.reserve(out.size() + apiKey.size() + text.size() + 64);
+    out += "{\"apiKey\":\"";
+    AppendJsonEscaped(out, apiKey);
+    out += "\",\"text\":\"";
+    AppendJsonEscaped(out, text);
+    out += "\",\"from\":\"";
+    out += from;
+    out += "\",\"to\":\"";
+    out += to;
+    out += "\"}";
+}
+
+// ============================================================================
+// MessagePack
+// ============================================================================
+
+void MsgPackWriter::BigEndian(uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+void MsgPackWriter::Header(uint8_t fixBase, uint32_t fixLimit, uint8_t code16, uint8_t code32, uint32_t count) {
+    if (count < fixLimit) {
+        out += static_cast<char>(fixBase | count);
+    } else if (count <= 0xFFFF) {
+        out += static_cast<char>(code16);
+        BigEndian(count, 2);
+    } else {
+        out += static_cast<char>(code32);
+        BigEndian(count, 4);
+    }
+}
+
+void MsgPackWriter::Map(uint32_t count) {
+    Header(0x80, 16, 0xDE, 0xDF, count);
+}
+
+void MsgPackWriter::Array(uint32_t count) {
+    Header(0x90, 16, 0xDC, 0xDD, count);
+}
+
+void MsgPackWriter::Str(string_view value) {
+    size_t length = value.size();
+    if (length < 32) {
+        out += static_cast<char>(0xA0 | length);
+    } else if (length <= 0xFF) {
+        out += static_cast<char>(0xD9);
+        BigEndian(length, 1);
+    } else if (length <= 0xFFFF) {
+        out += static_cast<char>(0xDA);
+        BigEndian(length, 2);
+    } else {
+        out += static_cast<char>(0xDB);
+        BigEndian(length, 4);
+    }
+    out.append(value.data(), value.size());
+}
+
+void MsgPackWriter::Uint(uint64_t value) {
+    if (value < 0x80) {
+        out += static_cast<char>(value);
+    } else if (value <= 0xFF) {
+        out += static_cast<char>(0xCC);
+        BigEndian(value, 1);
+    } else if (value <= 0xFFFF) {
+        out += static_cast<char>(0xCD);
+        BigEndian(value, 2);
+    } else if (value <= 0xFFFFFFFF) {
+        out += static_cast<char>(0xCE);
+        BigEndian(value, 4);
+    } else {
+        out += static_cast<char>(0xCF);
+        BigEndian(value, 8);
+    }
+}
+
+bool MsgPackReader::Take(size_t bytes, const unsigned char*& ptr) {
+    if (data.size() - pos < bytes) {
+        return false;
+    }
+    ptr = reinterpret_cast<const unsigned char*>(data.data() + pos);
+    pos += bytes;
+    return true;
+}
+
+static uint64_t ReadBigEndian(const unsigned char* ptr, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | ptr[i];
+    }
+    return value;
+}
+
+// Length of a fix/8/16/32 family (str, array, map); code8 0 = no 8-bit form
+bool MsgPackReader::ReadLength(uint8_t code, uint8_t fixBase, uint8_t fixMask, uint8_t code8,
+                               uint8_t code16, uint8_t code32, uint32_t& length) {
+    const unsigned char* ptr;
+    if ((code & ~fixMask) == fixBase) {
+        length = code & fixMask;
+    } else if (code8 && code == code8 && Take(1, ptr)) {
+        length = ptr[0];
+    } else if (code == code16 && Take(2, ptr)) {
+        length = static_cast<uint32_t>(ReadBigEndian(ptr, 2));
+    } else if (code == code32 && Take(4, ptr)) {
+        length = static_cast<uint32_t>(ReadBigEndian(ptr, 4));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool MsgPackReader::ReadMap(uint32_t& count) {
+    size_t start = pos;
+    const unsigned char* code;
+    if (!Take(1, code) || !ReadLength(code[0], 0x80, 0x0F, 0, 0xDE, 0xDF, count)) {
+        pos = start;
+        return false;
+    }
+    return true;
+}
+
+bool MsgPackReader::ReadArray(uint32_t& count) {
+    size_t start = pos;
+    const unsigned char* code;
+    if (!Take(1, code) || !ReadLength(code[0], 0x90, 0x0F, 0, 0xDC, 0xDD, count)) {
+        pos = start;
+        return false;
+    }
+    return true;
+}
+
+bool MsgPackReader::ReadStr(string_view& value) {
+    size_t start = pos;
+    const unsigned char* code;
+    const unsigned char* bytes;
+    uint32_t length;
+    if (!Take(1, code) || !ReadLength(code[0], 0xA0, 0x1F, 0xD9, 0xDA, 0xDB, length) || !Take(length, bytes)) {
+        pos = start;
+        return false;
+    }
+    value = string_view(reinterpret_cast<const char*>(bytes), length);
+    return true;
+}
+
+bool MsgPackReader::ReadUint(uint64_t& value) {
+    size_t start = pos;
+    const unsigned char* code;
+    const unsigned char* ptr;
+    if (!Take(1, code)) {
+        return false;
+    }
+    if (code[0] < 0x80) {
+        value = code[0];
+        return true;
+    }
+    int bytes = code[0] == 0xCC ? 1 : code[0] == 0xCD ? 2 : code[0] == 0xCE ? 4 : code[0] == 0xCF ? 8 : 0;
+    if (!bytes || !Take(bytes, ptr)) {
+        pos = start;
+        return false;
+    }
+    value = ReadBigEndian(ptr, bytes);
+    return true;
+}
+
+bool MsgPackReader::ReadNumber(double& value) {
+    uint64_t unsignedValue;
+    if (ReadUint(unsignedValue)) {
+        value = static_cast<double>(unsignedValue);
+        return true;
+    }
+
+    size_t start = pos;
+    const unsigned char* code;
+    const unsigned char* ptr;
+    if (!Take(1, code)) {
+        return false;
+    }
+    if (code[0] >= 0xE0) {   // Negative fixint
+        value = static_cast<int8_t>(code[0]);
+        return true;
+    }
+    switch (code[0]) {
+        case 0xCA:
+            if (Take(4, ptr)) {
+                uint32_t bits = static_cast<uint32_t>(ReadBigEndian(ptr, 4));
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                value = f;
+                return true;
+            }
+            break;
+        case 0xCB:
+            if (Take(8, ptr)) {
+                uint64_t bits = ReadBigEndian(ptr, 8);
+                memcpy(&value, &bits, sizeof(value));
+                return true;
+            }
+            break;
+        case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+            int bytes = 1 << (code[0] - 0xD0);
+            if (Take(bytes, ptr)) {
+                uint64_t raw = ReadBigEndian(ptr, bytes);
+                int shift = 64 - bytes * 8;
+                value = static_cast<double>(static_cast<int64_t>(raw << shift) >> shift);
+                return true;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    pos = start;
+    return false;
+}
+
+bool MsgPackReader::Skip() {
+    if (pos >= data.size()) {
+        return false;
+    }
+
+    uint8_t code = static_cast<uint8_t>(data[pos]);
+    string_view text;
+    double number;
+    uint32_t count;
+
+    if (code == 0xC0 || code == 0xC2 || code == 0xC3) {   // nil, false, true
+        ++pos;
+        return true;
+    }
+    if (ReadStr(text) || ReadNumber(number)) {
+        return true;
+    }
+    if (ReadArray(count)) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!Skip()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (ReadMap(count)) {
+        for (uint32_t i = 0; i < count * 2; ++i) {
+            if (!Skip()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;   // bin, ext and timestamps are not part of the protocol
+}
+
+void EncodeMsgPackRequest(PooledString& out, string_view sessionToken, string_view text,
+                          string_view from, string_view to) {
+    out.reserve(out.size() + sessionToken.size() + text.size() + from.size() + to.size() + 16);
+    MsgPackWriter writer(out);
+    writer.Map(4);
+    writer.Uint(WIRE_REQUEST_TOKEN);
+    writer.Str(sessionToken);
+    writer.Uint(WIRE_REQUEST_TEXT);
+    writer.Str(text);
+    writer.Uint(WIRE_REQUEST_FROM);
+    writer.Str(from);
+    writer.Uint(WIRE_REQUEST_TO);
+    writer.Str(to);
+}
+
+bool DecodeMsgPackResponse(string_view body, WireResponse& response) {
+    response.translation = string_view();
+    response.error = string_view();
+    response.credits = -1;
+
+    MsgPackReader reader(body);
+    uint32_t count;
+    if (!reader.ReadMap(count)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t key;
+        if (!reader.ReadUint(key)) {
+            return false;
+        }
+
+        bool ok;
+        switch (key) {
+            case WIRE_RESPONSE_TRANSLATION: ok = reader.ReadStr(response.translation); break;
+            case WIRE_RESPONSE_CREDITS: ok = reader.ReadNumber(response.credits); break;
+            case WIRE_RESPONSE_ERROR: ok = reader.ReadStr(response.error); break;
+            default: ok = reader.Skip(); break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return reader.AtEnd();
+}
+
+TranslationStreamReader::TranslationStreamReader() : sentences(0), credits(-1), done(false), malformed(false) {
+}
+
+size_t TranslationStreamReader::Feed(string_view bytes) {
+    size_t before = sentences;
+    size_t start = 0;
+    while (!done && !malformed && error.empty()) {
+        size_t newline = bytes.find('\n', start);
+        if (newline == string_view::npos) {
+            pending.append(bytes.data() + start, bytes.size() - start);
+            break;
+        }
+        if (pending.empty()) {
+            ParseLine(bytes.substr(start, newline - start));
+        } else {
+            pending.append(bytes.data() + start, newline - start);
+            ParseLine(pending);
+            pending.clear();
+        }
+        start = newline + 1;
+    }
+    return sentences - before;
+}
+
+void TranslationStreamReader::Finish() {
+    if (!pending.empty() && !done && !malformed && error.empty()) {
+        ParseLine(pending);
+    }
+    pending.clear();
+}
+
+void TranslationStreamReader::ParseLine(string_view line) {
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.remove_suffix(1);
+    }
+    if (line.empty()) {
+        return;   // Keep-alive
+    }
+
+    error = SimpleJsonParser::extractField(line, "error");
+    if (!error.empty()) {
+        return;
+    }
+    double lineCredits = SimpleJsonParser::extractNumber(line, "creditsRemaining");
+    if (lineCredits >= 0) {
+        credits = lineCredits;
+    }
+
+    if (SimpleJsonParser::extractField(line, "done") == "true") {
+        done = true;
+        return;
+    }
+
+    string seq = SimpleJsonParser::extractField(line, "seq");
+    if (seq.empty()) {
+        // Buffered answer from a proxy without streaming
+        string whole = SimpleJsonParser::extractField(line, "translation");
+        if (whole.empty() || sentences > 0) {
+            malformed = true;
+            return;
+        }
+        translation = std::move(whole);
+        sentences = 1;
+        done = true;
+        return;
+    }
+    if (seq != to_string(sentences) || line.find("\"translation\"") == string_view::npos) {
+        malformed = true;
+        return;
+    }
+    translation += SimpleJsonParser::extractField(line, "translation");
+    ++sentences;
+}
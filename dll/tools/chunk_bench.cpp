@@ -0,0 +1,347 @@
+// chunk_bench.cpp - Latency of long messages sent as one request versus parallel sentence chunks
+//
+// Usage: chunk_bench [messages] [seed] [timeScale]
+// Long messages (guild MOTDs and DKP rules, Chinese and English, at least
+// CHUNK_MIN_BYTES) go to a stand-in proxy that answers after a round trip
+// plus UPSTREAM_OVERHEAD_MS and UPSTREAM_MS_PER_BYTE of the text, sleeping
+// that time divided by timeScale on the calling thread. Two paths:
+//   one request   the whole message in one call, as before chunking
+//   chunked       TranslateInChunks as the DLL runs it without the async
+//                 engine: SplitLongMessage, a TranslationCache lookup per
+//                 NormalizeForCache'd chunk, the missing chunks shared out
+//                 in order by the calling thread and up to
+//                 MAX_PARALLEL_CHUNKS - 1 helper threads, successful chunks
+//                 cached, JoinChunkTranslations in order
+// Then two follow-ups on a warm cache: each message posted again with one
+// sentence changed, and each message retried after one chunk failed.
+// Prints end-to-end latency (p50/p95, model milliseconds), requests sent,
+// and the cost of splitting and joining. Every split is checked: chunks in
+// order, at most CHUNK_MAX_BYTES, only whitespace between them, and the
+// joined stand-in translations (which echo their chunk) match.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "../include/message_chunker.h"
+#include "../include/scheduling_policy.h"
+#include "../include/text_normalize.h"
+#include "../include/translation_cache.h"
+
+using namespace std;
+
+// Stand-in proxy model, in milliseconds (as streaming_bench)
+static const double UPSTREAM_OVERHEAD_MS = 120.0;     // Per upstream translation call
+static const double UPSTREAM_MS_PER_BYTE = 0.9;       // Grows with the text translated
+static const size_t CHUNK_MIN_BYTES = 240;            // TranslationClient::CHUNK_MIN_BYTES
+static const size_t CHUNK_MAX_BYTES = 160;            // TranslationClient::CHUNK_MAX_BYTES
+static const size_t MAX_PARALLEL_CHUNKS = 4;          // TranslationClient::MAX_PARALLEL_CHUNKS
+
+struct Message {
+    string text;
+    vector<string> sentences;
+    double roundTripMs;
+};
+
+static vector<Message> GenerateMessages(size_t count, uint32_t seed) {
+    static const char* const clauses[] = {
+        "本周团队活动安排如下", "周三晚上八点熔火之心", "周四晚上八点黑翼之巢", "请提前准备好抗火装备",
+        "迟到超过十分钟扣除DKP", "新人需要先打一次祖尔格拉布", "装备分配按照DKP竞拍", "不要在团队频道刷屏",
+        "治疗请看好坦克", "有问题请私聊会长", "缺少两个牧师和一个德鲁伊", "出黑莲花和奥术水晶",
+    };
+    static const char* const ends[] = { "。", "！", "？", "；" };
+    static const char* const rules[] = {
+        "Raid invites go out at 7:45 server time.", "Bring fire resistance gear for Molten Core.",
+        "Late arrivals lose 10 DKP.", "Loot is bid in whole DKP, minimum bid 1.5k gold equivalent.",
+        "Healers watch the main tank, not the meters.", "Keep raid chat clear during pulls!",
+        "We still need two priests and a druid.", "Questions go to an officer in whisper.",
+    };
+
+    mt19937 random(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    lognormal_distribution<double> roundTrip(log(80.0), 0.4);   // ~80 ms
+    auto pick = [&](size_t n) { return static_cast<size_t>(unit(random) * n); };
+
+    vector<Message> messages;
+    for (size_t i = 0; i < count; ++i) {
+        Message message;
+        bool english = unit(random) < 0.25;
+        size_t sentences = 2 + pick(9);
+        for (size_t s = 0; s < sentences || message.text.size() < CHUNK_MIN_BYTES; ++s) {
+            string sentence;
+            if (english) {
+                sentence = string(s ? " " : "") + rules[pick(8)];
+            } else {
+                sentence = clauses[pick(12)];
+                if (unit(random) < 0.5) {
+                    sentence += string("，") + clauses[pick(12)];
+                }
+                sentence += ends[pick(4)];
+            }
+            message.text += sentence;
+            message.sentences.push_back(sentence);
+        }
+        message.roundTripMs = roundTrip(random);
+        messages.push_back(std::move(message));
+    }
+    return messages;
+}
+
+// ============================================================================
+// Stand-in proxy: echoes the text back after the modeled latency
+// ============================================================================
+
+struct StandInProxy {
+    double timeScale;
+    atomic<size_t> requests;
+    atomic<size_t> bytesSent;
+
+    explicit StandInProxy(double timeScale) : timeScale(timeScale), requests(0), bytesSent(0) {}
+
+    bool Translate(string_view text, double roundTripMs, bool fail, PooledString& translation) {
+        requests++;
+        bytesSent += text.size();
+        double ms = roundTripMs + UPSTREAM_OVERHEAD_MS + UPSTREAM_MS_PER_BYTE * text.size();
+        this_thread::sleep_for(chrono::microseconds(static_cast<int64_t>(ms * 1000.0 / timeScale)));
+        if (fail) {
+            return false;
+        }
+        translation.assign(text.data(), text.size());
+        return true;
+    }
+};
+
+// TranslateInChunks without the async engine; failChunk is the index of a
+// chunk the stand-in fails, or -1. Returns false when any chunk failed.
+static bool TranslateInChunks(StandInProxy& proxy, TranslationCache& cache, const Message& message,
+                              long failChunk, string& result, size_t& chunkHits) {
+    vector<string_view> chunks = SplitLongMessage(message.text, CHUNK_MAX_BYTES);
+    vector<string> keys(chunks.size());
+    vector<PooledString> translations(chunks.size());
+    vector<char> succeeded(chunks.size(), 1);
+    vector<size_t> missing;
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        keys[i] = NormalizeForCache(chunks[i]);
+        if (cache.Lookup(keys[i], DEFAULT_LANGUAGE_PAIR, 0, translations[i])) {
+            chunkHits++;
+        } else {
+            missing.push_back(i);
+        }
+    }
+
+    if (!missing.empty()) {
+        atomic<size_t> next(0);
+        auto work = [&]() {
+            size_t k;
+            while ((k = next++) < missing.size()) {
+                size_t index = missing[k];
+                succeeded[index] = proxy.Translate(chunks[index], message.roundTripMs,
+                                                   static_cast<long>(index) == failChunk, translations[index]);
+            }
+        };
+
+        vector<thread> helpers;
+        size_t helperCount = min(missing.size(), MAX_PARALLEL_CHUNKS) - 1;
+        for (size_t h = 0; h < helperCount; ++h) {
+            try {
+                helpers.emplace_back(work);
+            } catch (const system_error&) {
+                break;
+            }
+        }
+        work();
+        for (thread& helper : helpers) {
+            helper.join();
+        }
+
+        for (size_t index : missing) {
+            if (succeeded[index]) {
+                cache.Insert(keys[index], DEFAULT_LANGUAGE_PAIR, translations[index], 0);
+            }
+        }
+        for (size_t index : missing) {
+            if (!succeeded[index]) {
+                return false;
+            }
+        }
+    }
+
+    result.clear();
+    for (const PooledString& translation : translations) {
+        JoinChunkTranslations(result, translation, true);
+    }
+    return true;
+}
+
+// ============================================================================
+
+// Chunks must be in-order views of the text, separated by whitespace only
+static bool CheckSplit(const string& text, const vector<string_view>& chunks) {
+    size_t pos = 0;
+    for (string_view chunk : chunks) {
+        if (chunk.empty() || chunk.size() > CHUNK_MAX_BYTES || chunk.data() < text.data() + pos) {
+            return false;
+        }
+        size_t start = static_cast<size_t>(chunk.data() - text.data());
+        string_view gap = string_view(text).substr(pos, start - pos);
+        if (gap.find_first_not_of(" \t\r\n") != string_view::npos && gap != "\xE3\x80\x80") {
+            return false;
+        }
+        pos = start + chunk.size();
+    }
+    return string_view(text).substr(pos).find_first_not_of(" \t\r\n") == string_view::npos;
+}
+
+static double Percentile(vector<double> values, double percentile) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+struct Row {
+    vector<double> ms;
+    size_t requests;
+    size_t bytesSent;
+    size_t chunkHits;
+};
+
+static void PrintRow(const char* name, const Row& row, size_t messages) {
+    printf("%-30s %9.0fms %9.0fms %10.2f %10.0f %10zu\n", name, Percentile(row.ms, 50), Percentile(row.ms, 95),
+           static_cast<double>(row.requests) / messages, static_cast<double>(row.bytesSent) / messages,
+           row.chunkHits);
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 42;
+    double timeScale = argc > 3 ? atof(argv[3]) : 10.0;
+    if (count == 0 || count > 100000 || timeScale <= 0.0) {
+        fprintf(stderr, "usage: %s [messages 1-100000] [seed] [timeScale > 0]\n", argv[0]);
+        return 1;
+    }
+
+    vector<Message> messages = GenerateMessages(count, seed);
+    size_t totalBytes = 0, totalChunks = 0, maxChunks = 0;
+    for (const Message& message : messages) {
+        vector<string_view> chunks = SplitLongMessage(message.text, CHUNK_MAX_BYTES);
+        if (!CheckSplit(message.text, chunks)) {
+            fprintf(stderr, "Bad split of: %s\n", message.text.c_str());
+            return 1;
+        }
+        totalBytes += message.text.size();
+        totalChunks += chunks.size();
+        maxChunks = max(maxChunks, chunks.size());
+    }
+    printf("%zu long messages, %.0f bytes and %.1f chunks on average (at most %zu), seed %u, time / %.0f\n\n",
+           count, static_cast<double>(totalBytes) / count, static_cast<double>(totalChunks) / count, maxChunks,
+           seed, timeScale);
+
+    auto modelMs = [&](chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() * timeScale;
+    };
+
+    // One request per message
+    Row single = {};
+    {
+        StandInProxy proxy(timeScale);
+        for (const Message& message : messages) {
+            PooledString translation;
+            auto start = chrono::steady_clock::now();
+            proxy.Translate(message.text, message.roundTripMs, false, translation);
+            single.ms.push_back(modelMs(start));
+        }
+        single.requests = proxy.requests;
+        single.bytesSent = proxy.bytesSent;
+    }
+
+    // Chunked on a cold cache, then the follow-ups on the same cache
+    Row chunked = {}, reposted = {}, retried = {};
+    bool ok = true;
+    {
+        StandInProxy proxy(timeScale);
+        TranslationCache cache(SchedulingPolicy::DEFAULT_CACHE_ENTRIES, SchedulingPolicy::DEFAULT_CACHE_EXPIRY_MS);
+        for (const Message& message : messages) {
+            vector<string_view> chunks = SplitLongMessage(message.text, CHUNK_MAX_BYTES);
+            string expected, result;
+            for (string_view chunk : chunks) {
+                expected += chunk;
+            }
+            auto start = chrono::steady_clock::now();
+            ok &= TranslateInChunks(proxy, cache, message, -1, result, chunked.chunkHits) && result == expected;
+            chunked.ms.push_back(modelMs(start));
+        }
+        chunked.requests = proxy.requests.exchange(0);
+        chunked.bytesSent = proxy.bytesSent.exchange(0);
+
+        // The MOTD posted again with its middle sentence reworded
+        for (const Message& message : messages) {
+            Message changed = message;
+            string& middle = changed.sentences[changed.sentences.size() / 2];
+            middle.insert(middle.find_first_not_of(' '), "2");
+            changed.text.clear();
+            for (const string& sentence : changed.sentences) {
+                changed.text += sentence;
+            }
+            string result;
+            auto start = chrono::steady_clock::now();
+            ok &= TranslateInChunks(proxy, cache, changed, -1, result, reposted.chunkHits);
+            reposted.ms.push_back(modelMs(start));
+        }
+        reposted.requests = proxy.requests.exchange(0);
+        reposted.bytesSent = proxy.bytesSent.exchange(0);
+
+        // A new message whose last chunk fails, then its retry
+        for (const Message& message : messages) {
+            cache.Clear();
+            size_t chunks = SplitLongMessage(message.text, CHUNK_MAX_BYTES).size();
+            string result;
+            size_t ignored = 0;
+            ok &= !TranslateInChunks(proxy, cache, message, static_cast<long>(chunks) - 1, result, ignored);
+            proxy.requests = 0;
+            proxy.bytesSent = 0;
+            auto start = chrono::steady_clock::now();
+            ok &= TranslateInChunks(proxy, cache, message, -1, result, retried.chunkHits);
+            retried.ms.push_back(modelMs(start));
+            retried.requests += proxy.requests;
+            retried.bytesSent += proxy.bytesSent;
+        }
+    }
+
+    printf("%-30s %11s %11s %10s %10s %10s\n", "", "p50", "p95", "requests", "bytes sent", "chunk hits");
+    PrintRow("one request", single, count);
+    PrintRow("parallel chunks", chunked, count);
+    PrintRow("reposted, one sentence changed", reposted, count);
+    PrintRow("retry after a failed chunk", retried, count);
+    printf("(per message; one request would resend the whole text in both follow-ups)\n");
+    printf("\nreassembled chunks: %s\n", ok ? "all match" : "MISMATCH");
+
+    // Wall-clock cost of splitting and joining in the DLL
+    const int iterations = 2000;
+    volatile size_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        const Message& message = messages[i % messages.size()];
+        vector<string_view> chunks = SplitLongMessage(message.text, CHUNK_MAX_BYTES);
+        string joined;
+        joined.reserve(message.text.size() * 2);
+        for (string_view chunk : chunks) {
+            JoinChunkTranslations(joined, chunk, false);
+        }
+        sink = sink + joined.size();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("split and join: %.0f ns per message\n", ns / iterations);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+// compact_cache_bench.cpp - Memory per entry and lookup time of string-keyed vs hashed cache keys
+//
+// Usage: compact_cache_bench <channel.tsv> [rounds]
+// The log holds "seconds<TAB>group<TAB>text" per line ('#' lines are
+// comments), as tools/data/channel_sample.tsv does. Its distinct lines fill
+// two caches of TranslationClient's size: the one before language pairs were
+// interned, reproduced here (an unordered_map keyed by a "zh->en:text"
+// string that GenerateCacheKey built for every lookup), and the DLL's
+// TranslationCache (64-bit text hash seeded with the pair ID, source text
+// stored once and compared only on a hash match). Every line of the log is
+// then looked up in both, hits and misses alike. Prints live heap bytes per
+// entry (counted by a replaced operator new), ns per lookup, and the cost of
+// interning a pair at the UnitXP boundary against the two language-code
+// strings each request used to carry.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../include/language_pair.h"
+#include "../include/scheduling_policy.h"
+#include "../include/translation_cache.h"
+
+using namespace std;
+
+static const size_t CACHE_ENTRIES = SchedulingPolicy::DEFAULT_CACHE_ENTRIES;
+static const uint32_t CACHE_EXPIRY_MS = SchedulingPolicy::DEFAULT_CACHE_EXPIRY_MS;
+
+// ============================================================================
+// Live heap bytes: every allocation carries its size in a header
+// ============================================================================
+
+static size_t g_liveBytes = 0;
+static const size_t HEADER_BYTES = alignof(max_align_t);
+
+void* operator new(size_t size) {
+    void* block = malloc(size + HEADER_BYTES);
+    if (!block) {
+        throw bad_alloc();
+    }
+    *static_cast<size_t*>(block) = size;
+    g_liveBytes += size;
+    return static_cast<char*>(block) + HEADER_BYTES;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    void* block = static_cast<char*>(ptr) - HEADER_BYTES;
+    g_liveBytes -= *static_cast<size_t*>(block);
+    free(block);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// ============================================================================
+// Before: string keys built per lookup
+// ============================================================================
+
+struct CacheEntry {
+    string translation;
+    uint32_t timestamp;
+};
+
+struct StringKeyedCache {
+    unordered_map<string, CacheEntry> cache;
+
+    static string GenerateCacheKey(string_view text, const string& sourceLang, const string& targetLang) {
+        string key;
+        key.reserve(sourceLang.size() + targetLang.size() + 3 + text.size());
+        key += sourceLang;
+        key += "->";
+        key += targetLang;
+        key += ':';
+        key += text;
+        return key;
+    }
+
+    bool Lookup(string_view text, const string& sourceLang, const string& targetLang, uint32_t now,
+                string& result) {
+        string cacheKey = GenerateCacheKey(text, sourceLang, targetLang);
+        auto it = cache.find(cacheKey);
+        if (it != cache.end() && (now - it->second.timestamp) < CACHE_EXPIRY_MS) {
+            result = it->second.translation;
+            return true;
+        }
+        return false;
+    }
+
+    void Insert(string_view text, const string& sourceLang, const string& targetLang, string_view translation,
+                uint32_t now) {
+        cache[GenerateCacheKey(text, sourceLang, targetLang)] = CacheEntry{ string(translation), now };
+    }
+};
+
+// ============================================================================
+
+static bool LoadTexts(const char* path, vector<string>& texts) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first = line.find('\t');
+        size_t second = first == string::npos ? string::npos : line.find('\t', first + 1);
+        if (second == string::npos) {
+            continue;
+        }
+        texts.push_back(line.substr(second + 1));
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: compact_cache_bench <channel.tsv> [rounds]\n");
+        return 1;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+
+    vector<string> texts;
+    if (!LoadTexts(argv[1], texts) || texts.empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    vector<string> distinct;
+    {
+        unordered_set<string> seen;
+        for (const string& text : texts) {
+            if (seen.insert(text).second && distinct.size() < CACHE_ENTRIES) {
+                distinct.push_back(text);
+            }
+        }
+    }
+    // Stand-in translations of about the source's length
+    auto translationOf = [](const string& text) { return string(text.rbegin(), text.rend()); };
+
+    const string sourceLang = "zh", targetLang = "en";
+    LanguagePairId pair = InternLanguagePair(sourceLang, targetLang);
+    const uint32_t now = 1000;
+
+    size_t baseBytes = g_liveBytes;
+    StringKeyedCache before;
+    for (const string& text : distinct) {
+        before.Insert(text, sourceLang, targetLang, translationOf(text), now);
+    }
+    size_t beforeBytes = g_liveBytes - baseBytes;
+
+    baseBytes = g_liveBytes;
+    TranslationCache after(CACHE_ENTRIES, CACHE_EXPIRY_MS);
+    for (const string& text : distinct) {
+        after.Insert(text, pair, translationOf(text), now);
+    }
+    size_t afterBytes = g_liveBytes - baseBytes;
+
+    size_t textBytes = 0;
+    for (const string& text : distinct) {
+        textBytes += text.size();
+    }
+    printf("%zu log lines, %zu cached entries, mean text %.1f bytes\n\n", texts.size(), distinct.size(),
+           static_cast<double>(textBytes) / distinct.size());
+
+    // Both must answer every line the same
+    size_t hitsBefore = 0, hitsAfter = 0;
+    for (const string& text : texts) {
+        string a;
+        PooledString b;
+        bool hitA = before.Lookup(text, sourceLang, targetLang, now, a);
+        bool hitB = after.Lookup(text, pair, now, b);
+        if (hitA != hitB || (hitA && string_view(b) != a)) {
+            fprintf(stderr, "Caches disagree on: %s\n", text.c_str());
+            return 1;
+        }
+        hitsBefore += hitA;
+        hitsAfter += hitB;
+    }
+
+    size_t lookups = static_cast<size_t>(rounds) * texts.size();
+    volatile size_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const string& text : texts) {
+            string result;
+            sink = sink + before.Lookup(text, sourceLang, targetLang, now, result);
+        }
+    }
+    double beforeNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const string& text : texts) {
+            PooledString result;
+            sink = sink + after.Lookup(text, pair, now, result);
+        }
+    }
+    double afterNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+
+    printf("%-22s %12s %14s\n", "", "bytes/entry", "ns per lookup");
+    printf("%-22s %12.0f %14.1f\n", "string keys (before)", static_cast<double>(beforeBytes) / distinct.size(),
+           beforeNs);
+    printf("%-22s %12.0f %14.1f\n", "hashed keys (after)", static_cast<double>(afterBytes) / distinct.size(),
+           afterNs);
+    printf("(%zu of %zu lookups per round hit; heap bytes exclude allocator overhead; the after lookup\n"
+           " includes the cache's mutex and the sampled timing behind cachestats)\n\n",
+           hitsAfter, texts.size());
+
+    // The request's language pair: two code strings before, a 16-bit ID after
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        sink = sink + InternLanguagePair(sourceLang, targetLang);
+    }
+    double internNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+    printf("language pair per request: %zu bytes as two strings, %zu as an interned ID (%.1f ns to intern)\n",
+           2 * sizeof(string), sizeof(LanguagePairId), internNs);
+    return 0;
+}
@@ -0,0 +1,242 @@
+// dispatch_bench.cpp - Cost of the UnitXP bridge for foreign calls, idle polls and subcommand lookup
+//
+// Usage: dispatch_bench [calls]
+// Every UnitXP call in the game passes through detoured_UnitXP, including
+// the ones other addons make (UnitXP_SP3's "behind", "distanceBetween",
+// ...). This replays three workloads on a stand-in Lua stack through two
+// bridges: the one before the fast path, reproduced here (std::string
+// copies of the first two arguments inside a try block, then a chain of
+// string compares), and the DLL's current one (string_view compare against
+// UNITXP_NAMESPACE before any try block, LookupSubcommand, the frame budget
+// bracket, an atomic idle-poll check). Prints ns per call for each, then
+// name resolution alone and the frame budget bracket alone.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../include/frame_budget.h"
+#include "../include/subcommand_table.h"
+
+using namespace std;
+
+// The Lua stack as the bridge sees it: argument strings by index
+struct FakeLuaState {
+    const char* args[4];
+    int argc;
+    const char* pushed;
+};
+
+static const char* LuaToString(FakeLuaState& L, int index) {
+    return index <= L.argc ? L.args[index - 1] : nullptr;
+}
+
+static void PushString(FakeLuaState& L, const char* s) {
+    L.pushed = s;
+}
+
+static int ForeignUnitXP(FakeLuaState& L) {
+    L.pushed = L.args[0];
+    return 1;
+}
+
+// Called through pointers like the game's own functions (p_lua_pushstring,
+// p_original_UnitXP), so neither bridge gets them folded in
+static void (*volatile LuaPushString)(FakeLuaState&, const char*) = PushString;
+static int (*volatile OriginalUnitXP)(FakeLuaState&) = ForeignUnitXP;
+
+// Result queue state the idle poll checks
+static mutex g_resultMutex;
+static deque<string> g_resultQueue;
+static atomic<size_t> g_resultCount(0);
+
+// ============================================================================
+// Before: copies, try block, compare chain (order of the old if/else chain)
+// ============================================================================
+
+static const char* const kChainOrder[] = {
+    "ping", "version", "status", "setkey", "credits", "trace", "translate_async", "poll", "translate",
+    "memstats", "cachestats", "template", "template_names", "segments", "neardup", "detect", "cancel",
+    "offline", "startup", "shared", "chunks", "poll_batch", "budget", "wire", "names", "hedge", "endpoints",
+    "push", "preflight", "stream", "multiplex",
+};
+
+// lua_tostring's std::string copy
+static string LuaToStdString(FakeLuaState& L, int index) {
+    const char* ptr = LuaToString(L, index);
+    return ptr ? string(ptr) : "";
+}
+
+static int BeforeChain(const string& subcmd) {
+    for (size_t i = 0; i < sizeof(kChainOrder) / sizeof(kChainOrder[0]); ++i) {
+        if (subcmd == kChainOrder[i]) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+static int BeforeUnitXP(FakeLuaState& L) {
+    try {
+        if (L.argc >= 1) {
+            string cmd{ LuaToStdString(L, 1) };
+            if (cmd == "WoWTranslate") {
+                if (L.argc >= 2) {
+                    string subcmd{ LuaToStdString(L, 2) };
+                    int index = BeforeChain(subcmd);
+                    if (index == 7) {  // poll
+                        string requestId, translation, error;
+                        lock_guard<mutex> lock(g_resultMutex);
+                        if (g_resultQueue.empty()) {
+                            LuaPushString(L, "");
+                            return 1;
+                        }
+                        requestId = g_resultQueue.front();
+                        LuaPushString(L, requestId.c_str());
+                        return 1;
+                    }
+                    LuaPushString(L, index >= 0 ? "ok" : "error|unknown command");
+                    return 1;
+                }
+                LuaPushString(L, "error|no subcommand specified");
+                return 1;
+            }
+        }
+        return OriginalUnitXP(L);
+    } catch (const exception&) {
+        LuaPushString(L, "error|exception");
+        return 1;
+    }
+}
+
+// ============================================================================
+// After: the DLL's fast path (detoured_UnitXP and DispatchSubcommand)
+// ============================================================================
+
+static FrameBudget g_frameBudget;
+
+static uint64_t NowUs() {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static int AfterUnitXP(FakeLuaState& L) {
+    const char* first = L.argc >= 1 ? LuaToString(L, 1) : nullptr;
+    if (!first || string_view(first) != UNITXP_NAMESPACE) {
+        return OriginalUnitXP(L);
+    }
+
+    try {
+        if (L.argc < 2) {
+            LuaPushString(L, "error|no subcommand specified");
+            return 1;
+        }
+        Subcommand id = LookupSubcommand(LuaToString(L, 2));
+        g_frameBudget.BeginCall(NowUs(), 0.0);
+        if (id == Subcommand::Poll) {
+            if (g_resultCount.load(memory_order_acquire) == 0) {
+                LuaPushString(L, "");
+            } else {
+                lock_guard<mutex> lock(g_resultMutex);
+                LuaPushString(L, g_resultQueue.empty() ? "" : g_resultQueue.front().c_str());
+            }
+        } else {
+            LuaPushString(L, id != Subcommand::Unknown ? "ok" : "error|unknown command");
+        }
+        g_frameBudget.EndCall(NowUs(), SubcommandName(id));
+        return 1;
+    } catch (const exception&) {
+        LuaPushString(L, "error|exception");
+        return 1;
+    }
+}
+
+// ============================================================================
+
+typedef int (*Bridge)(FakeLuaState&);
+
+static double NsPerCall(Bridge bridge, const vector<FakeLuaState>& calls, size_t count) {
+    volatile int sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        FakeLuaState L = calls[i % calls.size()];
+        sink = sink + bridge(L);
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / count;
+}
+
+static void Compare(const char* name, const vector<FakeLuaState>& calls, size_t count) {
+    double before = NsPerCall(BeforeUnitXP, calls, count);
+    double after = NsPerCall(AfterUnitXP, calls, count);
+    printf("%-28s %10.1f %10.1f %8.1fx\n", name, before, after, after > 0 ? before / after : 0.0);
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 5000000;
+
+    // Foreign calls: UnitXP_SP3 queries other addons make every frame
+    vector<FakeLuaState> foreign = {
+        { { "behind", "player", "target" }, 3, nullptr },
+        { { "inSight", "player", "target" }, 3, nullptr },
+        { { "distanceBetween", "player", "target" }, 3, nullptr },
+        { { "modernNameplateDistance", "enable" }, 2, nullptr },
+        { { "camera", "horizontalDisplacement" }, 2, nullptr },
+    };
+    vector<FakeLuaState> idlePoll = { { { "WoWTranslate", "poll" }, 2, nullptr } };
+    vector<FakeLuaState> every;
+    for (const char* name : kChainOrder) {
+        every.push_back(FakeLuaState{ { "WoWTranslate", name }, 2, nullptr });
+    }
+    vector<FakeLuaState> unknown = { { { "WoWTranslate", "no_such_command" }, 2, nullptr } };
+
+    // Both bridges must agree on what each call answers
+    for (const vector<FakeLuaState>* calls : { &foreign, &idlePoll, &every, &unknown }) {
+        for (FakeLuaState L : *calls) {
+            FakeLuaState R = L;
+            if (BeforeUnitXP(L) != AfterUnitXP(R) || string_view(L.pushed) != string_view(R.pushed)) {
+                fprintf(stderr, "Bridges disagree on %s %s\n", L.args[0], L.args[1]);
+                return 1;
+            }
+        }
+    }
+
+    printf("%zu calls per row, ns per call\n\n", count);
+    printf("%-28s %10s %10s %9s\n", "workload", "before", "after", "speedup");
+    Compare("foreign UnitXP call", foreign, count);
+    Compare("idle poll", idlePoll, count);
+    Compare("each subcommand in turn", every, count);
+    Compare("unknown subcommand", unknown, count);
+
+    // Name resolution alone
+    vector<string> names(begin(kChainOrder), end(kChainOrder));
+    volatile int sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        sink = sink + BeforeChain(names[i % names.size()]);
+    }
+    double chainNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / count;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        sink = sink + static_cast<int>(LookupSubcommand(names[i % names.size()]));
+    }
+    double hashNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / count;
+    printf("\nname lookup over %zu subcommands: compare chain %.1f ns, perfect hash %.1f ns\n", names.size(),
+           chainNs, hashNs);
+
+    // The frame budget bracket every WoWTranslate call pays (two clock reads)
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        g_frameBudget.BeginCall(NowUs(), 0.0);
+        g_frameBudget.EndCall(NowUs(), "poll");
+    }
+    double bracketNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / count;
+    printf("frame budget bracket: %.1f ns per call\n", bracketNs);
+    return 0;
+}
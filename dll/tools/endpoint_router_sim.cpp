@@ -0,0 +1,183 @@
+// endpoint_router_sim.cpp - Replays stand-in proxy endpoints with injected latency and faults through EndpointRouter
+//
+// Usage: endpoint_router_sim [seconds] [requestsPerSecond]
+// Four stand-in endpoints answer with log-normal latencies around their own
+// median and fail with their own error rate; the scenario also takes the
+// fastest one down (timeouts) for a minute and later slows it fourfold.
+// Every request is routed and failed over exactly as RoutedRequest does:
+// up to MAX_ATTEMPTS endpoints, probes cut off at PROBE_TIMEOUT_MS.
+// Prints the request distribution per endpoint and the latency percentiles
+// seen by the caller, against pinning every request to the first endpoint.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/endpoint_router.h"
+
+using namespace std;
+
+static const uint32_t REQUEST_TIMEOUT_MS = 10000;
+
+struct Phase {
+    uint64_t fromMs;
+    uint64_t toMs;
+    double latencyFactor;   // Multiplies the median
+    bool down;              // Every request times out
+};
+
+struct StandIn {
+    const char* name;
+    double medianMs;
+    double errorRate;       // Answers 502 after a normal round trip
+    vector<Phase> phases;
+};
+
+struct Outcome {
+    bool ok;
+    uint32_t elapsedMs;
+};
+
+class StandInEndpoint {
+public:
+    StandInEndpoint(const StandIn& config, uint32_t seed)
+        : config(config), random(seed), jitter(0.0, 0.25), unit(0.0, 1.0) {}
+
+    Outcome Serve(uint64_t nowMs, uint32_t timeoutMs) {
+        double factor = 1.0;
+        for (const Phase& phase : config.phases) {
+            if (nowMs >= phase.fromMs && nowMs < phase.toMs) {
+                if (phase.down) {
+                    return Outcome{ false, timeoutMs };
+                }
+                factor = phase.latencyFactor;
+            }
+        }
+        double ms = config.medianMs * factor * exp(jitter(random));
+        if (ms >= timeoutMs) {
+            return Outcome{ false, timeoutMs };
+        }
+        bool failed = unit(random) < config.errorRate;
+        return Outcome{ !failed, static_cast<uint32_t>(ms) };
+    }
+
+private:
+    StandIn config;
+    mt19937 random;
+    normal_distribution<double> jitter;
+    uniform_real_distribution<double> unit;
+};
+
+struct RunResult {
+    vector<uint32_t> latencies;
+    vector<uint64_t> served;      // Successful answers per endpoint
+    vector<uint64_t> attempts;    // Requests sent per endpoint
+    uint64_t failed;
+    uint64_t failovers;
+    vector<EndpointStats> stats;
+};
+
+static vector<StandIn> Scenario() {
+    return {
+        { "near:8443", 80.0, 0.01, { { 120000, 180000, 1.0, true }, { 300000, 420000, 4.0, false } } },
+        { "mid:8444", 140.0, 0.03, {} },
+        { "far:8445", 260.0, 0.01, {} },
+        { "flaky:8446", 90.0, 0.35, {} },
+    };
+}
+
+static RunResult Run(uint64_t durationMs, uint32_t intervalMs, bool routed) {
+    vector<StandIn> scenario = Scenario();
+    vector<StandInEndpoint> standIns;
+    EndpointRouter router;
+    for (size_t i = 0; i < scenario.size(); ++i) {
+        standIns.emplace_back(scenario[i], static_cast<uint32_t>(1000 + i));
+        router.Add(scenario[i].name);
+    }
+
+    RunResult result;
+    result.served.assign(scenario.size(), 0);
+    result.attempts.assign(scenario.size(), 0);
+    result.failed = 0;
+    for (uint64_t start = 0; start < durationMs; start += intervalMs) {
+        uint64_t nowMs = start;
+        bool ok = false;
+        if (!routed) {
+            Outcome outcome = standIns[0].Serve(nowMs, REQUEST_TIMEOUT_MS);
+            ++result.attempts[0];
+            nowMs += outcome.elapsedMs;
+            ok = outcome.ok;
+            result.served[0] += ok ? 1 : 0;
+        } else {
+            uint32_t tried = 0;
+            for (uint32_t attempt = 0; attempt < EndpointRouter::MAX_ATTEMPTS && !ok; ++attempt) {
+                EndpointChoice choice = router.Select(nowMs, tried);
+                if (choice.endpoint == EndpointRouter::NO_ENDPOINT) {
+                    break;
+                }
+                if (attempt > 0) {
+                    router.RecordFailover();
+                }
+                tried |= 1u << choice.endpoint;
+                Outcome outcome = standIns[choice.endpoint].Serve(
+                    nowMs, choice.probe ? EndpointRouter::PROBE_TIMEOUT_MS : REQUEST_TIMEOUT_MS);
+                ++result.attempts[choice.endpoint];
+                nowMs += outcome.elapsedMs;
+                router.Record(choice.endpoint, nowMs, outcome.elapsedMs, outcome.ok);
+                ok = outcome.ok;
+                result.served[choice.endpoint] += ok ? 1 : 0;
+            }
+        }
+        result.failed += ok ? 0 : 1;
+        result.latencies.push_back(static_cast<uint32_t>(nowMs - start));
+    }
+    result.failovers = router.GetFailovers();
+    result.stats = router.GetStats(durationMs);
+    return result;
+}
+
+static uint32_t Percentile(vector<uint32_t> values, double percentile) {
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+static void Report(const char* label, const RunResult& run) {
+    printf("%-8s p50 %5u ms  p95 %5u ms  p99 %5u ms  max %5u ms  failed %llu/%zu  failovers %llu\n", label,
+           Percentile(run.latencies, 50), Percentile(run.latencies, 95), Percentile(run.latencies, 99),
+           *max_element(run.latencies.begin(), run.latencies.end()), static_cast<unsigned long long>(run.failed),
+           run.latencies.size(), static_cast<unsigned long long>(run.failovers));
+}
+
+int main(int argc, char** argv) {
+    uint64_t seconds = argc > 1 ? strtoul(argv[1], nullptr, 10) : 600;
+    uint32_t perSecond = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 5;
+    if (seconds == 0 || perSecond == 0 || perSecond > 1000) {
+        fprintf(stderr, "usage: %s [seconds] [requestsPerSecond 1-1000]\n", argv[0]);
+        return 1;
+    }
+
+    vector<StandIn> scenario = Scenario();
+    printf("%llu s at %u requests/s; near is down 120-180 s and 4x slower 300-420 s\n",
+           static_cast<unsigned long long>(seconds), perSecond);
+    RunResult pinned = Run(seconds * 1000, 1000 / perSecond, false);
+    RunResult routed = Run(seconds * 1000, 1000 / perSecond, true);
+    Report("pinned", pinned);
+    Report("routed", routed);
+
+    printf("\n%-12s %7s %6s %9s %9s %9s %6s %10s\n", "endpoint", "median", "errors", "attempts", "served",
+           "share", "ewma", "ejections");
+    for (size_t i = 0; i < scenario.size(); ++i) {
+        const EndpointStats& stats = routed.stats[i];
+        printf("%-12s %5.0fms %5.0f%% %9llu %9llu %8.1f%% %4ums %10llu\n", scenario[i].name, scenario[i].medianMs,
+               scenario[i].errorRate * 100.0, static_cast<unsigned long long>(routed.attempts[i]),
+               static_cast<unsigned long long>(routed.served[i]),
+               100.0 * routed.served[i] / routed.latencies.size(), stats.rttMs,
+               static_cast<unsigned long long>(stats.ejections));
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+// frame_budget_harness.cpp - Drives the bridge's frame-budget policy with synthetic frames
+//
+// Usage: frame_budget_harness [budgetMicros] [frames]
+// Simulates a raid session at 60 fps on a synthetic clock: chat bursts
+// queue translate_async calls (with occasional lock contention), results
+// come back some frames later and are drained by one poll_batch per frame,
+// and a rare synchronous translate blocks on the network. The degrade rules
+// mirror lua_interface.cpp: queue insertion is deferred, poll batches stop
+// early and sync translations are refused once the frame is over budget.
+// Prints per-frame bridge time with the budget off and at the given budget.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "../include/frame_budget.h"
+
+using namespace std;
+
+static const uint64_t FRAME_MICROS = 16667;            // 60 fps
+static const uint64_t QUEUE_MICROS = 25;               // translate_async without contention
+static const uint64_t CONTENDED_QUEUE_MICROS = 400;    // requestMutex held by the worker
+static const uint64_t RESULT_MICROS = 35;              // One poll record formatted and pushed
+static const uint64_t SYNC_TRANSLATE_MICROS = 30000;   // Blocking network round trip
+static const uint64_t RESULT_DELAY_FRAMES = 20;        // Worker + proxy latency
+static const size_t POLL_BATCH = 8;
+
+struct SimulationResult {
+    FrameBudgetStats stats;
+    vector<uint64_t> frameMicros;
+    double meanResultDelayFrames;
+    uint64_t hitchFrames;            // Bridge time above twice the budget
+    vector<BudgetOverrun> overruns;
+};
+
+// Deterministic LCG so both runs see the same session
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed) : state(seed) {}
+    uint32_t Next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    bool Chance(uint32_t perMille) { return Next() % 1000 < perMille; }
+};
+
+static SimulationResult Simulate(uint32_t budgetMicros, uint64_t frames) {
+    FrameBudget budget(budgetMicros);
+    Random random(12345);
+
+    struct Request {
+        uint64_t requestFrame;
+        uint64_t readyFrame;
+    };
+    deque<Request> deferred;
+    deque<Request> inFlight;
+    deque<Request> ready;
+    uint64_t delivered = 0;
+    uint64_t delayTotal = 0;
+
+    SimulationResult result;
+    uint64_t now = 0;
+
+    auto queueCost = [&]() { return random.Chance(20) ? CONTENDED_QUEUE_MICROS : QUEUE_MICROS; };
+
+    for (uint64_t frame = 0; frame < frames; ++frame) {
+        uint64_t frameStart = frame * FRAME_MICROS;
+        now = max(now, frameStart);
+        uint64_t bridgeMicros = 0;
+
+        while (!inFlight.empty() && inFlight.front().readyFrame <= frame) {
+            ready.push_back(inFlight.front());
+            inFlight.pop_front();
+        }
+
+        // Chat events: quiet chatter, plus a 30-line burst (pull timers, loot spam) every 2 s
+        size_t messages = random.Chance(300) ? 1 : 0;
+        if (frame % 120 == 0) {
+            messages += 30;
+        }
+        for (size_t i = 0; i < messages; ++i) {
+            uint64_t start = now;
+            budget.BeginCall(now, 0);
+            if (deferred.empty() && !budget.Exhausted(now)) {
+                now += queueCost();
+                inFlight.push_back(Request{ frame, frame + RESULT_DELAY_FRAMES });
+            } else {
+                now += 2;
+                deferred.push_back(Request{ frame, 0 });
+                budget.RecordDeferred();
+            }
+            budget.EndCall(now, "translate_async");
+            bridgeMicros += now - start;
+            now += 50;   // Other addons' event handlers
+        }
+
+        // A debug macro's synchronous translate every 10 s
+        if (frame % 600 == 300) {
+            uint64_t start = now;
+            budget.BeginCall(now, 0);
+            if (budget.Exhausted(now)) {
+                budget.RecordRefused();
+            } else {
+                now += SYNC_TRANSLATE_MICROS;
+            }
+            budget.EndCall(now, "translate");
+            bridgeMicros += now - start;
+        }
+
+        // OnUpdate: one poll_batch carrying the frame time
+        {
+            uint64_t start = now;
+            budget.BeginCall(now, static_cast<double>(frame + 1));
+            while (!deferred.empty() && !budget.Exhausted(now)) {
+                now += queueCost();
+                inFlight.push_back(Request{ deferred.front().requestFrame, frame + RESULT_DELAY_FRAMES });
+                deferred.pop_front();
+            }
+            size_t count = 0;
+            while (count < POLL_BATCH && !ready.empty() && (count == 0 || !budget.Exhausted(now))) {
+                now += RESULT_MICROS;
+                delayTotal += frame - ready.front().requestFrame;
+                ready.pop_front();
+                ++delivered;
+                ++count;
+            }
+            if (count > 0 && count < POLL_BATCH && !ready.empty()) {
+                budget.RecordPartialPoll();
+            }
+            budget.EndCall(now, "poll_batch");
+            bridgeMicros += now - start;
+        }
+
+        result.frameMicros.push_back(bridgeMicros);
+    }
+
+    budget.BeginCall(now + FRAME_MICROS, 0);   // Closes the last frame
+    result.stats = budget.GetStats();
+    result.meanResultDelayFrames = delivered ? static_cast<double>(delayTotal) / delivered : 0.0;
+    result.hitchFrames = 0;
+    result.overruns.resize(FrameBudget::OVERRUN_HISTORY);
+    result.overruns.resize(budget.GetOverruns(result.overruns.data(), result.overruns.size()));
+    return result;
+}
+
+static uint64_t Percentile(vector<uint64_t> values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    sort(values.begin(), values.end());
+    return values[min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+static void Report(const char* label, const SimulationResult& result) {
+    const FrameBudgetStats& stats = result.stats;
+    printf("%s\n", label);
+    printf("  frames %llu, over budget %llu, over 2x budget %llu, calls %llu\n", (unsigned long long)stats.frames,
+           (unsigned long long)stats.overBudgetFrames, (unsigned long long)result.hitchFrames,
+           (unsigned long long)stats.calls);
+    printf("  bridge time per frame: p50 %llu us, p99 %llu us, max %llu us\n",
+           (unsigned long long)Percentile(result.frameMicros, 0.50),
+           (unsigned long long)Percentile(result.frameMicros, 0.99),
+           (unsigned long long)stats.maxFrameMicros);
+    printf("  deferred %llu, partial polls %llu, refused %llu, mean result delay %.2f frames\n",
+           (unsigned long long)stats.deferredRequests, (unsigned long long)stats.partialPolls,
+           (unsigned long long)stats.refusedRequests, result.meanResultDelayFrames);
+    if (!result.overruns.empty()) {
+        printf("  recent overruns (cause:frameUs/callUs):");
+        for (size_t i = 0; i < result.overruns.size() && i < 4; ++i) {
+            printf(" %s:%u/%u", result.overruns[i].cause ? result.overruns[i].cause : "unknown",
+                   result.overruns[i].frameMicros, result.overruns[i].callMicros);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t budgetMicros = argc >= 2 ? static_cast<uint32_t>(atoi(argv[1])) : FrameBudget::DEFAULT_BUDGET_MICROS;
+    uint64_t frames = argc >= 3 ? static_cast<uint64_t>(atoll(argv[2])) : 36000;
+
+    // The unlimited run is still measured against the budget so the two compare
+    SimulationResult runs[2] = { Simulate(0, frames), Simulate(budgetMicros, frames) };
+    for (SimulationResult& run : runs) {
+        run.stats.overBudgetFrames = static_cast<uint64_t>(
+            count_if(run.frameMicros.begin(), run.frameMicros.end(),
+                     [&](uint64_t micros) { return micros > budgetMicros; }));
+        run.hitchFrames = static_cast<uint64_t>(
+            count_if(run.frameMicros.begin(), run.frameMicros.end(),
+                     [&](uint64_t micros) { return micros > 2ull * budgetMicros; }));
+    }
+
+    Report("budget off", runs[0]);
+    char label[64];
+    snprintf(label, sizeof(label), "budget %u us", budgetMicros);
+    Report(label, runs[1]);
+    return 0;
+}
@@ -0,0 +1,100 @@
+// hedging_sim.cpp - Replays a long-tail proxy latency distribution through HedgePolicy
+//
+// Usage: hedging_sim [requests] [budgetPercent] [tailPercent]
+// Each request draws its latency from the proxy model: most answers come
+// back in about 300 ms (log-normal), tailPercent of them take 2-6 s. With
+// hedging, a request still running at the policy's threshold gets a
+// duplicate with an independent latency if the budget allows, and finishes
+// with whichever answers first - the same decision HedgedRequest makes.
+// Prints latency percentiles without and with hedging and the extra load.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../include/hedge_policy.h"
+
+using namespace std;
+
+struct LatencyModel {
+    mt19937 random;
+    lognormal_distribution<double> body;
+    uniform_real_distribution<double> tail;
+    uniform_real_distribution<double> unit;
+    double tailShare;
+
+    LatencyModel(uint32_t seed, double tailPercent)
+        : random(seed), body(5.7, 0.25), tail(2000.0, 6000.0), unit(0.0, 1.0), tailShare(tailPercent / 100.0) {}
+
+    uint32_t Draw() {
+        double ms = unit(random) < tailShare ? tail(random) : body(random);
+        return static_cast<uint32_t>(ms);
+    }
+};
+
+struct RunResult {
+    vector<uint32_t> latencies;
+    HedgeStats stats;
+};
+
+static RunResult Run(size_t requests, bool hedging, uint32_t budgetPercent, double tailPercent) {
+    LatencyModel primary(1234, tailPercent);
+    LatencyModel duplicate(5678, tailPercent);
+    HedgePolicy policy;
+    policy.Configure(hedging, budgetPercent);
+
+    RunResult result;
+    result.latencies.reserve(requests);
+    for (size_t i = 0; i < requests; ++i) {
+        uint32_t latency = primary.Draw();
+        uint32_t hedgeLatency = duplicate.Draw();   // Drawn either way so both runs see the same primaries
+        uint32_t threshold = policy.BeginRequest();
+
+        uint32_t answered = latency;
+        if (threshold > 0 && latency > threshold && policy.TryHedge()) {
+            if (threshold + hedgeLatency < latency) {
+                answered = threshold + hedgeLatency;
+                policy.RecordHedgeWin();
+            }
+        }
+        policy.RecordLatency(answered);
+        result.latencies.push_back(answered);
+    }
+    result.stats = policy.GetStats();
+    return result;
+}
+
+static uint32_t Percentile(vector<uint32_t> values, double percentile) {
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+static void Report(const char* label, const RunResult& run) {
+    printf("%-10s p50 %5u ms  p95 %5u ms  p99 %5u ms  p99.9 %5u ms  hedges %llu (%.1f%%, %llu won)\n", label,
+           Percentile(run.latencies, 50), Percentile(run.latencies, 95), Percentile(run.latencies, 99),
+           Percentile(run.latencies, 99.9), static_cast<unsigned long long>(run.stats.hedges),
+           run.stats.requests ? 100.0 * run.stats.hedges / run.stats.requests : 0.0,
+           static_cast<unsigned long long>(run.stats.hedgeWins));
+}
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+    uint32_t budgetPercent = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : HedgePolicy::DEFAULT_BUDGET_PERCENT;
+    double tailPercent = argc > 3 ? atof(argv[3]) : 3.0;
+    if (requests == 0 || budgetPercent == 0 || budgetPercent > 100 || tailPercent < 0 || tailPercent > 100) {
+        fprintf(stderr, "usage: %s [requests] [budgetPercent 1-100] [tailPercent]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%zu requests, %.1f%% tail of 2-6 s, hedge budget %u%%\n", requests, tailPercent, budgetPercent);
+    RunResult off = Run(requests, false, budgetPercent, tailPercent);
+    RunResult on = Run(requests, true, budgetPercent, tailPercent);
+    Report("no hedge", off);
+    Report("hedged", on);
+    printf("threshold settled at %u ms, %llu hedges denied by the budget\n", on.stats.thresholdMs,
+           static_cast<unsigned long long>(on.stats.budgetDenied));
+    return 0;
+}
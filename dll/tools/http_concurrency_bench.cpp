@@ -0,0 +1,729 @@
+// http_concurrency_bench.cpp - Requests in flight, memory and throughput: event loop versus thread per request
+//
+// Usage: http_concurrency_bench [requests] [medianMs] [seed]
+// Linux only (epoll); runs the DLL's AsyncHttpEngine through its epoll
+// transport, next to hand-rolled models of the alternatives. A stand-in proxy on loopback (one epoll thread)
+// answers each POST after the latency named in its body, drawn from a
+// lognormal around medianMs, so the server never limits concurrency. A
+// burst of short chat lines is translated four ways:
+//   serial      one blocking request at a time: the worker thread's model
+//               for queued lines (measured on the first SERIAL_SAMPLE)
+//   threads     a thread per request, up to MAX_IN_FLIGHT at once, each
+//               blocking on its own connection: the chunk helpers' model
+//   event loop  one thread, up to MAX_IN_FLIGHT requests, each on its own
+//               keep-alive connection, in a RequestTable driven by epoll
+//   engine      AsyncHttpEngine: one loop thread, MAX_IN_FLIGHT requests
+//               pipelined over MAX_CONNECTIONS_PER_SERVER connections and
+//               answered in order per connection (HTTP/2 streams on WinHTTP
+//               avoid that head-of-line wait)
+// Prints threads, peak requests in flight, throughput, latency percentiles
+// and resident/virtual memory growth per request in flight, plus what the
+// threads would reserve in the game's 32-bit address space.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../include/async_http.h"
+#include "../include/request_table.h"
+
+using namespace std;
+
+static const size_t MAX_IN_FLIGHT = 64;              // AsyncHttpEngine::MAX_IN_FLIGHT
+static const size_t SERIAL_SAMPLE = 40;
+static const size_t WIN32_STACK_RESERVE = 1 << 20;   // Default thread stack reserve of the game's threads
+
+static double NowMs() {
+    return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void SetNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// Length of the first complete HTTP message in buffer (headers plus
+// Content-Length body), or 0 while it is incomplete
+static size_t CompleteMessage(const string& buffer, size_t& bodyStart, size_t& bodyLength) {
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == string::npos) {
+        return 0;
+    }
+    size_t field = buffer.find("Content-Length: ");
+    bodyLength = (field != string::npos && field < headerEnd) ? strtoul(buffer.c_str() + field + 16, nullptr, 10) : 0;
+    bodyStart = headerEnd + 4;
+    return buffer.size() >= bodyStart + bodyLength ? bodyStart + bodyLength : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Stand-in proxy: answers in request order per connection, each after the
+// "delay" its body asks for
+
+class StandInProxy {
+public:
+    StandInProxy() : listenFd(-1), epollFd(-1), port(0), stop(false) {}
+    ~StandInProxy() { Stop(); }
+
+    bool Start() {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenFd, 4096) != 0 ||
+            getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return false;
+        }
+        port = ntohs(address.sin_port);
+        SetNonBlocking(listenFd);
+
+        epollFd = epoll_create1(0);
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+        loop = thread(&StandInProxy::Run, this);
+        return true;
+    }
+
+    void Stop() {
+        if (loop.joinable()) {
+            stop = true;
+            loop.join();
+        }
+        for (auto& connection : connections) {
+            close(connection.first);
+        }
+        connections.clear();
+        if (epollFd >= 0) {
+            close(epollFd);
+            epollFd = -1;
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+    }
+
+    uint16_t Port() const { return port; }
+
+private:
+    struct Reply {
+        bool ready;
+        string bytes;
+    };
+    struct Connection {
+        string in;
+        string out;
+        uint64_t firstSeq;       // Sequence number of replies.front()
+        deque<Reply> replies;
+    };
+    struct Timer {
+        double dueMs;
+        int fd;
+        uint64_t seq;
+        bool operator>(const Timer& other) const { return dueMs > other.dueMs; }
+    };
+
+    void Run() {
+        epoll_event events[256];
+        while (!stop) {
+            int timeout = 20;
+            if (!timers.empty()) {
+                timeout = max(0, min(timeout, static_cast<int>(ceil(timers.top().dueMs - NowMs()))));
+            }
+            int count = epoll_wait(epollFd, events, 256, timeout);
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    Accept();
+                } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    Drop(fd);
+                } else {
+                    if (events[i].events & EPOLLIN) {
+                        Receive(fd);
+                    }
+                    if (events[i].events & EPOLLOUT) {
+                        Flush(fd);
+                    }
+                }
+            }
+
+            double now = NowMs();
+            while (!timers.empty() && timers.top().dueMs <= now) {
+                Timer timer = timers.top();
+                timers.pop();
+                auto it = connections.find(timer.fd);
+                if (it == connections.end() || timer.seq < it->second.firstSeq) {
+                    continue;
+                }
+                Connection& connection = it->second;
+                connection.replies[timer.seq - connection.firstSeq].ready = true;
+                while (!connection.replies.empty() && connection.replies.front().ready) {
+                    connection.out += connection.replies.front().bytes;
+                    connection.replies.pop_front();
+                    connection.firstSeq++;
+                }
+                Flush(timer.fd);
+            }
+        }
+    }
+
+    void Accept() {
+        int fd;
+        while ((fd = accept(listenFd, nullptr, nullptr)) >= 0) {
+            SetNonBlocking(fd);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            connections[fd] = Connection{ string(), string(), 0, deque<Reply>() };
+        }
+    }
+
+    void Drop(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    }
+
+    void Receive(int fd) {
+        Connection& connection = connections[fd];
+        char buffer[4096];
+        ssize_t received;
+        while ((received = read(fd, buffer, sizeof(buffer))) > 0) {
+            connection.in.append(buffer, received);
+        }
+        if (received == 0) {
+            Drop(fd);
+            return;
+        }
+
+        size_t bodyStart = 0;
+        size_t bodyLength = 0;
+        size_t length;
+        while ((length = CompleteMessage(connection.in, bodyStart, bodyLength)) > 0) {
+            string body = connection.in.substr(bodyStart, bodyLength);
+            connection.in.erase(0, length);
+            size_t field = body.find("\"delay\":");
+            double delayMs = field != string::npos ? atof(body.c_str() + field + 8) : 0.0;
+
+            string answer = "{\"translation\":\"Looking for more for Molten Core, need healers\","
+                            "\"creditsRemaining\":1000}";
+            string reply = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                           to_string(answer.size()) + "\r\n\r\n" + answer;
+            uint64_t seq = connection.firstSeq + connection.replies.size();
+            connection.replies.push_back(Reply{ false, std::move(reply) });
+            timers.push(Timer{ NowMs() + delayMs, fd, seq });
+        }
+    }
+
+    void Flush(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) {
+            return;
+        }
+        string& out = it->second.out;
+        while (!out.empty()) {
+            ssize_t sent = write(fd, out.data(), out.size());
+            if (sent <= 0) {
+                break;
+            }
+            out.erase(0, sent);
+        }
+        epoll_event event = {};
+        event.events = out.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    int listenFd;
+    int epollFd;
+    uint16_t port;
+    atomic<bool> stop;
+    thread loop;
+    map<int, Connection> connections;
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers;
+};
+
+// ---------------------------------------------------------------------------
+// Workload, memory sampling and results
+
+// JSON bodies; the latency the stand-in should answer after rides along
+static vector<string> BuildBodies(size_t count, double medianMs, uint32_t seed) {
+    static const char* const lines[] = {
+        "MC还差治疗，来的密", "收黑莲花，价格好说", "公会招人，活跃玩家优先", "黑翼之巢缺一个坦克",
+        "组ZG，来个萨满", "谁有奥术水晶", "晚上八点集合", "求带哀嚎洞穴",
+    };
+    mt19937 random(seed);
+    lognormal_distribution<double> latency(log(medianMs), 0.5);
+    vector<string> bodies;
+    for (size_t i = 0; i < count; ++i) {
+        bodies.push_back(string("{\"apiKey\":\"WT-bench\",\"text\":\"") + lines[i % 8] +
+                         "\",\"from\":\"zh\",\"to\":\"en\",\"delay\":" + to_string(latency(random)) + "}");
+    }
+    return bodies;
+}
+
+// Whole HTTP messages for the hand-rolled clients
+static vector<string> FrameRequests(const vector<string>& bodies) {
+    vector<string> requests;
+    for (const string& body : bodies) {
+        requests.push_back("POST /api/translate HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\n"
+                           "Content-Length: " + to_string(body.size()) + "\r\n\r\n" + body);
+    }
+    return requests;
+}
+
+// Resident and virtual size (kB) from /proc/self/status
+static void ReadMemory(long& rssKb, long& vmKb) {
+    ifstream status("/proc/self/status");
+    string line;
+    rssKb = vmKb = 0;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            rssKb = atol(line.c_str() + 6);
+        } else if (line.compare(0, 7, "VmSize:") == 0) {
+            vmKb = atol(line.c_str() + 7);
+        }
+    }
+}
+
+// Peak growth over the baseline while a run is going; the baseline is
+// taken once the sampler's own thread exists
+class MemorySampler {
+public:
+    MemorySampler() : running(true), ready(false), peakRssKb(0), peakVmKb(0) {
+        sampler = thread([this]() {
+            // The first read gives this thread its malloc arena
+            ReadMemory(baseRssKb, baseVmKb);
+            ReadMemory(baseRssKb, baseVmKb);
+            ready = true;
+            while (running) {
+                long rss, vm;
+                ReadMemory(rss, vm);
+                peakRssKb = max(peakRssKb.load(), rss - baseRssKb);
+                peakVmKb = max(peakVmKb.load(), vm - baseVmKb);
+                this_thread::sleep_for(chrono::milliseconds(2));
+            }
+        });
+        while (!ready) {
+            this_thread::yield();
+        }
+    }
+    void Finish() {
+        running = false;
+        sampler.join();
+    }
+    long PeakRssKb() const { return peakRssKb; }
+    long PeakVmKb() const { return peakVmKb; }
+
+private:
+    atomic<bool> running;
+    atomic<bool> ready;
+    long baseRssKb;
+    long baseVmKb;
+    atomic<long> peakRssKb;
+    atomic<long> peakVmKb;
+    thread sampler;
+};
+
+struct RunResult {
+    const char* name;
+    size_t threads;          // Besides the caller
+    size_t peakInFlight;
+    size_t connections;
+    size_t requests;
+    size_t failures;
+    double wallMs;
+    vector<double> latencies;
+    long rssKb;
+    long vmKb;
+    size_t tableBytes;
+};
+
+static int Connect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One blocking exchange on fd; false on any socket error
+static bool BlockingExchange(int fd, const string& request) {
+    size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = write(fd, request.data() + sent, request.size() - sent);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    string in;
+    char buffer[RequestTable::READ_BUFFER_BYTES];
+    size_t bodyStart, bodyLength;
+    while (CompleteMessage(in, bodyStart, bodyLength) == 0) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return false;
+        }
+        in.append(buffer, n);
+    }
+    return in.find("\"translation\"") != string::npos;
+}
+
+// ---------------------------------------------------------------------------
+// Client models
+
+static RunResult RunSerial(uint16_t port, const vector<string>& requests) {
+    RunResult result = { "serial (worker)", 1, 1, 1, 0, 0, 0.0, {}, 0, 0, 0 };
+    MemorySampler memory;
+    double start = NowMs();
+    int fd = Connect(port);
+    for (size_t i = 0; i < min(SERIAL_SAMPLE, requests.size()); ++i) {
+        double sentAt = NowMs();
+        if (fd < 0 || !BlockingExchange(fd, requests[i])) {
+            result.failures++;
+        }
+        result.latencies.push_back(NowMs() - sentAt);
+        result.requests++;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    result.wallMs = NowMs() - start;
+    memory.Finish();
+    result.rssKb = memory.PeakRssKb();
+    result.vmKb = memory.PeakVmKb();
+    return result;
+}
+
+static RunResult RunThreads(uint16_t port, const vector<string>& requests) {
+    RunResult result = { "thread per request", 0, 0, 0, requests.size(), 0, 0.0, {}, 0, 0, 0 };
+    result.latencies.resize(requests.size());
+
+    mutex slotMutex;
+    condition_variable slotFree;
+    size_t live = 0;
+    size_t peak = 0;
+    atomic<size_t> failures(0);
+
+    // Detached, so each thread's stack is freed as soon as its request is done
+    MemorySampler memory;
+    double start = NowMs();
+    for (size_t i = 0; i < requests.size(); ++i) {
+        {
+            unique_lock<mutex> lock(slotMutex);
+            slotFree.wait(lock, [&]() { return live < MAX_IN_FLIGHT; });
+            peak = max(peak, ++live);
+        }
+        thread([&, i]() {
+            double sentAt = NowMs();
+            int fd = Connect(port);
+            if (fd < 0 || !BlockingExchange(fd, requests[i])) {
+                failures++;
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+            result.latencies[i] = NowMs() - sentAt;
+            lock_guard<mutex> lock(slotMutex);
+            live--;
+            slotFree.notify_all();
+        }).detach();
+    }
+    {
+        unique_lock<mutex> lock(slotMutex);
+        slotFree.wait(lock, [&]() { return live == 0; });
+    }
+    result.wallMs = NowMs() - start;
+    memory.Finish();
+    result.rssKb = memory.PeakRssKb();
+    result.vmKb = memory.PeakVmKb();
+
+    result.threads = peak;
+    result.peakInFlight = peak;
+    result.connections = peak;
+    result.failures = failures;
+    return result;
+}
+
+// Up to MAX_IN_FLIGHT requests, one per keep-alive connection; epoll
+// events carry the RequestTable id, so a stale event finds nothing
+static RunResult RunEventLoop(uint16_t port, const vector<string>& requests) {
+    RunResult result = { "event loop", 0, 0, 0, requests.size(), 0, 0.0, {}, 0, 0, 0 };
+    result.latencies.resize(requests.size());
+
+    struct Request {
+        size_t index;
+        int fd;
+        size_t sent;
+        string in;
+        double sentAt;
+    };
+
+    RequestTable table(MAX_IN_FLIGHT);
+    vector<int> idle;
+    size_t opened = 0;
+    int epollFd = epoll_create1(0);
+
+    MemorySampler memory;
+    double start = NowMs();
+    size_t next = 0;
+    size_t done = 0;
+    epoll_event events[MAX_IN_FLIGHT];
+    while (done < requests.size()) {
+        while (next < requests.size() && table.InFlight() < table.Capacity()) {
+            int fd;
+            if (!idle.empty()) {
+                fd = idle.back();
+                idle.pop_back();
+            } else {
+                fd = Connect(port);
+                if (fd < 0) {
+                    result.failures++;
+                    done++;
+                    next++;
+                    continue;
+                }
+                SetNonBlocking(fd);
+                opened++;
+            }
+            Request* request = new Request{ next, fd, 0, string(), NowMs() };
+            uint64_t id = table.Acquire(request);
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLOUT;
+            event.data.u64 = id;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            next++;
+        }
+
+        int count = epoll_wait(epollFd, events, MAX_IN_FLIGHT, 1000);
+        for (int i = 0; i < count; ++i) {
+            uint64_t id = events[i].data.u64;
+            Request* request = static_cast<Request*>(table.Find(id));
+            if (!request) {
+                continue;
+            }
+            const string& bytes = requests[request->index];
+            bool failed = (events[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+            if (!failed && (events[i].events & EPOLLOUT) && request->sent < bytes.size()) {
+                ssize_t n = write(request->fd, bytes.data() + request->sent, bytes.size() - request->sent);
+                if (n > 0) {
+                    request->sent += n;
+                }
+                if (request->sent == bytes.size()) {
+                    epoll_event event = {};
+                    event.events = EPOLLIN;
+                    event.data.u64 = id;
+                    epoll_ctl(epollFd, EPOLL_CTL_MOD, request->fd, &event);
+                }
+            }
+
+            bool complete = false;
+            if (!failed && (events[i].events & EPOLLIN)) {
+                char* buffer = table.Buffer(id);
+                ssize_t n;
+                while ((n = read(request->fd, buffer, RequestTable::READ_BUFFER_BYTES)) > 0) {
+                    request->in.append(buffer, n);
+                }
+                failed = n == 0;
+                size_t bodyStart, bodyLength;
+                complete = CompleteMessage(request->in, bodyStart, bodyLength) > 0;
+            }
+
+            if (complete || failed) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, request->fd, nullptr);
+                if (failed) {
+                    close(request->fd);
+                    result.failures++;
+                } else {
+                    idle.push_back(request->fd);
+                }
+                result.latencies[request->index] = NowMs() - request->sentAt;
+                table.Release(id);
+                delete request;
+                done++;
+            }
+        }
+    }
+    result.wallMs = NowMs() - start;
+    memory.Finish();
+    result.rssKb = memory.PeakRssKb();
+    result.vmKb = memory.PeakVmKb();
+
+    result.peakInFlight = table.Peak();
+    result.connections = opened;
+    result.tableBytes = table.BytesAllocated();
+    for (int fd : idle) {
+        close(fd);
+    }
+    close(epollFd);
+    return result;
+}
+
+// The DLL's AsyncHttpEngine (its epoll transport): one loop thread,
+// MAX_IN_FLIGHT requests pipelined over MAX_CONNECTIONS_PER_SERVER
+// connections, each connection's answers in the order its requests went out
+static RunResult RunEngine(uint16_t port, const vector<string>& bodies) {
+    RunResult result = { "engine (pipelined)", 1, 0, AsyncHttpEngine::MAX_CONNECTIONS_PER_SERVER, bodies.size(), 0,
+                         0.0, {}, 0, 0, 0 };
+    result.latencies.resize(bodies.size());
+
+    mutex doneMutex;
+    condition_variable finished;
+    size_t done = 0;
+    size_t failures = 0;
+
+    MemorySampler memory;
+    double start = NowMs();
+    AsyncHttpEngine engine;
+    if (!engine.Start(L"http_concurrency_bench")) {
+        result.failures = bodies.size();
+        memory.Finish();
+        return result;
+    }
+    engine.AddEndpoint("127.0.0.1", port);
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        double sentAt = NowMs();
+        auto completion = [&, i, sentAt](PooledString response, uint32_t) {
+            lock_guard<mutex> lock(doneMutex);
+            result.latencies[i] = NowMs() - sentAt;
+            failures += response.find("\"translation\"") == PooledString::npos ? 1 : 0;
+            done++;
+            finished.notify_all();
+        };
+        // Every slot in use: wait for one to come back
+        while (engine.Submit(0, "/api/translate", bodies[i], false, 0, completion) == 0) {
+            unique_lock<mutex> lock(doneMutex);
+            size_t seen = done;
+            finished.wait_for(lock, chrono::milliseconds(100), [&]() { return done != seen; });
+        }
+    }
+    {
+        unique_lock<mutex> lock(doneMutex);
+        finished.wait(lock, [&]() { return done == bodies.size(); });
+    }
+    result.wallMs = NowMs() - start;
+    AsyncHttpStats stats = engine.GetStats();
+    engine.Stop();
+    memory.Finish();
+    result.rssKb = memory.PeakRssKb();
+    result.vmKb = memory.PeakVmKb();
+
+    result.peakInFlight = stats.peakInFlight;
+    result.tableBytes = stats.tableBytes;
+    result.failures = failures;
+    return result;
+}
+
+static double Percentile(vector<double> values, double percentile) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+static void PrintResult(const RunResult& result) {
+    double perRequest = static_cast<double>(max<size_t>(result.peakInFlight, 1));
+    printf("%-20s %7zu %9zu %6zu %9.0f %8.0fms %8.0fms %9.1f %9.1f%s\n", result.name, result.threads,
+           result.peakInFlight, result.connections, result.requests * 1000.0 / result.wallMs,
+           Percentile(result.latencies, 50), Percentile(result.latencies, 95), result.rssKb / perRequest,
+           result.vmKb / perRequest, result.failures ? "  FAILURES" : "");
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+    double medianMs = argc > 2 ? atof(argv[2]) : 200.0;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 42;
+    if (count == 0 || count > 100000 || medianMs <= 0.0 || medianMs > 5000.0) {
+        fprintf(stderr, "usage: %s [requests 1-100000] [medianMs 1-5000] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    StandInProxy proxy;
+    if (!proxy.Start()) {
+        fprintf(stderr, "stand-in proxy could not listen on loopback\n");
+        return 1;
+    }
+    vector<string> bodies = BuildBodies(count, medianMs, seed);
+    vector<string> requests = FrameRequests(bodies);
+    printf("%zu requests, proxy latency median %.0f ms (lognormal), at most %zu in flight\n\n", count, medianMs,
+           MAX_IN_FLIGHT);
+
+    // One exchange first, so the stand-in's own allocations are not charged to the serial run
+    int warmUp = Connect(proxy.Port());
+    if (warmUp < 0 || !BlockingExchange(warmUp, requests[0])) {
+        fprintf(stderr, "stand-in proxy did not answer\n");
+        return 1;
+    }
+    close(warmUp);
+
+    // The event-driven clients run first: glibc keeps freed thread stacks,
+    // which would hide their memory growth behind the threads' run
+    vector<RunResult> results;
+    results.push_back(RunSerial(proxy.Port(), requests));
+    results.push_back(RunEventLoop(proxy.Port(), requests));
+    results.push_back(RunEngine(proxy.Port(), bodies));
+    results.push_back(RunThreads(proxy.Port(), requests));
+    proxy.Stop();
+
+    printf("%-20s %7s %9s %6s %9s %10s %10s %9s %9s\n", "", "threads", "in flight", "conns", "req/s", "p50",
+           "p95", "RSS kB/rq", "VM kB/rq");
+    bool failed = false;
+    for (const RunResult& result : results) {
+        PrintResult(result);
+        failed = failed || result.failures > 0;
+    }
+
+    const RunResult& eventLoop = results[1];
+    const RunResult& engine = results[2];
+    const RunResult& threads = results[3];
+    printf("\nevent loop: %.1f x the serial worker's throughput; request table %zu bytes for %zu slots "
+           "(%.0f bytes per request in flight)\n",
+           (eventLoop.requests * 1000.0 / eventLoop.wallMs) / (results[0].requests * 1000.0 / results[0].wallMs),
+           eventLoop.tableBytes, MAX_IN_FLIGHT, static_cast<double>(eventLoop.tableBytes) / MAX_IN_FLIGHT);
+    printf("engine: %.1f x the serial worker's throughput on %zu connections\n",
+           (engine.requests * 1000.0 / engine.wallMs) / (results[0].requests * 1000.0 / results[0].wallMs),
+           engine.connections);
+    printf("32-bit game process: %zu threads reserve %zu MB of its 2 GB address space for stacks; "
+           "the engine's slots need %.0f kB\n",
+           threads.threads, threads.threads * WIN32_STACK_RESERVE >> 20, eventLoop.tableBytes / 1024.0);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+// language_id_accuracy.cpp - Accuracy and cost of IdentifyLanguage on a labeled chat sample
+//
+// Usage: language_id_accuracy <sample.tsv> [minConfidence]
+// The sample holds "language<TAB>kind<TAB>text" per line ('#' lines are
+// comments); language is the code IdentifyLanguage should return, "und"
+// when it should decline, and kind groups lines for the breakdown (script,
+// pinyin, romanized, mixed). tools/data/language_id_sample.tsv is such a
+// sample, written apart from the trigram and Han marker tables. Each line
+// is classified the way ResolveAutoSource does it: a guess under
+// minConfidence counts as undetermined. Prints accuracy per language and
+// kind, the lines undetermined and the lines misrouted (accepted with the
+// wrong code, which sends the proxy a wrong source), every miss, and the
+// time per line.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../include/language_id.h"
+
+using namespace std;
+
+static const float DEFAULT_MIN_CONFIDENCE = 0.3f;   // TranslationClient::MIN_AUTO_CONFIDENCE
+static const char* const UNDETERMINED = "und";
+
+struct LabeledLine {
+    string language;
+    string kind;
+    string text;
+};
+
+static bool LoadSample(const char* path, vector<LabeledLine>& lines) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first = line.find('\t');
+        size_t second = first == string::npos ? string::npos : line.find('\t', first + 1);
+        if (second == string::npos) {
+            continue;
+        }
+        lines.push_back(LabeledLine{ line.substr(0, first), line.substr(first + 1, second - first - 1),
+                                     line.substr(second + 1) });
+    }
+    return true;
+}
+
+static string Classify(const string& text, float minConfidence, float& confidence) {
+    LanguageGuess guess = IdentifyLanguage(text);
+    confidence = guess.confidence;
+    if (guess.language.empty() || guess.confidence < minConfidence) {
+        return UNDETERMINED;
+    }
+    return string(guess.language);
+}
+
+struct Tally {
+    int lines = 0;
+    int correct = 0;
+    int undetermined = 0;   // Labeled with a language, declined
+    int misrouted = 0;      // Accepted with the wrong code
+};
+
+static void Count(Tally& tally, const string& label, const string& guess) {
+    ++tally.lines;
+    if (guess == label) {
+        ++tally.correct;
+    } else if (guess == UNDETERMINED) {
+        ++tally.undetermined;
+    } else {
+        ++tally.misrouted;
+    }
+}
+
+static void PrintTally(const string& name, const Tally& tally) {
+    printf("%-14s %6d %8.1f%% %8d %10d\n", name.c_str(), tally.lines, 100.0 * tally.correct / tally.lines,
+           tally.undetermined, tally.misrouted);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: language_id_accuracy <sample.tsv> [minConfidence]\n");
+        return 1;
+    }
+    float minConfidence = argc > 2 ? static_cast<float>(atof(argv[2])) : DEFAULT_MIN_CONFIDENCE;
+
+    vector<LabeledLine> lines;
+    if (!LoadSample(argv[1], lines) || lines.empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    map<string, Tally> byLanguage;
+    map<string, Tally> byKind;
+    Tally total;
+    vector<string> misses;
+    for (const LabeledLine& line : lines) {
+        float confidence = 0.0f;
+        string guess = Classify(line.text, minConfidence, confidence);
+        Count(byLanguage[line.language], line.language, guess);
+        Count(byKind[line.language + "/" + line.kind], line.language, guess);
+        Count(total, line.language, guess);
+        if (guess != line.language) {
+            char miss[512];
+            snprintf(miss, sizeof(miss), "  %-3s -> %-3s %.2f  %s", line.language.c_str(), guess.c_str(),
+                     confidence, line.text.c_str());
+            misses.push_back(miss);
+        }
+    }
+
+    printf("%zu lines, minimum confidence %.2f\n\n", lines.size(), minConfidence);
+    printf("%-14s %6s %9s %8s %10s\n", "language", "lines", "correct", "und", "misrouted");
+    for (const auto& entry : byLanguage) {
+        PrintTally(entry.first, entry.second);
+    }
+    PrintTally("all", total);
+    printf("\n%-14s %6s %9s %8s %10s\n", "kind", "lines", "correct", "und", "misrouted");
+    for (const auto& entry : byKind) {
+        PrintTally(entry.first, entry.second);
+    }
+
+    printf("\nmisses (label -> result, confidence):\n");
+    for (const string& miss : misses) {
+        printf("%s\n", miss.c_str());
+    }
+
+    // Cost per line; the volatile sum keeps the calls from being folded away
+    const int rounds = 200;
+    volatile float sink = 0.0f;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (const LabeledLine& line : lines) {
+            sink = sink + IdentifyLanguage(line.text).confidence;
+        }
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("\n%.0f ns per line\n", ns / rounds / lines.size());
+    return 0;
+}
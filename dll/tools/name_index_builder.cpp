@@ -0,0 +1,278 @@
+// name_index_builder.cpp - Compiles an item/quest name TSV into the mapped .wtni format
+//
+// Usage: name_index_builder <input.tsv> <output.wtni> [benchLookups]
+// Each non-empty line is "item|quest<TAB>id<TAB>englishName<TAB>chineseName";
+// either name may be empty, lines starting with '#' are comments and the
+// first line for an ID wins. After writing, the file is mapped back through
+// the DLL's reader and lookups are timed (benchLookups, default 1000000;
+// 0 skips the benchmark).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../include/name_index.h"
+#include "../include/name_index_format.h"
+
+using namespace std;
+
+static const size_t MAX_NAME_BYTES = 0xFFFF;
+
+struct Names {
+    string name[NAME_LANGUAGE_COUNT];
+};
+
+static bool WriteBytes(FILE* out, const void* data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, out) == size;
+}
+
+static bool SplitFields(const string& line, vector<string>& fields) {
+    fields.clear();
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == string::npos ? string::npos : tab - start));
+        if (tab == string::npos) {
+            break;
+        }
+        start = tab + 1;
+    }
+    return fields.size() == 4;
+}
+
+// Deterministic LCG so runs are comparable
+static uint32_t NextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static void Benchmark(const char* path, const map<uint32_t, Names> (&tables)[NAME_KIND_COUNT], size_t lookups) {
+    NameIndex index;
+    if (!index.Open(path)) {
+        fprintf(stderr, "cannot map %s back\n", path);
+        return;
+    }
+
+    vector<uint32_t> ids[NAME_KIND_COUNT];
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        for (const auto& entry : tables[kind]) {
+            ids[kind].push_back(entry.first);
+        }
+    }
+
+    // Verify every name survives the round trip before timing anything
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        for (const auto& entry : tables[kind]) {
+            for (uint32_t language = 0; language < NAME_LANGUAGE_COUNT; ++language) {
+                string_view name;
+                bool found = index.Lookup(static_cast<NameKind>(kind), entry.first,
+                                          static_cast<NameLanguage>(language), name);
+                if (found != !entry.second.name[language].empty() ||
+                    (found && name != entry.second.name[language])) {
+                    fprintf(stderr, "round trip mismatch for %s %u\n", kind == NAME_KIND_ITEM ? "item" : "quest",
+                            entry.first);
+                    return;
+                }
+            }
+        }
+    }
+
+    // Half the probes are known IDs, half random ones (mostly misses), as a
+    // busy trade channel mixes indexed items with custom-server additions
+    uint32_t state = 12345;
+    vector<pair<NameKind, uint32_t>> probes(lookups);
+    for (auto& probe : probes) {
+        NameKind kind = (NextRandom(state) % 4 == 0) ? NAME_KIND_QUEST : NAME_KIND_ITEM;
+        if (ids[kind].empty()) {
+            kind = kind == NAME_KIND_ITEM ? NAME_KIND_QUEST : NAME_KIND_ITEM;
+        }
+        uint32_t id = (NextRandom(state) % 2 == 0) ? ids[kind][NextRandom(state) % ids[kind].size()]
+                                                    : NextRandom(state) % 100000;
+        probe = make_pair(kind, id);
+    }
+
+    size_t found = 0;
+    size_t bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for (const auto& probe : probes) {
+        string_view name;
+        if (index.Lookup(probe.first, probe.second, NAME_LANGUAGE_EN, name)) {
+            ++found;
+            bytes += name.size();
+        }
+    }
+    double mappedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+
+    // Baseline: the same table as a heap hash map built at load time
+    auto loadStart = chrono::steady_clock::now();
+    unordered_map<uint64_t, string> heap;
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        for (const auto& entry : tables[kind]) {
+            heap.emplace((uint64_t(kind) << 32) | entry.first, entry.second.name[NAME_LANGUAGE_EN]);
+        }
+    }
+    double heapLoadUs = chrono::duration<double, micro>(chrono::steady_clock::now() - loadStart).count();
+
+    size_t heapFound = 0;
+    size_t heapBytes = 0;
+    start = chrono::steady_clock::now();
+    for (const auto& probe : probes) {
+        auto it = heap.find((uint64_t(probe.first) << 32) | probe.second);
+        if (it != heap.end() && !it->second.empty()) {
+            ++heapFound;
+            heapBytes += it->second.size();
+        }
+    }
+    double heapNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+
+    NameIndexStats stats = index.GetStats();
+    printf("benchmark: %zu lookups, %zu found (%zu name bytes)\n", lookups, found, bytes);
+    printf("  mapped index: open %llu us, %.1f ns/lookup\n",
+           static_cast<unsigned long long>(stats.openMicros), mappedNs);
+    printf("  heap hash map: load %.0f us, %.1f ns/lookup%s\n", heapLoadUs, heapNs,
+           heapFound == found && heapBytes == bytes ? "" : " (MISMATCH)");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <input.tsv> <output.wtni> [benchLookups]\n", argv[0]);
+        return 1;
+    }
+    size_t benchLookups = argc >= 4 ? static_cast<size_t>(strtoul(argv[3], nullptr, 10)) : 1000000;
+
+    ifstream input(argv[1], ios::binary);
+    if (!input) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    map<uint32_t, Names> tables[NAME_KIND_COUNT];
+    string line;
+    vector<string> fields;
+    size_t lineNumber = 0;
+    size_t duplicates = 0;
+    while (getline(input, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        char* idEnd = nullptr;
+        unsigned long id = 0;
+        if (SplitFields(line, fields)) {
+            id = strtoul(fields[1].c_str(), &idEnd, 10);
+        }
+        NameKind kind = fields[0] == "quest" ? NAME_KIND_QUEST : NAME_KIND_ITEM;
+        if (fields.size() != 4 || (fields[0] != "item" && fields[0] != "quest") || fields[1].empty() ||
+            *idEnd != '\0' || id == 0 || id > 0xFFFFFFFFul ||
+            fields[2].size() > MAX_NAME_BYTES || fields[3].size() > MAX_NAME_BYTES) {
+            fprintf(stderr, "%s:%zu: expected item|quest<TAB>id<TAB>english<TAB>chinese\n", argv[1], lineNumber);
+            continue;
+        }
+
+        Names names;
+        names.name[NAME_LANGUAGE_EN] = fields[2];
+        names.name[NAME_LANGUAGE_ZH] = fields[3];
+        if (!tables[kind].emplace(static_cast<uint32_t>(id), std::move(names)).second) {
+            ++duplicates;
+        }
+    }
+
+    if (tables[NAME_KIND_ITEM].empty() && tables[NAME_KIND_QUEST].empty()) {
+        fprintf(stderr, "no names in %s\n", argv[1]);
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    // Entries in ID order (map is sorted), items then quests; identical
+    // names (quest chains, item variants) share one copy in the string block
+    string stringBlock;
+    unordered_map<string, uint32_t> stringOffsets;
+    vector<NameIndexEntry> entries;
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        for (const auto& item : tables[kind]) {
+            NameIndexEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.id = item.first;
+            for (uint32_t language = 0; language < NAME_LANGUAGE_COUNT; ++language) {
+                const string& name = item.second.name[language];
+                if (name.empty()) {
+                    continue;
+                }
+                auto inserted = stringOffsets.emplace(name, static_cast<uint32_t>(stringBlock.size()));
+                if (inserted.second) {
+                    stringBlock += name;
+                }
+                entry.nameOffset[language] = inserted.first->second;
+                entry.nameLength[language] = static_cast<uint16_t>(name.size());
+            }
+            entries.push_back(entry);
+        }
+    }
+
+    // Page tables: pages[p] is the first entry with id >> shift >= p
+    vector<uint32_t> pageBlock;
+    uint32_t pageCounts[NAME_KIND_COUNT];
+    for (uint32_t kind = 0; kind < NAME_KIND_COUNT; ++kind) {
+        uint32_t maxId = tables[kind].empty() ? 0 : tables[kind].rbegin()->first;
+        pageCounts[kind] = tables[kind].empty() ? 0 : (maxId >> NAME_INDEX_PAGE_SHIFT) + 1;
+        uint32_t index = 0;
+        auto it = tables[kind].begin();
+        for (uint32_t page = 0; page <= pageCounts[kind]; ++page) {
+            while (it != tables[kind].end() && (it->first >> NAME_INDEX_PAGE_SHIFT) < page) {
+                ++it;
+                ++index;
+            }
+            pageBlock.push_back(index);
+        }
+    }
+
+    NameIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, NAME_INDEX_MAGIC, sizeof(header.magic));
+    header.version = NAME_INDEX_VERSION;
+    header.itemCount = static_cast<uint32_t>(tables[NAME_KIND_ITEM].size());
+    header.questCount = static_cast<uint32_t>(tables[NAME_KIND_QUEST].size());
+    header.pageShift = NAME_INDEX_PAGE_SHIFT;
+    header.itemPageCount = pageCounts[NAME_KIND_ITEM];
+    header.questPageCount = pageCounts[NAME_KIND_QUEST];
+    header.pageOffset = sizeof(NameIndexHeader);
+    header.entryOffset = header.pageOffset + static_cast<uint32_t>(pageBlock.size() * sizeof(uint32_t));
+    header.stringOffset = header.entryOffset + static_cast<uint32_t>(entries.size() * sizeof(NameIndexEntry));
+    header.stringBytes = static_cast<uint32_t>(stringBlock.size());
+
+    FILE* out = fopen(argv[2], "wb");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    bool ok = WriteBytes(out, &header, sizeof(header)) &&
+              WriteBytes(out, pageBlock.data(), pageBlock.size() * sizeof(uint32_t)) &&
+              WriteBytes(out, entries.data(), entries.size() * sizeof(NameIndexEntry)) &&
+              WriteBytes(out, stringBlock.data(), stringBlock.size());
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "write to %s failed\n", argv[2]);
+        return 1;
+    }
+
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    printf("%u items, %u quests (%zu duplicates skipped), %.1f ms, %u bytes -> %s\n",
+           header.itemCount, header.questCount, duplicates, buildMs,
+           header.stringOffset + header.stringBytes, argv[2]);
+
+    if (benchLookups > 0) {
+        Benchmark(argv[2], tables, benchLookups);
+    }
+    return 0;
+}
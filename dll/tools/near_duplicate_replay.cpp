@@ -0,0 +1,162 @@
+// near_duplicate_replay.cpp - Precision, recall and cost of near-duplicate reuse on a labeled channel log
+//
+// Usage: near_duplicate_replay <channel.tsv> [indexEntries]
+// The log holds "seconds<TAB>group<TAB>text" per line ('#' lines are
+// comments); lines sharing a group are variants of one advert or request,
+// so reusing a translation within a group is right and across groups is
+// wrong (tools/data/channel_sample.tsv is such a log). Each message takes
+// TranslateText's path: the exact cache on the normalized key, then the
+// NearDuplicateIndex, then the proxy, whose answer is cached and indexed.
+// The stand-in translation is the message's group, so every near-duplicate
+// answer can be checked. Replays once per SimHash threshold and prints
+// proxy requests, near-duplicate hits, precision (hits from the right
+// group) and recall (hits out of the misses an earlier variant could have
+// answered), then the index's scan cost.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../include/near_duplicate.h"
+#include "../include/scheduling_policy.h"
+#include "../include/text_normalize.h"
+#include "../include/translation_cache.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+static const size_t DEFAULT_INDEX_ENTRIES = 512;   // TranslationClient::MAX_NEAR_DUPLICATE_SIZE
+static const int DEFAULT_THRESHOLD = 8;            // TranslationClient::DEFAULT_NEAR_DUPLICATE_THRESHOLD
+
+struct LoggedMessage {
+    uint32_t timeMs;
+    string group;
+    string text;
+};
+
+static bool LoadLog(const char* path, vector<LoggedMessage>& messages) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first = line.find('\t');
+        size_t second = first == string::npos ? string::npos : line.find('\t', first + 1);
+        if (second == string::npos) {
+            continue;
+        }
+        uint32_t timeMs = static_cast<uint32_t>(atof(line.c_str()) * 1000.0);
+        messages.push_back(LoggedMessage{ timeMs, line.substr(first + 1, second - first - 1), line.substr(second + 1) });
+    }
+    return true;
+}
+
+struct Outcome {
+    uint64_t proxyRequests;
+    uint64_t exactHits;
+    uint64_t nearHits;
+    uint64_t nearCorrect;
+    uint64_t reusable;       // Exact misses an earlier variant in the index could have answered
+    NearDuplicateStats index;
+};
+
+static Outcome Replay(const vector<LoggedMessage>& messages, int threshold, size_t indexEntries) {
+    TranslationCache cache(SchedulingPolicy::DEFAULT_CACHE_ENTRIES, SchedulingPolicy::DEFAULT_CACHE_EXPIRY_MS);
+    NearDuplicateIndex index(indexEntries);
+    set<string> indexedGroups;
+    Outcome outcome = {};
+
+    for (const LoggedMessage& message : messages) {
+        string key = NormalizeForCache(message.text);
+        PooledString translation;
+        cache.CleanExpired(message.timeMs);
+        if (cache.Lookup(key, DEFAULT_LANGUAGE_PAIR, message.timeMs, translation)) {
+            ++outcome.exactHits;
+            continue;
+        }
+
+        if (CountCodepoints(key) >= NearDuplicateIndex::MIN_CHARS && indexedGroups.count(message.group)) {
+            ++outcome.reusable;
+        }
+        int distance = 0;
+        if (threshold >= 0 && index.FindNearest(key, DEFAULT_LANGUAGE_PAIR, threshold, translation, distance)) {
+            ++outcome.nearHits;
+            if (string_view(translation) == message.group) {
+                ++outcome.nearCorrect;
+            }
+            continue;
+        }
+
+        ++outcome.proxyRequests;
+        cache.Insert(key, DEFAULT_LANGUAGE_PAIR, message.group, message.timeMs);
+        index.Insert(key, DEFAULT_LANGUAGE_PAIR, message.group);
+        if (CountCodepoints(key) >= NearDuplicateIndex::MIN_CHARS) {
+            indexedGroups.insert(message.group);
+        }
+    }
+    outcome.index = index.GetStats();
+    return outcome;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: near_duplicate_replay <channel.tsv> [indexEntries]\n");
+        return 1;
+    }
+    size_t indexEntries = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : DEFAULT_INDEX_ENTRIES;
+
+    vector<LoggedMessage> messages;
+    if (!LoadLog(argv[1], messages) || messages.empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    set<string> groups;
+    for (const LoggedMessage& message : messages) {
+        groups.insert(message.group);
+    }
+    printf("%zu messages in %zu groups, %.1f h, index of %zu entries\n\n", messages.size(), groups.size(),
+           messages.back().timeMs / 3600000.0, indexEntries);
+
+    Outcome off = Replay(messages, -1, indexEntries);
+    printf("%-10s %8s %8s %8s %10s %8s\n", "threshold", "proxy", "exact", "near", "precision", "recall");
+    printf("%-10s %8llu %8llu %8s %10s %8s\n", "off", static_cast<unsigned long long>(off.proxyRequests),
+           static_cast<unsigned long long>(off.exactHits), "-", "-", "-");
+    for (int threshold = 0; threshold <= 16; threshold += 2) {
+        Outcome outcome = Replay(messages, threshold, indexEntries);
+        char name[16];
+        snprintf(name, sizeof(name), "%d bits%s", threshold, threshold == DEFAULT_THRESHOLD ? "*" : "");
+        printf("%-10s %8llu %8llu %8llu %9.1f%% %7.1f%%\n", name,
+               static_cast<unsigned long long>(outcome.proxyRequests),
+               static_cast<unsigned long long>(outcome.exactHits), static_cast<unsigned long long>(outcome.nearHits),
+               outcome.nearHits ? 100.0 * outcome.nearCorrect / outcome.nearHits : 100.0,
+               outcome.reusable ? 100.0 * outcome.nearCorrect / outcome.reusable : 0.0);
+    }
+    printf("(* the DLL's default)\n\n");
+
+    // Cost per lookup with a full index, and the whole path per message
+    Outcome outcome = Replay(messages, DEFAULT_THRESHOLD, indexEntries);
+    const int rounds = 20;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        Replay(messages, DEFAULT_THRESHOLD, indexEntries);
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("index: %zu entries after the replay, %llu lookups, %.0f ns per lookup (fingerprint and scan)\n",
+           outcome.index.entries, static_cast<unsigned long long>(outcome.index.queries),
+           outcome.index.queries ? static_cast<double>(outcome.index.scanNanos) / outcome.index.queries : 0.0);
+    printf("replay: %.2f us per message (normalize, cache, near-duplicate, insert), %.0f messages/s\n",
+           ns / rounds / messages.size() / 1000.0, rounds * messages.size() / (ns / 1e9));
+    return 0;
+}
@@ -0,0 +1,183 @@
+// offline_engine_bench.cpp - Coverage, throughput and memory of the offline gloss engine on a channel log
+//
+// Usage: offline_engine_bench <channel.tsv> [dictionary.tsv] [rounds]
+// The log holds "seconds<TAB>group<TAB>text" per line ('#' lines are
+// comments), as tools/data/channel_sample.tsv does. Every line goes through
+// OfflineEngine::Gloss the way TranslateOffline calls it: as a fallback any
+// gloss is used, as a first pass only lines of at most
+// DEFAULT_OFFLINE_FIRST_PASS_CHARS codepoints the dictionary fully covers.
+// Prints the lines each mode would answer, a few glosses, glosses per second
+// and the engine's memory (live heap bytes counted by a replaced operator
+// new, and the engine's own estimate). With a dictionary file
+// (word<TAB>gloss, as WoWTranslate_dictionary.tsv) the built-in glossary is
+// measured first, then again with the file loaded.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../include/offline_engine.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+static const size_t FIRST_PASS_CHARS = 8;   // TranslationClient::DEFAULT_OFFLINE_FIRST_PASS_CHARS
+static const int SAMPLE_GLOSSES = 6;
+
+// ============================================================================
+// Live heap bytes: every allocation carries its size in a header
+// ============================================================================
+
+static size_t g_liveBytes = 0;
+static const size_t HEADER_BYTES = alignof(max_align_t);
+
+void* operator new(size_t size) {
+    void* block = malloc(size + HEADER_BYTES);
+    if (!block) {
+        throw bad_alloc();
+    }
+    *static_cast<size_t*>(block) = size;
+    g_liveBytes += size;
+    return static_cast<char*>(block) + HEADER_BYTES;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    void* block = static_cast<char*>(ptr) - HEADER_BYTES;
+    g_liveBytes -= *static_cast<size_t*>(block);
+    free(block);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// ============================================================================
+
+static bool LoadTexts(const char* path, vector<string>& texts) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first = line.find('\t');
+        size_t second = first == string::npos ? string::npos : line.find('\t', first + 1);
+        if (second == string::npos) {
+            continue;
+        }
+        texts.push_back(line.substr(second + 1));
+    }
+    return true;
+}
+
+static bool HasCjk(string_view text) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (IsCjkCodepoint(NextCodepoint(text, pos))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void Measure(const char* name, OfflineEngine& engine, size_t liveBytes, const vector<string>& texts,
+                    int rounds) {
+    size_t glossed = 0, covered = 0, firstPass = 0;
+    int shown = 0;
+    for (const string& text : texts) {
+        string gloss;
+        bool fullCoverage = false;
+        if (!engine.Gloss(text, gloss, fullCoverage)) {
+            continue;
+        }
+        ++glossed;
+        covered += fullCoverage;
+        if (fullCoverage && CountCodepoints(text) <= FIRST_PASS_CHARS) {
+            ++firstPass;
+        }
+        if (shown < SAMPLE_GLOSSES && HasCjk(text)) {
+            printf("  %s\n    ~ %s\n", text.c_str(), gloss.c_str());
+            ++shown;
+        }
+    }
+
+    volatile size_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const string& text : texts) {
+            string gloss;
+            bool fullCoverage = false;
+            sink = sink + engine.Gloss(text, gloss, fullCoverage);
+        }
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    size_t calls = static_cast<size_t>(rounds) * texts.size();
+
+    OfflineEngineStats stats = engine.GetStats();
+    printf("%s: %zu entries, %.1f kB live heap (%.1f kB estimated by the engine)\n", name, stats.entries,
+           liveBytes / 1024.0, stats.approximateBytes / 1024.0);
+    printf("  fallback answers %zu of %zu lines (%.1f%%), %zu fully covered\n", glossed, texts.size(),
+           100.0 * glossed / texts.size(), covered);
+    printf("  first pass (<= %zu chars, fully covered) answers %zu lines (%.1f%%)\n", FIRST_PASS_CHARS,
+           firstPass, 100.0 * firstPass / texts.size());
+    printf("  %.0f ns per line, %.0f glosses/s\n\n", ns / calls, calls / (ns / 1e9));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: offline_engine_bench <channel.tsv> [dictionary.tsv] [rounds]\n");
+        return 1;
+    }
+    const char* dictionary = argc > 2 ? argv[2] : nullptr;
+    int rounds = argc > 3 ? atoi(argv[3]) : 200;
+
+    vector<string> texts;
+    if (!LoadTexts(argv[1], texts) || texts.empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    printf("%zu lines\n\n", texts.size());
+
+    size_t baseBytes = g_liveBytes;
+    OfflineEngine engine;
+    size_t engineBytes = sizeof(OfflineEngine) + g_liveBytes - baseBytes;
+    Measure("built-in glossary", engine, engineBytes, texts, rounds);
+
+    if (dictionary) {
+        baseBytes = g_liveBytes;
+        int added = engine.LoadDictionary(dictionary);
+        if (added < 0) {
+            fprintf(stderr, "Cannot read %s\n", dictionary);
+            return 1;
+        }
+        printf("loaded %d entries from %s\n", added, dictionary);
+        engineBytes += g_liveBytes - baseBytes;
+        Measure("with dictionary", engine, engineBytes, texts, rounds);
+    }
+    return 0;
+}
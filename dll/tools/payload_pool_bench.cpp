@@ -0,0 +1,212 @@
+// payload_pool_bench.cpp - Counts heap allocations per message, std::string vs PooledString
+//
+// Usage: payload_pool_bench [messages] [threads]
+// Replays one message's payload lifecycle the way the DLL handles it: the
+// request id and text copies, language codes, the JSON request body, a
+// response read in 512-byte pieces, the parsed translation and the result
+// copies handed to PollResult. Every operator new in the process is counted,
+// so the std::string run shows what the CRT heap sees per message and the
+// PooledString run what is left once payloads come from the pool. Then runs
+// both on several threads at once, first with each thread freeing its own
+// payloads, then with results built on workers and freed by one consumer
+// thread (the worker -> PollResult hand-off), where the pool's thread
+// caches have to pass blocks back.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/payload_pool.h"
+
+using namespace std;
+
+static atomic<uint64_t> g_heapAllocations(0);
+
+void* operator new(size_t bytes) {
+    g_heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (void* ptr = malloc(bytes ? bytes : 1)) {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+static const char* const CHAT_LINES[] = {
+    "有人去黑石深渊吗？缺一个治疗",
+    "LF2M for Scholomance, need tank and healer, PST",
+    "收购奥金锭，价格好说，私聊",
+    "公会招人，周末开MC和BWL，要求60级，装备不限，有语音，活动时间晚上八点到十一点，欢迎新老玩家加入我们",
+    "wts [Arcanite Bar] 8g each, bulk discount",
+    "谢谢",
+};
+static const size_t CHAT_LINE_COUNT = sizeof(CHAT_LINES) / sizeof(CHAT_LINES[0]);
+
+// One message from translate_async to the addon; returns the result strings
+template <typename Str>
+struct Result {
+    Str requestId;
+    Str translation;
+    Str error;
+};
+
+template <typename Str>
+static Result<Str> RunMessage(uint32_t sequence) {
+    Str requestId("incoming_");
+    requestId += to_string(sequence).c_str();
+    Str text(CHAT_LINES[sequence % CHAT_LINE_COUNT]);
+    Str source("zh");
+    Str target("en");
+
+    Str body("{\"apiKey\":\"WT-0123456789abcdef\",\"text\":\"");
+    body += text;
+    body += "\",\"from\":\"";
+    body += source;
+    body += "\",\"to\":\"";
+    body += target;
+    body += "\"}";
+
+    // The proxy's answer arrives in pieces
+    Str wire("{\"translation\":\"");
+    for (size_t i = 0; i < text.size(); ++i) {
+        wire += "ab";
+    }
+    wire += "\",\"creditsRemaining\":12345}";
+    Str response;
+    for (size_t offset = 0; offset < wire.size(); offset += 512) {
+        response += Str(wire.data() + offset, min<size_t>(512, wire.size() - offset));
+    }
+
+    size_t start = response.find(":\"") + 2;
+    Str translation = response.substr(start, response.find('"', start) - start);
+
+    Result<Str> result;
+    result.requestId = requestId;
+    result.translation = translation;
+    return result;
+}
+
+template <typename Str>
+static void CountAllocations(const char* name, uint32_t messages) {
+    RunMessage<Str>(0);   // Warm the pool's caches
+    uint64_t before = g_heapAllocations.load();
+    auto start = chrono::steady_clock::now();
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < messages; ++i) {
+        Result<Str> result = RunMessage<Str>(i);
+        bytes += result.translation.size();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    uint64_t allocations = g_heapAllocations.load() - before;
+    printf("  %-13s %8.2f heap allocations/message %9.0f ns/message  (%zu bytes out)\n", name,
+           static_cast<double>(allocations) / messages, ns / messages, bytes);
+}
+
+// Every thread builds and frees its own payloads
+template <typename Str>
+static double RunSameThread(uint32_t messages, uint32_t threads) {
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            for (uint32_t i = 0; i < messages / threads; ++i) {
+                RunMessage<Str>(i + t);
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Workers build results, one consumer frees them, as PollResult does
+template <typename Str>
+static double RunHandOff(uint32_t messages, uint32_t threads) {
+    mutex queueMutex;
+    condition_variable queueChanged;
+    deque<Result<Str>> results;
+    uint32_t workersDone = 0;
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (uint32_t i = 0; i < messages / threads; ++i) {
+                Result<Str> result = RunMessage<Str>(i + t);
+                lock_guard<mutex> lock(queueMutex);
+                results.push_back(std::move(result));
+                queueChanged.notify_one();
+            }
+            lock_guard<mutex> lock(queueMutex);
+            ++workersDone;
+            queueChanged.notify_one();
+        });
+    }
+
+    uint64_t consumed = 0;
+    unique_lock<mutex> lock(queueMutex);
+    while (workersDone < threads || !results.empty()) {
+        if (results.empty()) {
+            queueChanged.wait(lock);
+            continue;
+        }
+        Result<Str> result = std::move(results.front());
+        results.pop_front();
+        bool drained = results.empty();
+        lock.unlock();
+        consumed += result.translation.size();
+        if (drained) {
+            PayloadPool::ReleaseThreadCache();
+        }
+        lock.lock();
+    }
+    lock.unlock();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return consumed ? chrono::duration<double>(chrono::steady_clock::now() - start).count() : 0.0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t messages = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200000;
+    uint32_t threads = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 4;
+    if (messages == 0 || threads == 0) {
+        fprintf(stderr, "Usage: payload_pool_bench [messages] [threads]\n");
+        return 1;
+    }
+
+    printf("%u messages, single thread\n", messages);
+    CountAllocations<string>("std::string", messages);
+    CountAllocations<PooledString>("PooledString", messages);
+
+    printf("\n%-26s %14s %14s\n", "messages/s", "std::string", "PooledString");
+    printf("%-26s %14.0f %14.0f\n", "1 thread", messages / RunSameThread<string>(messages, 1),
+           messages / RunSameThread<PooledString>(messages, 1));
+    printf("%u %-24s %14.0f %14.0f\n", threads, "threads, own frees", messages / RunSameThread<string>(messages, threads),
+           messages / RunSameThread<PooledString>(messages, threads));
+    printf("%u %-24s %14.0f %14.0f\n", threads, "threads -> 1 consumer", messages / RunHandOff<string>(messages, threads),
+           messages / RunHandOff<PooledString>(messages, threads));
+
+    PayloadPoolStats stats = PayloadPool::GetStats();
+    printf("\npool: %llu allocations, %llu recycled, %llu oversize, %zu bytes in use, peak %zu, "
+           "%zu slab bytes, %llu slabs released\n",
+           static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.recycled),
+           static_cast<unsigned long long>(stats.oversize), stats.bytesInUse, stats.peakBytesInUse,
+           stats.slabBytes, static_cast<unsigned long long>(stats.slabsReleased));
+    return 0;
+}
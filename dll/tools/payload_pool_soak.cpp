@@ -0,0 +1,211 @@
+// payload_pool_soak.cpp - Runs hours of simulated chat through the pool and tracks its footprint
+//
+// Usage: payload_pool_soak [hours] [messagesPerMinute] [seed]
+// A game thread and a worker thread pass payloads the way the DLL does:
+// the game thread queues request text, the worker builds the request body
+// and response, parses the translation and queues the result, and the game
+// thread drains results (releasing its thread cache once the queue is
+// empty, as PollResult does). Simulated minutes run back to back; most
+// carry a Poisson number of messages around messagesPerMinute, and one in
+// twenty is a raid or world-event burst at 30x that, all queued at once.
+// Samples the pool after each minute's drain and prints peak and
+// steady-state slab bytes, peak bytes in use, the slabs given back after
+// bursts, and (on Linux) the process's resident set.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/payload_pool.h"
+
+using namespace std;
+
+static const uint32_t BURST_EVERY_MINUTES = 20;
+static const uint32_t BURST_FACTOR = 30;
+
+struct Request {
+    PooledString requestId;
+    PooledString text;
+};
+
+struct Result {
+    PooledString requestId;
+    PooledString translation;
+    PooledString error;
+};
+
+// Pipes the worker reads from and writes to; one lock is enough for a soak
+struct Pipeline {
+    mutex pipeMutex;
+    condition_variable changed;
+    deque<Request> requests;
+    deque<Result> results;
+    bool stopping = false;
+};
+
+static size_t ResidentBytes() {
+#ifdef __linux__
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int fields = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+    return fields == 2 ? resident * 4096 : 0;
+#else
+    return 0;
+#endif
+}
+
+static PooledString MakeText(mt19937& random) {
+    // Mostly short chat, some long guild adverts past the 1 KB class
+    static const char PIECE[] = "组队刷本缺治疗";
+    uniform_int_distribution<int> pieces(1, 12);
+    int count = pieces(random);
+    if (random() % 25 == 0) {
+        count *= 20;
+    }
+    PooledString text;
+    for (int i = 0; i < count; ++i) {
+        text += PIECE;
+    }
+    return text;
+}
+
+static void WorkerThread(Pipeline& pipe) {
+    unique_lock<mutex> lock(pipe.pipeMutex);
+    while (true) {
+        pipe.changed.wait(lock, [&] { return pipe.stopping || !pipe.requests.empty(); });
+        if (pipe.requests.empty()) {
+            return;
+        }
+        Request request = std::move(pipe.requests.front());
+        pipe.requests.pop_front();
+        lock.unlock();
+
+        PooledString body("{\"apiKey\":\"WT-0123456789abcdef\",\"text\":\"");
+        body += request.text;
+        body += "\",\"from\":\"zh\",\"to\":\"en\"}";
+
+        PooledString response("{\"translation\":\"");
+        for (size_t i = 0; i < request.text.size(); i += 3) {
+            response += PooledString("team up", 7);
+        }
+        response += "\",\"creditsRemaining\":4242}";
+
+        size_t start = response.find(":\"") + 2;
+        Result result;
+        result.requestId = std::move(request.requestId);
+        result.translation = response.substr(start, response.find('"', start) - start);
+
+        lock.lock();
+        pipe.results.push_back(std::move(result));
+        pipe.changed.notify_all();
+    }
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 8.0;
+    double perMinute = argc > 2 ? atof(argv[2]) : 40.0;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 7;
+    if (hours <= 0 || hours > 24 * 7 || perMinute <= 0 || perMinute > 10000) {
+        fprintf(stderr, "Usage: payload_pool_soak [hours 0-168] [messagesPerMinute] [seed]\n");
+        return 1;
+    }
+
+    Pipeline pipe;
+    thread worker(WorkerThread, ref(pipe));
+    mt19937 random(seed);
+    poisson_distribution<uint32_t> normal(perMinute);
+    poisson_distribution<uint32_t> burst(perMinute * BURST_FACTOR);
+
+    uint32_t minutes = static_cast<uint32_t>(hours * 60.0);
+    vector<size_t> slabSamples;
+    size_t peakResident = 0;
+    size_t startResident = ResidentBytes();
+    uint64_t messages = 0;
+    uint64_t delivered = 0;
+
+    for (uint32_t minute = 0; minute < minutes; ++minute) {
+        uint32_t count = minute % BURST_EVERY_MINUTES == BURST_EVERY_MINUTES - 1 ? burst(random) : normal(random);
+        {
+            lock_guard<mutex> lock(pipe.pipeMutex);
+            for (uint32_t i = 0; i < count; ++i) {
+                Request request;
+                request.requestId = "incoming_";
+                request.requestId += to_string(messages++).c_str();
+                request.text = MakeText(random);
+                pipe.requests.push_back(std::move(request));
+            }
+            pipe.changed.notify_all();
+        }
+
+        // The addon drains until every result of the minute is in
+        uint64_t target = messages;
+        unique_lock<mutex> lock(pipe.pipeMutex);
+        while (delivered < target) {
+            pipe.changed.wait(lock, [&] { return !pipe.results.empty(); });
+            while (!pipe.results.empty()) {
+                Result result = std::move(pipe.results.front());
+                pipe.results.pop_front();
+                ++delivered;
+            }
+            lock.unlock();
+            PayloadPool::ReleaseThreadCache();
+            lock.lock();
+        }
+        lock.unlock();
+
+        PayloadPoolStats stats = PayloadPool::GetStats();
+        slabSamples.push_back(stats.slabBytes);
+        peakResident = max(peakResident, ResidentBytes());
+    }
+
+    {
+        lock_guard<mutex> lock(pipe.pipeMutex);
+        pipe.stopping = true;
+        pipe.changed.notify_all();
+    }
+    worker.join();
+
+    // Steady state: median over the second half, bursts included
+    vector<size_t> late(slabSamples.begin() + slabSamples.size() / 2, slabSamples.end());
+    sort(late.begin(), late.end());
+    size_t steadySlabs = late.empty() ? 0 : late[late.size() / 2];
+    size_t firstHalfPeak = 0;
+    size_t secondHalfPeak = 0;
+    for (size_t i = 0; i < slabSamples.size(); ++i) {
+        size_t& peak = i < slabSamples.size() / 2 ? firstHalfPeak : secondHalfPeak;
+        peak = max(peak, slabSamples[i]);
+    }
+
+    PayloadPoolStats stats = PayloadPool::GetStats();
+    printf("%.1f h of chat, ~%.0f messages/min with a %ux burst every %u min, seed %u\n", hours, perMinute,
+           BURST_FACTOR, BURST_EVERY_MINUTES, seed);
+    printf("  messages:            %llu\n", static_cast<unsigned long long>(messages));
+    printf("  allocations:         %llu (%.1f per message, %.1f%% recycled, %llu oversize)\n",
+           static_cast<unsigned long long>(stats.allocations), static_cast<double>(stats.allocations) / messages,
+           100.0 * stats.recycled / max<uint64_t>(1, stats.allocations),
+           static_cast<unsigned long long>(stats.oversize));
+    printf("  slab bytes drained:  peak %zu (first half %zu, second half %zu), steady %zu, end %zu\n",
+           max(firstHalfPeak, secondHalfPeak), firstHalfPeak, secondHalfPeak, steadySlabs, stats.slabBytes);
+    printf("  bytes in use:        peak %zu, end %zu\n", stats.peakBytesInUse, stats.bytesInUse);
+    printf("  slabs released:      %llu\n", static_cast<unsigned long long>(stats.slabsReleased));
+    if (peakResident) {
+        printf("  resident set:        start %zu, peak %zu, end %zu\n", startResident, peakResident, ResidentBytes());
+    }
+
+    // A footprint that kept climbing after the first hours would show here
+    bool flat = secondHalfPeak <= firstHalfPeak + 64 * 1024 * 4;
+    printf("  footprint:           %s\n", flat ? "flat" : "GROWING");
+    return flat ? 0 : 1;
+}
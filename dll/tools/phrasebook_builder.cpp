@@ -0,0 +1,188 @@
+// phrasebook_builder.cpp - Compiles a TSV phrasebook into the mapped .wtpb format
+//
+// Usage: phrasebook_builder <input.tsv> <output.wtpb> [sourceLang] [targetLang]
+// Each non-empty line is "phrase<TAB>translation"; lines starting with '#'
+// are comments. Phrases are normalized the same way as DLL cache keys.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../include/phrasebook_format.h"
+#include "../include/text_normalize.h"
+
+using namespace std;
+
+static const uint32_t MAX_DISPLACEMENT = 1u << 24;
+
+static bool WriteBytes(FILE* out, const void* data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, out) == size;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <input.tsv> <output.wtpb> [sourceLang] [targetLang]\n", argv[0]);
+        return 1;
+    }
+
+    string sourceLang = argc >= 4 ? argv[3] : "zh";
+    string targetLang = argc >= 5 ? argv[4] : "en";
+    if (sourceLang.size() >= 8 || targetLang.size() >= 8) {
+        fprintf(stderr, "language codes must be shorter than 8 characters\n");
+        return 1;
+    }
+
+    ifstream input(argv[1], ios::binary);
+    if (!input) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    // Sorted, de-duplicated by normalized key; the first occurrence wins
+    map<string, string> phrases;
+    string line;
+    size_t lineNumber = 0;
+    size_t duplicates = 0;
+    while (getline(input, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t tab = line.find('\t');
+        if (tab == string::npos || tab == 0 || tab + 1 == line.size()) {
+            fprintf(stderr, "%s:%zu: expected phrase<TAB>translation\n", argv[1], lineNumber);
+            continue;
+        }
+        string key = NormalizeForCache(string_view(line).substr(0, tab));
+        if (!phrases.emplace(key, line.substr(tab + 1)).second) {
+            ++duplicates;
+        }
+    }
+
+    if (phrases.empty()) {
+        fprintf(stderr, "no phrases in %s\n", argv[1]);
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    vector<string_view> keys;
+    vector<string_view> values;
+    for (const auto& phrase : phrases) {
+        keys.push_back(phrase.first);
+        values.push_back(phrase.second);
+    }
+
+    // Hash-and-displace: place the largest buckets first, trying displacement
+    // seeds until every key in the bucket lands in a free slot
+    uint32_t entryCount = static_cast<uint32_t>(keys.size());
+    uint32_t bucketCount = max<uint32_t>(1, entryCount / 4);
+
+    vector<vector<uint32_t>> buckets(bucketCount);
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        buckets[PhrasebookBucket(keys[i], bucketCount)].push_back(i);
+    }
+
+    vector<uint32_t> order(bucketCount);
+    for (uint32_t b = 0; b < bucketCount; ++b) {
+        order[b] = b;
+    }
+    stable_sort(order.begin(), order.end(),
+                [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    vector<uint32_t> displacements(bucketCount, 0);
+    vector<int64_t> slotOwner(entryCount, -1);
+    vector<uint32_t> slots;
+    for (uint32_t b : order) {
+        const vector<uint32_t>& members = buckets[b];
+        if (members.empty()) {
+            continue;
+        }
+
+        bool placed = false;
+        for (uint32_t d = 1; d < MAX_DISPLACEMENT && !placed; ++d) {
+            slots.clear();
+            placed = true;
+            for (uint32_t index : members) {
+                uint32_t slot = PhrasebookSlot(keys[index], d, entryCount);
+                if (slotOwner[slot] >= 0 || find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (placed) {
+                displacements[b] = d;
+                for (size_t k = 0; k < members.size(); ++k) {
+                    slotOwner[slots[k]] = members[k];
+                }
+            }
+        }
+
+        if (!placed) {
+            fprintf(stderr, "failed to place bucket %u (%zu keys)\n", b, members.size());
+            return 1;
+        }
+    }
+
+    // String block: keys in sorted order, then values
+    string stringBlock;
+    vector<PhrasebookEntry> sortedEntries(entryCount);
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        sortedEntries[i].keyOffset = static_cast<uint32_t>(stringBlock.size());
+        sortedEntries[i].keyLength = static_cast<uint32_t>(keys[i].size());
+        stringBlock.append(keys[i].data(), keys[i].size());
+    }
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        sortedEntries[i].valueOffset = static_cast<uint32_t>(stringBlock.size());
+        sortedEntries[i].valueLength = static_cast<uint32_t>(values[i].size());
+        stringBlock.append(values[i].data(), values[i].size());
+    }
+
+    vector<PhrasebookEntry> entries(entryCount);
+    for (uint32_t slot = 0; slot < entryCount; ++slot) {
+        entries[slot] = sortedEntries[static_cast<size_t>(slotOwner[slot])];
+    }
+
+    PhrasebookHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PHRASEBOOK_MAGIC, sizeof(header.magic));
+    header.version = PHRASEBOOK_VERSION;
+    header.entryCount = entryCount;
+    header.bucketCount = bucketCount;
+    memcpy(header.sourceLang, sourceLang.data(), sourceLang.size());
+    memcpy(header.targetLang, targetLang.data(), targetLang.size());
+    header.displacementOffset = sizeof(PhrasebookHeader);
+    header.entryOffset = header.displacementOffset + bucketCount * sizeof(uint32_t);
+    header.stringOffset = header.entryOffset + entryCount * sizeof(PhrasebookEntry);
+    header.stringBytes = static_cast<uint32_t>(stringBlock.size());
+
+    FILE* out = fopen(argv[2], "wb");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    bool ok = WriteBytes(out, &header, sizeof(header)) &&
+              WriteBytes(out, displacements.data(), displacements.size() * sizeof(uint32_t)) &&
+              WriteBytes(out, entries.data(), entries.size() * sizeof(PhrasebookEntry)) &&
+              WriteBytes(out, stringBlock.data(), stringBlock.size());
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        fprintf(stderr, "write to %s failed\n", argv[2]);
+        return 1;
+    }
+
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    printf("%u phrases (%zu duplicates skipped), %u buckets, %.1f ms, %u bytes -> %s (%s -> %s)\n",
+           entryCount, duplicates, bucketCount, buildMs,
+           header.stringOffset + header.stringBytes, argv[2], sourceLang.c_str(), targetLang.c_str());
+    return 0;
+}
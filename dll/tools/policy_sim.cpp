@@ -0,0 +1,277 @@
+// policy_sim.cpp - Replays hours of chat traffic against the async path's scheduling and cache policies in virtual time
+//
+// Usage: policy_sim [hours] [messagesPerMinute] [seed]
+// Chat arrives as a Poisson stream that swells and ebbs over the day: lines
+// that recur (trade ads, LFG calls) drawn from a Zipf distribution, spam
+// campaigns several bots repeat within seconds of each other, and lines seen
+// once. Each message goes through the client's own RequestScheduler, as in
+// TranslateAsync and the worker loop: share an identical queued or
+// in-flight request, otherwise queue; the single worker wakes (on enqueue,
+// or on its next idle poll) through the scheduler's wait on the clock,
+// consults the real TranslationCache and on a miss waits for a modeled proxy
+// round trip. Everything runs on a VirtualClock and an EventScheduler, so a
+// run is repeatable for a given seed and takes milliseconds of CPU per
+// simulated hour.
+// Prints latency, requests answered without the proxy and the character
+// cost per SchedulingPolicy configuration.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/event_scheduler.h"
+#include "../include/request_scheduler.h"
+#include "../include/scheduling_policy.h"
+#include "../include/translation_cache.h"
+
+using namespace std;
+
+static const double CENTS_PER_CHAR = 0.003;   // $30 per million characters
+static const uint64_t DAY_MS = 86400000;
+
+struct Message {
+    uint64_t arrivalMs;
+    string text;        // Stands in for the line; equal text means an identical line
+    uint32_t chars;
+};
+
+// Deterministic chat stream; the same seed gives every policy the same traffic
+static vector<Message> GenerateTraffic(uint64_t durationMs, double perMinute, uint32_t seed) {
+    mt19937 random(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    lognormal_distribution<double> length(3.6, 0.5);   // ~37 characters
+
+    const size_t recurringLines = 3000;
+    vector<double> zipf(recurringLines);
+    double total = 0.0;
+    for (size_t i = 0; i < recurringLines; ++i) {
+        total += 1.0 / pow(static_cast<double>(i + 1), 1.1);
+        zipf[i] = total;
+    }
+    vector<uint32_t> recurringChars(recurringLines);
+    for (uint32_t& chars : recurringChars) {
+        chars = max<uint32_t>(4, static_cast<uint32_t>(length(random)));
+    }
+
+    vector<Message> messages;
+    uint64_t campaign = 0;
+    uint64_t uniqueLines = 0;
+    double t = 0.0;
+    while (true) {
+        // Busiest in the evening, a third as busy before dawn
+        double phase = 2.0 * 3.14159265358979 * (fmod(t, static_cast<double>(DAY_MS)) / DAY_MS);
+        double rate = perMinute * (1.0 - 0.5 * cos(phase)) / 60000.0;
+        t += -log(1.0 - unit(random)) / rate;
+        if (t >= durationMs) {
+            break;
+        }
+
+        uint64_t now = static_cast<uint64_t>(t);
+        double kind = unit(random);
+        if (kind < 0.55) {
+            size_t line = lower_bound(zipf.begin(), zipf.end(), unit(random) * total) - zipf.begin();
+            messages.push_back(Message{ now, "r" + to_string(line), recurringChars[line] });
+        } else if (kind < 0.70) {
+            // A campaign runs for ten minutes; two to four bots post each line
+            campaign = now / 600000;
+            uint32_t chars = 60 + static_cast<uint32_t>(campaign % 60);
+            int bots = 2 + static_cast<int>(unit(random) * 3);
+            for (int bot = 0; bot < bots; ++bot) {
+                messages.push_back(Message{ now + static_cast<uint64_t>(unit(random) * 2000), "s" + to_string(campaign),
+                                            chars });
+            }
+        } else {
+            messages.push_back(Message{ now, "u" + to_string(uniqueLines++),
+                                        max<uint32_t>(4, static_cast<uint32_t>(length(random))) });
+        }
+    }
+    sort(messages.begin(), messages.end(),
+         [](const Message& a, const Message& b) { return a.arrivalMs < b.arrivalMs; });
+    return messages;
+}
+
+// Proxy round trip: ~300 ms, longer for long lines, with a 3% tail of 2-6 s
+class ProxyModel {
+public:
+    explicit ProxyModel(uint32_t seed) : random(seed), body(5.7, 0.25), tail(2000.0, 6000.0), unit(0.0, 1.0) {}
+
+    uint64_t RoundTrip(uint32_t chars) {
+        double ms = unit(random) < 0.03 ? tail(random) : body(random);
+        return static_cast<uint64_t>(ms * (1.0 + chars / 400.0));
+    }
+
+private:
+    mt19937 random;
+    lognormal_distribution<double> body;
+    uniform_real_distribution<double> tail;
+    uniform_real_distribution<double> unit;
+};
+
+struct Metrics {
+    vector<uint32_t> latencies;   // Arrival to result ready
+    uint64_t proxyRequests;
+    uint64_t cacheHits;           // Requests the worker answered from the cache
+    uint64_t shared;              // Messages that joined an identical request
+    uint64_t charsBilled;
+    uint64_t events;
+    double cpuMs;
+};
+
+// The async path of TranslationClient, driven in virtual time: arrivals go
+// through TranslateAsync's sharing and queueing, and the loop below is the
+// worker's, both on the client's RequestScheduler. Each wait on the
+// VirtualClock (the idle wait, the proxy round trip) runs the arrivals due
+// meanwhile. TranslateText is modeled by its cache step and the proxy.
+class AsyncPathReplay {
+public:
+    AsyncPathReplay(const SchedulingPolicy& policy, uint32_t seed)
+        : scheduler(clock), requests(policy, clock), cache(policy.cacheEntries, policy.cacheExpiryMs), proxy(seed),
+          metrics() {}
+
+    Metrics Run(const vector<Message>& messages, uint64_t durationMs) {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < messages.size(); ++i) {
+            scheduler.At(messages[i].arrivalMs, [this, &messages, i]() { Arrive(messages, i); });
+        }
+
+        // WorkerThreadFunc; the replay ends once every message is answered
+        // or the last requests are ten minutes past the end of the traffic
+        uint64_t endMs = durationMs + 600000;
+        unique_lock<mutex> lock(requestMutex);
+        while (clock.Now() < endMs && !(scheduler.Empty() && requests.queued.empty())) {
+            AsyncRequest request;
+            if (requests.StartNext(request)) {
+                lock.unlock();
+                const Message& leader = messages[stoul(request.requestId)];
+                Translate(request, leader);
+                lock.lock();
+                for (const string& id : requests.Finish(request.requestId)) {
+                    metrics.latencies.push_back(static_cast<uint32_t>(clock.Now() - messages[stoul(id)].arrivalMs));
+                }
+            } else {
+                requests.WaitForWork(lock, []() { return false; });
+            }
+        }
+
+        metrics.events = scheduler.EventsRun();
+        metrics.cpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return metrics;
+    }
+
+private:
+    // TranslateAsync: share an identical request, else queue and wake the worker
+    void Arrive(const vector<Message>& messages, size_t index) {
+        lock_guard<mutex> lock(requestMutex);
+        string requestId = to_string(index);
+        const string& text = messages[index].text;
+        if (requests.Join(requestId, text, DEFAULT_LANGUAGE_PAIR)) {
+            ++metrics.shared;
+            return;
+        }
+        requests.Enqueue(AsyncRequest(requestId, text, DEFAULT_LANGUAGE_PAIR));
+    }
+
+    // TranslateText's cache, else a proxy round trip
+    void Translate(const AsyncRequest& request, const Message& leader) {
+        uint32_t tick = clock.NowMs();
+        PooledString translation;
+        cache.CleanExpired(tick);
+        if (cache.Lookup(request.text, DEFAULT_LANGUAGE_PAIR, tick, translation)) {
+            ++metrics.cacheHits;
+            return;
+        }
+
+        ++metrics.proxyRequests;
+        metrics.charsBilled += leader.chars;
+        clock.SleepFor(static_cast<uint32_t>(proxy.RoundTrip(leader.chars)));
+        cache.Insert(request.text, DEFAULT_LANGUAGE_PAIR, "translated", clock.NowMs());
+    }
+
+    VirtualClock clock;
+    EventScheduler scheduler;
+    mutex requestMutex;
+    RequestScheduler requests;
+    TranslationCache cache;
+    ProxyModel proxy;
+    Metrics metrics;
+};
+
+static uint32_t Percentile(vector<uint32_t> values, double percentile) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+struct Configuration {
+    const char* name;
+    SchedulingPolicy policy;
+};
+
+static vector<Configuration> Configurations() {
+    vector<Configuration> configurations;
+    SchedulingPolicy policy;
+    configurations.push_back({ "default", policy });
+
+    policy = SchedulingPolicy();
+    policy.wakeOnEnqueue = false;
+    configurations.push_back({ "poll every 50 ms", policy });
+
+    policy = SchedulingPolicy();
+    policy.coalesceIdentical = false;
+    configurations.push_back({ "no sharing", policy });
+
+    policy = SchedulingPolicy();
+    policy.cacheEntries = 0;
+    configurations.push_back({ "no cache", policy });
+
+    policy = SchedulingPolicy();
+    policy.cacheEntries = 100;
+    configurations.push_back({ "cache 100", policy });
+
+    policy = SchedulingPolicy();
+    policy.cacheEntries = 2000;
+    configurations.push_back({ "cache 2000", policy });
+
+    policy = SchedulingPolicy();
+    policy.cacheEntries = 2000;
+    policy.cacheExpiryMs = 6 * 3600000;
+    configurations.push_back({ "cache 2000, 6 h", policy });
+    return configurations;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 8.0;
+    double perMinute = argc > 2 ? atof(argv[2]) : 30.0;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 42;
+    if (hours <= 0 || hours > 24 * 30 || perMinute <= 0 || perMinute > 6000) {
+        fprintf(stderr, "usage: %s [hours 0-720] [messagesPerMinute] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t durationMs = static_cast<uint64_t>(hours * 3600000.0);
+    vector<Message> messages = GenerateTraffic(durationMs, perMinute, seed);
+    printf("%.1f h of chat, %zu messages (~%.0f/min), seed %u\n\n", hours, messages.size(), perMinute, seed);
+    printf("%-17s %6s %6s %6s %7s %9s %9s %9s %8s %7s\n", "policy", "p50", "p95", "p99", "local", "requests",
+           "chars", "cost", "events", "cpu");
+
+    for (const Configuration& configuration : Configurations()) {
+        AsyncPathReplay replay(configuration.policy, seed + 1);
+        Metrics metrics = replay.Run(messages, durationMs);
+        double local = 100.0 * (messages.size() - metrics.proxyRequests) / messages.size();
+        printf("%-17s %4ums %4ums %4ums %6.1f%% %9llu %9llu   $%6.2f %8llu %5.0fms\n", configuration.name,
+               Percentile(metrics.latencies, 50), Percentile(metrics.latencies, 95),
+               Percentile(metrics.latencies, 99), local, static_cast<unsigned long long>(metrics.proxyRequests),
+               static_cast<unsigned long long>(metrics.charsBilled), metrics.charsBilled * CENTS_PER_CHAR / 100.0,
+               static_cast<unsigned long long>(metrics.events), metrics.cpuMs);
+    }
+    return 0;
+}
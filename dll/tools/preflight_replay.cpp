@@ -0,0 +1,270 @@
+// preflight_replay.cpp - Counts proxy requests the pre-flight check and the negative cache avoid on a chat log
+//
+// Usage: preflight_replay [log.txt] [hours] [seed]
+// The log holds one message per line, optionally prefixed with its time in
+// seconds and a tab ("12.5<TAB>+1"); untimed lines are spaced two seconds
+// apart. Without a log a chat stream is generated: Chinese party/trade
+// lines, and the short lines the addon forwards as-is today (numbers, "+1",
+// coordinates, raid markers, lone links, emoticons, "LFM MC") plus English
+// lines and over-long pastes.
+// Each message is replayed against the DLL's cache before and after the
+// change, with a stand-in proxy that hands back lines without Chinese
+// unchanged and rejects lines over its length limit. Prints requests with
+// and without the change and what answered the difference.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/negative_cache.h"
+#include "../include/preflight.h"
+#include "../include/scheduling_policy.h"
+#include "../include/text_normalize.h"
+#include "../include/translation_cache.h"
+
+using namespace std;
+
+static const size_t PROXY_MAX_BYTES = 600;   // Stand-in proxy's length limit
+
+struct LoggedMessage {
+    uint32_t timeMs;
+    string text;
+};
+
+static bool LoadLog(const char* path, vector<LoggedMessage>& messages) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    uint32_t untimedMs = 0;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        size_t tab = line.find('\t');
+        char* end = nullptr;
+        double seconds = tab != string::npos ? strtod(line.c_str(), &end) : 0.0;
+        if (tab != string::npos && end == line.c_str() + tab) {
+            messages.push_back(LoggedMessage{ static_cast<uint32_t>(seconds * 1000.0), line.substr(tab + 1) });
+        } else {
+            untimedMs += 2000;
+            messages.push_back(LoggedMessage{ untimedMs, line });
+        }
+    }
+    stable_sort(messages.begin(), messages.end(),
+                [](const LoggedMessage& a, const LoggedMessage& b) { return a.timeMs < b.timeMs; });
+    return true;
+}
+
+static vector<LoggedMessage> GenerateLog(double hours, uint32_t seed) {
+    // Party/trade lines are built from parts so most are new, as in real chat
+    static const char* const verbs[] = { "收", "出", "求", "组", "缺", "来个", "招" };
+    static const char* const things[] = {
+        "黑莲花", "奥术水晶", "熔火碎片", "治疗", "坦克", "法师", "术士拉人", "附魔 十字军", "铁矿", "符文布",
+        "火焰之王的毛", "MC", "BWL", "祖格", "安其拉废墟", "纳克萨玛斯", "死亡矿井", "黑石深渊", "厄运之槌",
+    };
+    static const char* const tails[] = { "", " 私聊", " 速度", " 价格私聊", " 还有位置", " 马上走", " 谢谢" };
+    static const char* const passThrough[] = {
+        "1", "+1", "111", "233", "666", "88", "{skull}", "{rt8} {rt7}", "http://ph.wt/1",
+        "http://ph.wt/1 http://ph.wt/2", "xD", "T_T", "orz", "LFM MC", "WTS", "DPS?", "gg", "???", "...", "!!!",
+    };
+    static const char* const english[] = {
+        "anyone", "selling", "iron", "ore", "thanks", "lol", "nice", "where", "is", "the", "flight", "master",
+        "need", "one", "more", "healer", "brb", "good", "luck", "everyone", "what", "time", "raid", "tonight",
+    };
+
+    mt19937 random(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    auto pick = [&](size_t count) { return static_cast<size_t>(unit(random) * count); };
+    vector<LoggedMessage> log;
+    vector<string> pastes;
+    double t = 0.0;
+    double durationMs = hours * 3600000.0;
+    while (true) {
+        t += -log1p(-unit(random)) * 2000.0;   // ~30 messages a minute
+        if (t >= durationMs) {
+            break;
+        }
+        uint32_t now = static_cast<uint32_t>(t);
+        double kind = unit(random);
+        string line;
+        if (kind < 0.50) {
+            line = string(verbs[pick(7)]) + things[pick(19)] + tails[pick(7)];
+            if (unit(random) < 0.4) {
+                line += " " + to_string(1 + pick(60)) + "g";
+            }
+        } else if (kind < 0.75) {
+            line = passThrough[pick(20)];
+        } else if (kind < 0.85) {
+            // Prices, counts and map positions with varying numbers
+            if (unit(random) < 0.5) {
+                line = to_string(pick(100)) + "." + to_string(pick(10)) + ", " + to_string(pick(100)) + "." +
+                       to_string(pick(10));
+            } else {
+                line = to_string(1 + pick(99)) + "g " + to_string(pick(100)) + "s";
+            }
+        } else if (kind < 0.97) {
+            int words = 2 + static_cast<int>(pick(5));
+            for (int i = 0; i < words; ++i) {
+                line += (i ? " " : "") + string(english[pick(24)]);
+            }
+        } else {
+            // Bots repeat a handful of over-long advertisements
+            if (pastes.size() < 4 || unit(random) < 0.1) {
+                string paste = "[" + to_string(pastes.size()) + "]";
+                while (paste.size() <= PROXY_MAX_BYTES) {
+                    paste += string(verbs[pick(7)]) + things[pick(19)];
+                }
+                pastes.push_back(paste);
+            }
+            line = pastes[pick(pastes.size())];
+        }
+        log.push_back(LoggedMessage{ now, line });
+    }
+    return log;
+}
+
+static bool HasChinese(const string& text) {
+    for (size_t i = 0; i + 2 < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0xE4 && c <= 0xE9) {
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class ProxyAnswer { TRANSLATED, UNCHANGED, REJECTED };
+
+static ProxyAnswer StandInProxy(const string& text) {
+    if (text.size() > PROXY_MAX_BYTES) {
+        return ProxyAnswer::REJECTED;
+    }
+    return HasChinese(text) ? ProxyAnswer::TRANSLATED : ProxyAnswer::UNCHANGED;
+}
+
+struct ReplayCounts {
+    uint64_t requests;
+    uint64_t cacheHits;
+    uint64_t preflight[PREFLIGHT_CLASS_COUNT];
+    uint64_t negativeUnchanged;
+    uint64_t negativeRejected;
+};
+
+// withChange = false replays the old path: every success, unchanged lines
+// included, is cached; rejections are not remembered
+static ReplayCounts Replay(const vector<LoggedMessage>& log, bool withChange) {
+    SchedulingPolicy policy;
+    TranslationCache cache(policy.cacheEntries, policy.cacheExpiryMs);
+    NegativeCache negative;
+    ReplayCounts counts = {};
+
+    for (const LoggedMessage& message : log) {
+        if (withChange) {
+            PreflightClass kind = ClassifyMessage(message.text);
+            if (kind != PreflightClass::TRANSLATE) {
+                counts.preflight[static_cast<int>(kind)]++;
+                continue;
+            }
+        }
+
+        string key = NormalizeForCache(message.text);
+        PooledString translation;
+        if (cache.Lookup(key, DEFAULT_LANGUAGE_PAIR, message.timeMs, translation)) {
+            counts.cacheHits++;
+            continue;
+        }
+        NegativeResult remembered;
+        PooledString error;
+        if (withChange && negative.Lookup(key, DEFAULT_LANGUAGE_PAIR, message.timeMs, remembered, error)) {
+            if (remembered == NegativeResult::UNCHANGED) {
+                counts.negativeUnchanged++;
+            } else {
+                counts.negativeRejected++;
+            }
+            continue;
+        }
+        cache.CleanExpired(message.timeMs);
+
+        counts.requests++;
+        ProxyAnswer answer = StandInProxy(message.text);
+        if (answer == ProxyAnswer::REJECTED) {
+            if (withChange) {
+                negative.Insert(key, DEFAULT_LANGUAGE_PAIR, NegativeResult::REJECTED, "Text too long", message.timeMs);
+            }
+        } else if (answer == ProxyAnswer::UNCHANGED && withChange) {
+            negative.Insert(key, DEFAULT_LANGUAGE_PAIR, NegativeResult::UNCHANGED, "", message.timeMs);
+        } else {
+            cache.Insert(key, DEFAULT_LANGUAGE_PAIR, answer == ProxyAnswer::UNCHANGED ? message.text : "translated",
+                         message.timeMs);
+        }
+    }
+    return counts;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 2 ? atof(argv[2]) : 4.0;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 42;
+    if (hours <= 0 || hours > 24 * 30) {
+        fprintf(stderr, "usage: %s [log.txt|-] [hours 0-720] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    vector<LoggedMessage> log;
+    if (argc > 1 && string(argv[1]) != "-") {
+        if (!LoadLog(argv[1], log)) {
+            fprintf(stderr, "cannot read %s\n", argv[1]);
+            return 1;
+        }
+        printf("%s: %zu messages\n\n", argv[1], log.size());
+    } else {
+        log = GenerateLog(hours, seed);
+        printf("Generated %.1f h of chat, %zu messages, seed %u\n\n", hours, log.size(), seed);
+    }
+
+    ReplayCounts before = Replay(log, false);
+    ReplayCounts after = Replay(log, true);
+
+    uint64_t skipped = 0;
+    for (int kind = 1; kind < PREFLIGHT_CLASS_COUNT; ++kind) {
+        skipped += after.preflight[kind];
+    }
+    printf("%-28s %8s %8s\n", "", "before", "after");
+    printf("%-28s %8llu %8llu\n", "proxy requests", static_cast<unsigned long long>(before.requests),
+           static_cast<unsigned long long>(after.requests));
+    printf("%-28s %8llu %8llu\n", "DLL cache hits", static_cast<unsigned long long>(before.cacheHits),
+           static_cast<unsigned long long>(after.cacheHits));
+    printf("%-28s %8s %8llu\n", "answered by pre-flight", "-", static_cast<unsigned long long>(skipped));
+    for (int kind = 1; kind < PREFLIGHT_CLASS_COUNT; ++kind) {
+        printf("  %-26s %8s %8llu\n", PreflightClassName(static_cast<PreflightClass>(kind)), "-",
+               static_cast<unsigned long long>(after.preflight[kind]));
+    }
+    printf("%-28s %8s %8llu\n", "negative cache: unchanged", "-",
+           static_cast<unsigned long long>(after.negativeUnchanged));
+    printf("%-28s %8s %8llu\n", "negative cache: rejected", "-",
+           static_cast<unsigned long long>(after.negativeRejected));
+
+    long long avoided = static_cast<long long>(before.requests) - static_cast<long long>(after.requests);
+    printf("\nrequests avoided: %lld (%.1f%% of %llu)\n", avoided,
+           before.requests ? 100.0 * avoided / before.requests : 0.0, static_cast<unsigned long long>(before.requests));
+
+    // Cost of the check every message now pays
+    auto start = chrono::steady_clock::now();
+    size_t translate = 0;
+    for (const LoggedMessage& message : log) {
+        translate += ClassifyMessage(message.text) == PreflightClass::TRANSLATE ? 1 : 0;
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("pre-flight check: %.0f ns per message (%zu of %zu go on to the proxy path)\n",
+           log.empty() ? 0.0 : ns / log.size(), translate, log.size());
+    return 0;
+}
@@ -0,0 +1,188 @@
+// push_delivery_harness.cpp - Compares push delivery with OnUpdate polling on a fake Lua host
+//
+// Usage: push_delivery_harness [minutes] [requestsPerMinute] [seed]
+// Stands in for the game's main thread: frames at 60 fps, each running the
+// OnUpdate scripts a few ms in. Translation requests arrive as a Poisson
+// stream and their results become ready on the worker after a modeled proxy
+// round trip. The polling addon drains with poll_batch every POLL_INTERVAL
+// while requests are pending; the push addon makes one "push tick" call per
+// frame through the real PushDelivery gate and drains when it says so, with
+// timed polling kept as a slow fallback. Prints the time from "result ready
+// in the DLL" to "addon drains it", drains per minute and how many found
+// nothing, ticks per minute, and the measured cost of an idle tick.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../include/push_delivery.h"
+
+using namespace std;
+
+static const uint64_t FRAME_US = 16667;                  // 60 fps
+static const uint64_t ONUPDATE_OFFSET_US = 3000;         // OnUpdate scripts run after the pump
+static const uint64_t POLL_INTERVAL_US = 100000;         // WoWTranslate_API POLL_INTERVAL
+static const uint64_t FALLBACK_POLL_INTERVAL_US = 1000000;  // PUSH_FALLBACK_POLL_INTERVAL
+
+struct Request {
+    uint64_t sentUs;
+    uint64_t readyUs;     // Result queued by the worker
+};
+
+static vector<Request> GenerateRequests(uint64_t durationUs, double perMinute, uint32_t seed) {
+    mt19937 random(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    lognormal_distribution<double> roundTrip(5.7, 0.35);    // ~300 ms
+    vector<Request> requests;
+    double t = 0.0;
+    double meanGapUs = 60e6 / perMinute;
+    while (true) {
+        t += -log(1.0 - unit(random)) * meanGapUs;
+        if (t >= durationUs) {
+            break;
+        }
+        uint64_t sent = static_cast<uint64_t>(t);
+        requests.push_back(Request{ sent, sent + static_cast<uint64_t>(roundTrip(random) * 1000.0) });
+    }
+    sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) { return a.readyUs < b.readyUs; });
+    return requests;
+}
+
+struct Metrics {
+    vector<uint32_t> latenciesUs;   // Result ready to addon drain
+    uint64_t drains;                // poll_batch calls
+    uint64_t emptyDrains;           // poll_batch calls that found no result
+    uint64_t ticks;                 // push tick calls
+};
+
+// The host's frame loop; push selects which addon is loaded
+static Metrics RunHost(const vector<Request>& requests, uint64_t durationUs, bool push) {
+    Metrics metrics = {};
+    PushDelivery delivery;
+    delivery.SetEnabled(push);
+
+    // Requests sorted by send time decide when the addon's poll frame runs
+    vector<uint64_t> sent;
+    for (const Request& request : requests) {
+        sent.push_back(request.sentUs);
+    }
+    sort(sent.begin(), sent.end());
+
+    size_t nextSent = 0;
+    size_t nextReady = 0;    // Results before this index were delivered
+    size_t readyCount = 0;   // Results queued in the DLL (index < readyCount)
+    int64_t pending = 0;     // Requests the addon is waiting for
+    uint64_t sinceLastPollUs = 0;
+    bool pollFrame = false;
+
+    // poll_batch: hands over every queued result
+    auto drain = [&](uint64_t nowUs) {
+        ++metrics.drains;
+        if (nextReady == readyCount) {
+            ++metrics.emptyDrains;
+            return;
+        }
+        for (; nextReady < readyCount; ++nextReady) {
+            metrics.latenciesUs.push_back(static_cast<uint32_t>(nowUs - requests[nextReady].readyUs));
+            --pending;
+        }
+        if (pending == 0) {
+            pollFrame = false;
+        }
+    };
+    auto advance = [&](uint64_t nowUs) {
+        while (readyCount < requests.size() && requests[readyCount].readyUs <= nowUs) {
+            ++readyCount;
+        }
+        while (nextSent < sent.size() && sent[nextSent] <= nowUs) {
+            ++nextSent;
+            ++pending;
+            if (!pollFrame) {
+                pollFrame = true;
+                sinceLastPollUs = 0;
+            }
+        }
+    };
+
+    uint64_t pollIntervalUs = push ? FALLBACK_POLL_INTERVAL_US : POLL_INTERVAL_US;
+    for (uint64_t frameUs = 0; frameUs < durationUs; frameUs += FRAME_US) {
+        uint64_t updateUs = frameUs + ONUPDATE_OFFSET_US;
+        advance(updateUs);
+        if (pollFrame) {
+            sinceLastPollUs += FRAME_US;
+            bool ready = false;
+            if (push) {
+                ++metrics.ticks;
+                ready = delivery.ShouldDeliver(updateUs, nextReady < readyCount);
+            }
+            if (ready || sinceLastPollUs >= pollIntervalUs) {
+                sinceLastPollUs = 0;
+                drain(updateUs);
+            }
+        }
+    }
+    return metrics;
+}
+
+static uint32_t Percentile(vector<uint32_t> values, double percentile) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+// Wall-clock cost of the check a tick makes with nothing waiting
+static double IdleCheckNanos() {
+    PushDelivery delivery;
+    delivery.SetEnabled(true);
+    const uint64_t iterations = 50000000;
+    volatile bool waiting = false;
+    uint64_t delivered = 0;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        delivered += delivery.ShouldDeliver(i, waiting) ? 1 : 0;
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return delivered == 0 ? ns / iterations : -1.0;
+}
+
+int main(int argc, char** argv) {
+    double minutes = argc > 1 ? atof(argv[1]) : 60.0;
+    double perMinute = argc > 2 ? atof(argv[2]) : 20.0;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 10)) : 42;
+    if (minutes <= 0 || minutes > 24 * 60 || perMinute <= 0 || perMinute > 6000) {
+        fprintf(stderr, "usage: %s [minutes 0-1440] [requestsPerMinute] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t durationUs = static_cast<uint64_t>(minutes * 60e6);
+    vector<Request> requests = GenerateRequests(durationUs, perMinute, seed);
+    printf("%.0f min at 60 fps, %zu requests (~%.0f/min), seed %u\n\n", minutes, requests.size(), perMinute, seed);
+    printf("%-22s %8s %8s %8s %12s %12s %12s\n", "addon", "p50", "p99", "max", "drains/min", "empty/min",
+           "ticks/min");
+
+    struct Mode {
+        const char* name;
+        bool push;
+    };
+    const Mode modes[] = {
+        { "poll 100 ms", false },
+        { "push, per-frame tick", true },
+    };
+    for (const Mode& mode : modes) {
+        Metrics metrics = RunHost(requests, durationUs, mode.push);
+        printf("%-22s %6.1fms %6.1fms %6.1fms %12.1f %12.1f %12.0f\n", mode.name,
+               Percentile(metrics.latenciesUs, 50) / 1000.0, Percentile(metrics.latenciesUs, 99) / 1000.0,
+               Percentile(metrics.latenciesUs, 100) / 1000.0, metrics.drains / minutes,
+               metrics.emptyDrains / minutes, metrics.ticks / minutes);
+    }
+
+    printf("\nidle tick check: %.2f ns\n", IdleCheckNanos());
+    return 0;
+}
@@ -0,0 +1,217 @@
+// shared_cache_multiprocess.cpp - Runs SharedTranslationCache across forked clients
+//
+// Usage: shared_cache_multiprocess [clients] [lines] [fetchMs] [failPercent]
+// Forks clients processes that map one fresh table and walk the same chat
+// log in lockstep, the way multiboxed game clients see the same lines at
+// once. Each client follows TranslateText's shared-cache path: Lookup, then
+// TryClaim; the claim holder "fetches" (sleeps fetchMs) and publishes, the
+// others WaitFor it and fetch themselves only if the wait comes back empty.
+// failPercent of fetches fail and only release the claim, so waiters have
+// to notice the claimant gave up. Prints proxy fetches per line (1.0 is
+// perfect single-flight), wait outcomes, and any translation that came back
+// wrong. Also checks claim ownership: a release with someone else's (or no)
+// claim id must leave the holder's claim in place.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../include/shared_translation_cache.h"
+
+using namespace std;
+
+static const uint32_t EXPIRY_MS = 60000;
+static const uint32_t WAIT_MS = 4000;          // TranslationClient::SHARED_CACHE_WAIT_MS
+
+// Counters every client adds to; lives in an anonymous shared mapping
+struct Totals {
+    atomic<uint32_t> ready;
+    atomic<uint32_t> go;
+    atomic<uint64_t> lookupHits;
+    atomic<uint64_t> claimedFetches;
+    atomic<uint64_t> unclaimedFetches;   // TryClaim said fetch but the probe window was full
+    atomic<uint64_t> fallbackFetches;    // Waited and nothing was published
+    atomic<uint64_t> failedFetches;
+    atomic<uint64_t> waitHits;
+    atomic<uint64_t> wrong;
+    atomic<uint64_t> waitMs;
+};
+
+static string LineText(uint32_t line) {
+    return "msg " + to_string(line) + " anyone lfg for the dungeon tonight?";
+}
+
+static string LineTranslation(uint32_t line) {
+    return "translated " + to_string(line);
+}
+
+static uint32_t NowMs() {
+    return static_cast<uint32_t>(
+        chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void RunClient(const string& name, uint32_t client, uint32_t lines, uint32_t fetchMs,
+                      uint32_t failPercent, Totals& totals) {
+    SharedTranslationCache cache(EXPIRY_MS);
+    if (!cache.Open(name)) {
+        fprintf(stderr, "client %u: cannot open shared table\n", client);
+        _exit(1);
+    }
+
+    ++totals.ready;
+    while (!totals.go.load()) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    for (uint32_t line = 0; line < lines; ++line) {
+        string text = LineText(line);
+        string expected = LineTranslation(line);
+        PooledString result;
+
+        if (cache.Lookup(text, "zh", "en", result)) {
+            ++totals.lookupHits;
+        } else {
+            uint64_t claim = 0;
+            bool fetch = cache.TryClaim(text, "zh", "en", claim);
+            if (!fetch) {
+                uint32_t start = NowMs();
+                bool found = cache.WaitFor(text, "zh", "en", WAIT_MS, result);
+                totals.waitMs += NowMs() - start;
+                if (found) {
+                    ++totals.waitHits;
+                } else {
+                    ++totals.fallbackFetches;
+                    fetch = true;
+                }
+            } else if (claim) {
+                ++totals.claimedFetches;
+            } else {
+                ++totals.unclaimedFetches;
+            }
+
+            if (fetch) {
+                this_thread::sleep_for(chrono::milliseconds(fetchMs));
+                // Failures are decided per line so every client agrees on them
+                if ((line * 2654435761u) % 100 < failPercent && claim) {
+                    ++totals.failedFetches;
+                    cache.ReleaseClaim(text, "zh", "en", claim);
+                    continue;
+                }
+                cache.Publish(text, "zh", "en", expected, claim);
+                result.assign(expected.data(), expected.size());
+            }
+        }
+
+        if (string(result.data(), result.size()) != expected) {
+            ++totals.wrong;
+        }
+    }
+    _exit(0);
+}
+
+// A release must only ever clear the claim it was handed
+static bool CheckOwnership(const string& name) {
+    SharedTranslationCache holder(EXPIRY_MS);
+    SharedTranslationCache other(EXPIRY_MS);
+    if (!holder.Open(name) || !other.Open(name)) {
+        return false;
+    }
+
+    const char* text = "ownership check line";
+    uint64_t held = 0;
+    uint64_t waiter = 0;
+    bool ok = holder.TryClaim(text, "zh", "en", held) && held != 0;
+    ok = ok && !other.TryClaim(text, "zh", "en", waiter) && waiter == 0;
+
+    // The waiter timing out and tearing down, then a stale id, must not free the line
+    other.ReleaseClaim(text, "zh", "en", waiter);
+    other.ReleaseClaim(text, "zh", "en", held ^ (1ull << 32));
+    other.Publish(text, "zh", "en", "from the waiter", waiter);
+    uint64_t probe = 0;
+    ok = ok && !other.TryClaim(text, "zh", "en", probe);
+
+    holder.ReleaseClaim(text, "zh", "en", held);
+    ok = ok && other.TryClaim(text, "zh", "en", probe) && probe != 0;
+    other.ReleaseClaim(text, "zh", "en", probe);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t clients = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 4;
+    uint32_t lines = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 300;
+    uint32_t fetchMs = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 20;
+    uint32_t failPercent = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 5;
+    if (clients == 0 || lines == 0) {
+        fprintf(stderr, "Usage: shared_cache_multiprocess [clients] [lines] [fetchMs] [failPercent]\n");
+        return 1;
+    }
+
+    string name = "WoWTranslate_multiprocess_" + to_string(getpid());
+    SharedMemoryRegion::Remove(name);
+
+    void* mapping = mmap(nullptr, sizeof(Totals), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    Totals& totals = *new (mapping) Totals();
+
+    vector<pid_t> children;
+    for (uint32_t client = 0; client < clients; ++client) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            RunClient(name, client, lines, fetchMs, failPercent, totals);
+        }
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        children.push_back(pid);
+    }
+
+    while (totals.ready.load() < clients) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    auto start = chrono::steady_clock::now();
+    totals.go = 1;
+
+    bool childrenOk = true;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        childrenOk = childrenOk && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    bool ownershipOk = CheckOwnership(name);
+    SharedMemoryRegion::Remove(name);
+
+    uint64_t fetches = totals.claimedFetches + totals.unclaimedFetches + totals.fallbackFetches;
+    uint64_t waits = totals.waitHits + totals.fallbackFetches;
+    printf("%u clients x %u lines, %u ms fetch, %u%% of fetches fail, %.2f s\n",
+           clients, lines, fetchMs, failPercent, seconds);
+    printf("  proxy fetches:   %llu (%.2f per line; %u without the shared cache)\n",
+           static_cast<unsigned long long>(fetches), static_cast<double>(fetches) / lines, clients * lines);
+    printf("    claimed %llu, unclaimed %llu, after a fruitless wait %llu, failed %llu\n",
+           static_cast<unsigned long long>(totals.claimedFetches.load()),
+           static_cast<unsigned long long>(totals.unclaimedFetches.load()),
+           static_cast<unsigned long long>(totals.fallbackFetches.load()),
+           static_cast<unsigned long long>(totals.failedFetches.load()));
+    printf("  lookup hits:     %llu\n", static_cast<unsigned long long>(totals.lookupHits.load()));
+    printf("  waits:           %llu (%llu answered, mean %.1f ms)\n",
+           static_cast<unsigned long long>(waits), static_cast<unsigned long long>(totals.waitHits.load()),
+           waits ? static_cast<double>(totals.waitMs) / waits : 0.0);
+    printf("  wrong answers:   %llu\n", static_cast<unsigned long long>(totals.wrong.load()));
+    printf("  claim ownership: %s\n", ownershipOk ? "ok" : "FAILED");
+
+    bool ok = childrenOk && ownershipOk && totals.wrong == 0;
+    return ok ? 0 : 1;
+}
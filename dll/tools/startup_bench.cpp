@@ -0,0 +1,316 @@
+// startup_bench.cpp - Loader-lock, setkey and first-request cost of eager versus deferred startup
+//
+// Usage: startup_bench [handshakeMs] [requestMs] [dataDir]
+// Linux only (loopback sockets). Times the DLL's startup steps, in the
+// order each startup runs them, on the game's side of the fence:
+//   before  DllMain opened the log and built the TranslationClient under
+//           the loader lock; setkey (Initialize) then joined the worker on a
+//           re-key, opened WinHTTP, mapped the phrasebook and dictionary and
+//           started the worker, all on the game thread; the first
+//           translation paid for the TCP/TLS handshake
+//   after   DllMain only starts the startup thread, which does all of the
+//           above plus a HEAD warm-up; setkey copies the key under a mutex;
+//           the first translation finds a warm connection
+// The client is its portable members (TranslationCache, OfflineEngine with
+// the built-in glossary, NearDuplicateIndex, the phrasebook and name index
+// mappings and dictionary from dataDir, named as next to the DLL). A
+// stand-in proxy on loopback answers a new connection after handshakeMs and
+// each request after requestMs. WinHttpOpen itself is not modeled. Prints
+// the median of each phase over several runs.
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/name_index.h"
+#include "../include/near_duplicate.h"
+#include "../include/offline_engine.h"
+#include "../include/phrasebook.h"
+#include "../include/scheduling_policy.h"
+#include "../include/translation_cache.h"
+
+using namespace std;
+
+static const int RUNS = 15;
+static const size_t NEAR_DUPLICATE_ENTRIES = 512;   // TranslationClient::MAX_NEAR_DUPLICATE_SIZE
+
+static uint64_t NowUs() {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// ============================================================================
+// Stand-in proxy: one thread per connection
+// ============================================================================
+
+class LoopbackProxy {
+public:
+    LoopbackProxy(uint32_t handshakeMs, uint32_t requestMs) : handshakeMs(handshakeMs), requestMs(requestMs) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 64) != 0 ||
+            getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            perror("listen");
+            exit(1);
+        }
+        port = ntohs(addr.sin_port);
+        acceptor = thread([this]() { AcceptLoop(); });
+    }
+
+    ~LoopbackProxy() {
+        shutdown(listener, SHUT_RDWR);
+        close(listener);
+        acceptor.join();
+    }
+
+    uint16_t Port() const { return port; }
+
+private:
+    void AcceptLoop() {
+        for (;;) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            thread([this, fd]() { Serve(fd); }).detach();
+        }
+    }
+
+    // The handshake ends with one byte; each request line gets one reply line
+    void Serve(int fd) {
+        this_thread::sleep_for(chrono::milliseconds(handshakeMs));
+        char byte = 'H';
+        if (write(fd, &byte, 1) != 1) {
+            close(fd);
+            return;
+        }
+        char buffer[256];
+        while (read(fd, buffer, sizeof(buffer)) > 0) {
+            this_thread::sleep_for(chrono::milliseconds(requestMs));
+            if (write(fd, "ok\n", 3) != 3) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    uint32_t handshakeMs;
+    uint32_t requestMs;
+    int listener;
+    uint16_t port;
+    thread acceptor;
+};
+
+// A connection the way WinHTTP opens one: TCP connect, then the handshake
+static int Connect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    char byte;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || read(fd, &byte, 1) != 1) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+static void Request(int fd) {
+    char reply[8];
+    if (write(fd, "POST\n", 5) != 5 || read(fd, reply, sizeof(reply)) <= 0) {
+        perror("request");
+        exit(1);
+    }
+}
+
+// ============================================================================
+// The client's startup steps
+// ============================================================================
+
+struct Client {
+    TranslationCache cache;
+    OfflineEngine offlineEngine;
+    NearDuplicateIndex nearDuplicates;
+    Phrasebook phrasebook;
+    NameIndex nameIndex;
+
+    atomic<bool> running;
+    thread worker;
+    int connection;
+    mutex keyMutex;
+    string apiKey;
+
+    Client()
+        : cache(SchedulingPolicy::DEFAULT_CACHE_ENTRIES, SchedulingPolicy::DEFAULT_CACHE_EXPIRY_MS),
+          nearDuplicates(NEAR_DUPLICATE_ENTRIES), running(false), connection(-1) {}
+
+    ~Client() {
+        StopWorker();
+        if (connection >= 0) {
+            close(connection);
+        }
+    }
+
+    void LoadFiles(const string& dataDir) {
+        if (dataDir.empty()) {
+            return;
+        }
+        phrasebook.Open(dataDir + "/WoWTranslate_phrasebook.wtpb");
+        nameIndex.Open(dataDir + "/WoWTranslate_names.wtni");
+        offlineEngine.LoadDictionary(dataDir + "/WoWTranslate_dictionary.tsv");
+    }
+
+    // The worker stays busy with back-to-back requests, so a re-key lands mid-request
+    void StartWorker(uint16_t port, bool busy) {
+        running = true;
+        worker = thread([this, port, busy]() {
+            int fd = busy ? Connect(port) : -1;
+            while (running) {
+                if (busy) {
+                    Request(fd);
+                } else {
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                }
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+        });
+    }
+
+    void StopWorker() {
+        if (running.exchange(false) && worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    void SetApiKey(const string& key) {
+        lock_guard<mutex> lock(keyMutex);
+        apiKey = key;
+    }
+};
+
+static void OpenLog(const string& path) {
+    FILE* log = fopen(path.c_str(), "a");
+    if (log) {
+        fprintf(log, "[INFO] WoWTranslate: DLL_PROCESS_ATTACH\n[INFO] Initializing WoWTranslate library\n");
+        fflush(log);
+        fclose(log);
+    }
+}
+
+struct Phases {
+    vector<double> attach;
+    vector<double> setKey;
+    vector<double> reKey;
+    vector<double> firstRequest;
+    vector<double> background;
+};
+
+static double Median(vector<double> values) {
+    sort(values.begin(), values.end());
+    return values.empty() ? 0.0 : values[values.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    uint32_t handshakeMs = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 120;
+    uint32_t requestMs = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 80;
+    string dataDir = argc > 3 ? argv[3] : "";
+    string logPath = (dataDir.empty() ? string(".") : dataDir) + "/startup_bench.log";
+
+    LoopbackProxy proxy(handshakeMs, requestMs);
+    Phases before, after;
+
+    for (int run = 0; run < RUNS; ++run) {
+        // Before: log and client under the loader lock
+        uint64_t start = NowUs();
+        OpenLog(logPath);
+        unique_ptr<Client> client(new Client());
+        before.attach.push_back((NowUs() - start) / 1000.0);
+
+        // First setkey: files, connection handle (lazy, as WinHttpConnect) and worker on the game thread
+        start = NowUs();
+        client->SetApiKey("WT-first");
+        client->LoadFiles(dataDir);
+        client->StartWorker(proxy.Port(), true);
+        before.setKey.push_back((NowUs() - start) / 1000.0);
+
+        // Re-key while the worker is inside a request: Cleanup joined it, then Initialize ran again
+        this_thread::sleep_for(chrono::milliseconds(handshakeMs + requestMs / 2));
+        start = NowUs();
+        client->StopWorker();
+        client->SetApiKey("WT-second");
+        client->LoadFiles(dataDir);
+        client->StartWorker(proxy.Port(), false);
+        before.reKey.push_back((NowUs() - start) / 1000.0);
+
+        // First translation on a cold connection
+        start = NowUs();
+        client->connection = Connect(proxy.Port());
+        Request(client->connection);
+        before.firstRequest.push_back((NowUs() - start) / 1000.0);
+        client.reset();
+
+        // After: DllMain starts the startup thread and returns
+        uint64_t backgroundUs = 0;
+        start = NowUs();
+        thread startup([&]() {
+            uint64_t threadStart = NowUs();
+            OpenLog(logPath);
+            client.reset(new Client());
+            client->LoadFiles(dataDir);
+            client->connection = Connect(proxy.Port());
+            Request(client->connection);  // HEAD warm-up
+            client->StartWorker(proxy.Port(), true);
+            backgroundUs = NowUs() - threadStart;
+        });
+        after.attach.push_back((NowUs() - start) / 1000.0);
+        startup.join();
+        after.background.push_back(backgroundUs / 1000.0);
+
+        // setkey and re-key are the same mutex-guarded copy
+        start = NowUs();
+        client->SetApiKey("WT-first");
+        after.setKey.push_back((NowUs() - start) / 1000.0);
+        this_thread::sleep_for(chrono::milliseconds(requestMs / 2));
+        start = NowUs();
+        client->SetApiKey("WT-second");
+        after.reKey.push_back((NowUs() - start) / 1000.0);
+
+        // First translation on the warmed connection
+        start = NowUs();
+        Request(client->connection);
+        after.firstRequest.push_back((NowUs() - start) / 1000.0);
+        client.reset();
+    }
+    remove(logPath.c_str());
+
+    printf("handshake %u ms, request %u ms, %s, median of %d runs (ms)\n\n", handshakeMs, requestMs,
+           dataDir.empty() ? "no data files" : dataDir.c_str(), RUNS);
+    printf("%-34s %10s %10s\n", "phase", "before", "after");
+    printf("%-34s %10.3f %10.3f\n", "DLL_PROCESS_ATTACH (loader lock)", Median(before.attach), Median(after.attach));
+    printf("%-34s %10.3f %10.3f\n", "first setkey (game thread)", Median(before.setKey), Median(after.setKey));
+    printf("%-34s %10.3f %10.3f\n", "re-key mid-request (game thread)", Median(before.reKey), Median(after.reKey));
+    printf("%-34s %10.3f %10.3f\n", "first translation", Median(before.firstRequest), Median(after.firstRequest));
+    printf("%-34s %10s %10.3f\n", "startup thread (off the game)", "-", Median(after.background));
+    return 0;
+}
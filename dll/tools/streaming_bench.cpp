@@ -0,0 +1,242 @@
+// streaming_bench.cpp - Time to first sentence of long messages, streamed versus buffered
+//
+// Usage: streaming_bench [messages] [seed]
+// Long Chinese messages (guild MOTDs, DKP rules, recruitment pastes; 2-10
+// sentences, at least STREAM_MIN_BYTES) are sent through a stand-in proxy in
+// virtual time. The stand-in translates a buffered request in one upstream
+// call, and a streamed one sentence by sentence, writing each sentence's
+// record as soon as it is done. Three DLL paths are compared:
+//   buffered   one POST /api/translate; nothing shows until the whole answer
+//   chunked    the default path: chunks of CHUNK_MAX_BYTES requested in
+//              parallel (at most MAX_PARALLEL_CHUNKS), shown when all are back
+//   streamed   POST /api/translate/stream; the body arrives in reads split at
+//              random points and is fed through the DLL's real
+//              TranslationStreamReader, whose reassembled text is checked
+// Prints time to first sentence and to the full message (p50/p95) as seen
+// by the DLL, plus the reader's cost per byte.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/message_chunker.h"
+#include "../include/wire_format.h"
+
+using namespace std;
+
+// Stand-in proxy model, in milliseconds
+static const double UPSTREAM_OVERHEAD_MS = 120.0;     // Per upstream translation call
+static const double UPSTREAM_MS_PER_BYTE = 0.9;       // Grows with the text translated
+static const double SENTENCE_OVERHEAD_MS = 25.0;      // Per sentence when streaming
+static const size_t STREAM_MIN_BYTES = 240;           // TranslationClient::STREAM_MIN_BYTES
+static const size_t CHUNK_MAX_BYTES = 160;            // TranslationClient::CHUNK_MAX_BYTES
+static const size_t MAX_PARALLEL_CHUNKS = 4;          // TranslationClient::MAX_PARALLEL_CHUNKS
+
+struct Message {
+    string text;
+    vector<string> sentences;      // Source sentences, in order
+    vector<string> translations;   // What the stand-in answers for each
+    double roundTripMs;            // Network round trip for this message's requests
+};
+
+static vector<Message> GenerateMessages(size_t count, uint32_t seed) {
+    static const char* const clauses[] = {
+        "本周团队活动安排如下", "周三晚上八点熔火之心", "周四晚上八点黑翼之巢", "请提前准备好抗火装备",
+        "迟到超过十分钟扣除DKP", "新人需要先打一次祖尔格拉布", "装备分配按照DKP竞拍", "不要在团队频道刷屏",
+        "治疗请看好坦克", "有问题请私聊会长", "缺少两个牧师和一个德鲁伊", "出黑莲花和奥术水晶",
+    };
+    static const char* const ends[] = { "。", "！", "？", "；" };
+
+    mt19937 random(seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    lognormal_distribution<double> roundTrip(log(80.0), 0.4);   // ~80 ms
+    auto pick = [&](size_t n) { return static_cast<size_t>(unit(random) * n); };
+
+    vector<Message> messages;
+    for (size_t i = 0; i < count; ++i) {
+        Message message;
+        // Only messages of at least STREAM_MIN_BYTES are streamed or chunked
+        size_t sentences = 2 + pick(9);
+        for (size_t s = 0; s < sentences || message.text.size() < STREAM_MIN_BYTES; ++s) {
+            string sentence = clauses[pick(12)];
+            if (unit(random) < 0.5) {
+                sentence += string("，") + clauses[pick(12)];
+            }
+            sentence += ends[pick(4)];
+            message.text += sentence;
+            message.sentences.push_back(sentence);
+            // English comes out at roughly the same byte count as the UTF-8 Chinese
+            string translation = "S" + to_string(s) + ":";
+            while (translation.size() + 2 < sentence.size()) {
+                translation += " word";
+            }
+            translation += ". ";
+            message.translations.push_back(translation);
+        }
+        message.translations.back().pop_back();
+        message.roundTripMs = roundTrip(random);
+        messages.push_back(std::move(message));
+    }
+    return messages;
+}
+
+static double UpstreamMs(size_t bytes) {
+    return UPSTREAM_OVERHEAD_MS + UPSTREAM_MS_PER_BYTE * bytes;
+}
+
+struct Timing {
+    double firstMs;
+    double fullMs;
+};
+
+static Timing Buffered(const Message& message) {
+    double done = message.roundTripMs + UpstreamMs(message.text.size());
+    return Timing{ done, done };
+}
+
+static Timing Chunked(const Message& message) {
+    vector<string_view> chunks = SplitLongMessage(message.text, CHUNK_MAX_BYTES);
+    if (chunks.size() < 2) {
+        return Buffered(message);
+    }
+    // Chunks wait for a free slot; the message is shown when the last is back
+    vector<double> slots(min(MAX_PARALLEL_CHUNKS, chunks.size()), 0.0);
+    double done = 0.0;
+    for (string_view chunk : chunks) {
+        auto slot = min_element(slots.begin(), slots.end());
+        *slot += message.roundTripMs + UpstreamMs(chunk.size());
+        done = max(done, *slot);
+    }
+    return Timing{ done, done };
+}
+
+static string EscapeJson(const string& text) {
+    string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+// One read of the streamed body, at the time its bytes reach the DLL
+struct Read {
+    double atMs;
+    string bytes;
+};
+
+// ok is cleared when the reader's text differs from what was sent
+static Timing Streamed(const Message& message, mt19937& random, bool& ok) {
+    // The stand-in writes each record as its sentence finishes
+    vector<Read> writes;
+    double upstream = message.roundTripMs / 2 + UPSTREAM_OVERHEAD_MS;
+    for (size_t s = 0; s < message.sentences.size(); ++s) {
+        upstream += SENTENCE_OVERHEAD_MS + UPSTREAM_MS_PER_BYTE * message.sentences[s].size();
+        writes.push_back(Read{ upstream + message.roundTripMs / 2,
+                               "{\"seq\":" + to_string(s) + ",\"translation\":\"" +
+                                   EscapeJson(message.translations[s]) + "\"}\n" });
+    }
+    writes.back().bytes += "{\"done\":true,\"creditsRemaining\":1000}\n";
+
+    // Reads are cut at arbitrary points, so a record may span several
+    uniform_int_distribution<size_t> cut(1, 48);
+    TranslationStreamReader reader;
+    Timing timing = { -1.0, -1.0 };
+    for (const Read& write : writes) {
+        size_t pos = 0;
+        while (pos < write.bytes.size()) {
+            size_t length = min(cut(random), write.bytes.size() - pos);
+            reader.Feed(string_view(write.bytes).substr(pos, length));
+            pos += length;
+            if (timing.firstMs < 0 && reader.Sentences() > 0) {
+                timing.firstMs = write.atMs;
+            }
+        }
+    }
+    reader.Finish();
+    timing.fullMs = writes.back().atMs;
+
+    string expected;
+    for (const string& translation : message.translations) {
+        expected += translation;
+    }
+    if (!reader.Done() || reader.Malformed() || reader.Translation() != expected ||
+        reader.Sentences() != message.sentences.size()) {
+        ok = false;
+    }
+    return timing;
+}
+
+static double Percentile(vector<double> values, double percentile) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t rank = min(values.size() - 1, static_cast<size_t>(values.size() * percentile / 100.0));
+    nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 2000;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 42;
+    if (count == 0 || count > 1000000) {
+        fprintf(stderr, "usage: %s [messages 1-1000000] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    vector<Message> messages = GenerateMessages(count, seed);
+    size_t totalBytes = 0;
+    for (const Message& message : messages) {
+        totalBytes += message.text.size();
+    }
+    printf("%zu long messages, %.0f bytes on average, seed %u\n\n", count,
+           static_cast<double>(totalBytes) / count, seed);
+
+    mt19937 random(seed + 1);
+    vector<double> first[3];
+    vector<double> full[3];
+    bool ok = true;
+    for (const Message& message : messages) {
+        Timing timings[3] = { Buffered(message), Chunked(message), Streamed(message, random, ok) };
+        for (int mode = 0; mode < 3; ++mode) {
+            first[mode].push_back(timings[mode].firstMs);
+            full[mode].push_back(timings[mode].fullMs);
+        }
+    }
+
+    const char* const names[] = { "buffered", "chunked (default)", "streamed" };
+    printf("%-20s %12s %12s %12s %12s\n", "", "first p50", "first p95", "full p50", "full p95");
+    for (int mode = 0; mode < 3; ++mode) {
+        printf("%-20s %10.0fms %10.0fms %10.0fms %10.0fms\n", names[mode], Percentile(first[mode], 50),
+               Percentile(first[mode], 95), Percentile(full[mode], 50), Percentile(full[mode], 95));
+    }
+    printf("\nreassembled streams: %s\n", ok ? "all match" : "MISMATCH");
+
+    // Wall-clock cost of parsing the stream in the DLL
+    string body;
+    for (size_t s = 0; s < 8; ++s) {
+        body += "{\"seq\":" + to_string(s) + ",\"translation\":\"S: word word word word word word word.\"}\n";
+    }
+    body += "{\"done\":true,\"creditsRemaining\":1000}\n";
+    const int iterations = 200000;
+    size_t sentences = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        TranslationStreamReader reader;
+        for (size_t pos = 0; pos < body.size(); pos += 64) {
+            reader.Feed(string_view(body).substr(pos, 64));
+        }
+        sentences += reader.Sentences();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("stream reader: %.1f ns per byte (%zu sentences parsed)\n", ns / (static_cast<double>(body.size()) * iterations),
+           sentences);
+    return ok ? 0 : 1;
+}
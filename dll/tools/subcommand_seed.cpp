@@ -0,0 +1,56 @@
+// subcommand_seed.cpp - Finds a perfect hash seed for the subcommand table
+//
+// Usage: subcommand_seed [maxSeeds]
+// LookupSubcommand hashes names with a fixed SUBCOMMAND_HASH_SEED, checked
+// by a static_assert in subcommand_table.cpp. When a new subcommand makes
+// that assert fire, this searches seeds 0..maxSeeds-1 with the same hash
+// and table size and prints the first one that gives every name its own
+// slot, to paste into SUBCOMMAND_HASH_SEED. It also checks that the table
+// as built resolves every subcommand's name back to it and rejects names
+// that are not subcommands.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "../include/subcommand_table.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    uint32_t maxSeeds = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 65536;
+
+    // The table as compiled into the DLL
+    int subcommands = 0;
+    bool ok = true;
+    for (int id = 0; id <= static_cast<int>(Subcommand::Multiplex); ++id) {
+        const char* name = SubcommandName(static_cast<Subcommand>(id));
+        if (LookupSubcommand(name) != static_cast<Subcommand>(id)) {
+            fprintf(stderr, "%s does not resolve to itself\n", name);
+            ok = false;
+        }
+        ++subcommands;
+    }
+    for (const char* name : { "", "Ping", "pin", "pingg", "translate_asyn", "behind", "WoWTranslate" }) {
+        if (LookupSubcommand(name) != Subcommand::Unknown) {
+            fprintf(stderr, "\"%s\" resolves to a subcommand\n", name);
+            ok = false;
+        }
+    }
+    printf("%d subcommands, current table %s\n", subcommands, ok ? "resolves all of them" : "is BROKEN");
+
+    uint32_t first = 0, perfect = 0;
+    for (uint32_t seed = 0; seed < maxSeeds; ++seed) {
+        if (IsPerfectSubcommandSeed(seed)) {
+            if (perfect++ == 0) {
+                first = seed;
+            }
+        }
+    }
+    if (perfect == 0) {
+        printf("no perfect seed below %u; grow SUBCOMMAND_TABLE_SIZE\n", maxSeeds);
+        return 1;
+    }
+    printf("first perfect seed: %u (%u of %u seeds are perfect)\n", first, perfect, maxSeeds);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// template_replay.cpp - Cache hit rate of raw, normalized and templated keys on a replayed channel log
+//
+// Usage: template_replay <channel.tsv> [playerName ...]
+// The log holds "seconds<TAB>group<TAB>text" per line ('#' lines are
+// comments), as tools/data/channel_sample.tsv does; the group column is not
+// used here. Each message goes through TranslateText's cache tiers three
+// times: keyed on the raw text, keyed on NormalizeForCache, and normalized
+// with templating on, where a miss on the full key is retried on the
+// template key (numbers and the given player names lifted into slots) and
+// a template hit is filled back in. A miss is a proxy request; the stand-in
+// proxy hands the text back unchanged, so slot markers always survive and
+// the templated numbers are an upper bound. Prints hits, requests and the
+// characters sent for each key, then the cost of building the keys.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../include/scheduling_policy.h"
+#include "../include/text_normalize.h"
+#include "../include/translation_cache.h"
+#include "../include/utf8.h"
+
+using namespace std;
+
+struct LoggedMessage {
+    uint32_t timeMs;
+    string text;
+};
+
+static bool LoadLog(const char* path, vector<LoggedMessage>& messages) {
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        size_t first = line.find('\t');
+        size_t second = first == string::npos ? string::npos : line.find('\t', first + 1);
+        if (second == string::npos) {
+            continue;
+        }
+        uint32_t timeMs = static_cast<uint32_t>(atof(line.c_str()) * 1000.0);
+        messages.push_back(LoggedMessage{ timeMs, line.substr(second + 1) });
+    }
+    return true;
+}
+
+enum class KeyMode { RAW, NORMALIZED, TEMPLATED };
+
+struct Outcome {
+    uint64_t exactHits;
+    uint64_t templateHits;
+    uint64_t proxyRequests;
+    uint64_t charsSent;
+};
+
+static Outcome Replay(const vector<LoggedMessage>& messages, KeyMode mode, const vector<string>& names) {
+    TranslationCache cache(SchedulingPolicy::DEFAULT_CACHE_ENTRIES, SchedulingPolicy::DEFAULT_CACHE_EXPIRY_MS);
+    Outcome outcome = {};
+
+    for (const LoggedMessage& message : messages) {
+        string key = mode == KeyMode::RAW ? message.text : NormalizeForCache(message.text);
+        PooledString translation;
+        cache.CleanExpired(message.timeMs);
+        if (cache.Lookup(key, DEFAULT_LANGUAGE_PAIR, message.timeMs, translation)) {
+            ++outcome.exactHits;
+            continue;
+        }
+
+        TextTemplate textTemplate;
+        if (mode == KeyMode::TEMPLATED && ExtractTemplate(message.text, names, textTemplate)) {
+            string templateKey = NormalizeForCache(textTemplate.text);
+            string filled;
+            if (cache.Lookup(templateKey, DEFAULT_LANGUAGE_PAIR, message.timeMs, translation) &&
+                FillTemplate(translation, textTemplate.slots, filled)) {
+                ++outcome.templateHits;
+                cache.Insert(key, DEFAULT_LANGUAGE_PAIR, filled, message.timeMs);
+                continue;
+            }
+            ++outcome.proxyRequests;
+            outcome.charsSent += CountCodepoints(textTemplate.text);
+            if (FillTemplate(textTemplate.text, textTemplate.slots, filled)) {
+                cache.Insert(templateKey, DEFAULT_LANGUAGE_PAIR, textTemplate.text, message.timeMs);
+                cache.Insert(key, DEFAULT_LANGUAGE_PAIR, filled, message.timeMs);
+            }
+            continue;
+        }
+
+        ++outcome.proxyRequests;
+        outcome.charsSent += CountCodepoints(message.text);
+        cache.Insert(key, DEFAULT_LANGUAGE_PAIR, message.text, message.timeMs);
+    }
+    return outcome;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: template_replay <channel.tsv> [playerName ...]\n");
+        return 1;
+    }
+    vector<string> names(argv + 2, argv + argc);
+
+    vector<LoggedMessage> messages;
+    if (!LoadLog(argv[1], messages) || messages.empty()) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+    printf("%zu messages, %.1f h, %zu player names\n\n", messages.size(), messages.back().timeMs / 3600000.0,
+           names.size());
+
+    static const struct {
+        const char* name;
+        KeyMode mode;
+    } modes[] = {
+        { "raw", KeyMode::RAW },
+        { "normalized", KeyMode::NORMALIZED },
+        { "templated", KeyMode::TEMPLATED },
+    };
+    printf("%-12s %8s %9s %8s %9s %10s\n", "key", "exact", "template", "proxy", "hit rate", "chars sent");
+    for (const auto& entry : modes) {
+        Outcome outcome = Replay(messages, entry.mode, names);
+        printf("%-12s %8llu %9llu %8llu %8.1f%% %10llu\n", entry.name,
+               static_cast<unsigned long long>(outcome.exactHits),
+               static_cast<unsigned long long>(outcome.templateHits),
+               static_cast<unsigned long long>(outcome.proxyRequests),
+               100.0 * (outcome.exactHits + outcome.templateHits) / messages.size(),
+               static_cast<unsigned long long>(outcome.charsSent));
+    }
+
+    // Cost of the keys themselves on every message; the volatile sum keeps
+    // the calls from being folded away
+    const int rounds = 50;
+    volatile size_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (const LoggedMessage& message : messages) {
+            sink = sink + NormalizeForCache(message.text).size();
+        }
+    }
+    double normalizeNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        for (const LoggedMessage& message : messages) {
+            TextTemplate textTemplate;
+            if (ExtractTemplate(message.text, names, textTemplate)) {
+                sink = sink + NormalizeForCache(textTemplate.text).size();
+            }
+        }
+    }
+    double templateNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    printf("\nNormalizeForCache: %.0f ns per message; ExtractTemplate and its key: %.0f ns per message\n",
+           normalizeNs / rounds / messages.size(), templateNs / rounds / messages.size());
+    return 0;
+}
@@ -0,0 +1,176 @@
+// wire_format_bench.cpp - Compares the JSON and MessagePack proxy protocols
+//
+// Usage: wire_format_bench [iterations]
+// Encodes requests and decodes responses for a set of typical chat lines in
+// both formats, the way TranslationClient does, and prints body sizes and
+// per-message encode/decode times. The JSON request carries the API key, the
+// MessagePack request a session token of the same length as the proxy issues.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../include/wire_format.h"
+
+using namespace std;
+
+struct Sample {
+    const char* text;
+    const char* translation;
+};
+
+static const Sample SAMPLES[] = {
+    { "\xE6\xB1\x82\xE7\xBB\x84", "LFG" },
+    { "\xE9\xBB\x91\xE7\x9F\xB3\xE5\xA1\x94\xE4\xB8\x8A\xE5\xB1\x82\xE7\xBC\xBA\xE4\xB8\x80\xE4\xB8\xAA\xE5\x9D\xA6\xE5\x85\x8B\xEF\xBC\x8C\xE9\x80\x9F\xE6\x9D\xA5",
+      "UBRS needs one tank, come quick" },
+    { "\xE6\x94\xB6[\xE5\xA5\xA5\xE6\x9C\xAF\xE6\xB0\xB4\xE6\x99\xB6]\xE5\x92\x8C[\xE7\xBB\xBF\xE5\xAE\x9D\xE7\x9F\xB3]\xEF\xBC\x8C\xE4\xBB\xB7\xE6\xA0\xBC\xE5\x8F\xAF\xE8\xB0\x88 \"\xE7\xA7\x81\xE8\x81\x8A\"",
+      "Buying [Arcane Crystal] and [Green Gem], price negotiable \"whisper me\"" },
+    { "\xE4\xBB\x8A\xE6\x99\x9A\xE5\x85\xAB\xE7\x82\xB9MC\xE5\xBC\x80\xE6\xB4\xBB\xEF\xBC\x8C\xE9\x9C\x80\xE8\xA6\x81\xE6\x8A\x97\xE7\x81\xAB\xE8\xA3\x85\xE5\xA4\x87\xEF\xBC\x8C\xE6\xB2\xA1\xE6\x9C\x89\xE7\x9A\x84\xE5\x85\x88\xE5\x8E\xBB\xE5\x81\x9A\xE4\xB8\x80\xE4\xB8\x8B\xE7\x81\xAB\xE6\x8A\x97\xE4\xBB\xBB\xE5\x8A\xA1\xE3\x80\x82\xE9\x9B\x86\xE5\x90\x88\xE7\x82\xB9\xE5\x9C\xA8\xE9\xBB\x91\xE7\x9F\xB3\xE5\xB1\xB1\xE9\x97\xA8\xE5\x8F\xA3\xEF\xBC\x8C\xE8\xAF\xB7\xE5\x87\x86\xE6\x97\xB6\xE5\x88\xB0\xE5\x9C\xBA\xE3\x80\x82",
+      "MC starts at 8 tonight, fire resistance gear required; if you have none, do the fire resistance quest first. "
+      "Meet at the Blackrock Mountain entrance, please be on time." },
+    { "gogogo\n\xE5\x86\xB2", "gogogo\nCharge" },
+};
+
+static const size_t SAMPLE_COUNT = sizeof(SAMPLES) / sizeof(SAMPLES[0]);
+static const char* API_KEY = "WT-3f9c2a7e51d84b06a1c9e2f4d7b8a0c6";
+static const char* SESSION_TOKEN = "s-8d41c07f2b9e4a6d93f1e0b5c7a28d64";
+static const uint64_t CREDITS = 48213;
+
+static uint64_t ElapsedNanos(chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+}
+
+// Response bodies as the proxy sends them
+static PooledString JsonResponse(const Sample& sample) {
+    PooledString body = "{\"translation\":\"";
+    AppendJsonEscaped(body, sample.translation);
+    body += "\",\"creditsRemaining\":" + to_string(CREDITS) + "}";
+    return body;
+}
+
+static PooledString MsgPackResponse(const Sample& sample) {
+    PooledString body;
+    MsgPackWriter writer(body);
+    writer.Map(2);
+    writer.Uint(WIRE_RESPONSE_TRANSLATION);
+    writer.Str(sample.translation);
+    writer.Uint(WIRE_RESPONSE_CREDITS);
+    writer.Uint(CREDITS);
+    return body;
+}
+
+struct FormatResult {
+    size_t requestBytes;
+    size_t responseBytes;
+    uint64_t encodeNanos;
+    uint64_t decodeNanos;
+    size_t checksum;   // Keeps the decoded values alive
+};
+
+static FormatResult RunJson(int iterations) {
+    FormatResult result = {};
+    vector<PooledString> responses;
+    for (const Sample& sample : SAMPLES) {
+        responses.push_back(JsonResponse(sample));
+        result.responseBytes += responses.back().size();
+    }
+
+    for (int i = 0; i < iterations; ++i) {
+        for (size_t s = 0; s < SAMPLE_COUNT; ++s) {
+            auto start = chrono::steady_clock::now();
+            PooledString request;
+            EncodeJsonRequest(request, API_KEY, SAMPLES[s].text, "zh", "en");
+            result.encodeNanos += ElapsedNanos(start);
+            if (i == 0) {
+                result.requestBytes += request.size();
+            }
+
+            // Same field reads as RequestTranslation
+            start = chrono::steady_clock::now();
+            string error = SimpleJsonParser::extractField(responses[s], "error");
+            string translation = SimpleJsonParser::extractField(responses[s], "translation");
+            double credits = SimpleJsonParser::extractNumber(responses[s], "creditsRemaining");
+            PooledString copy(translation.data(), translation.size());
+            result.decodeNanos += ElapsedNanos(start);
+            result.checksum += error.size() + copy.size() + static_cast<size_t>(credits);
+        }
+    }
+    return result;
+}
+
+static FormatResult RunMsgPack(int iterations) {
+    FormatResult result = {};
+    vector<PooledString> responses;
+    for (const Sample& sample : SAMPLES) {
+        responses.push_back(MsgPackResponse(sample));
+        result.responseBytes += responses.back().size();
+    }
+
+    for (int i = 0; i < iterations; ++i) {
+        for (size_t s = 0; s < SAMPLE_COUNT; ++s) {
+            auto start = chrono::steady_clock::now();
+            PooledString request;
+            EncodeMsgPackRequest(request, SESSION_TOKEN, SAMPLES[s].text, "zh", "en");
+            result.encodeNanos += ElapsedNanos(start);
+            if (i == 0) {
+                result.requestBytes += request.size();
+            }
+
+            // Same steps as RequestTranslationBinary: decode views, one copy out
+            start = chrono::steady_clock::now();
+            WireResponse wire;
+            if (!DecodeMsgPackResponse(responses[s], wire)) {
+                fprintf(stderr, "decode failed for sample %zu\n", s);
+                exit(1);
+            }
+            PooledString copy(wire.translation.data(), wire.translation.size());
+            result.decodeNanos += ElapsedNanos(start);
+            result.checksum += wire.error.size() + copy.size() + static_cast<size_t>(wire.credits);
+        }
+    }
+    return result;
+}
+
+// Both formats must carry the same content
+static bool CheckRoundTrip() {
+    for (const Sample& sample : SAMPLES) {
+        PooledString response = MsgPackResponse(sample);
+        WireResponse wire;
+        if (!DecodeMsgPackResponse(response, wire) || wire.translation != sample.translation ||
+            wire.credits != CREDITS || !wire.error.empty()) {
+            return false;
+        }
+        if (SimpleJsonParser::extractField(JsonResponse(sample), "translation") != sample.translation) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    if (iterations <= 0) {
+        fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    if (!CheckRoundTrip()) {
+        fprintf(stderr, "round trip mismatch\n");
+        return 1;
+    }
+
+    FormatResult json = RunJson(iterations);
+    FormatResult msgpack = RunMsgPack(iterations);
+    double messages = static_cast<double>(iterations) * SAMPLE_COUNT;
+
+    printf("%zu chat lines, %d iterations\n", SAMPLE_COUNT, iterations);
+    printf("%-8s %12s %12s %12s %12s\n", "format", "reqBytes", "respBytes", "encodeNs", "decodeNs");
+    printf("%-8s %12zu %12zu %12.0f %12.0f\n", "json", json.requestBytes, json.responseBytes,
+           json.encodeNanos / messages, json.decodeNanos / messages);
+    printf("%-8s %12zu %12zu %12.0f %12.0f\n", "msgpack", msgpack.requestBytes, msgpack.responseBytes,
+           msgpack.encodeNanos / messages, msgpack.decodeNanos / messages);
+    return json.checksum == msgpack.checksum ? 0 : 1;
+}